@@ -272,6 +272,27 @@ print_bearer_info (MMBearer *bearer)
             g_print ("                     | Bytes transmitted: '%" G_GUINT64_FORMAT "'\n", val);
         else
             g_print ("                     | Bytes transmitted: 'N/A'\n");
+
+        /* Packet counts and throughput are only available when the stats
+         * are read from the network interface counters */
+        if (mm_bearer_stats_get_rx_packets (stats) > 0 || mm_bearer_stats_get_tx_packets (stats) > 0) {
+            g_print ("                     |        Rx packets: '%" G_GUINT64_FORMAT "'\n"
+                     "                     |        Tx packets: '%" G_GUINT64_FORMAT "'\n"
+                     "                     |     Rx rate (bps): '%" G_GUINT64_FORMAT "'\n"
+                     "                     |     Tx rate (bps): '%" G_GUINT64_FORMAT "'\n"
+                     "                     | Rx rate avg (bps): '%" G_GUINT64_FORMAT "'\n"
+                     "                     | Tx rate avg (bps): '%" G_GUINT64_FORMAT "'\n"
+                     "                     |Rx rate peak (bps): '%" G_GUINT64_FORMAT "'\n"
+                     "                     |Tx rate peak (bps): '%" G_GUINT64_FORMAT "'\n",
+                     mm_bearer_stats_get_rx_packets (stats),
+                     mm_bearer_stats_get_tx_packets (stats),
+                     mm_bearer_stats_get_rx_rate (stats),
+                     mm_bearer_stats_get_tx_rate (stats),
+                     mm_bearer_stats_get_rx_rate_average (stats),
+                     mm_bearer_stats_get_tx_rate_average (stats),
+                     mm_bearer_stats_get_rx_rate_peak (stats),
+                     mm_bearer_stats_get_tx_rate_peak (stats));
+        }
     }
 
     g_clear_object (&stats);
@@ -34,14 +34,30 @@
 
 G_DEFINE_TYPE (MMBearerStats, mm_bearer_stats, G_TYPE_OBJECT)
 
-#define PROPERTY_DURATION "duration"
-#define PROPERTY_RX_BYTES "rx-bytes"
-#define PROPERTY_TX_BYTES "tx-bytes"
+#define PROPERTY_DURATION               "duration"
+#define PROPERTY_RX_BYTES               "rx-bytes"
+#define PROPERTY_TX_BYTES               "tx-bytes"
+#define PROPERTY_RX_PACKETS             "rx-packets"
+#define PROPERTY_TX_PACKETS             "tx-packets"
+#define PROPERTY_RX_RATE                "rx-rate"
+#define PROPERTY_TX_RATE                "tx-rate"
+#define PROPERTY_RX_RATE_AVERAGE        "rx-rate-average"
+#define PROPERTY_TX_RATE_AVERAGE        "tx-rate-average"
+#define PROPERTY_RX_RATE_PEAK           "rx-rate-peak"
+#define PROPERTY_TX_RATE_PEAK           "tx-rate-peak"
 
 struct _MMBearerStatsPrivate {
     guint   duration;
     guint64 rx_bytes;
     guint64 tx_bytes;
+    guint64 rx_packets;
+    guint64 tx_packets;
+    guint64 rx_rate;
+    guint64 tx_rate;
+    guint64 rx_rate_average;
+    guint64 tx_rate_average;
+    guint64 rx_rate_peak;
+    guint64 tx_rate_peak;
 };
 
 /*****************************************************************************/
@@ -127,6 +143,238 @@ mm_bearer_stats_set_tx_bytes (MMBearerStats *self,
 
 /*****************************************************************************/
 
+/**
+ * mm_bearer_stats_get_rx_packets:
+ * @self: a #MMBearerStats.
+ *
+ * Gets the number of packets received without error in the connection.
+ *
+ * Only available when the statistics are taken from the network interface counters; 0 otherwise.
+ *
+ * Returns: a #guint64.
+ */
+guint64
+mm_bearer_stats_get_rx_packets (MMBearerStats *self)
+{
+    g_return_val_if_fail (MM_IS_BEARER_STATS (self), 0);
+
+    return self->priv->rx_packets;
+}
+
+void
+mm_bearer_stats_set_rx_packets (MMBearerStats *self,
+                                guint64 rx_packets)
+{
+    g_return_if_fail (MM_IS_BEARER_STATS (self));
+
+    self->priv->rx_packets = rx_packets;
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_bearer_stats_get_tx_packets:
+ * @self: a #MMBearerStats.
+ *
+ * Gets the number of packets transmitted without error in the connection.
+ *
+ * Only available when the statistics are taken from the network interface counters; 0 otherwise.
+ *
+ * Returns: a #guint64.
+ */
+guint64
+mm_bearer_stats_get_tx_packets (MMBearerStats *self)
+{
+    g_return_val_if_fail (MM_IS_BEARER_STATS (self), 0);
+
+    return self->priv->tx_packets;
+}
+
+void
+mm_bearer_stats_set_tx_packets (MMBearerStats *self,
+                                guint64 tx_packets)
+{
+    g_return_if_fail (MM_IS_BEARER_STATS (self));
+
+    self->priv->tx_packets = tx_packets;
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_bearer_stats_get_rx_rate:
+ * @self: a #MMBearerStats.
+ *
+ * Gets the receive throughput measured during the last statistics update interval, in bits per second.
+ *
+ * Only available when the statistics are taken from the network interface counters; 0 otherwise.
+ *
+ * Returns: a #guint64.
+ */
+guint64
+mm_bearer_stats_get_rx_rate (MMBearerStats *self)
+{
+    g_return_val_if_fail (MM_IS_BEARER_STATS (self), 0);
+
+    return self->priv->rx_rate;
+}
+
+void
+mm_bearer_stats_set_rx_rate (MMBearerStats *self,
+                             guint64 rx_rate)
+{
+    g_return_if_fail (MM_IS_BEARER_STATS (self));
+
+    self->priv->rx_rate = rx_rate;
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_bearer_stats_get_tx_rate:
+ * @self: a #MMBearerStats.
+ *
+ * Gets the transmit throughput measured during the last statistics update interval, in bits per second.
+ *
+ * Only available when the statistics are taken from the network interface counters; 0 otherwise.
+ *
+ * Returns: a #guint64.
+ */
+guint64
+mm_bearer_stats_get_tx_rate (MMBearerStats *self)
+{
+    g_return_val_if_fail (MM_IS_BEARER_STATS (self), 0);
+
+    return self->priv->tx_rate;
+}
+
+void
+mm_bearer_stats_set_tx_rate (MMBearerStats *self,
+                             guint64 tx_rate)
+{
+    g_return_if_fail (MM_IS_BEARER_STATS (self));
+
+    self->priv->tx_rate = tx_rate;
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_bearer_stats_get_rx_rate_average:
+ * @self: a #MMBearerStats.
+ *
+ * Gets the exponentially weighted moving average of the receive throughput, in bits per second.
+ *
+ * Only available when the statistics are taken from the network interface counters; 0 otherwise.
+ *
+ * Returns: a #guint64.
+ */
+guint64
+mm_bearer_stats_get_rx_rate_average (MMBearerStats *self)
+{
+    g_return_val_if_fail (MM_IS_BEARER_STATS (self), 0);
+
+    return self->priv->rx_rate_average;
+}
+
+void
+mm_bearer_stats_set_rx_rate_average (MMBearerStats *self,
+                                     guint64 rx_rate_average)
+{
+    g_return_if_fail (MM_IS_BEARER_STATS (self));
+
+    self->priv->rx_rate_average = rx_rate_average;
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_bearer_stats_get_tx_rate_average:
+ * @self: a #MMBearerStats.
+ *
+ * Gets the exponentially weighted moving average of the transmit throughput, in bits per second.
+ *
+ * Only available when the statistics are taken from the network interface counters; 0 otherwise.
+ *
+ * Returns: a #guint64.
+ */
+guint64
+mm_bearer_stats_get_tx_rate_average (MMBearerStats *self)
+{
+    g_return_val_if_fail (MM_IS_BEARER_STATS (self), 0);
+
+    return self->priv->tx_rate_average;
+}
+
+void
+mm_bearer_stats_set_tx_rate_average (MMBearerStats *self,
+                                     guint64 tx_rate_average)
+{
+    g_return_if_fail (MM_IS_BEARER_STATS (self));
+
+    self->priv->tx_rate_average = tx_rate_average;
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_bearer_stats_get_rx_rate_peak:
+ * @self: a #MMBearerStats.
+ *
+ * Gets the highest receive throughput measured in the connection, in bits per second.
+ *
+ * Only available when the statistics are taken from the network interface counters; 0 otherwise.
+ *
+ * Returns: a #guint64.
+ */
+guint64
+mm_bearer_stats_get_rx_rate_peak (MMBearerStats *self)
+{
+    g_return_val_if_fail (MM_IS_BEARER_STATS (self), 0);
+
+    return self->priv->rx_rate_peak;
+}
+
+void
+mm_bearer_stats_set_rx_rate_peak (MMBearerStats *self,
+                                  guint64 rx_rate_peak)
+{
+    g_return_if_fail (MM_IS_BEARER_STATS (self));
+
+    self->priv->rx_rate_peak = rx_rate_peak;
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_bearer_stats_get_tx_rate_peak:
+ * @self: a #MMBearerStats.
+ *
+ * Gets the highest transmit throughput measured in the connection, in bits per second.
+ *
+ * Only available when the statistics are taken from the network interface counters; 0 otherwise.
+ *
+ * Returns: a #guint64.
+ */
+guint64
+mm_bearer_stats_get_tx_rate_peak (MMBearerStats *self)
+{
+    g_return_val_if_fail (MM_IS_BEARER_STATS (self), 0);
+
+    return self->priv->tx_rate_peak;
+}
+
+void
+mm_bearer_stats_set_tx_rate_peak (MMBearerStats *self,
+                                  guint64 tx_rate_peak)
+{
+    g_return_if_fail (MM_IS_BEARER_STATS (self));
+
+    self->priv->tx_rate_peak = tx_rate_peak;
+}
+
+/*****************************************************************************/
+
 GVariant *
 mm_bearer_stats_get_dictionary (MMBearerStats *self)
 {
@@ -149,6 +397,25 @@ mm_bearer_stats_get_dictionary (MMBearerStats *self)
                             "{sv}",
                             PROPERTY_TX_BYTES,
                             g_variant_new_uint64 (self->priv->tx_bytes));
+
+    /* Packet counts and throughput are only known when the stats come from
+     * the network interface counters; skip them otherwise */
+    if (self->priv->rx_packets)
+        g_variant_builder_add (&builder, "{sv}", PROPERTY_RX_PACKETS, g_variant_new_uint64 (self->priv->rx_packets));
+    if (self->priv->tx_packets)
+        g_variant_builder_add (&builder, "{sv}", PROPERTY_TX_PACKETS, g_variant_new_uint64 (self->priv->tx_packets));
+    if (self->priv->rx_rate)
+        g_variant_builder_add (&builder, "{sv}", PROPERTY_RX_RATE, g_variant_new_uint64 (self->priv->rx_rate));
+    if (self->priv->tx_rate)
+        g_variant_builder_add (&builder, "{sv}", PROPERTY_TX_RATE, g_variant_new_uint64 (self->priv->tx_rate));
+    if (self->priv->rx_rate_average)
+        g_variant_builder_add (&builder, "{sv}", PROPERTY_RX_RATE_AVERAGE, g_variant_new_uint64 (self->priv->rx_rate_average));
+    if (self->priv->tx_rate_average)
+        g_variant_builder_add (&builder, "{sv}", PROPERTY_TX_RATE_AVERAGE, g_variant_new_uint64 (self->priv->tx_rate_average));
+    if (self->priv->rx_rate_peak)
+        g_variant_builder_add (&builder, "{sv}", PROPERTY_RX_RATE_PEAK, g_variant_new_uint64 (self->priv->rx_rate_peak));
+    if (self->priv->tx_rate_peak)
+        g_variant_builder_add (&builder, "{sv}", PROPERTY_TX_RATE_PEAK, g_variant_new_uint64 (self->priv->tx_rate_peak));
     return g_variant_builder_end (&builder);
 }
 
@@ -191,6 +458,38 @@ mm_bearer_stats_new_from_dictionary (GVariant *dictionary,
             mm_bearer_stats_set_tx_bytes (
                 self,
                 g_variant_get_uint64 (value));
+        } else if (g_str_equal (key, PROPERTY_RX_PACKETS)) {
+            mm_bearer_stats_set_rx_packets (
+                self,
+                g_variant_get_uint64 (value));
+        } else if (g_str_equal (key, PROPERTY_TX_PACKETS)) {
+            mm_bearer_stats_set_tx_packets (
+                self,
+                g_variant_get_uint64 (value));
+        } else if (g_str_equal (key, PROPERTY_RX_RATE)) {
+            mm_bearer_stats_set_rx_rate (
+                self,
+                g_variant_get_uint64 (value));
+        } else if (g_str_equal (key, PROPERTY_TX_RATE)) {
+            mm_bearer_stats_set_tx_rate (
+                self,
+                g_variant_get_uint64 (value));
+        } else if (g_str_equal (key, PROPERTY_RX_RATE_AVERAGE)) {
+            mm_bearer_stats_set_rx_rate_average (
+                self,
+                g_variant_get_uint64 (value));
+        } else if (g_str_equal (key, PROPERTY_TX_RATE_AVERAGE)) {
+            mm_bearer_stats_set_tx_rate_average (
+                self,
+                g_variant_get_uint64 (value));
+        } else if (g_str_equal (key, PROPERTY_RX_RATE_PEAK)) {
+            mm_bearer_stats_set_rx_rate_peak (
+                self,
+                g_variant_get_uint64 (value));
+        } else if (g_str_equal (key, PROPERTY_TX_RATE_PEAK)) {
+            mm_bearer_stats_set_tx_rate_peak (
+                self,
+                g_variant_get_uint64 (value));
         }
         g_free (key);
         g_variant_unref (value);
@@ -60,6 +60,14 @@ GType mm_bearer_stats_get_type (void);
 guint   mm_bearer_stats_get_duration (MMBearerStats *self);
 guint64 mm_bearer_stats_get_rx_bytes (MMBearerStats *self);
 guint64 mm_bearer_stats_get_tx_bytes (MMBearerStats *self);
+guint64 mm_bearer_stats_get_rx_packets (MMBearerStats *self);
+guint64 mm_bearer_stats_get_tx_packets (MMBearerStats *self);
+guint64 mm_bearer_stats_get_rx_rate (MMBearerStats *self);
+guint64 mm_bearer_stats_get_tx_rate (MMBearerStats *self);
+guint64 mm_bearer_stats_get_rx_rate_average (MMBearerStats *self);
+guint64 mm_bearer_stats_get_tx_rate_average (MMBearerStats *self);
+guint64 mm_bearer_stats_get_rx_rate_peak (MMBearerStats *self);
+guint64 mm_bearer_stats_get_tx_rate_peak (MMBearerStats *self);
 
 /*****************************************************************************/
 /* ModemManager/libmm-glib/mmcli specific methods */
@@ -75,6 +83,14 @@ MMBearerStats *mm_bearer_stats_new_from_dictionary (GVariant *dictionary,
 void mm_bearer_stats_set_duration (MMBearerStats *self, guint duration);
 void mm_bearer_stats_set_rx_bytes (MMBearerStats *self, guint64 rx_bytes);
 void mm_bearer_stats_set_tx_bytes (MMBearerStats *self, guint64 tx_bytes);
+void mm_bearer_stats_set_rx_packets (MMBearerStats *self, guint64 rx_packets);
+void mm_bearer_stats_set_tx_packets (MMBearerStats *self, guint64 tx_packets);
+void mm_bearer_stats_set_rx_rate (MMBearerStats *self, guint64 rx_rate);
+void mm_bearer_stats_set_tx_rate (MMBearerStats *self, guint64 tx_rate);
+void mm_bearer_stats_set_rx_rate_average (MMBearerStats *self, guint64 rx_rate_average);
+void mm_bearer_stats_set_tx_rate_average (MMBearerStats *self, guint64 tx_rate_average);
+void mm_bearer_stats_set_rx_rate_peak (MMBearerStats *self, guint64 rx_rate_peak);
+void mm_bearer_stats_set_tx_rate_peak (MMBearerStats *self, guint64 tx_rate_peak);
 
 GVariant *mm_bearer_stats_get_dictionary (MMBearerStats *self);
 
@@ -23,6 +23,7 @@
 #include "errors.h"
 #include "dm-commands.h"
 #include "nv-items.h"
+#include "log-items.h"
 #include "result-private.h"
 #include "utils.h"
 
@@ -1715,7 +1716,7 @@ qcdm_cmd_log_config_new (char *buf,
     DMCmdLogConfig *cmd;
     uint16_t highest = 0;
     uint32_t items_len = 0;
-    size_t cmdsize = 0, cmdbufsize;
+    size_t cmdsize = 0, cmdbufsize, encap_len;
     uint32_t i;
     uint16_t log_code;
 
@@ -1732,12 +1733,14 @@ qcdm_cmd_log_config_new (char *buf,
             items_len++;
         }
     }
-    cmdsize = sizeof (DMCmdLogConfig) + ((highest + 7) / 8);
+    /* Room for the bit of the highest log item */
+    cmdsize = sizeof (DMCmdLogConfig) + (highest ? (highest / 8) + 1 : 0);
     cmdbufsize = cmdsize + DIAG_TRAILER_LEN;
 
     qcdm_return_val_if_fail (len >= cmdsize, 0);
 
     cmd = calloc (1, cmdbufsize);
+    qcdm_return_val_if_fail (cmd != NULL, 0);
     cmd->code = DIAG_CMD_LOG_CONFIG;
     cmd->op = htole32 (op);
     cmd->equipid = htole32 (equip_id);
@@ -1751,7 +1754,9 @@ qcdm_cmd_log_config_new (char *buf,
         cmd->num_items = htole32 (highest);
     }
 
-    return dm_encapsulate_buffer ((char *) cmd, cmdsize, cmdbufsize, buf, len);
+    encap_len = dm_encapsulate_buffer ((char *) cmd, cmdsize, cmdbufsize, buf, len);
+    free (cmd);
+    return encap_len;
 }
 
 size_t
@@ -1903,6 +1908,49 @@ qcdm_cmd_log_config_set_mask_new (char *buf,
                                     items);
 }
 
+size_t
+qcdm_cmd_log_config_set_mask_codes_new (char *buf,
+                                        size_t len,
+                                        uint32_t equip_id,
+                                        const uint16_t codes[],
+                                        size_t n_codes)
+{
+    uint16_t *items;
+    size_t i, n_items = 0, encap_len;
+
+    qcdm_return_val_if_fail (buf != NULL, 0);
+    qcdm_return_val_if_fail (codes != NULL || n_codes == 0, 0);
+
+    /* Only the codes of the given equipment ID, 0-terminated */
+    items = calloc (n_codes + 1, sizeof (uint16_t));
+    qcdm_return_val_if_fail (items != NULL, 0);
+    for (i = 0; i < n_codes; i++) {
+        if (DM_LOG_ITEM_EQUIP_ID (codes[i]) == equip_id && (codes[i] & 0x0FFF))
+            items[n_items++] = codes[i];
+    }
+
+    encap_len = qcdm_cmd_log_config_new (buf,
+                                         len,
+                                         DIAG_CMD_LOG_CONFIG_OP_SET_MASK,
+                                         equip_id,
+                                         items);
+    free (items);
+    return encap_len;
+}
+
+uint32_t
+qcdm_log_codes_get_equip_ids (const uint16_t codes[], size_t n_codes)
+{
+    uint32_t equip_ids = 0;
+    size_t i;
+
+    qcdm_return_val_if_fail (codes != NULL || n_codes == 0, 0);
+
+    for (i = 0; i < n_codes; i++)
+        equip_ids |= 1 << DM_LOG_ITEM_EQUIP_ID (codes[i]);
+    return equip_ids;
+}
+
 QcdmResult *
 qcdm_cmd_log_config_set_mask_result (const char *buf, size_t len, int *out_error)
 {
@@ -600,6 +600,19 @@ size_t qcdm_cmd_log_config_set_mask_new (char *buf,
                                          uint32_t equip_id,
                                          uint16_t items[]);
 
+/* Builds the command enabling exactly those of @codes (any of log-items.h)
+ * which belong to @equip_id; one such command is needed for each of the
+ * equipment IDs returned by qcdm_log_codes_get_equip_ids(). */
+size_t qcdm_cmd_log_config_set_mask_codes_new (char *buf,
+                                               size_t len,
+                                               uint32_t equip_id,
+                                               const uint16_t codes[],
+                                               size_t n_codes);
+
+/* Returns a bitmask with bit N set if any of @codes has equipment ID N */
+uint32_t qcdm_log_codes_get_equip_ids (const uint16_t codes[],
+                                       size_t n_codes);
+
 #define QCDM_CMD_LOG_CONFIG_MASK_ITEM_EQUIP_ID  "equip-id"
 
 #define QCDM_CMD_LOG_CONFIG_MASK_ITEM_NUM_ITEMS "num-items"
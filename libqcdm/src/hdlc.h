@@ -0,0 +1,80 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of version 2 of the GNU General Public
+ * License as published by the Free Software Foundation
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBQCDM_HDLC_H
+#define LIBQCDM_HDLC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Async HDLC-like framing, shared by libqcdm and libwmc: frames are escaped
+ * so that the control character (0x7E) and the escape character (0x7D) never
+ * show up within them, and are protected with a CRC-16/X.25 (as in RFC 1662)
+ * sent little endian right before the trailing control character.
+ */
+
+#define HDLC_CONTROL_CHAR 0x7E
+#define HDLC_ESC_CHAR     0x7D
+#define HDLC_ESC_MASK     0x20
+
+/* Initial value of the running CRC */
+#define HDLC_CRC16_INIT 0xFFFF
+/* Value of the running CRC after a whole frame including its own CRC */
+#define HDLC_CRC16_GOOD 0xF0B8
+
+/* Updates a running CRC, without the final inversion */
+uint16_t hdlc_crc16_update (uint16_t crc,
+                            const char *buffer,
+                            size_t len);
+
+/* CRC of a buffer, using HDLC_CRC16_INIT if @seed is 0 */
+uint16_t hdlc_crc16 (const char *buffer,
+                     size_t len,
+                     uint16_t seed);
+
+size_t hdlc_escape (const char *inbuf,
+                    size_t inbuf_len,
+                    uint8_t escape_all_ctrl,
+                    char *outbuf,
+                    size_t outbuf_len);
+
+/* @outbuf may be @inbuf, to unescape in place */
+size_t hdlc_unescape (const char *inbuf,
+                      size_t inbuf_len,
+                      char *outbuf,
+                      size_t outbuf_len,
+                      uint8_t *escaping);
+
+size_t hdlc_encapsulate_buffer (char *inbuf,
+                                size_t cmd_len,
+                                size_t inbuf_len,
+                                uint16_t crc_seed,
+                                uint8_t add_trailer,
+                                uint8_t escape_all_ctrl,
+                                char *outbuf,
+                                size_t outbuf_len);
+
+/* @outbuf may be @inbuf, to decapsulate in place */
+uint8_t hdlc_decapsulate_buffer (const char *inbuf,
+                                 size_t inbuf_len,
+                                 uint8_t check_known_crc,
+                                 uint16_t known_crc,
+                                 char *outbuf,
+                                 size_t outbuf_len,
+                                 size_t *out_decap_len,
+                                 size_t *out_used,
+                                 uint8_t *out_need_more);
+
+#endif  /* LIBQCDM_HDLC_H */
@@ -20,6 +20,9 @@
 
 #include <stdint.h>
 
+/* Log codes carry the equipment ID they belong to in the upper 4 bits */
+#define DM_LOG_ITEM_EQUIP_ID(code) (((code) >> 12) & 0x0F)
+
 enum {
     /* CDMA and EVDO items */
     DM_LOG_ITEM_CDMA_ACCESS_CHANNEL_MSG         = 0x1004,
@@ -18,6 +18,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <endian.h>
+#include <stddef.h>
 
 #include "log-items.h"
 #include "logs.h"
@@ -66,6 +67,39 @@ check_log_item (const char *buf, size_t len, uint16_t log_code, size_t min_len,
 
 /**********************************************************************/
 
+qcdmbool
+qcdm_log_record_parse (const char *buf, size_t len, QcdmLogRecord *out_record)
+{
+    DMCmdLog *log_cmd = (DMCmdLog *) buf;
+    size_t log_len;
+
+    qcdm_return_val_if_fail (buf != NULL, FALSE);
+    qcdm_return_val_if_fail (out_record != NULL, FALSE);
+
+    if (len < sizeof (DMCmdLog) || buf[0] != DIAG_CMD_LOG)
+        return FALSE;
+
+    /* 'len' counts everything after itself */
+    log_len = le16toh (log_cmd->len) + offsetof (DMCmdLog, _unknown2);
+    if (log_len < sizeof (DMCmdLog) || log_len > len)
+        return FALSE;
+
+    out_record->log_code = le16toh (log_cmd->log_code);
+    out_record->timestamp = le64toh (log_cmd->timestamp);
+    out_record->payload = log_cmd->data;
+    out_record->payload_len = log_len - sizeof (DMCmdLog);
+    return TRUE;
+}
+
+uint64_t
+qcdm_log_timestamp_to_ms (uint64_t timestamp)
+{
+    /* 1.25ms units */
+    return ((timestamp >> 16) * 5) / 4;
+}
+
+/**********************************************************************/
+
 #define PILOT_SETS_LOG_ACTIVE_SET    "active-set"
 #define PILOT_SETS_LOG_CANDIDATE_SET "candidate-set"
 #define PILOT_SETS_LOG_REMAINING_SET  "remaining-set"
@@ -23,6 +23,25 @@
 
 /**********************************************************************/
 
+/* A log packet of any kind, pointing into the buffer it was parsed from */
+typedef struct {
+    uint16_t log_code;
+    /* Upper 48 bits: 1.25ms units since 1980-01-06 00:00:00 UTC;
+     * lower 16 bits: fraction of that unit in chips */
+    uint64_t timestamp;
+    const uint8_t *payload;
+    size_t payload_len;
+} QcdmLogRecord;
+
+qcdmbool    qcdm_log_record_parse       (const char *buf,
+                                         size_t len,
+                                         QcdmLogRecord *out_record);
+
+/* Milliseconds since 1980-01-06 00:00:00 UTC */
+uint64_t    qcdm_log_timestamp_to_ms    (uint64_t timestamp);
+
+/**********************************************************************/
+
 enum {
     QCDM_LOG_ITEM_EVDO_PILOT_SETS_V2_TYPE_UNKNOWN = 0,
     QCDM_LOG_ITEM_EVDO_PILOT_SETS_V2_TYPE_ACTIVE = 1,
@@ -22,6 +22,11 @@
 
 QcdmResult *qcdm_result_new (void);
 
+/* Keys are not copied, so they must be static strings (like the item names
+ * in commands.h); they're still looked up by content.  Values added for an
+ * existing key replace the previous one.  Pointers returned by the getters
+ * are only valid until the next value is added. */
+
 void qcdm_result_add_string (QcdmResult *result,
                              const char *key,
                              const char *str);
@@ -24,7 +24,15 @@
 
 /*********************************************************/
 
-typedef struct Val Val;
+/* A result is a single allocation holding a fixed table of values, indexed
+ * by a small open-addressing hash of their keys, plus an arena for strings
+ * and arrays.  The arena lives inline in the result and only moves to the
+ * heap if some command returns more data than fits in it.
+ */
+
+#define MAX_VALS        24
+#define INDEX_SIZE      32  /* power of 2, larger than MAX_VALS */
+#define INLINE_DATA_LEN 256
 
 typedef enum {
     VAL_TYPE_NONE = 0,
@@ -35,161 +43,145 @@ typedef enum {
     VAL_TYPE_U16_ARRAY = 5,
 } ValType;
 
-struct Val {
-    char *key;
+typedef struct {
+    /* Not copied, see result-private.h */
+    const char *key;
     uint8_t type;
     union {
-        char *s;
         uint8_t u8;
         uint32_t u32;
-        uint8_t *u8_array;
-        uint16_t *u16_array;
+        size_t offset;  /* of strings and arrays, in the data arena */
     } u;
     uint32_t array_len;
-    Val *next;
-};
+} Val;
 
-static void
-val_free (Val *v)
-{
-    if (v->type == VAL_TYPE_STRING) {
-        free (v->u.s);
-    } else if (v->type == VAL_TYPE_U8_ARRAY) {
-        free (v->u.u8_array);
-    } else if (v->type == VAL_TYPE_U16_ARRAY) {
-        free (v->u.u16_array);
-    }
-    free (v->key);
-    memset (v, 0, sizeof (*v));
-    free (v);
-}
+struct QcdmResult {
+    uint32_t refcount;
+    uint32_t n_vals;
+    /* Index into vals + 1 for each hash slot; 0 if empty */
+    uint8_t index[INDEX_SIZE];
+    Val vals[MAX_VALS];
+
+    uint8_t *data;
+    size_t data_len;
+    size_t data_alloc;
+    uint8_t inline_data[INLINE_DATA_LEN];
+};
 
-static Val *
-val_new_string (const char *key, const char *value)
+static uint32_t
+key_hash (const char *key)
 {
-    Val *v;
-
-    qcdm_return_val_if_fail (key != NULL, NULL);
-    qcdm_return_val_if_fail (key[0] != '\0', NULL);
-    qcdm_return_val_if_fail (value != NULL, NULL);
-
-    v = calloc (sizeof (Val), 1);
-    if (v == NULL)
-        return NULL;
+    uint32_t h = 2166136261u;
 
-    v->key = strdup (key);
-    v->type = VAL_TYPE_STRING;
-    v->u.s = strdup (value);
-    return v;
+    /* FNV-1a */
+    while (*key) {
+        h ^= (uint8_t) *key++;
+        h *= 16777619u;
+    }
+    return h;
 }
 
-static Val *
-val_new_u8 (const char *key, uint8_t u)
+/* Returns the hash slot either holding @key or where it should be added */
+static uint32_t
+find_slot (QcdmResult *r, const char *key)
 {
-    Val *v;
+    uint32_t slot;
 
-    qcdm_return_val_if_fail (key != NULL, NULL);
-    qcdm_return_val_if_fail (key[0] != '\0', NULL);
+    slot = key_hash (key) & (INDEX_SIZE - 1);
+    while (r->index[slot]) {
+        const char *k = r->vals[r->index[slot] - 1].key;
 
-    v = calloc (sizeof (Val), 1);
-    if (v == NULL)
-        return NULL;
-
-    v->key = strdup (key);
-    v->type = VAL_TYPE_U8;
-    v->u.u8 = u;
-    return v;
+        if (k == key || strcmp (k, key) == 0)
+            break;
+        slot = (slot + 1) & (INDEX_SIZE - 1);
+    }
+    return slot;
 }
 
-static Val *
-val_new_u8_array (const char *key, const uint8_t *array, size_t array_len)
+/* Reserves @len bytes in the data arena, aligned for any array type */
+static uint8_t *
+data_reserve (QcdmResult *r, size_t len, size_t *out_offset)
 {
-    Val *v;
-
-    qcdm_return_val_if_fail (key != NULL, NULL);
-    qcdm_return_val_if_fail (key[0] != '\0', NULL);
-    qcdm_return_val_if_fail (array != NULL, NULL);
-    qcdm_return_val_if_fail (array_len > 0, NULL);
-
-    v = calloc (sizeof (Val), 1);
-    if (v == NULL)
-        return NULL;
-
-    v->key = strdup (key);
-    v->type = VAL_TYPE_U8_ARRAY;
-    v->u.u8_array = malloc (array_len);
-    if (v->u.u8_array == NULL) {
-        val_free (v);
-        return NULL;
+    size_t offset;
+
+    offset = (r->data_len + sizeof (uint32_t) - 1) & ~(sizeof (uint32_t) - 1);
+    if (offset + len > r->data_alloc) {
+        size_t alloc;
+        uint8_t *data;
+
+        alloc = r->data_alloc * 2;
+        while (offset + len > alloc)
+            alloc *= 2;
+
+        if (r->data == r->inline_data) {
+            data = malloc (alloc);
+            if (data)
+                memcpy (data, r->inline_data, r->data_len);
+        } else
+            data = realloc (r->data, alloc);
+        if (data == NULL)
+            return NULL;
+
+        r->data = data;
+        r->data_alloc = alloc;
     }
-    memcpy (v->u.u8_array, array, array_len);
-    v->array_len = array_len;
 
-    return v;
+    r->data_len = offset + len;
+    *out_offset = offset;
+    return &r->data[offset];
 }
 
+/* Adds a new value for @key, replacing any previous one */
 static Val *
-val_new_u32 (const char *key, uint32_t u)
+add_val (QcdmResult *r, const char *key, ValType type)
 {
+    uint32_t slot;
     Val *v;
 
-    qcdm_return_val_if_fail (key != NULL, NULL);
     qcdm_return_val_if_fail (key[0] != '\0', NULL);
+    qcdm_return_val_if_fail (r->n_vals < MAX_VALS, NULL);
 
-    v = calloc (sizeof (Val), 1);
-    if (v == NULL)
-        return NULL;
-
-    v->key = strdup (key);
-    v->type = VAL_TYPE_U32;
-    v->u.u32 = u;
+    slot = find_slot (r, key);
+    v = &r->vals[r->n_vals++];
+    memset (v, 0, sizeof (*v));
+    v->key = key;
+    v->type = type;
+    r->index[slot] = r->n_vals;
     return v;
 }
 
 static Val *
-val_new_u16_array (const char *key, const uint16_t *array, size_t array_len)
+find_val (QcdmResult *r, const char *key, ValType expected_type)
 {
+    uint32_t slot;
     Val *v;
-    size_t sz;
-
-    qcdm_return_val_if_fail (key != NULL, NULL);
-    qcdm_return_val_if_fail (key[0] != '\0', NULL);
-    qcdm_return_val_if_fail (array != NULL, NULL);
-    qcdm_return_val_if_fail (array_len > 0, NULL);
 
-    v = calloc (sizeof (Val), 1);
-    if (v == NULL)
+    slot = find_slot (r, key);
+    if (!r->index[slot])
         return NULL;
 
-    v->key = strdup (key);
-    v->type = VAL_TYPE_U16_ARRAY;
-    sz = sizeof (uint16_t) * array_len;
-    v->u.u16_array = malloc (sz);
-    if (v->u.u16_array == NULL) {
-        val_free (v);
-        return NULL;
-    }
-    memcpy (v->u.u16_array, array, sz);
-    v->array_len = array_len;
-
+    v = &r->vals[r->index[slot] - 1];
+    /* Check type */
+    qcdm_return_val_if_fail (v->type == expected_type, NULL);
     return v;
 }
 
 /*********************************************************/
 
-struct QcdmResult {
-    uint32_t refcount;
-    Val *first;
-};
-
 QcdmResult *
 qcdm_result_new (void)
 {
     QcdmResult *r;
 
-    r = calloc (sizeof (QcdmResult), 1);
-    if (r)
+    r = malloc (sizeof (QcdmResult));
+    if (r) {
         r->refcount = 1;
+        r->n_vals = 0;
+        memset (r->index, 0, sizeof (r->index));
+        r->data = r->inline_data;
+        r->data_len = 0;
+        r->data_alloc = sizeof (r->inline_data);
+    }
     return r;
 }
 
@@ -206,15 +198,9 @@ qcdm_result_ref (QcdmResult *r)
 static void
 qcdm_result_free (QcdmResult *r)
 {
-    Val *v, *n;
-
-    v = r->first;
-    while (v) {
-        n = v->next;
-        val_free (v);
-        v = n;
-    }
-    memset (r, 0, sizeof (*r));
+    if (r->data != r->inline_data)
+        free (r->data);
+    r->refcount = 0;
     free (r);
 }
 
@@ -229,40 +215,28 @@ qcdm_result_unref (QcdmResult *r)
         qcdm_result_free (r);
 }
 
-static Val *
-find_val (QcdmResult *r, const char *key, ValType expected_type)
-{
-    Val *v, *n;
-
-    v = r->first;
-    while (v) {
-        n = v->next;
-        if (strcmp (v->key, key) == 0) {
-            /* Check type */
-            qcdm_return_val_if_fail (v->type == expected_type, NULL);
-            return v;
-        }
-        v = n;
-    }
-    return NULL;
-}
-
 void
 qcdm_result_add_string (QcdmResult *r,
                        const char *key,
                        const char *str)
 {
     Val *v;
+    uint8_t *data;
+    size_t len, offset;
 
     qcdm_return_if_fail (r != NULL);
     qcdm_return_if_fail (r->refcount > 0);
     qcdm_return_if_fail (key != NULL);
     qcdm_return_if_fail (str != NULL);
 
-    v = val_new_string (key, str);
+    len = strlen (str) + 1;
+    data = data_reserve (r, len, &offset);
+    qcdm_return_if_fail (data != NULL);
+    memcpy (data, str, len);
+
+    v = add_val (r, key, VAL_TYPE_STRING);
     qcdm_return_if_fail (v != NULL);
-    v->next = r->first;
-    r->first = v;
+    v->u.offset = offset;
 }
 
 int
@@ -282,7 +256,7 @@ qcdm_result_get_string (QcdmResult *r,
     if (v == NULL)
         return -QCDM_ERROR_VALUE_NOT_FOUND;
 
-    *out_val = v->u.s;
+    *out_val = (const char *) &r->data[v->u.offset];
     return 0;
 }
 
@@ -297,10 +271,9 @@ qcdm_result_add_u8 (QcdmResult *r,
     qcdm_return_if_fail (r->refcount > 0);
     qcdm_return_if_fail (key != NULL);
 
-    v = val_new_u8 (key, num);
+    v = add_val (r, key, VAL_TYPE_U8);
     qcdm_return_if_fail (v != NULL);
-    v->next = r->first;
-    r->first = v;
+    v->u.u8 = num;
 }
 
 int
@@ -330,17 +303,23 @@ qcdm_result_add_u8_array (QcdmResult *r,
                           size_t array_len)
 {
     Val *v;
+    uint8_t *data;
+    size_t offset;
 
     qcdm_return_if_fail (r != NULL);
     qcdm_return_if_fail (r->refcount > 0);
     qcdm_return_if_fail (key != NULL);
     qcdm_return_if_fail (array != NULL);
-    qcdm_return_if_fail (array_len >= 0);
+    qcdm_return_if_fail (array_len > 0);
+
+    data = data_reserve (r, array_len, &offset);
+    qcdm_return_if_fail (data != NULL);
+    memcpy (data, array, array_len);
 
-    v = val_new_u8_array (key, array, array_len);
+    v = add_val (r, key, VAL_TYPE_U8_ARRAY);
     qcdm_return_if_fail (v != NULL);
-    v->next = r->first;
-    r->first = v;
+    v->u.offset = offset;
+    v->array_len = array_len;
 }
 
 int
@@ -361,7 +340,7 @@ qcdm_result_get_u8_array (QcdmResult *r,
     if (v == NULL)
         return -QCDM_ERROR_VALUE_NOT_FOUND;
 
-    *out_val = v->u.u8_array;
+    *out_val = &r->data[v->u.offset];
     *out_len = v->array_len;
     return 0;
 }
@@ -377,10 +356,9 @@ qcdm_result_add_u32 (QcdmResult *r,
     qcdm_return_if_fail (r->refcount > 0);
     qcdm_return_if_fail (key != NULL);
 
-    v = val_new_u32 (key, num);
+    v = add_val (r, key, VAL_TYPE_U32);
     qcdm_return_if_fail (v != NULL);
-    v->next = r->first;
-    r->first = v;
+    v->u.u32 = num;
 }
 
 int
@@ -410,17 +388,24 @@ qcdm_result_add_u16_array (QcdmResult *r,
                            size_t array_len)
 {
     Val *v;
+    uint8_t *data;
+    size_t sz, offset;
 
     qcdm_return_if_fail (r != NULL);
     qcdm_return_if_fail (r->refcount > 0);
     qcdm_return_if_fail (key != NULL);
     qcdm_return_if_fail (array != NULL);
-    qcdm_return_if_fail (array_len >= 0);
+    qcdm_return_if_fail (array_len > 0);
+
+    sz = sizeof (uint16_t) * array_len;
+    data = data_reserve (r, sz, &offset);
+    qcdm_return_if_fail (data != NULL);
+    memcpy (data, array, sz);
 
-    v = val_new_u16_array (key, array, array_len);
+    v = add_val (r, key, VAL_TYPE_U16_ARRAY);
     qcdm_return_if_fail (v != NULL);
-    v->next = r->first;
-    r->first = v;
+    v->u.offset = offset;
+    v->array_len = array_len;
 }
 
 int
@@ -441,7 +426,7 @@ qcdm_result_get_u16_array (QcdmResult *r,
     if (v == NULL)
         return -QCDM_ERROR_VALUE_NOT_FOUND;
 
-    *out_val = v->u.u16_array;
+    *out_val = (const uint16_t *) &r->data[v->u.offset];
     *out_len = v->array_len;
     return 0;
 }
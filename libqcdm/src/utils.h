@@ -39,6 +39,7 @@ size_t dm_escape (const char *inbuf,
                   char *outbuf,
                   size_t outbuf_len);
 
+/* @outbuf may be @inbuf, to unescape in place */
 size_t dm_unescape (const char *inbuf,
                     size_t inbuf_len,
                     char *outbuf,
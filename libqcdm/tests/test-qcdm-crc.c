@@ -20,6 +20,7 @@
 
 #include "test-qcdm-crc.h"
 #include "utils.h"
+#include "hdlc.h"
 
 void
 test_crc16_2 (void *f, void *data)
@@ -63,3 +64,77 @@ test_crc16_1 (void *f, void *data)
     g_assert (crc == expected);
 }
 
+/* Bit-at-a-time CRC-16/X.25, as a reference for the table-driven one */
+static guint16
+reference_crc16 (const guint8 *buffer, gsize len)
+{
+    guint16 crc = 0xFFFF;
+    guint i;
+
+    while (len--) {
+        crc ^= *buffer++;
+        for (i = 0; i < 8; i++)
+            crc = (crc & 1) ? ((crc >> 1) ^ 0x8408) : (crc >> 1);
+    }
+    return ~crc;
+}
+
+void
+test_crc16_random (void *f, void *data)
+{
+    guint8 buf[1024 + 8];
+    guint i;
+
+    for (i = 0; i < sizeof (buf); i++)
+        buf[i] = (guint8) g_test_rand_int ();
+
+    /* Cover every alignment and every tail length of the 8-byte steps */
+    for (i = 0; i < 1000; i++) {
+        gsize offset;
+        gsize len;
+
+        offset = g_test_rand_int_range (0, 8);
+        len = g_test_rand_int_range (0, 1024);
+        g_assert_cmphex (dm_crc16 ((const char *) &buf[offset], len), ==,
+                         reference_crc16 (&buf[offset], len));
+    }
+}
+
+void
+test_crc16_residual (void *f, void *data)
+{
+    char buf[64];
+    guint16 crc;
+    guint i;
+
+    for (i = 0; i < sizeof (buf) - 2; i++)
+        buf[i] = (char) i;
+
+    /* Running the CRC over the data plus its own FCS yields the X.25 residual */
+    crc = dm_crc16 (buf, sizeof (buf) - 2);
+    buf[sizeof (buf) - 2] = crc & 0xFF;
+    buf[sizeof (buf) - 1] = (crc >> 8) & 0xFF;
+    g_assert_cmphex (hdlc_crc16_update (HDLC_CRC16_INIT, buf, sizeof (buf)), ==, HDLC_CRC16_GOOD);
+}
+
+void
+test_crc16_benchmark (void *f, void *data)
+{
+    static char buf[4096];
+    guint n_iterations = 20000;
+    guint16 crc = 0;
+    gdouble elapsed;
+    guint i;
+
+    for (i = 0; i < sizeof (buf); i++)
+        buf[i] = (char) g_test_rand_int ();
+
+    g_test_timer_start ();
+    for (i = 0; i < n_iterations; i++)
+        crc ^= dm_crc16 (buf, sizeof (buf));
+    elapsed = g_test_timer_elapsed ();
+
+    g_test_minimized_result (elapsed, "crc16: %.1lf MB/s (%04x)",
+                             (n_iterations * sizeof (buf)) / (elapsed * 1e6), crc);
+}
+
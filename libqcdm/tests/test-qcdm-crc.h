@@ -20,6 +20,9 @@
 
 void test_crc16_2 (void *f, void *data);
 void test_crc16_1 (void *f, void *data);
+void test_crc16_random (void *f, void *data);
+void test_crc16_residual (void *f, void *data);
+void test_crc16_benchmark (void *f, void *data);
 
 #endif  /* TEST_QCDM_CRC_H */
 
@@ -122,3 +122,141 @@ test_escape_unescape (void *f, void *data)
     g_assert (memcmp (unescaped, data1, unlen) == 0);
 }
 
+
+/* The original byte-by-byte implementation, as reference */
+static gsize
+reference_unescape (const char *inbuf,
+                    gsize inbuf_len,
+                    char *outbuf,
+                    gsize outbuf_len,
+                    qcdmbool *escaping)
+{
+    gsize i, outsize;
+
+    for (i = 0, outsize = 0; i < inbuf_len; i++) {
+        if (*escaping) {
+            outbuf[outsize++] = inbuf[i] ^ 0x20;
+            *escaping = FALSE;
+        } else if (inbuf[i] == 0x7d)
+            *escaping = TRUE;
+        else
+            outbuf[outsize++] = inbuf[i];
+
+        /* About to overrun output buffer size */
+        if (outsize >= outbuf_len)
+            return 0;
+    }
+
+    return outsize;
+}
+
+/* Random data with the given percentage of escape characters */
+static void
+fill_escaped (char *buf, gsize len, guint escape_pct)
+{
+    gsize i;
+
+    for (i = 0; i < len; i++) {
+        if ((guint) g_test_rand_int_range (0, 100) < escape_pct)
+            buf[i] = 0x7d;
+        else
+            buf[i] = (char) g_test_rand_int_range (0, 256);
+    }
+}
+
+void
+test_unescape_random (void *f, void *data)
+{
+    static const guint escape_pcts[] = { 0, 1, 10, 50, 100 };
+    char inbuf[512];
+    char expected[sizeof (inbuf) + 4];
+    char unescaped[sizeof (inbuf) + 4];
+    guint i;
+
+    for (i = 0; i < 2000; i++) {
+        gsize len, split, outbuf_len, expected_len, unescaped_len;
+        qcdmbool expected_escaping = FALSE;
+        qcdmbool escaping = FALSE;
+
+        len = g_test_rand_int_range (2, sizeof (inbuf) + 1);
+        fill_escaped (inbuf, len, escape_pcts[i % G_N_ELEMENTS (escape_pcts)]);
+
+        /* Two chunks, carrying the escaping state over, into an output buffer
+         * which sometimes gets filled up */
+        split = g_test_rand_int_range (1, len);
+        outbuf_len = len + g_test_rand_int_range (0, 4);
+
+        expected_len = reference_unescape (inbuf, split, expected, outbuf_len, &expected_escaping);
+        unescaped_len = dm_unescape (inbuf, split, unescaped, outbuf_len, &escaping);
+        g_assert_cmpuint (unescaped_len, ==, expected_len);
+        g_assert_cmpint (escaping, ==, expected_escaping);
+        if (!expected_len)
+            continue;
+        g_assert (memcmp (unescaped, expected, expected_len) == 0);
+
+        expected_len = reference_unescape (&inbuf[split], len - split, expected, outbuf_len, &expected_escaping);
+        unescaped_len = dm_unescape (&inbuf[split], len - split, unescaped, outbuf_len, &escaping);
+        g_assert_cmpuint (unescaped_len, ==, expected_len);
+        g_assert_cmpint (escaping, ==, expected_escaping);
+        g_assert (memcmp (unescaped, expected, expected_len) == 0);
+    }
+}
+
+void
+test_unescape_in_place (void *f, void *data)
+{
+    static const guint escape_pcts[] = { 0, 1, 10, 50, 100 };
+    char inbuf[512];
+    char expected[sizeof (inbuf)];
+    guint i;
+
+    for (i = 0; i < 2000; i++) {
+        gsize len, expected_len, unescaped_len;
+        qcdmbool expected_escaping = FALSE;
+        qcdmbool escaping = FALSE;
+
+        len = g_test_rand_int_range (1, sizeof (inbuf) + 1);
+        fill_escaped (inbuf, len, escape_pcts[i % G_N_ELEMENTS (escape_pcts)]);
+
+        expected_len = reference_unescape (inbuf, len, expected, len, &expected_escaping);
+        unescaped_len = dm_unescape (inbuf, len, inbuf, len, &escaping);
+        g_assert_cmpuint (unescaped_len, ==, expected_len);
+        g_assert_cmpint (escaping, ==, expected_escaping);
+        g_assert (memcmp (inbuf, expected, expected_len) == 0);
+    }
+}
+
+void
+test_decapsulate_in_place (void *f, void *data)
+{
+    static const guint escape_pcts[] = { 0, 1, 10, 50 };
+    char cmdbuf[256 + 2];
+    char encap[2 * sizeof (cmdbuf) + 1];
+    char decap[sizeof (encap)];
+    guint i;
+
+    for (i = 0; i < 500; i++) {
+        gsize cmd_len, encap_len;
+        gsize decap_len = 0, in_place_len = 0;
+        gsize used = 0, in_place_used = 0;
+        qcdmbool more = FALSE;
+
+        cmd_len = g_test_rand_int_range (1, sizeof (cmdbuf) - 1);
+        fill_escaped (cmdbuf, cmd_len, escape_pcts[i % G_N_ELEMENTS (escape_pcts)]);
+        encap_len = dm_encapsulate_buffer (cmdbuf, cmd_len, sizeof (cmdbuf), encap, sizeof (encap));
+        g_assert_cmpuint (encap_len, >, 0);
+
+        g_assert (dm_decapsulate_buffer (encap, encap_len, decap, sizeof (decap),
+                                         &decap_len, &used, &more));
+        g_assert (!more);
+        g_assert (dm_decapsulate_buffer (encap, encap_len, encap, encap_len,
+                                         &in_place_len, &in_place_used, &more));
+        g_assert (!more);
+
+        g_assert_cmpuint (in_place_len, ==, cmd_len);
+        g_assert_cmpuint (in_place_len, ==, decap_len);
+        g_assert_cmpuint (in_place_used, ==, used);
+        g_assert (memcmp (encap, cmdbuf, cmd_len) == 0);
+        g_assert (memcmp (decap, cmdbuf, cmd_len) == 0);
+    }
+}
@@ -0,0 +1,269 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of version 2 of the GNU General Public
+ * License as published by the Free Software Foundation
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <string.h>
+#include <stdlib.h>
+#include <endian.h>
+
+#include "test-qcdm-logs.h"
+#include "commands.h"
+#include "logs.h"
+#include "log-items.h"
+#include "dm-commands.h"
+#include "utils.h"
+
+static const uint16_t stream_codes[] = {
+    DM_LOG_ITEM_EVDO_PILOT_SETS_V2,
+    DM_LOG_ITEM_EVDO_AIR_LINK_SUMMARY,
+    DM_LOG_ITEM_CDMA_MARKOV_STATS,
+    DM_LOG_ITEM_WCDMA_AGC_INFO,
+};
+
+/*****************************************************************************/
+/* Synthetic log stream generator */
+
+/* Builds the unescaped log packet #@i, with @payload_len bytes of payload
+ * chosen to need escaping now and then. Returns the packet length. */
+static gsize
+build_log_packet (char *buf, guint i, gsize payload_len)
+{
+    DMCmdLog *log_cmd = (DMCmdLog *) buf;
+    gsize j;
+
+    memset (log_cmd, 0, sizeof (*log_cmd));
+    log_cmd->code = DIAG_CMD_LOG;
+    log_cmd->len = htole16 (sizeof (DMCmdLog) + payload_len - 4);
+    log_cmd->_unknown2 = log_cmd->len;
+    log_cmd->log_code = htole16 (stream_codes[i % G_N_ELEMENTS (stream_codes)]);
+    log_cmd->timestamp = htole64 (((guint64) i << 16) | (i & 0xFFFF));
+    for (j = 0; j < payload_len; j++)
+        log_cmd->data[j] = (uint8_t) (i + j * 7);
+
+    return sizeof (DMCmdLog) + payload_len;
+}
+
+/* Writes @n_records framed log packets back to back into @buf, like a modem
+ * streaming logs would. Returns the number of bytes written. */
+static gsize
+generate_log_stream (char *buf, gsize len, guint n_records, gsize payload_len)
+{
+    char packet[sizeof (DMCmdLog) + 512 + DIAG_TRAILER_LEN];
+    gsize written = 0;
+    guint i;
+
+    g_assert (payload_len <= 512);
+
+    for (i = 0; i < n_records; i++) {
+        gsize packet_len;
+        gsize encap_len;
+
+        packet_len = build_log_packet (packet, i, payload_len);
+        encap_len = dm_encapsulate_buffer (packet, packet_len, sizeof (packet),
+                                           buf + written, len - written);
+        g_assert_cmpuint (encap_len, >, 0);
+        written += encap_len;
+    }
+    return written;
+}
+
+/* Deframes and parses every record in @stream; returns the number found
+ * and the sum of their payload lengths in @out_payload_bytes. */
+static guint
+consume_log_stream (const char *stream,
+                    gsize stream_len,
+                    gboolean check,
+                    gsize *out_payload_bytes)
+{
+    char decap[1024];
+    const char *start = stream;
+    const char *end = stream + stream_len;
+    gsize payload_bytes = 0;
+    guint n = 0;
+
+    while (start < end) {
+        const char *marker;
+        gsize decap_len = 0;
+        gsize used = 0;
+        qcdmbool more = FALSE;
+        QcdmLogRecord record;
+
+        marker = memchr (start, DIAG_CONTROL_CHAR, end - start);
+        g_assert (marker);
+
+        g_assert (dm_decapsulate_buffer (start, marker - start + 1,
+                                         decap, sizeof (decap),
+                                         &decap_len, &used, &more));
+        g_assert (!more);
+        g_assert (qcdm_log_record_parse (decap, decap_len, &record));
+
+        if (check) {
+            g_assert_cmpuint (record.log_code, ==, stream_codes[n % G_N_ELEMENTS (stream_codes)]);
+            g_assert_cmpuint (record.timestamp >> 16, ==, n);
+            g_assert_cmpuint (record.payload[1], ==, (uint8_t) (n + 7));
+        }
+
+        payload_bytes += record.payload_len;
+        n++;
+        start = marker + 1;
+    }
+
+    if (out_payload_bytes)
+        *out_payload_bytes = payload_bytes;
+    return n;
+}
+
+/*****************************************************************************/
+
+static guint
+count_mask_bits (const uint8_t *mask, gsize len)
+{
+    guint n = 0;
+    gsize i;
+
+    for (i = 0; i < len; i++) {
+        uint8_t b;
+
+        for (b = mask[i]; b; b &= b - 1)
+            n++;
+    }
+    return n;
+}
+
+void
+test_logs_mask_codes (void *f, void *data)
+{
+    static const uint16_t codes[] = {
+        DM_LOG_ITEM_EVDO_PILOT_SETS_V2,
+        DM_LOG_ITEM_WCDMA_AGC_INFO,
+        DM_LOG_ITEM_EVDO_AIR_LINK_SUMMARY,
+    };
+    char buf[600];
+    char decap[600];
+    gsize len;
+    gsize decap_len = 0;
+    gsize used = 0;
+    qcdmbool more = FALSE;
+    DMCmdLogConfig *cmd;
+
+    g_assert_cmpuint (qcdm_log_codes_get_equip_ids (codes, G_N_ELEMENTS (codes)), ==,
+                      (1 << 1) | (1 << 4));
+
+    len = qcdm_cmd_log_config_set_mask_codes_new (buf, sizeof (buf), 1, codes, G_N_ELEMENTS (codes));
+    g_assert_cmpuint (len, >, 0);
+    g_assert (dm_decapsulate_buffer (buf, len, decap, sizeof (decap), &decap_len, &used, &more));
+
+    /* The mask must have room for the highest item, and only for it */
+    cmd = (DMCmdLogConfig *) decap;
+    g_assert_cmpuint (decap_len, ==, sizeof (DMCmdLogConfig) + (0x08B / 8) + 1);
+    g_assert_cmpuint (cmd->code, ==, DIAG_CMD_LOG_CONFIG);
+    g_assert_cmpuint (le32toh (cmd->op), ==, DIAG_CMD_LOG_CONFIG_OP_SET_MASK);
+    g_assert_cmpuint (le32toh (cmd->equipid), ==, 1);
+    g_assert_cmpuint (le32toh (cmd->num_items), ==, 0x08B);
+    g_assert (cmd->mask[0x08B / 8] & (1 << (0x08B % 8)));
+    g_assert (cmd->mask[0x068 / 8] & (1 << (0x068 % 8)));
+    /* WCDMA AGC info belongs to equipment ID 4 */
+    g_assert_cmpuint (count_mask_bits (cmd->mask, decap_len - sizeof (DMCmdLogConfig)), ==, 2);
+
+    len = qcdm_cmd_log_config_set_mask_codes_new (buf, sizeof (buf), 4, codes, G_N_ELEMENTS (codes));
+    g_assert_cmpuint (len, >, 0);
+    g_assert (dm_decapsulate_buffer (buf, len, decap, sizeof (decap), &decap_len, &used, &more));
+    cmd = (DMCmdLogConfig *) decap;
+    g_assert_cmpuint (le32toh (cmd->equipid), ==, 4);
+    g_assert_cmpuint (le32toh (cmd->num_items), ==, 0x105);
+    g_assert (cmd->mask[0x105 / 8] & (1 << (0x105 % 8)));
+    g_assert_cmpuint (count_mask_bits (cmd->mask, decap_len - sizeof (DMCmdLogConfig)), ==, 1);
+}
+
+void
+test_logs_record_parse (void *f, void *data)
+{
+    char packet[sizeof (DMCmdLog) + 32];
+    QcdmLogRecord record;
+    gsize len;
+
+    len = build_log_packet (packet, 3, 32);
+    g_assert (qcdm_log_record_parse (packet, len, &record));
+    g_assert_cmpuint (record.log_code, ==, DM_LOG_ITEM_WCDMA_AGC_INFO);
+    g_assert_cmpuint (record.timestamp, ==, (3 << 16) | 3);
+    g_assert_cmpuint (record.payload_len, ==, 32);
+    g_assert ((const char *) record.payload == packet + sizeof (DMCmdLog));
+
+    /* 1.25ms units */
+    g_assert_cmpuint (qcdm_log_timestamp_to_ms ((guint64) 800 << 16), ==, 1000);
+
+    /* Trailing bytes beyond the packet length are not part of the payload */
+    len = build_log_packet (packet, 0, 16);
+    g_assert (qcdm_log_record_parse (packet, sizeof (packet), &record));
+    g_assert_cmpuint (record.payload_len, ==, 16);
+}
+
+void
+test_logs_record_invalid (void *f, void *data)
+{
+    char packet[sizeof (DMCmdLog) + 32];
+    QcdmLogRecord record;
+    gsize len;
+
+    /* Truncated */
+    len = build_log_packet (packet, 0, 32);
+    g_assert (!qcdm_log_record_parse (packet, len - 1, &record));
+    g_assert (!qcdm_log_record_parse (packet, sizeof (DMCmdLog) - 1, &record));
+
+    /* Length shorter than the header */
+    ((DMCmdLog *) packet)->len = htole16 (4);
+    g_assert (!qcdm_log_record_parse (packet, len, &record));
+
+    /* Not a log packet */
+    len = build_log_packet (packet, 0, 32);
+    packet[0] = DIAG_CMD_VERSION_INFO;
+    g_assert (!qcdm_log_record_parse (packet, len, &record));
+}
+
+void
+test_logs_stream (void *f, void *data)
+{
+    static char stream[200 * 2 * (sizeof (DMCmdLog) + 64 + DIAG_TRAILER_LEN)];
+    gsize stream_len;
+    gsize payload_bytes = 0;
+
+    stream_len = generate_log_stream (stream, sizeof (stream), 200, 64);
+    g_assert_cmpuint (consume_log_stream (stream, stream_len, TRUE, &payload_bytes), ==, 200);
+    g_assert_cmpuint (payload_bytes, ==, 200 * 64);
+}
+
+void
+test_logs_stream_benchmark (void *f, void *data)
+{
+    static char stream[2000 * 2 * (sizeof (DMCmdLog) + 128 + DIAG_TRAILER_LEN)];
+    gsize stream_len;
+    gsize payload_bytes = 0;
+    guint n_iterations = 200;
+    guint n_records = 0;
+    gdouble elapsed;
+    guint i;
+
+    stream_len = generate_log_stream (stream, sizeof (stream), 2000, 128);
+
+    g_test_timer_start ();
+    for (i = 0; i < n_iterations; i++)
+        n_records += consume_log_stream (stream, stream_len, FALSE, &payload_bytes);
+    elapsed = g_test_timer_elapsed ();
+
+    g_assert_cmpuint (n_records, ==, 2000 * n_iterations);
+    g_test_minimized_result (elapsed, "log stream: %.0lf records/s, %.1lf MB/s",
+                             n_records / elapsed,
+                             (n_iterations * stream_len) / (elapsed * 1e6));
+}
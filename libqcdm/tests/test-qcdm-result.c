@@ -17,10 +17,12 @@
 
 #include <glib.h>
 #include <string.h>
+#include <stdlib.h>
 
 #include "test-qcdm-result.h"
 #include "result.h"
 #include "result-private.h"
+#include "errors.h"
 
 #define TEST_TAG "test"
 
@@ -90,3 +92,196 @@ test_result_uint8_array (void *f, void *data)
 
     qcdm_result_unref (result);
 }
+
+static const char *many_keys[] = {
+    "call-state", "operating-mode", "system-mode", "mode-pref", "band-pref",
+    "roam-pref", "service-domain-pref", "acq-order-pref", "hybrid-pref",
+    "network-selection-pref", "esn", "model", "comp-date", "comp-time",
+    "release-date", "release-time", "at-state", "session-state", "almp-state",
+    "init-state"
+};
+
+void
+test_result_many_values (void *f, void *data)
+{
+    QcdmResult *result;
+    guint32 missing = 0;
+    guint i;
+
+    result = qcdm_result_new ();
+    for (i = 0; i < G_N_ELEMENTS (many_keys); i++) {
+        if (i % 3 == 0)
+            qcdm_result_add_u32 (result, many_keys[i], 0x10000 + i);
+        else if (i % 3 == 1)
+            qcdm_result_add_u8 (result, many_keys[i], i);
+        else
+            qcdm_result_add_string (result, many_keys[i], many_keys[i]);
+    }
+
+    for (i = 0; i < G_N_ELEMENTS (many_keys); i++) {
+        /* Lookups are by content, not by pointer */
+        gchar *key = g_strdup (many_keys[i]);
+
+        if (i % 3 == 0) {
+            guint32 tmp = 0;
+
+            g_assert_cmpint (qcdm_result_get_u32 (result, key, &tmp), ==, 0);
+            g_assert_cmpuint (tmp, ==, 0x10000 + i);
+        } else if (i % 3 == 1) {
+            guint8 tmp = 0;
+
+            g_assert_cmpint (qcdm_result_get_u8 (result, key, &tmp), ==, 0);
+            g_assert_cmpuint (tmp, ==, i);
+        } else {
+            const char *tmp = NULL;
+
+            g_assert_cmpint (qcdm_result_get_string (result, key, &tmp), ==, 0);
+            g_assert_cmpstr (tmp, ==, many_keys[i]);
+        }
+        g_free (key);
+    }
+
+    g_assert_cmpint (qcdm_result_get_u32 (result, "not-there", &missing), ==, -QCDM_ERROR_VALUE_NOT_FOUND);
+
+    qcdm_result_unref (result);
+}
+
+void
+test_result_replace (void *f, void *data)
+{
+    guint32 tmp = 0;
+    QcdmResult *result;
+
+    result = qcdm_result_new ();
+    qcdm_result_add_u32 (result, TEST_TAG, 1);
+    qcdm_result_add_u32 (result, TEST_TAG, 2);
+
+    /* Latest value wins */
+    qcdm_result_get_u32 (result, TEST_TAG, &tmp);
+    g_assert_cmpuint (tmp, ==, 2);
+
+    qcdm_result_unref (result);
+}
+
+void
+test_result_large_data (void *f, void *data)
+{
+    guint16 items[1000];
+    const guint16 *tmp_items = NULL;
+    const char *tmp_str = NULL;
+    const guint8 *tmp_array = NULL;
+    gsize tmp_len = 0;
+    QcdmResult *result;
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (items); i++)
+        items[i] = i * 7;
+
+    /* Enough data to not fit in the result itself */
+    result = qcdm_result_new ();
+    qcdm_result_add_string (result, "str", "foobarblahblahblah");
+    qcdm_result_add_u8_array (result, "array", (const guint8 *) "\x01\x02\x03", 3);
+    qcdm_result_add_u16_array (result, "items", items, G_N_ELEMENTS (items));
+
+    g_assert_cmpint (qcdm_result_get_string (result, "str", &tmp_str), ==, 0);
+    g_assert_cmpstr (tmp_str, ==, "foobarblahblahblah");
+    g_assert_cmpint (qcdm_result_get_u8_array (result, "array", &tmp_array, &tmp_len), ==, 0);
+    g_assert_cmpuint (tmp_len, ==, 3);
+    g_assert (memcmp (tmp_array, "\x01\x02\x03", 3) == 0);
+    g_assert_cmpint (qcdm_result_get_u16_array (result, "items", &tmp_items, &tmp_len), ==, 0);
+    g_assert_cmpuint (tmp_len, ==, G_N_ELEMENTS (items));
+    g_assert (memcmp (tmp_items, items, sizeof (items)) == 0);
+
+    qcdm_result_unref (result);
+}
+
+/*****************************************************************************/
+/* Allocation counting, only available with glibc */
+
+#if defined (__GLIBC__)
+
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+static gboolean counting;
+static guint n_allocs;
+
+void *
+malloc (size_t size)
+{
+    if (counting)
+        n_allocs++;
+    return __libc_malloc (size);
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+    if (counting)
+        n_allocs++;
+    return __libc_calloc (nmemb, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+    if (counting)
+        n_allocs++;
+    return __libc_realloc (ptr, size);
+}
+
+#define ALLOC_COUNT_START() G_STMT_START { n_allocs = 0; counting = TRUE; } G_STMT_END
+#define ALLOC_COUNT_STOP()  G_STMT_START { counting = FALSE; } G_STMT_END
+
+#else
+
+static guint n_allocs;
+
+#define ALLOC_COUNT_START()
+#define ALLOC_COUNT_STOP()
+
+#endif
+
+/* Builds and reads back a result like the one of the CM subsystem state
+ * info, polled periodically */
+static void
+build_and_read_state_info (void)
+{
+    QcdmResult *result;
+    const char *tmp_str = NULL;
+    guint32 tmp = 0;
+    guint i;
+
+    result = qcdm_result_new ();
+    for (i = 0; i < 10; i++)
+        qcdm_result_add_u32 (result, many_keys[i], i);
+    qcdm_result_add_string (result, many_keys[10], "0x12345678");
+
+    for (i = 0; i < 10; i++)
+        qcdm_result_get_u32 (result, many_keys[i], &tmp);
+    qcdm_result_get_string (result, many_keys[10], &tmp_str);
+
+    qcdm_result_unref (result);
+}
+
+void
+test_result_benchmark (void *f, void *data)
+{
+    guint n_iterations = 200000;
+    gdouble elapsed;
+    guint i;
+
+    ALLOC_COUNT_START ();
+    build_and_read_state_info ();
+    ALLOC_COUNT_STOP ();
+
+    g_test_timer_start ();
+    for (i = 0; i < n_iterations; i++)
+        build_and_read_state_info ();
+    elapsed = g_test_timer_elapsed ();
+
+    g_test_minimized_result (elapsed, "result: %.1lf ns per result, %u allocations",
+                             (elapsed * 1e9) / n_iterations, n_allocs);
+}
+
@@ -104,3 +104,96 @@ test_utils_decapsulate_sierra_cns (void *f, void *data)
     g_assert (success == FALSE);
 }
 
+/* Typical log packet payload: mostly plain data with the odd byte needing
+ * to be escaped */
+static void
+fill_frame_payload (char *buf, gsize len)
+{
+    gsize i;
+
+    for (i = 0; i < len; i++) {
+        buf[i] = (char) g_test_rand_int ();
+        if (g_test_rand_int_range (0, 64) == 0)
+            buf[i] = g_test_rand_bit () ? DIAG_CONTROL_CHAR : 0x7D;
+    }
+}
+
+void
+test_utils_framing_roundtrip (void *f, void *data)
+{
+    char cmdbuf[512 + 2];
+    char encap[2 * sizeof (cmdbuf) + 1];
+    char decap[sizeof (cmdbuf) + 1];
+    guint i;
+
+    for (i = 0; i < 200; i++) {
+        gsize cmd_len;
+        gsize encap_len;
+        gsize decap_len = 0;
+        gsize used = 0;
+        qcdmbool more = FALSE;
+        char orig[sizeof (cmdbuf)];
+        gint pos;
+
+        cmd_len = g_test_rand_int_range (1, sizeof (cmdbuf) - 2);
+        fill_frame_payload (cmdbuf, cmd_len);
+        memcpy (orig, cmdbuf, cmd_len);
+
+        encap_len = dm_encapsulate_buffer (cmdbuf, cmd_len, sizeof (cmdbuf), encap, sizeof (encap));
+        g_assert_cmpuint (encap_len, >, cmd_len);
+        g_assert (memchr (encap, DIAG_CONTROL_CHAR, encap_len - 1) == NULL);
+        g_assert (encap[encap_len - 1] == DIAG_CONTROL_CHAR);
+
+        g_assert (dm_decapsulate_buffer (encap, encap_len, decap, sizeof (decap),
+                                         &decap_len, &used, &more));
+        g_assert (more == FALSE);
+        g_assert_cmpuint (used, ==, encap_len);
+        g_assert_cmpuint (decap_len, ==, cmd_len);
+        g_assert (memcmp (decap, orig, cmd_len) == 0);
+
+        /* A single flipped bit in a plain payload byte must fail the CRC check */
+        pos = g_test_rand_int_range (0, encap_len - 1);
+        encap[pos] ^= 0x01;
+        if (encap[pos] != DIAG_CONTROL_CHAR && encap[pos] != 0x7D &&
+            encap[pos] != (0x7D ^ 0x01) && (pos == 0 || encap[pos - 1] != 0x7D))
+            g_assert (!dm_decapsulate_buffer (encap, encap_len, decap, sizeof (decap),
+                                              &decap_len, &used, &more));
+    }
+}
+
+void
+test_utils_framing_benchmark (void *f, void *data)
+{
+    static char cmdbuf[2048 + 2];
+    static char encap[2 * sizeof (cmdbuf) + 1];
+    static char decap[sizeof (encap)];
+    gsize cmd_len = sizeof (cmdbuf) - 2;
+    gsize encap_len = 0;
+    guint n_iterations = 10000;
+    gdouble elapsed;
+    guint i;
+
+    fill_frame_payload (cmdbuf, cmd_len);
+
+    g_test_timer_start ();
+    for (i = 0; i < n_iterations; i++)
+        encap_len = dm_encapsulate_buffer (cmdbuf, cmd_len, sizeof (cmdbuf), encap, sizeof (encap));
+    elapsed = g_test_timer_elapsed ();
+    g_assert_cmpuint (encap_len, >, cmd_len);
+    g_test_minimized_result (elapsed, "encode: %.1lf MB/s",
+                             (n_iterations * cmd_len) / (elapsed * 1e6));
+
+    g_test_timer_start ();
+    for (i = 0; i < n_iterations; i++) {
+        gsize decap_len = 0;
+        gsize used = 0;
+        qcdmbool more = FALSE;
+
+        g_assert (dm_decapsulate_buffer (encap, encap_len, decap, sizeof (decap),
+                                         &decap_len, &used, &more));
+    }
+    elapsed = g_test_timer_elapsed ();
+    g_test_minimized_result (elapsed, "decode: %.1lf MB/s",
+                             (n_iterations * encap_len) / (elapsed * 1e6));
+}
+
@@ -24,5 +24,9 @@ void test_utils_encapsulate_buffer (void *f, void *data);
 
 void test_utils_decapsulate_sierra_cns (void *f, void *data);
 
+void test_utils_framing_roundtrip (void *f, void *data);
+
+void test_utils_framing_benchmark (void *f, void *data);
+
 #endif  /* TEST_QCDM_UTILS_H */
 
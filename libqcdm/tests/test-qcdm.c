@@ -22,6 +22,7 @@
 #include "test-qcdm-escaping.h"
 #include "test-qcdm-com.h"
 #include "test-qcdm-result.h"
+#include "test-qcdm-logs.h"
 #include "test-qcdm-utils.h"
 
 typedef struct {
@@ -80,16 +81,36 @@ int main (int argc, char **argv)
 
     g_test_suite_add (suite, TESTCASE (test_crc16_1, NULL));
     g_test_suite_add (suite, TESTCASE (test_crc16_2, NULL));
+    g_test_suite_add (suite, TESTCASE (test_crc16_random, NULL));
+    g_test_suite_add (suite, TESTCASE (test_crc16_residual, NULL));
     g_test_suite_add (suite, TESTCASE (test_escape1, NULL));
     g_test_suite_add (suite, TESTCASE (test_escape2, NULL));
     g_test_suite_add (suite, TESTCASE (test_escape_unescape, NULL));
+    g_test_suite_add (suite, TESTCASE (test_unescape_random, NULL));
+    g_test_suite_add (suite, TESTCASE (test_unescape_in_place, NULL));
+    g_test_suite_add (suite, TESTCASE (test_decapsulate_in_place, NULL));
     g_test_suite_add (suite, TESTCASE (test_utils_decapsulate_buffer, NULL));
     g_test_suite_add (suite, TESTCASE (test_utils_encapsulate_buffer, NULL));
     g_test_suite_add (suite, TESTCASE (test_utils_decapsulate_sierra_cns, NULL));
+    g_test_suite_add (suite, TESTCASE (test_utils_framing_roundtrip, NULL));
     g_test_suite_add (suite, TESTCASE (test_result_string, NULL));
     g_test_suite_add (suite, TESTCASE (test_result_uint32, NULL));
     g_test_suite_add (suite, TESTCASE (test_result_uint8, NULL));
     g_test_suite_add (suite, TESTCASE (test_result_uint8_array, NULL));
+    g_test_suite_add (suite, TESTCASE (test_result_many_values, NULL));
+    g_test_suite_add (suite, TESTCASE (test_result_replace, NULL));
+    g_test_suite_add (suite, TESTCASE (test_result_large_data, NULL));
+    g_test_suite_add (suite, TESTCASE (test_logs_mask_codes, NULL));
+    g_test_suite_add (suite, TESTCASE (test_logs_record_parse, NULL));
+    g_test_suite_add (suite, TESTCASE (test_logs_record_invalid, NULL));
+    g_test_suite_add (suite, TESTCASE (test_logs_stream, NULL));
+
+    if (g_test_perf ()) {
+        g_test_suite_add (suite, TESTCASE (test_crc16_benchmark, NULL));
+        g_test_suite_add (suite, TESTCASE (test_utils_framing_benchmark, NULL));
+        g_test_suite_add (suite, TESTCASE (test_result_benchmark, NULL));
+        g_test_suite_add (suite, TESTCASE (test_logs_stream_benchmark, NULL));
+    }
 
     /* Live tests */
     if (port) {
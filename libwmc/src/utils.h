@@ -20,6 +20,8 @@
 
 #include <stdint.h>
 
+#include "hdlc.h"
+
 typedef uint8_t wmcbool;
 #ifndef TRUE
 #define TRUE ((uint8_t) 1)
@@ -35,37 +37,6 @@ typedef uint8_t wmcbool;
 
 uint16_t wmc_crc16 (const char *buffer, size_t len, uint16_t seed);
 
-size_t hdlc_escape (const char *inbuf,
-                    size_t inbuf_len,
-                    wmcbool escape_all_ctrl,
-                    char *outbuf,
-                    size_t outbuf_len);
-
-size_t hdlc_unescape (const char *inbuf,
-                      size_t inbuf_len,
-                      char *outbuf,
-                      size_t outbuf_len,
-                      wmcbool *escaping);
-
-size_t hdlc_encapsulate_buffer (char *inbuf,
-                                size_t cmd_len,
-                                size_t inbuf_len,
-                                uint16_t crc_seed,
-                                wmcbool add_trailer,
-                                wmcbool escape_all_ctrl,
-                                char *outbuf,
-                                size_t outbuf_len);
-
-wmcbool hdlc_decapsulate_buffer (const char *inbuf,
-                                 size_t inbuf_len,
-                                 wmcbool check_known_crc,
-                                 uint16_t known_crc,
-                                 char *outbuf,
-                                 size_t outbuf_len,
-                                 size_t *out_decap_len,
-                                 size_t *out_used,
-                                 wmcbool *out_need_more);
-
 /* Functions for actual communication */
 
 size_t wmc_encapsulate (char *inbuf,
@@ -67,7 +67,7 @@ create_modem (MMPlugin *self,
 
 /*****************************************************************************/
 G_MODULE_EXPORT MMPlugin *
-mm_plugin_create (void)
+MM_PLUGIN_CREATE (altair_lte) (void)
 {
     static const gchar *subsystems[] = { "tty", "net", NULL };
     static const mm_uint16_pair products[] = {
@@ -43,6 +43,6 @@ typedef struct {
 
 GType mm_plugin_altair_lte_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (altair_lte) (void);
 
 #endif /* MM_PLUGIN_ALTAIR_LTE_H */
@@ -66,7 +66,7 @@ create_modem (MMPlugin *self,
 /*****************************************************************************/
 
 G_MODULE_EXPORT MMPlugin *
-mm_plugin_create (void)
+MM_PLUGIN_CREATE (anydata) (void)
 {
     static const gchar *subsystems[] = { "tty", "net", "usb", NULL };
     static const guint16 vendor_ids[] = { 0x16d5, 0 };
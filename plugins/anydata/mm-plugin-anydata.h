@@ -38,6 +38,6 @@ typedef struct {
 
 GType mm_plugin_anydata_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (anydata) (void);
 
 #endif /* MM_PLUGIN_ANYDATA_H */
@@ -172,7 +172,7 @@ grab_port (MMPlugin *self,
 /*****************************************************************************/
 
 G_MODULE_EXPORT MMPlugin *
-mm_plugin_create (void)
+MM_PLUGIN_CREATE (cinterion) (void)
 {
     static const gchar *subsystems[] = { "tty", "net", "usb", NULL };
     static const gchar *vendor_strings[] = { "cinterion", "siemens", NULL };
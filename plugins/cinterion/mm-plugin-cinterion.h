@@ -42,6 +42,6 @@ typedef struct {
 
 GType mm_plugin_cinterion_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (cinterion) (void);
 
 #endif /* MM_PLUGIN_CINTERION_H */
@@ -467,7 +467,7 @@ grab_port (MMPlugin *self,
 /*****************************************************************************/
 
 G_MODULE_EXPORT MMPlugin *
-mm_plugin_create (void)
+MM_PLUGIN_CREATE (dell) (void)
 {
     static const gchar *subsystems[] = { "tty", "net", "usb", NULL };
     static const guint16 vendors[] = { 0x413c, 0 };
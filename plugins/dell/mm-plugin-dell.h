@@ -41,6 +41,6 @@ typedef struct {
 
 GType mm_plugin_dell_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (dell) (void);
 
 #endif /* MM_PLUGIN_DELL_H */
@@ -35,6 +35,6 @@ typedef struct {
 
 GType mm_plugin_generic_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (generic) (void);
 
 #endif /* MM_PLUGIN_GENERIC_H */
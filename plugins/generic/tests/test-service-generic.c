@@ -77,6 +77,333 @@ test_enable_disable (TestFixture *fixture)
     g_free (ports[0]);
 }
 
+static gdouble
+connect_disconnect (MMBearer *bearer)
+{
+    GError *error = NULL;
+    GTimer *timer;
+    gdouble elapsed;
+
+    timer = g_timer_new ();
+    mm_bearer_connect_sync (bearer, NULL, &error);
+    g_assert_no_error (error);
+    elapsed = g_timer_elapsed (timer, NULL);
+    g_timer_destroy (timer);
+
+    mm_bearer_disconnect_sync (bearer, NULL, &error);
+    g_assert_no_error (error);
+
+    return elapsed;
+}
+
+static void
+test_reconnect (TestFixture *fixture)
+{
+    GError *error = NULL;
+    MMObject *obj;
+    MMModem *modem;
+    MMBearerProperties *properties;
+    MMBearer *bearer;
+    TestPortContext *port0;
+    gchar *ports [] = { NULL, NULL };
+    gdouble first;
+    gdouble second;
+
+    ports[0] = g_strdup_printf ("abstract:port0:%ld", (glong) getpid ());
+
+    /* No context defined initially, so the first connection needs to look for
+     * a free CID and define it */
+    port0 = test_port_context_new (ports[0]);
+    test_port_context_load_commands (port0, COMMON_GSM_PORT_CONF);
+    test_port_context_set_command (port0, "AT+CGDCONT?", "\r\nOK\r\n");
+    test_port_context_set_command (port0, "AT+CGDCONT=1,\"IP\",\"internet\"", "\r\nOK\r\n");
+    test_port_context_set_command (port0, "ATD*99***1#", "\r\nCONNECT\r\n");
+    test_port_context_set_command (port0, "AT+CGACT=0,1", "\r\nOK\r\n");
+    test_port_context_start (port0);
+
+    test_fixture_no_modem (fixture);
+    test_fixture_set_profile (fixture,
+                              "test-reconnect",
+                              "Generic",
+                              (const gchar *const *)ports);
+    obj = test_fixture_get_modem (fixture);
+
+    modem = mm_object_get_modem (obj);
+    g_assert (modem != NULL);
+    mm_modem_enable_sync (modem, NULL, &error);
+    g_assert_no_error (error);
+
+    properties = mm_bearer_properties_new ();
+    mm_bearer_properties_set_apn (properties, "internet");
+    mm_bearer_properties_set_ip_type (properties, MM_BEARER_IP_FAMILY_IPV4);
+    bearer = mm_modem_create_bearer_sync (modem, properties, NULL, &error);
+    g_assert_no_error (error);
+    g_object_unref (properties);
+
+    /* Emulate the latency of a real modem from now on */
+    test_port_context_set_delay (port0, 50);
+
+    first = connect_disconnect (bearer);
+    g_assert_cmpuint (test_port_context_get_command_count (port0, "AT+CGDCONT?"), ==, 1);
+    g_assert_cmpuint (test_port_context_get_command_count (port0, "AT+CGDCONT=1,\"IP\",\"internet\""), ==, 1);
+
+    /* Reconnecting with the same settings dials right away, the context
+     * defined in the first attempt is already known */
+    second = connect_disconnect (bearer);
+    g_assert_cmpuint (test_port_context_get_command_count (port0, "AT+CGDCONT?"), ==, 1);
+    g_assert_cmpuint (test_port_context_get_command_count (port0, "AT+CGDCONT=1,\"IP\",\"internet\""), ==, 1);
+    g_assert_cmpuint (test_port_context_get_command_count (port0, "ATD*99***1#"), ==, 2);
+
+    /* Timings depend on the load of the machine running the test, so they're
+     * only reported */
+    if (g_test_perf ())
+        g_test_message ("connection time: %.3fs first, %.3fs reconnecting", first, second);
+
+    test_port_context_set_delay (port0, 0);
+
+    mm_modem_disable_sync (modem, NULL, &error);
+    g_assert_no_error (error);
+
+    g_object_unref (bearer);
+    g_object_unref (modem);
+    g_object_unref (obj);
+
+    test_port_context_stop (port0);
+    test_port_context_free (port0);
+
+    g_free (ports[0]);
+}
+
+static gboolean
+wait_timeout_cb (GMainLoop *loop)
+{
+    g_assert_not_reached ();
+    return G_SOURCE_REMOVE;
+}
+
+static void
+bearer_connected_updated (MMBearer *bearer,
+                          GParamSpec *pspec,
+                          GMainLoop *loop)
+{
+    g_main_loop_quit (loop);
+}
+
+/* Property updates are received after the method replies, so wait for them */
+static void
+wait_bearer_connected (MMBearer *bearer,
+                       gboolean connected)
+{
+    GMainLoop *loop;
+    guint timeout_id;
+    gulong handler_id;
+
+    loop = g_main_loop_new (NULL, FALSE);
+    handler_id = g_signal_connect (bearer,
+                                   "notify::connected",
+                                   G_CALLBACK (bearer_connected_updated),
+                                   loop);
+    timeout_id = g_timeout_add_seconds (10, (GSourceFunc) wait_timeout_cb, loop);
+    while (!mm_bearer_get_connected (bearer) != !connected)
+        g_main_loop_run (loop);
+    g_source_remove (timeout_id);
+    g_signal_handler_disconnect (bearer, handler_id);
+    g_main_loop_unref (loop);
+}
+
+static void
+test_cgev_disconnect (TestFixture *fixture)
+{
+    GError *error = NULL;
+    MMObject *obj;
+    MMModem *modem;
+    MMBearerProperties *properties;
+    MMBearer *bearer;
+    TestPortContext *port_contexts[2];
+    gchar *ports [] = { NULL, NULL, NULL };
+    guint i;
+
+    /* The first port is the primary one and the second the data port, so
+     * that unsolicited messages are received while connected */
+    for (i = 0; i < G_N_ELEMENTS (port_contexts); i++) {
+        ports[i] = g_strdup_printf ("abstract:port%u:%ld", i, (glong) getpid ());
+        port_contexts[i] = test_port_context_new (ports[i]);
+        test_port_context_load_commands (port_contexts[i], COMMON_GSM_PORT_CONF);
+        test_port_context_set_command (port_contexts[i], "AT+CGEREP=2", "\r\nOK\r\n");
+        test_port_context_set_command (port_contexts[i], "AT+CGEREP=0", "\r\nOK\r\n");
+        test_port_context_set_command (port_contexts[i], "AT+CGDCONT?", "\r\n+CGDCONT: 1,\"IP\",\"internet\",\"\",0,0\r\n\r\nOK\r\n");
+        test_port_context_set_command (port_contexts[i], "ATD*99***1#", "\r\nCONNECT\r\n");
+        test_port_context_set_command (port_contexts[i], "AT+CGACT=0,1", "\r\nOK\r\n");
+        test_port_context_start (port_contexts[i]);
+    }
+
+    test_fixture_no_modem (fixture);
+    test_fixture_set_profile (fixture,
+                              "test-cgev-disconnect",
+                              "Generic",
+                              (const gchar *const *)ports);
+    obj = test_fixture_get_modem (fixture);
+
+    modem = mm_object_get_modem (obj);
+    g_assert (modem != NULL);
+    mm_modem_enable_sync (modem, NULL, &error);
+    g_assert_no_error (error);
+
+    properties = mm_bearer_properties_new ();
+    mm_bearer_properties_set_apn (properties, "internet");
+    mm_bearer_properties_set_ip_type (properties, MM_BEARER_IP_FAMILY_IPV4);
+    bearer = mm_modem_create_bearer_sync (modem, properties, NULL, &error);
+    g_assert_no_error (error);
+    g_object_unref (properties);
+
+    mm_bearer_connect_sync (bearer, NULL, &error);
+    g_assert_no_error (error);
+    wait_bearer_connected (bearer, TRUE);
+
+    /* The network deactivating the context disconnects the bearer */
+    test_port_context_send_unsolicited (port_contexts[0], "\r\n+CGEV: NW PDN DEACT 1\r\n");
+    wait_bearer_connected (bearer, FALSE);
+
+    /* Events were enabled, so the context status was never polled */
+    for (i = 0; i < G_N_ELEMENTS (port_contexts); i++)
+        g_assert_cmpuint (test_port_context_get_command_count (port_contexts[i], "AT+CGACT?"), ==, 0);
+
+    mm_modem_disable_sync (modem, NULL, &error);
+    g_assert_no_error (error);
+
+    g_object_unref (bearer);
+    g_object_unref (modem);
+    g_object_unref (obj);
+
+    for (i = 0; i < G_N_ELEMENTS (port_contexts); i++) {
+        test_port_context_stop (port_contexts[i]);
+        test_port_context_free (port_contexts[i]);
+        g_free (ports[i]);
+    }
+}
+
+typedef struct {
+    GMainLoop *loop;
+    guint n_pending;
+} ConnectContext;
+
+static void
+bearer_connect_ready (MMBearer *bearer,
+                      GAsyncResult *res,
+                      ConnectContext *ctx)
+{
+    GError *error = NULL;
+
+    mm_bearer_connect_finish (bearer, res, &error);
+    g_assert_no_error (error);
+
+    if (--ctx->n_pending == 0)
+        g_main_loop_quit (ctx->loop);
+}
+
+static void
+test_concurrent_connect (TestFixture *fixture)
+{
+    GError *error = NULL;
+    MMObject *obj;
+    MMModem *modem;
+    MMBearerProperties *properties;
+    MMBearer *bearers[2];
+    TestPortContext *port_contexts[3];
+    gchar *ports [] = { NULL, NULL, NULL, NULL };
+    ConnectContext ctx;
+    guint timeout_id;
+    guint i;
+
+    /* One primary port and two data ports. No context defined initially, so
+     * both bearers need to look for a free CID and define it. */
+    for (i = 0; i < G_N_ELEMENTS (port_contexts); i++) {
+        ports[i] = g_strdup_printf ("abstract:port%u:%ld", i, (glong) getpid ());
+        port_contexts[i] = test_port_context_new (ports[i]);
+        test_port_context_load_commands (port_contexts[i], COMMON_GSM_PORT_CONF);
+        test_port_context_set_command (port_contexts[i], "AT+CGDCONT?", "\r\nOK\r\n");
+        test_port_context_set_command (port_contexts[i], "AT+CGDCONT=1,\"IP\",\"internet\"", "\r\nOK\r\n");
+        test_port_context_set_command (port_contexts[i], "AT+CGDCONT=2,\"IP\",\"internet\"", "\r\nOK\r\n");
+        test_port_context_set_command (port_contexts[i], "ATD*99***1#", "\r\nCONNECT\r\n");
+        test_port_context_set_command (port_contexts[i], "ATD*99***2#", "\r\nCONNECT\r\n");
+        test_port_context_set_command (port_contexts[i], "AT+CGACT=0,1", "\r\nOK\r\n");
+        test_port_context_set_command (port_contexts[i], "AT+CGACT=0,2", "\r\nOK\r\n");
+        test_port_context_start (port_contexts[i]);
+    }
+
+    test_fixture_no_modem (fixture);
+    test_fixture_set_profile (fixture,
+                              "test-concurrent-connect",
+                              "Generic",
+                              (const gchar *const *)ports);
+    obj = test_fixture_get_modem (fixture);
+
+    modem = mm_object_get_modem (obj);
+    g_assert (modem != NULL);
+    mm_modem_enable_sync (modem, NULL, &error);
+    g_assert_no_error (error);
+
+    properties = mm_bearer_properties_new ();
+    mm_bearer_properties_set_apn (properties, "internet");
+    mm_bearer_properties_set_ip_type (properties, MM_BEARER_IP_FAMILY_IPV4);
+    for (i = 0; i < G_N_ELEMENTS (bearers); i++) {
+        bearers[i] = mm_modem_create_bearer_sync (modem, properties, NULL, &error);
+        g_assert_no_error (error);
+    }
+    g_object_unref (properties);
+
+    /* Emulate the latency of a real modem, so that both connection attempts
+     * overlap */
+    for (i = 0; i < G_N_ELEMENTS (port_contexts); i++)
+        test_port_context_set_delay (port_contexts[i], 50);
+
+    ctx.loop = g_main_loop_new (NULL, FALSE);
+    ctx.n_pending = G_N_ELEMENTS (bearers);
+    timeout_id = g_timeout_add_seconds (10, (GSourceFunc) wait_timeout_cb, ctx.loop);
+    for (i = 0; i < G_N_ELEMENTS (bearers); i++)
+        mm_bearer_connect (bearers[i], NULL, (GAsyncReadyCallback) bearer_connect_ready, &ctx);
+    g_main_loop_run (ctx.loop);
+    g_source_remove (timeout_id);
+    g_main_loop_unref (ctx.loop);
+
+    /* Each bearer got its own data port... */
+    wait_bearer_connected (bearers[0], TRUE);
+    wait_bearer_connected (bearers[1], TRUE);
+    g_assert_cmpstr (mm_bearer_get_interface (bearers[0]), !=, mm_bearer_get_interface (bearers[1]));
+
+    /* ...and its own context, defined in the primary port and dialed in each
+     * of the data ports */
+    g_assert_cmpuint (test_port_context_get_command_count (port_contexts[0], "AT+CGDCONT=1,\"IP\",\"internet\""), ==, 1);
+    g_assert_cmpuint (test_port_context_get_command_count (port_contexts[0], "AT+CGDCONT=2,\"IP\",\"internet\""), ==, 1);
+    for (i = 1; i < G_N_ELEMENTS (port_contexts); i++)
+        g_assert_cmpuint (test_port_context_get_command_count (port_contexts[i], "ATD*99***1#") +
+                          test_port_context_get_command_count (port_contexts[i], "ATD*99***2#"), ==, 1);
+    g_assert_cmpuint (test_port_context_get_command_count (port_contexts[1], "ATD*99***1#") +
+                      test_port_context_get_command_count (port_contexts[2], "ATD*99***1#"), ==, 1);
+
+    for (i = 0; i < G_N_ELEMENTS (port_contexts); i++)
+        test_port_context_set_delay (port_contexts[i], 0);
+
+    for (i = 0; i < G_N_ELEMENTS (bearers); i++) {
+        mm_bearer_disconnect_sync (bearers[i], NULL, &error);
+        g_assert_no_error (error);
+    }
+
+    mm_modem_disable_sync (modem, NULL, &error);
+    g_assert_no_error (error);
+
+    for (i = 0; i < G_N_ELEMENTS (bearers); i++)
+        g_object_unref (bearers[i]);
+    g_object_unref (modem);
+    g_object_unref (obj);
+
+    for (i = 0; i < G_N_ELEMENTS (port_contexts); i++) {
+        test_port_context_stop (port_contexts[i]);
+        test_port_context_free (port_contexts[i]);
+        g_free (ports[i]);
+    }
+}
+
 /*****************************************************************************/
 
 int main (int   argc,
@@ -84,7 +411,10 @@ int main (int   argc,
 {
     g_test_init (&argc, &argv, NULL);
 
-    TEST_ADD ("/MM/Service/Generic/enable-disable", test_enable_disable);
+    TEST_ADD ("/MM/Service/Generic/enable-disable",     test_enable_disable);
+    TEST_ADD ("/MM/Service/Generic/reconnect",          test_reconnect);
+    TEST_ADD ("/MM/Service/Generic/cgev-disconnect",    test_cgev_disconnect);
+    TEST_ADD ("/MM/Service/Generic/concurrent-connect", test_concurrent_connect);
 
     return g_test_run ();
 }
@@ -75,7 +75,7 @@ grab_port (MMPlugin *self,
 /*****************************************************************************/
 
 G_MODULE_EXPORT MMPlugin *
-mm_plugin_create (void)
+MM_PLUGIN_CREATE (haier) (void)
 {
     static const gchar *subsystems[] = { "tty", NULL };
     static const guint16 vendor_ids[] = { 0x201e, 0 };
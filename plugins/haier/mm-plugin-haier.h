@@ -35,6 +35,6 @@ typedef struct {
 
 GType mm_plugin_haier_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (haier) (void);
 
 #endif /* MM_PLUGIN_HAIER_H */
@@ -42,6 +42,6 @@ typedef struct {
 
 GType mm_plugin_iridium_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (iridium) (void);
 
 #endif /* MM_PLUGIN_IRIDIUM_H */
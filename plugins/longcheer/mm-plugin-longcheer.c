@@ -241,7 +241,7 @@ grab_port (MMPlugin *self,
 /*****************************************************************************/
 
 G_MODULE_EXPORT MMPlugin *
-mm_plugin_create (void)
+MM_PLUGIN_CREATE (longcheer) (void)
 {
     static const gchar *subsystems[] = { "tty", NULL };
     /* Vendors: Longcheer and TAMobile */
@@ -370,6 +370,16 @@ authenticate (GTask *task)
                                                                                g_strdup (user));
         encoded_password = mm_broadband_modem_take_and_convert_to_current_charset (MM_BROADBAND_MODEM (ctx->modem),
                                                                                    g_strdup (password));
+        if ((user && !encoded_user) || (password && !encoded_password)) {
+            g_free (encoded_user);
+            g_free (encoded_password);
+            g_task_return_new_error (task,
+                                     MM_CORE_ERROR,
+                                     MM_CORE_ERROR_UNSUPPORTED,
+                                     "Couldn't convert user or password to current charset");
+            g_object_unref (task);
+            return;
+        }
 
         command = g_strdup_printf ("AT*EIAAUW=%d,1,\"%s\",\"%s\"",
                                    ctx->cid,
@@ -95,7 +95,7 @@ grab_port (MMPlugin *self,
 /*****************************************************************************/
 
 G_MODULE_EXPORT MMPlugin *
-mm_plugin_create (void)
+MM_PLUGIN_CREATE (ericsson_mbm) (void)
 {
     static const gchar *subsystems[] = { "tty", "net", "usb", NULL };
     static const gchar *udev_tags[] = {
@@ -38,6 +38,6 @@ typedef struct {
 
 GType mm_plugin_mbm_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (ericsson_mbm) (void);
 
 #endif /* MM_PLUGIN_MBM_H */
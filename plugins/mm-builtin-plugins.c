@@ -0,0 +1,86 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ */
+
+#include "mm-plugin.h"
+
+/*****************************************************************************/
+/* Creators of all plugins linked into the daemon */
+
+MMPlugin *MM_PLUGIN_CREATE (altair_lte)    (void);
+MMPlugin *MM_PLUGIN_CREATE (anydata)       (void);
+MMPlugin *MM_PLUGIN_CREATE (cinterion)     (void);
+MMPlugin *MM_PLUGIN_CREATE (dell)          (void);
+MMPlugin *MM_PLUGIN_CREATE (ericsson_mbm)  (void);
+MMPlugin *MM_PLUGIN_CREATE (generic)       (void);
+MMPlugin *MM_PLUGIN_CREATE (haier)         (void);
+MMPlugin *MM_PLUGIN_CREATE (huawei)        (void);
+MMPlugin *MM_PLUGIN_CREATE (iridium)       (void);
+MMPlugin *MM_PLUGIN_CREATE (linktop)       (void);
+MMPlugin *MM_PLUGIN_CREATE (longcheer)     (void);
+MMPlugin *MM_PLUGIN_CREATE (motorola)      (void);
+MMPlugin *MM_PLUGIN_CREATE (mtk)           (void);
+MMPlugin *MM_PLUGIN_CREATE (nokia)         (void);
+MMPlugin *MM_PLUGIN_CREATE (nokia_icera)   (void);
+MMPlugin *MM_PLUGIN_CREATE (novatel)       (void);
+MMPlugin *MM_PLUGIN_CREATE (novatel_lte)   (void);
+MMPlugin *MM_PLUGIN_CREATE (option)        (void);
+MMPlugin *MM_PLUGIN_CREATE (option_hso)    (void);
+MMPlugin *MM_PLUGIN_CREATE (pantech)       (void);
+MMPlugin *MM_PLUGIN_CREATE (quectel)       (void);
+MMPlugin *MM_PLUGIN_CREATE (samsung)       (void);
+MMPlugin *MM_PLUGIN_CREATE (sierra)        (void);
+MMPlugin *MM_PLUGIN_CREATE (sierra_legacy) (void);
+MMPlugin *MM_PLUGIN_CREATE (simtech)       (void);
+MMPlugin *MM_PLUGIN_CREATE (telit)         (void);
+MMPlugin *MM_PLUGIN_CREATE (thuraya)       (void);
+MMPlugin *MM_PLUGIN_CREATE (ublox)         (void);
+MMPlugin *MM_PLUGIN_CREATE (via)           (void);
+MMPlugin *MM_PLUGIN_CREATE (wavecom)       (void);
+MMPlugin *MM_PLUGIN_CREATE (x22x)          (void);
+MMPlugin *MM_PLUGIN_CREATE (zte)           (void);
+
+const MMPluginCreateFunc mm_builtin_plugins[] = {
+    MM_PLUGIN_CREATE (altair_lte),
+    MM_PLUGIN_CREATE (anydata),
+    MM_PLUGIN_CREATE (cinterion),
+    MM_PLUGIN_CREATE (dell),
+    MM_PLUGIN_CREATE (ericsson_mbm),
+    MM_PLUGIN_CREATE (generic),
+    MM_PLUGIN_CREATE (haier),
+    MM_PLUGIN_CREATE (huawei),
+    MM_PLUGIN_CREATE (iridium),
+    MM_PLUGIN_CREATE (linktop),
+    MM_PLUGIN_CREATE (longcheer),
+    MM_PLUGIN_CREATE (motorola),
+    MM_PLUGIN_CREATE (mtk),
+    MM_PLUGIN_CREATE (nokia),
+    MM_PLUGIN_CREATE (nokia_icera),
+    MM_PLUGIN_CREATE (novatel),
+    MM_PLUGIN_CREATE (novatel_lte),
+    MM_PLUGIN_CREATE (option),
+    MM_PLUGIN_CREATE (option_hso),
+    MM_PLUGIN_CREATE (pantech),
+    MM_PLUGIN_CREATE (quectel),
+    MM_PLUGIN_CREATE (samsung),
+    MM_PLUGIN_CREATE (sierra),
+    MM_PLUGIN_CREATE (sierra_legacy),
+    MM_PLUGIN_CREATE (simtech),
+    MM_PLUGIN_CREATE (telit),
+    MM_PLUGIN_CREATE (thuraya),
+    MM_PLUGIN_CREATE (ublox),
+    MM_PLUGIN_CREATE (via),
+    MM_PLUGIN_CREATE (wavecom),
+    MM_PLUGIN_CREATE (x22x),
+    MM_PLUGIN_CREATE (zte),
+    NULL
+};
@@ -51,7 +51,7 @@ create_modem (MMPlugin *self,
 /*****************************************************************************/
 
 G_MODULE_EXPORT MMPlugin *
-mm_plugin_create (void)
+MM_PLUGIN_CREATE (motorola) (void)
 {
     static const gchar *subsystems[] = { "tty", NULL };
     static const mm_uint16_pair product_ids[] = {
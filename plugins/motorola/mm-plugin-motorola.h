@@ -37,6 +37,6 @@ typedef struct {
 
 GType mm_plugin_motorola_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (motorola) (void);
 
 #endif /* MM_PLUGIN_MOTOROLA_H */
@@ -86,7 +86,7 @@ grab_port (MMPlugin *self,
 /*****************************************************************************/
 
 G_MODULE_EXPORT MMPlugin *
-mm_plugin_create (void)
+MM_PLUGIN_CREATE (mtk) (void)
 {
     static const gchar *subsystems[] = { "tty", NULL };
     static const gchar *udev_tags[]={
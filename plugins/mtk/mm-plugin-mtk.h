@@ -37,6 +37,6 @@ typedef struct {
 
 GType mm_plugin_mtk_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (mtk) (void);
 
 #endif /* MM_PLUGIN_MTK_H */
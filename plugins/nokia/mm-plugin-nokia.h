@@ -36,6 +36,6 @@ typedef struct {
 
 GType mm_plugin_nokia_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (nokia) (void);
 
 #endif /* MM_PLUGIN_NOKIA_H */
@@ -42,6 +42,6 @@ typedef struct {
 
 GType mm_plugin_novatel_lte_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (novatel_lte) (void);
 
 #endif /* MM_PLUGIN_NOVATEL_LTE_H */
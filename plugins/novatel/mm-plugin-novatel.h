@@ -43,6 +43,6 @@ typedef struct {
 
 GType mm_plugin_novatel_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (novatel) (void);
 
 #endif /* MM_PLUGIN_NOVATEL_H */
@@ -165,7 +165,7 @@ grab_port (MMPlugin *self,
 /*****************************************************************************/
 
 G_MODULE_EXPORT MMPlugin *
-mm_plugin_create (void)
+MM_PLUGIN_CREATE (option_hso) (void)
 {
     static const gchar *subsystems[] = { "tty", "net", NULL };
     static const gchar *drivers[] = { "hso", NULL };
@@ -35,6 +35,6 @@ typedef struct {
 
 GType mm_plugin_quectel_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (quectel) (void);
 
 #endif /* MM_PLUGIN_QUECTEL_H */
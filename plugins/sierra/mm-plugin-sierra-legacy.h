@@ -35,6 +35,6 @@ typedef struct {
 
 GType mm_plugin_sierra_legacy_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (sierra_legacy) (void);
 
 #endif /* MM_PLUGIN_SIERRA_LEGACY_H */
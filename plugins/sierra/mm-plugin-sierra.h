@@ -37,6 +37,6 @@ typedef struct {
 
 GType mm_plugin_sierra_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (sierra) (void);
 
 #endif /* MM_PLUGIN_SIERRA_H */
@@ -37,6 +37,6 @@ typedef struct {
 
 GType mm_plugin_simtech_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (simtech) (void);
 
 #endif /* MM_PLUGIN_SIMTECH_H */
@@ -85,7 +85,7 @@ create_modem (MMPlugin *self,
 /*****************************************************************************/
 
 G_MODULE_EXPORT MMPlugin *
-mm_plugin_create (void)
+MM_PLUGIN_CREATE (telit) (void)
 {
     static const gchar *subsystems[] = { "tty", "net", "usb", NULL };
     /* Vendors: Telit */
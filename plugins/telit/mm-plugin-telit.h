@@ -37,6 +37,6 @@ typedef struct {
 
 GType mm_plugin_telit_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (telit) (void);
 
 #endif /* MM_PLUGIN_TELIT_H */
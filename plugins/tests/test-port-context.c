@@ -33,6 +33,10 @@ struct _TestPortContext {
     GSocketService *socket_service;
     GList *clients;
     GHashTable *commands;
+    /* Accessed from both the test and the port context threads */
+    gint delay;
+    GMutex received_mutex;
+    GHashTable *received;
 };
 
 /*****************************************************************************/
@@ -92,6 +96,25 @@ test_port_context_load_commands (TestPortContext *self,
     g_free (contents);
 }
 
+void
+test_port_context_set_delay (TestPortContext *self,
+                             guint delay_ms)
+{
+    g_atomic_int_set (&self->delay, (gint) delay_ms);
+}
+
+guint
+test_port_context_get_command_count (TestPortContext *self,
+                                     const gchar *command)
+{
+    guint count;
+
+    g_mutex_lock (&self->received_mutex);
+    count = GPOINTER_TO_UINT (g_hash_table_lookup (self->received, command));
+    g_mutex_unlock (&self->received_mutex);
+    return count;
+}
+
 static const gchar *
 process_next_command (TestPortContext *ctx,
                       GByteArray *buffer)
@@ -114,7 +137,13 @@ process_next_command (TestPortContext *ctx,
     /* Setup command and lookup response */
     command = g_strndup ((gchar *)buffer->data, i);
     response = g_hash_table_lookup (ctx->commands, command);
-    g_free (command);
+
+    /* Keep track of the received commands; the table takes the command */
+    g_mutex_lock (&ctx->received_mutex);
+    g_hash_table_replace (ctx->received,
+                          command,
+                          GUINT_TO_POINTER (GPOINTER_TO_UINT (g_hash_table_lookup (ctx->received, command)) + 1));
+    g_mutex_unlock (&ctx->received_mutex);
 
     /* Remove command from buffer */
     g_byte_array_remove_range (buffer, 0, i);
@@ -159,6 +188,12 @@ client_parse_request (Client *client)
         response = process_next_command (client->ctx, client->buffer);
         if (response) {
             GError *error = NULL;
+            guint delay;
+
+            /* Emulate the time a real modem takes to reply */
+            delay = (guint) g_atomic_int_get (&client->ctx->delay);
+            if (delay > 0)
+                g_usleep (delay * 1000);
 
             if (!g_output_stream_write_all (g_io_stream_get_output_stream (G_IO_STREAM (client->connection)),
                                             response,
@@ -242,6 +277,53 @@ client_new (TestPortContext *self,
     return client;
 }
 
+/*****************************************************************************/
+
+typedef struct {
+    TestPortContext *ctx;
+    gchar *message;
+} UnsolicitedContext;
+
+static gboolean
+send_unsolicited_cb (UnsolicitedContext *unsolicited)
+{
+    GList *l;
+
+    for (l = unsolicited->ctx->clients; l; l = g_list_next (l)) {
+        Client *client = l->data;
+        GError *error = NULL;
+
+        if (!g_output_stream_write_all (g_io_stream_get_output_stream (G_IO_STREAM (client->connection)),
+                                        unsolicited->message,
+                                        strlen (unsolicited->message),
+                                        NULL, /* bytes_written */
+                                        NULL, /* cancellable */
+                                        &error)) {
+            g_warning ("Cannot send unsolicited message to client: %s", error->message);
+            g_error_free (error);
+        }
+    }
+
+    g_free (unsolicited->message);
+    g_slice_free (UnsolicitedContext, unsolicited);
+    return G_SOURCE_REMOVE;
+}
+
+void
+test_port_context_send_unsolicited (TestPortContext *self,
+                                    const gchar *message)
+{
+    UnsolicitedContext *unsolicited;
+
+    g_assert (self->context != NULL);
+
+    /* Clients are only accessed from the port context thread */
+    unsolicited = g_slice_new (UnsolicitedContext);
+    unsolicited->ctx = self;
+    unsolicited->message = g_strcompress (message);
+    g_main_context_invoke (self->context, (GSourceFunc) send_unsolicited_cb, unsolicited);
+}
+
 /* /\*****************************************************************************\/ */
 
 static void
@@ -387,6 +469,8 @@ test_port_context_free (TestPortContext *self)
 
     g_cond_clear (&self->ready_cond);
     g_mutex_clear (&self->ready_mutex);
+    g_mutex_clear (&self->received_mutex);
+    g_hash_table_unref (self->received);
 
     if (self->commands)
         g_hash_table_unref (self->commands);
@@ -418,5 +502,7 @@ test_port_context_new (const gchar *name)
     self->name = g_strdup (name);
     g_cond_init (&self->ready_cond);
     g_mutex_init (&self->ready_mutex);
+    g_mutex_init (&self->received_mutex);
+    self->received = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
     return self;
 }
@@ -32,4 +32,14 @@ void             test_port_context_set_command   (TestPortContext *self,
 void             test_port_context_load_commands (TestPortContext *self,
                                                   const gchar *commands_file);
 
+/* Time to wait before sending each response, 0 by default */
+void             test_port_context_set_delay         (TestPortContext *self,
+                                                      guint delay_ms);
+/* Number of times the given command has been received */
+guint            test_port_context_get_command_count (TestPortContext *self,
+                                                      const gchar *command);
+/* Send an unsolicited message to all connected clients */
+void             test_port_context_send_unsolicited  (TestPortContext *self,
+                                                      const gchar *message);
+
 #endif /* TEST_PORT_CONTEXT_H */
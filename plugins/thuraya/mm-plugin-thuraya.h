@@ -43,6 +43,6 @@ typedef struct {
 
 GType mm_plugin_thuraya_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (thuraya) (void);
 
 #endif /* MM_PLUGIN_THURAYA_H */
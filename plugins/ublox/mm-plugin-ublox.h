@@ -35,6 +35,6 @@ typedef struct {
 
 GType mm_plugin_ublox_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (ublox) (void);
 
 #endif /* MM_PLUGIN_UBLOX_H */
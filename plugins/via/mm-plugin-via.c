@@ -53,7 +53,7 @@ create_modem (MMPlugin *self,
 /*****************************************************************************/
 
 G_MODULE_EXPORT MMPlugin *
-mm_plugin_create (void)
+MM_PLUGIN_CREATE (via) (void)
 {
     static const gchar *subsystems[] = { "tty", NULL };
     static const mm_str_pair product_strings[] = { { "via",    "cbp7" },
@@ -41,6 +41,6 @@ typedef struct {
 
 GType mm_plugin_via_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (via) (void);
 
 #endif /* MM_PLUGIN_VIA_H */
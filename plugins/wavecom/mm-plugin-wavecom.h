@@ -44,6 +44,6 @@ typedef struct {
 
 GType mm_plugin_wavecom_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (wavecom) (void);
 
 #endif /* MM_PLUGIN_WAVECOM_H */
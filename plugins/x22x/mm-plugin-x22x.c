@@ -253,7 +253,7 @@ grab_port (MMPlugin *self,
 /*****************************************************************************/
 
 G_MODULE_EXPORT MMPlugin *
-mm_plugin_create (void)
+MM_PLUGIN_CREATE (x22x) (void)
 {
     static const gchar *subsystems[] = { "tty", "net", "usb", NULL };
     /* Vendors: TAMobile and Olivetti */
@@ -37,6 +37,6 @@ typedef struct {
 
 GType mm_plugin_x22x_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (x22x) (void);
 
 #endif /* MM_PLUGIN_X22X_H */
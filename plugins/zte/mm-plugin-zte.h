@@ -37,6 +37,6 @@ typedef struct {
 
 GType mm_plugin_zte_get_type (void);
 
-G_MODULE_EXPORT MMPlugin *mm_plugin_create (void);
+G_MODULE_EXPORT MMPlugin *MM_PLUGIN_CREATE (zte) (void);
 
 #endif /* MM_PLUGIN_ZTE_H */
@@ -27,11 +27,23 @@
 #include "mm-log.h"
 #include "mm-kernel-device-generic-rules.h"
 
+/* Minimum number of consecutive rules required to build an index segment */
+#define SEGMENT_MIN_RULES 8
+
 static void
 udev_rule_match_clear (MMUdevRuleMatch *rule_match)
 {
     g_free (rule_match->parameter);
     g_free (rule_match->value);
+    g_free (rule_match->property);
+    g_free (rule_match->prefix_value);
+}
+
+static void
+udev_rule_segment_free (MMUdevRuleSegment *segment)
+{
+    g_hash_table_unref (segment->index);
+    g_slice_free (MMUdevRuleSegment, segment);
 }
 
 static void
@@ -53,6 +65,8 @@ udev_rule_clear (MMUdevRule *rule)
 
     if (rule->conditions)
         g_array_unref (rule->conditions);
+    if (rule->segment)
+        udev_rule_segment_free (rule->segment);
 }
 
 static gboolean
@@ -154,6 +168,16 @@ load_rule_result (MMUdevRuleResult  *rule_result,
         rule_result->content.property.name = g_strndup (left + 4, left_len - 5);
         rule_result->content.property.value = right;
         right = NULL;
+
+        /* Values read from interface attributes */
+        if (g_str_equal (rule_result->content.property.value, "$attr{bInterfaceClass}"))
+            rule_result->content.property.value_attribute = MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_CLASS;
+        else if (g_str_equal (rule_result->content.property.value, "$attr{bInterfaceSubClass}"))
+            rule_result->content.property.value_attribute = MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_SUBCLASS;
+        else if (g_str_equal (rule_result->content.property.value, "$attr{bInterfaceProtocol}"))
+            rule_result->content.property.value_attribute = MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_PROTOCOL;
+        else if (g_str_equal (rule_result->content.property.value, "$attr{bInterfaceNumber}"))
+            rule_result->content.property.value_attribute = MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_NUMBER;
         goto out;
     }
 
@@ -173,6 +197,101 @@ out:
     return TRUE;
 }
 
+static void
+compile_rule_match (MMUdevRuleMatch *rule_match)
+{
+    const gchar *parameter;
+    const gchar *value;
+
+    parameter = rule_match->parameter;
+    value     = rule_match->value;
+
+    /* We only apply 'add' rules */
+    if (g_str_equal (parameter, "ACTION")) {
+        rule_match->parameter_type = MM_UDEV_RULE_MATCH_PARAMETER_ACTION;
+        rule_match->action_add = !!strstr (value, "add");
+        return;
+    }
+
+    if (g_str_equal (parameter, "SUBSYSTEMS") || g_str_equal (parameter, "SUBSYSTEM")) {
+        rule_match->parameter_type = MM_UDEV_RULE_MATCH_PARAMETER_SUBSYSTEM;
+        return;
+    }
+
+    if (g_str_equal (parameter, "DRIVER") || g_str_equal (parameter, "DRIVERS")) {
+        rule_match->parameter_type = MM_UDEV_RULE_MATCH_PARAMETER_DRIVER;
+        return;
+    }
+
+    if (g_str_equal (parameter, "KERNEL")) {
+        rule_match->parameter_type = MM_UDEV_RULE_MATCH_PARAMETER_KERNEL;
+        return;
+    }
+
+    if (g_str_equal (parameter, "DEVPATH")) {
+        rule_match->parameter_type = MM_UDEV_RULE_MATCH_PARAMETER_DEVPATH;
+        /* If not already doing a prefix match, do an implicit one. This is so that
+         * we can add properties to the usb_device owning all ports, and then apply
+         * the property to all ports individually processed here. */
+        if (value[0] && value[strlen (value) - 1] != '*')
+            rule_match->prefix_value = g_strdup_printf ("%s/*", value);
+        return;
+    }
+
+    if (g_str_has_prefix (parameter, "ATTRS")) {
+        gchar    *attribute;
+        gboolean  numeric = TRUE;
+
+        attribute = g_strdup (&parameter[5]);
+        g_strdelimit (attribute, "{}", ' ');
+        g_strstrip (attribute);
+
+        if (g_str_equal (attribute, "idVendor"))
+            rule_match->parameter_type = MM_UDEV_RULE_MATCH_PARAMETER_ATTR_VENDOR_ID;
+        else if (g_str_equal (attribute, "idProduct"))
+            rule_match->parameter_type = MM_UDEV_RULE_MATCH_PARAMETER_ATTR_PRODUCT_ID;
+        else if (g_str_equal (attribute, "manufacturer")) {
+            rule_match->parameter_type = MM_UDEV_RULE_MATCH_PARAMETER_ATTR_MANUFACTURER;
+            numeric = FALSE;
+        } else if (g_str_equal (attribute, "product")) {
+            rule_match->parameter_type = MM_UDEV_RULE_MATCH_PARAMETER_ATTR_PRODUCT;
+            numeric = FALSE;
+        } else {
+            if (g_str_equal (attribute, "bInterfaceClass"))
+                rule_match->parameter_type = MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_CLASS;
+            else if (g_str_equal (attribute, "bInterfaceSubClass"))
+                rule_match->parameter_type = MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_SUBCLASS;
+            else if (g_str_equal (attribute, "bInterfaceProtocol"))
+                rule_match->parameter_type = MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_PROTOCOL;
+            else if (g_str_equal (attribute, "bInterfaceNumber"))
+                rule_match->parameter_type = MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_NUMBER;
+            else {
+                mm_warn ("Unknown attribute: %s", attribute);
+                numeric = FALSE;
+            }
+            /* Interface attributes may just be required to exist */
+            rule_match->value_any = g_str_equal (value, "?*");
+        }
+
+        if (numeric)
+            rule_match->value_uint_set = mm_get_uint_from_hex_str (value, &rule_match->value_uint);
+
+        g_free (attribute);
+        return;
+    }
+
+    /* Previously set property checks */
+    if (g_str_has_prefix (parameter, "ENV")) {
+        rule_match->parameter_type = MM_UDEV_RULE_MATCH_PARAMETER_ENV;
+        rule_match->property = g_strdup (&parameter[3]);
+        g_strdelimit (rule_match->property, "{}", ' ');
+        g_strstrip (rule_match->property);
+        return;
+    }
+
+    mm_warn ("Unknown match condition parameter: %s", parameter);
+}
+
 static gboolean
 load_rule_match (MMUdevRuleMatch  *rule_match,
                  const gchar      *item,
@@ -202,6 +321,7 @@ load_rule_match (MMUdevRuleMatch  *rule_match,
     g_free (operator);
     rule_match->parameter = left;
     rule_match->value     = right;
+    compile_rule_match (rule_match);
     return TRUE;
 }
 
@@ -361,6 +481,107 @@ out:
     return TRUE;
 }
 
+/* Returns the vendor or product id that the given rule requires, if any */
+static gboolean
+rule_get_segment_key (const MMUdevRule         *rule,
+                      MMUdevRuleMatchParameter  key,
+                      guint                    *out_id)
+{
+    guint i;
+
+    /* Only property rules can be skipped; labels and gotos change the flow */
+    if (rule->result.type != MM_UDEV_RULE_RESULT_TYPE_PROPERTY || !rule->conditions)
+        return FALSE;
+
+    for (i = 0; i < rule->conditions->len; i++) {
+        const MMUdevRuleMatch *match;
+
+        match = &g_array_index (rule->conditions, MMUdevRuleMatch, i);
+        if (match->parameter_type == key &&
+            match->type == MM_UDEV_RULE_MATCH_TYPE_EQUAL &&
+            match->value_uint_set) {
+            *out_id = match->value_uint;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+static guint
+find_segment_end (GArray                   *rules,
+                  guint                     first_rule_index,
+                  MMUdevRuleMatchParameter  key)
+{
+    guint i;
+    guint id;
+
+    for (i = first_rule_index; i < rules->len; i++) {
+        if (!rule_get_segment_key (&g_array_index (rules, MMUdevRule, i), key, &id))
+            break;
+    }
+    return i;
+}
+
+static void
+build_segments (GArray *rules)
+{
+    guint i = 0;
+    guint n_segments = 0;
+    guint n_indexed = 0;
+
+    while (i < rules->len) {
+        MMUdevRuleSegment        *segment;
+        MMUdevRuleMatchParameter  key;
+        guint                     vid_end;
+        guint                     pid_end;
+        guint                     j;
+
+        /* Index by product id if it covers at least as many rules, as it's the
+         * most selective key (e.g. within the per-vendor sections of the plugin
+         * rules all rules share the same vendor id) */
+        vid_end = find_segment_end (rules, i, MM_UDEV_RULE_MATCH_PARAMETER_ATTR_VENDOR_ID);
+        pid_end = find_segment_end (rules, i, MM_UDEV_RULE_MATCH_PARAMETER_ATTR_PRODUCT_ID);
+        if (pid_end >= vid_end) {
+            key = MM_UDEV_RULE_MATCH_PARAMETER_ATTR_PRODUCT_ID;
+            j = pid_end;
+        } else {
+            key = MM_UDEV_RULE_MATCH_PARAMETER_ATTR_VENDOR_ID;
+            j = vid_end;
+        }
+
+        if ((j - i) < SEGMENT_MIN_RULES) {
+            i++;
+            continue;
+        }
+
+        segment = g_slice_new0 (MMUdevRuleSegment);
+        segment->key   = key;
+        segment->end   = j;
+        segment->index = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) g_array_unref);
+
+        for (j = i; j < segment->end; j++) {
+            GArray *indices;
+            guint   id = 0;
+
+            rule_get_segment_key (&g_array_index (rules, MMUdevRule, j), key, &id);
+            indices = g_hash_table_lookup (segment->index, GUINT_TO_POINTER (id));
+            if (!indices) {
+                indices = g_array_new (FALSE, FALSE, sizeof (guint));
+                g_hash_table_insert (segment->index, GUINT_TO_POINTER (id), indices);
+            }
+            g_array_append_val (indices, j);
+        }
+
+        g_array_index (rules, MMUdevRule, i).segment = segment;
+        n_indexed += (segment->end - i);
+        n_segments++;
+        i = segment->end;
+    }
+
+    mm_dbg ("[rules] %u indexed in %u segments", n_indexed, n_segments);
+}
+
 static GList *
 list_rule_files (const gchar *rules_dir_path)
 {
@@ -431,6 +652,7 @@ mm_kernel_device_generic_rules_load (const gchar  *rules_dir,
     }
 
     mm_dbg ("[rules] %u loaded", rules->len);
+    build_segments (rules);
 
 out:
     if (rule_files)
@@ -444,3 +666,293 @@ out:
 
     return rules;
 }
+
+/*****************************************************************************/
+
+static gboolean
+string_match (const gchar *str,
+              const gchar *original_pattern)
+{
+    gchar    *pattern;
+    gchar    *start;
+    gboolean  open_prefix = FALSE;
+    gboolean  open_suffix = FALSE;
+    gboolean  match;
+
+    pattern = g_strdup (original_pattern);
+    start = pattern;
+
+    if (start[0] == '*') {
+        open_prefix = TRUE;
+        start++;
+    }
+
+    if (start[strlen (start) - 1] == '*') {
+        open_suffix = TRUE;
+        start[strlen (start) - 1] = '\0';
+    }
+
+    if (open_suffix && !open_prefix)
+        match = g_str_has_prefix (str, start);
+    else if (!open_suffix && open_prefix)
+        match = g_str_has_suffix (str, start);
+    else if (open_suffix && open_prefix)
+        match = !!strstr (str, start);
+    else
+        match = g_str_equal (str, start);
+
+    g_free (pattern);
+    return match;
+}
+
+static gboolean
+check_devpath (const MMUdevRulesDevice *device,
+               const MMUdevRuleMatch   *match,
+               gboolean                 condition_equal)
+{
+    /* If sysfs path invalid (e.g. path doesn't exist), no match */
+    if (!device->sysfs_path)
+        return FALSE;
+
+    /* We allow both a direct match and a prefix patch */
+    if (string_match (device->sysfs_path, match->value) == condition_equal)
+        return TRUE;
+    if (match->prefix_value && string_match (device->sysfs_path, match->prefix_value) == condition_equal)
+        return TRUE;
+
+    if (g_str_has_prefix (device->sysfs_path, "/sys")) {
+        if (string_match (&device->sysfs_path[4], match->value) == condition_equal)
+            return TRUE;
+        if (match->prefix_value && string_match (&device->sysfs_path[4], match->prefix_value) == condition_equal)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+static gboolean
+check_uint_attribute (const MMUdevRuleMatch *match,
+                      guint                  attribute,
+                      gboolean               condition_equal)
+{
+    return (match->value_uint_set && ((attribute == match->value_uint) == condition_equal));
+}
+
+static gboolean
+check_condition (const MMUdevRulesDevice    *device,
+                 const MMUdevRuleMatch      *match,
+                 MMUdevRulesGetPropertyFunc  get_property,
+                 gpointer                    user_data)
+{
+    gboolean condition_equal;
+
+    condition_equal = (match->type == MM_UDEV_RULE_MATCH_TYPE_EQUAL);
+
+    switch (match->parameter_type) {
+    case MM_UDEV_RULE_MATCH_PARAMETER_ACTION:
+        return (match->action_add == condition_equal);
+
+    /* We look for the subsystem string in the whole sysfs path.
+     *
+     * Note that we're not really making a difference between "SUBSYSTEMS"
+     * (where the whole device tree is checked) and "SUBSYSTEM" (where just one
+     * single device is checked), because a lot of the MM udev rules are meant
+     * to just tag the physical device (e.g. with ID_MM_DEVICE_IGNORE) instead
+     * of the single ports. In our case with the custom parsing, we do tag all
+     * independent ports.
+     */
+    case MM_UDEV_RULE_MATCH_PARAMETER_SUBSYSTEM:
+        return ((device->sysfs_path && !!strstr (device->sysfs_path, match->value)) == condition_equal);
+
+    /* Exact DRIVER match? We also include the check for DRIVERS, even if we
+     * only apply it to this port driver. */
+    case MM_UDEV_RULE_MATCH_PARAMETER_DRIVER:
+        return ((!g_strcmp0 (match->value, device->driver)) == condition_equal);
+
+    /* Device name checks */
+    case MM_UDEV_RULE_MATCH_PARAMETER_KERNEL:
+        return (string_match (device->name, match->value) == condition_equal);
+
+    /* Device sysfs path checks */
+    case MM_UDEV_RULE_MATCH_PARAMETER_DEVPATH:
+        return check_devpath (device, match, condition_equal);
+
+    /* VID/PID in the physdev */
+    case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_VENDOR_ID:
+        return check_uint_attribute (match, device->physdev_vid, condition_equal);
+    case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_PRODUCT_ID:
+        return check_uint_attribute (match, device->physdev_pid, condition_equal);
+
+    /* manufacturer and product in the physdev */
+    case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_MANUFACTURER:
+        return ((device->physdev_manufacturer && g_str_equal (device->physdev_manufacturer, match->value)) == condition_equal);
+    case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_PRODUCT:
+        return ((device->physdev_product && g_str_equal (device->physdev_product, match->value)) == condition_equal);
+
+    /* interface class/subclass/protocol/number in the interface */
+    case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_CLASS:
+        return (match->value_any || check_uint_attribute (match, device->interface_class, condition_equal));
+    case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_SUBCLASS:
+        return (match->value_any || check_uint_attribute (match, device->interface_subclass, condition_equal));
+    case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_PROTOCOL:
+        return (match->value_any || check_uint_attribute (match, device->interface_protocol, condition_equal));
+    case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_NUMBER:
+        return (match->value_any || check_uint_attribute (match, device->interface_number, condition_equal));
+
+    /* Previously set property checks */
+    case MM_UDEV_RULE_MATCH_PARAMETER_ENV:
+        return ((!g_strcmp0 (get_property (match->property, user_data), match->value)) == condition_equal);
+
+    case MM_UDEV_RULE_MATCH_PARAMETER_UNKNOWN:
+        /* Already warned about it when loading the rules */
+        return FALSE;
+    }
+
+    g_assert_not_reached ();
+    return FALSE;
+}
+
+static guint
+check_rule (GArray                     *rules,
+            guint                       rule_i,
+            const MMUdevRulesDevice    *device,
+            MMUdevRulesGetPropertyFunc  get_property,
+            MMUdevRulesSetPropertyFunc  set_property,
+            gpointer                    user_data)
+{
+    MMUdevRule *rule;
+    gboolean    apply = TRUE;
+
+    g_assert (rule_i < rules->len);
+
+    rule = &g_array_index (rules, MMUdevRule, rule_i);
+    if (rule->conditions) {
+        guint condition_i;
+
+        for (condition_i = 0; condition_i < rule->conditions->len; condition_i++) {
+            MMUdevRuleMatch *match;
+
+            match = &g_array_index (rule->conditions, MMUdevRuleMatch, condition_i);
+            if (!check_condition (device, match, get_property, user_data)) {
+                apply = FALSE;
+                break;
+            }
+        }
+    }
+
+    if (apply) {
+        switch (rule->result.type) {
+        case MM_UDEV_RULE_RESULT_TYPE_PROPERTY: {
+            gchar *property_value_read = NULL;
+
+            switch (rule->result.content.property.value_attribute) {
+            case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_CLASS:
+                property_value_read = g_strdup_printf ("%02x", device->interface_class);
+                break;
+            case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_SUBCLASS:
+                property_value_read = g_strdup_printf ("%02x", device->interface_subclass);
+                break;
+            case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_PROTOCOL:
+                property_value_read = g_strdup_printf ("%02x", device->interface_protocol);
+                break;
+            case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_NUMBER:
+                property_value_read = g_strdup_printf ("%02x", device->interface_number);
+                break;
+            default:
+                break;
+            }
+
+            /* add new property */
+            mm_dbg ("(%s/%s) property added: %s=%s",
+                    device->subsystem,
+                    device->name,
+                    rule->result.content.property.name,
+                    property_value_read ? property_value_read : rule->result.content.property.value);
+
+            if (!property_value_read)
+                set_property (rule->result.content.property.name,
+                              rule->result.content.property.value,
+                              NULL,
+                              user_data);
+            else
+                set_property (rule->result.content.property.name,
+                              property_value_read,
+                              g_free,
+                              user_data);
+            break;
+        }
+
+        case MM_UDEV_RULE_RESULT_TYPE_LABEL:
+            /* noop */
+            break;
+
+        case MM_UDEV_RULE_RESULT_TYPE_GOTO_INDEX:
+            /* Jump to a new index */
+            return rule->result.content.index;
+
+        case MM_UDEV_RULE_RESULT_TYPE_GOTO_TAG:
+        case MM_UDEV_RULE_RESULT_TYPE_UNKNOWN:
+            g_assert_not_reached ();
+        }
+    }
+
+    /* Go to the next rule */
+    return rule_i + 1;
+}
+
+static guint
+check_segment (GArray                     *rules,
+               const MMUdevRuleSegment    *segment,
+               const MMUdevRulesDevice    *device,
+               MMUdevRulesGetPropertyFunc  get_property,
+               MMUdevRulesSetPropertyFunc  set_property,
+               gpointer                    user_data)
+{
+    GArray *indices;
+    guint   id;
+
+    id = (segment->key == MM_UDEV_RULE_MATCH_PARAMETER_ATTR_VENDOR_ID ?
+          device->physdev_vid :
+          device->physdev_pid);
+
+    /* Only the rules requiring the port id may apply; these are all property
+     * rules, so the order in which they're checked is preserved and there are
+     * no jumps. */
+    indices = g_hash_table_lookup (segment->index, GUINT_TO_POINTER (id));
+    if (indices) {
+        guint i;
+
+        for (i = 0; i < indices->len; i++)
+            check_rule (rules, g_array_index (indices, guint, i), device, get_property, set_property, user_data);
+    }
+
+    return segment->end;
+}
+
+void
+mm_kernel_device_generic_rules_apply (GArray                     *rules,
+                                      const MMUdevRulesDevice    *device,
+                                      gboolean                    use_index,
+                                      MMUdevRulesGetPropertyFunc  get_property,
+                                      MMUdevRulesSetPropertyFunc  set_property,
+                                      gpointer                    user_data)
+{
+    guint i;
+
+    g_assert (rules);
+    g_assert (rules->len > 0);
+    g_assert (device);
+    g_assert (get_property && set_property);
+
+    /* Start to process rules */
+    i = 0;
+    while (i < rules->len) {
+        const MMUdevRule *rule;
+
+        rule = &g_array_index (rules, MMUdevRule, i);
+        if (use_index && rule->segment)
+            i = check_segment (rules, rule->segment, device, get_property, set_property, user_data);
+        else
+            i = check_rule (rules, i, device, get_property, set_property, user_data);
+    }
+}
@@ -23,10 +23,39 @@ typedef enum {
     MM_UDEV_RULE_MATCH_TYPE_NOT_EQUAL,
 } MMUdevRuleMatchType;
 
+/* Parameters known by the rules engine, resolved when the rules are loaded so
+ * that matching a port doesn't require parsing the rule strings again. */
+typedef enum {
+    MM_UDEV_RULE_MATCH_PARAMETER_UNKNOWN,
+    MM_UDEV_RULE_MATCH_PARAMETER_ACTION,
+    MM_UDEV_RULE_MATCH_PARAMETER_SUBSYSTEM,
+    MM_UDEV_RULE_MATCH_PARAMETER_DRIVER,
+    MM_UDEV_RULE_MATCH_PARAMETER_KERNEL,
+    MM_UDEV_RULE_MATCH_PARAMETER_DEVPATH,
+    MM_UDEV_RULE_MATCH_PARAMETER_ATTR_VENDOR_ID,
+    MM_UDEV_RULE_MATCH_PARAMETER_ATTR_PRODUCT_ID,
+    MM_UDEV_RULE_MATCH_PARAMETER_ATTR_MANUFACTURER,
+    MM_UDEV_RULE_MATCH_PARAMETER_ATTR_PRODUCT,
+    MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_CLASS,
+    MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_SUBCLASS,
+    MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_PROTOCOL,
+    MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_NUMBER,
+    MM_UDEV_RULE_MATCH_PARAMETER_ENV,
+} MMUdevRuleMatchParameter;
+
 typedef struct {
-    MMUdevRuleMatchType  type;
-    gchar               *parameter;
-    gchar               *value;
+    MMUdevRuleMatchType       type;
+    gchar                    *parameter;
+    gchar                    *value;
+
+    /* Compiled match */
+    MMUdevRuleMatchParameter  parameter_type;
+    gchar                    *property;       /* ENV{} matches */
+    gchar                    *prefix_value;   /* implicit DEVPATH prefix match */
+    gboolean                  value_any;      /* "?*" attribute matches */
+    gboolean                  value_uint_set; /* numeric attribute matches */
+    guint                     value_uint;
+    gboolean                  action_add;     /* ACTION matches */
 } MMUdevRuleMatch;
 
 typedef enum {
@@ -38,8 +67,10 @@ typedef enum {
 } MMUdevRuleResultType;
 
 typedef struct {
-    gchar *name;
-    gchar *value;
+    gchar                    *name;
+    gchar                    *value;
+    /* Set if the value is read from an interface attribute, e.g. "$attr{bInterfaceNumber}" */
+    MMUdevRuleMatchParameter  value_attribute;
 } MMUdevRuleResultProperty;
 
 typedef struct {
@@ -51,12 +82,55 @@ typedef struct {
     } content;
 } MMUdevRuleResult;
 
+/* A segment is a run of consecutive property rules which all require an exact
+ * vendor (or product) id match. Only the rules indexed under the port id need
+ * to be checked; all the others are known not to apply. */
+typedef struct {
+    MMUdevRuleMatchParameter  key;   /* VENDOR_ID or PRODUCT_ID */
+    guint                     end;   /* index of the first rule after the segment */
+    GHashTable               *index; /* id -> GArray of rule indices */
+} MMUdevRuleSegment;
+
 typedef struct {
-    GArray           *conditions;
-    MMUdevRuleResult  result;
+    GArray            *conditions;
+    MMUdevRuleResult   result;
+    /* Only set in the first rule of a segment */
+    MMUdevRuleSegment *segment;
 } MMUdevRule;
 
 GArray *mm_kernel_device_generic_rules_load (const gchar  *rules_dir,
                                              GError      **error);
 
+/* Port contents the rules are matched against */
+typedef struct {
+    const gchar *subsystem;
+    const gchar *name;
+    const gchar *sysfs_path;
+    const gchar *driver;
+    guint16      physdev_vid;
+    guint16      physdev_pid;
+    const gchar *physdev_manufacturer;
+    const gchar *physdev_product;
+    guint8       interface_class;
+    guint8       interface_subclass;
+    guint8       interface_protocol;
+    guint8       interface_number;
+} MMUdevRulesDevice;
+
+typedef const gchar * (* MMUdevRulesGetPropertyFunc) (const gchar *property,
+                                                      gpointer     user_data);
+
+/* If value_destroy is NULL, value is owned by the rules array */
+typedef void (* MMUdevRulesSetPropertyFunc) (const gchar    *property,
+                                             const gchar    *value,
+                                             GDestroyNotify  value_destroy,
+                                             gpointer        user_data);
+
+void mm_kernel_device_generic_rules_apply (GArray                     *rules,
+                                           const MMUdevRulesDevice    *device,
+                                           gboolean                    use_index,
+                                           MMUdevRulesGetPropertyFunc  get_property,
+                                           MMUdevRulesSetPropertyFunc  set_property,
+                                           gpointer                    user_data);
+
 G_END_DECLS
@@ -58,11 +58,9 @@ struct _MMKernelDeviceGenericPrivate {
     guint8   interface_protocol;
     guint8   interface_number;
     gchar   *physdev_sysfs_path;
-    guint16  physdev_vid;
-    guint16  physdev_pid;
-    gchar   *physdev_subsystem;
-    gchar   *physdev_manufacturer;
-    gchar   *physdev_product;
+
+    /* Contents from sysfs, shared among all ports of the physical device */
+    struct _PhysdevInfo *physdev;
 };
 
 static guint
@@ -253,110 +251,196 @@ preload_driver (MMKernelDeviceGeneric *self)
                 self->priv->driver);
 }
 
+/*****************************************************************************/
+/* Physical device contents
+ *
+ * The physdev attributes are equal for all ports exported by the same physical
+ * device, so they're read from sysfs once and shared among all the sibling
+ * ports. Entries are kept in the cache while referenced by at least one port,
+ * and they're invalidated as soon as one of the ports is removed, so that a
+ * different device plugged in later in the same place is read again.
+ */
+
+typedef struct _PhysdevInfo {
+    guint    ref_count;
+    gchar   *sysfs_path;
+    guint16  vid;
+    guint16  pid;
+    gchar   *subsystem;
+    gchar   *manufacturer;
+    gchar   *product;
+} PhysdevInfo;
+
+/* physdev sysfs path -> PhysdevInfo (not owned) */
+static GHashTable *physdev_cache;
+/* "subsystem/name" of the port -> physdev sysfs path */
+static GHashTable *physdev_ports;
+
+static PhysdevInfo *
+physdev_info_ref (PhysdevInfo *info)
+{
+    info->ref_count++;
+    return info;
+}
+
 static void
-preload_physdev_vid (MMKernelDeviceGeneric *self)
+physdev_info_unref (PhysdevInfo *info)
 {
-    if (!self->priv->physdev_vid && self->priv->physdev_sysfs_path) {
-        guint val;
+    g_assert (info->ref_count > 0);
+    if (--info->ref_count > 0)
+        return;
 
-        val = read_sysfs_property_as_hex (self->priv->physdev_sysfs_path, "idVendor");
-        if (val && val <= G_MAXUINT16)
-            self->priv->physdev_vid = val;
-    }
+    /* Only remove from the cache if it wasn't already invalidated */
+    if (physdev_cache && g_hash_table_lookup (physdev_cache, info->sysfs_path) == info)
+        g_hash_table_remove (physdev_cache, info->sysfs_path);
 
-    if (self->priv->physdev_vid) {
-        mm_dbg ("(%s/%s) vid (ID_VENDOR_ID): 0x%04x",
-                mm_kernel_event_properties_get_subsystem (self->priv->properties),
-                mm_kernel_event_properties_get_name      (self->priv->properties),
-                self->priv->physdev_vid);
-        g_object_set_data_full (G_OBJECT (self), "ID_VENDOR_ID", g_strdup_printf ("%04x", self->priv->physdev_vid), g_free);
-    } else
-        mm_dbg ("(%s/%s) vid: unknown",
-                mm_kernel_event_properties_get_subsystem (self->priv->properties),
-                mm_kernel_event_properties_get_name      (self->priv->properties));
+    g_free (info->product);
+    g_free (info->manufacturer);
+    g_free (info->subsystem);
+    g_free (info->sysfs_path);
+    g_slice_free (PhysdevInfo, info);
+}
+
+static PhysdevInfo *
+physdev_info_load (const gchar *sysfs_path)
+{
+    PhysdevInfo *info;
+    gchar       *aux;
+    gchar       *subsyspath;
+    guint        val;
+
+    info = g_slice_new0 (PhysdevInfo);
+    info->ref_count  = 1;
+    info->sysfs_path = g_strdup (sysfs_path);
 
+    val = read_sysfs_property_as_hex (sysfs_path, "idVendor");
+    if (val && val <= G_MAXUINT16)
+        info->vid = val;
+
+    val = read_sysfs_property_as_hex (sysfs_path, "idProduct");
+    if (val && val <= G_MAXUINT16)
+        info->pid = val;
+
+    info->manufacturer = read_sysfs_property_as_string (sysfs_path, "manufacturer");
+    info->product      = read_sysfs_property_as_string (sysfs_path, "product");
+
+    aux = g_strdup_printf ("%s/subsystem", sysfs_path);
+    subsyspath = canonicalize_file_name (aux);
+    info->subsystem = g_path_get_dirname (subsyspath);
+    g_free (subsyspath);
+    g_free (aux);
+
+    return info;
 }
 
-static void
-preload_physdev_pid (MMKernelDeviceGeneric *self)
+static PhysdevInfo *
+physdev_info_get (const gchar *sysfs_path,
+                  const gchar *port_subsystem,
+                  const gchar *port_name)
 {
-    if (!self->priv->physdev_pid && self->priv->physdev_sysfs_path) {
-        guint val;
+    PhysdevInfo *info;
 
-        val = read_sysfs_property_as_hex (self->priv->physdev_sysfs_path, "idProduct");
-        if (val && val <= G_MAXUINT16)
-            self->priv->physdev_pid = val;
+    if (G_UNLIKELY (!physdev_cache)) {
+        physdev_cache = g_hash_table_new (g_str_hash, g_str_equal);
+        physdev_ports = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
     }
 
-    if (self->priv->physdev_pid) {
-        mm_dbg ("(%s/%s) pid (ID_MODEL_ID): 0x%04x",
-                mm_kernel_event_properties_get_subsystem (self->priv->properties),
-                mm_kernel_event_properties_get_name      (self->priv->properties),
-                self->priv->physdev_pid);
-        g_object_set_data_full (G_OBJECT (self), "ID_MODEL_ID", g_strdup_printf ("%04x", self->priv->physdev_pid), g_free);
-    } else
-        mm_dbg ("(%s/%s) pid: unknown",
-                mm_kernel_event_properties_get_subsystem (self->priv->properties),
-                mm_kernel_event_properties_get_name      (self->priv->properties));
+    /* Keep track of which physdev each port belongs to, so that the entry can
+     * be invalidated on port removal, when there is no sysfs path any more */
+    g_hash_table_insert (physdev_ports,
+                         g_strdup_printf ("%s/%s", port_subsystem, port_name),
+                         g_strdup (sysfs_path));
+
+    info = g_hash_table_lookup (physdev_cache, sysfs_path);
+    if (info)
+        return physdev_info_ref (info);
+
+    info = physdev_info_load (sysfs_path);
+    g_hash_table_insert (physdev_cache, info->sysfs_path, info);
+    return info;
 }
 
 static void
-preload_physdev_subsystem (MMKernelDeviceGeneric *self)
+physdev_info_invalidate (const gchar *port_subsystem,
+                         const gchar *port_name)
 {
-    if (!self->priv->physdev_subsystem && self->priv->physdev_sysfs_path) {
-        gchar *aux;
-        gchar *subsyspath;
-
-        aux = g_strdup_printf ("%s/subsystem", self->priv->physdev_sysfs_path);
-        subsyspath = canonicalize_file_name (aux);
-        self->priv->physdev_subsystem = g_path_get_dirname (subsyspath);
-        g_free (subsyspath);
-        g_free (aux);
-    }
+    gchar       *port;
+    const gchar *sysfs_path;
 
-    mm_dbg ("(%s/%s) subsystem: %s",
-            mm_kernel_event_properties_get_subsystem (self->priv->properties),
-            mm_kernel_event_properties_get_name      (self->priv->properties),
-            self->priv->physdev_subsystem ? self->priv->physdev_subsystem : "unknown");
+    if (!physdev_cache)
+        return;
+
+    port = g_strdup_printf ("%s/%s", port_subsystem, port_name);
+    sysfs_path = g_hash_table_lookup (physdev_ports, port);
+    if (sysfs_path) {
+        /* Ports still referencing the entry keep their own reference to it */
+        if (g_hash_table_remove (physdev_cache, sysfs_path))
+            mm_dbg ("(%s) physdev contents invalidated: %s", port, sysfs_path);
+        g_hash_table_remove (physdev_ports, port);
+    }
+    g_free (port);
 }
 
 static void
-preload_manufacturer (MMKernelDeviceGeneric *self)
+preload_physdev (MMKernelDeviceGeneric *self)
 {
-    if (!self->priv->physdev_manufacturer)
-        self->priv->physdev_manufacturer = (self->priv->physdev_sysfs_path ? read_sysfs_property_as_string (self->priv->physdev_sysfs_path, "manufacturer") : NULL);
+    if (!self->priv->physdev && self->priv->physdev_sysfs_path)
+        self->priv->physdev = physdev_info_get (self->priv->physdev_sysfs_path,
+                                                mm_kernel_event_properties_get_subsystem (self->priv->properties),
+                                                mm_kernel_event_properties_get_name      (self->priv->properties));
 
-    if (self->priv->physdev_manufacturer) {
+    if (self->priv->physdev && self->priv->physdev->manufacturer) {
         mm_dbg ("(%s/%s) manufacturer (ID_VENDOR): %s",
                 mm_kernel_event_properties_get_subsystem (self->priv->properties),
                 mm_kernel_event_properties_get_name      (self->priv->properties),
-                self->priv->physdev_manufacturer);
-        g_object_set_data_full (G_OBJECT (self), "ID_VENDOR", g_strdup (self->priv->physdev_manufacturer), g_free);
+                self->priv->physdev->manufacturer);
+        g_object_set_data_full (G_OBJECT (self), "ID_VENDOR", g_strdup (self->priv->physdev->manufacturer), g_free);
     } else
         mm_dbg ("(%s/%s) manufacturer: unknown",
                 mm_kernel_event_properties_get_subsystem (self->priv->properties),
                 mm_kernel_event_properties_get_name      (self->priv->properties));
-}
 
-static void
-preload_product (MMKernelDeviceGeneric *self)
-{
-    if (!self->priv->physdev_product)
-        self->priv->physdev_product = (self->priv->physdev_sysfs_path ? read_sysfs_property_as_string (self->priv->physdev_sysfs_path, "product") : NULL);
-
-    if (self->priv->physdev_product) {
+    if (self->priv->physdev && self->priv->physdev->product) {
         mm_dbg ("(%s/%s) product (ID_MODEL): %s",
                 mm_kernel_event_properties_get_subsystem (self->priv->properties),
                 mm_kernel_event_properties_get_name      (self->priv->properties),
-                self->priv->physdev_product);
-        g_object_set_data_full (G_OBJECT (self), "ID_MODEL", g_strdup (self->priv->physdev_product), g_free);
+                self->priv->physdev->product);
+        g_object_set_data_full (G_OBJECT (self), "ID_MODEL", g_strdup (self->priv->physdev->product), g_free);
     } else
         mm_dbg ("(%s/%s) product: unknown",
                 mm_kernel_event_properties_get_subsystem (self->priv->properties),
                 mm_kernel_event_properties_get_name      (self->priv->properties));
 
+    if (self->priv->physdev && self->priv->physdev->vid) {
+        mm_dbg ("(%s/%s) vid (ID_VENDOR_ID): 0x%04x",
+                mm_kernel_event_properties_get_subsystem (self->priv->properties),
+                mm_kernel_event_properties_get_name      (self->priv->properties),
+                self->priv->physdev->vid);
+        g_object_set_data_full (G_OBJECT (self), "ID_VENDOR_ID", g_strdup_printf ("%04x", self->priv->physdev->vid), g_free);
+    } else
+        mm_dbg ("(%s/%s) vid: unknown",
+                mm_kernel_event_properties_get_subsystem (self->priv->properties),
+                mm_kernel_event_properties_get_name      (self->priv->properties));
+
+    if (self->priv->physdev && self->priv->physdev->pid) {
+        mm_dbg ("(%s/%s) pid (ID_MODEL_ID): 0x%04x",
+                mm_kernel_event_properties_get_subsystem (self->priv->properties),
+                mm_kernel_event_properties_get_name      (self->priv->properties),
+                self->priv->physdev->pid);
+        g_object_set_data_full (G_OBJECT (self), "ID_MODEL_ID", g_strdup_printf ("%04x", self->priv->physdev->pid), g_free);
+    } else
+        mm_dbg ("(%s/%s) pid: unknown",
+                mm_kernel_event_properties_get_subsystem (self->priv->properties),
+                mm_kernel_event_properties_get_name      (self->priv->properties));
+
+    mm_dbg ("(%s/%s) subsystem: %s",
+            mm_kernel_event_properties_get_subsystem (self->priv->properties),
+            mm_kernel_event_properties_get_name      (self->priv->properties),
+            (self->priv->physdev && self->priv->physdev->subsystem) ? self->priv->physdev->subsystem : "unknown");
 }
 
+/*****************************************************************************/
+
 static void
 preload_interface_class (MMKernelDeviceGeneric *self)
 {
@@ -408,12 +492,8 @@ preload_contents (MMKernelDeviceGeneric *self)
     preload_interface_protocol   (self);
     preload_interface_number     (self);
     preload_physdev_sysfs_path   (self);
-    preload_manufacturer         (self);
-    preload_product              (self);
     preload_driver               (self);
-    preload_physdev_vid          (self);
-    preload_physdev_pid          (self);
-    preload_physdev_subsystem    (self);
+    preload_physdev              (self);
 }
 
 /*****************************************************************************/
@@ -510,7 +590,9 @@ kernel_device_get_physdev_vid (MMKernelDevice *self)
 {
     g_return_val_if_fail (MM_IS_KERNEL_DEVICE_GENERIC (self), 0);
 
-    return MM_KERNEL_DEVICE_GENERIC (self)->priv->physdev_vid;
+    return (MM_KERNEL_DEVICE_GENERIC (self)->priv->physdev ?
+            MM_KERNEL_DEVICE_GENERIC (self)->priv->physdev->vid :
+            0);
 }
 
 static guint16
@@ -518,7 +600,9 @@ kernel_device_get_physdev_pid (MMKernelDevice *self)
 {
     g_return_val_if_fail (MM_IS_KERNEL_DEVICE_GENERIC (self), 0);
 
-    return MM_KERNEL_DEVICE_GENERIC (self)->priv->physdev_pid;
+    return (MM_KERNEL_DEVICE_GENERIC (self)->priv->physdev ?
+            MM_KERNEL_DEVICE_GENERIC (self)->priv->physdev->pid :
+            0);
 }
 
 static const gchar *
@@ -534,7 +618,9 @@ kernel_device_get_physdev_subsystem (MMKernelDevice *self)
 {
     g_return_val_if_fail (MM_IS_KERNEL_DEVICE_GENERIC (self), NULL);
 
-    return MM_KERNEL_DEVICE_GENERIC (self)->priv->physdev_subsystem;
+    return (MM_KERNEL_DEVICE_GENERIC (self)->priv->physdev ?
+            MM_KERNEL_DEVICE_GENERIC (self)->priv->physdev->subsystem :
+            NULL);
 }
 
 static const gchar *
@@ -542,7 +628,9 @@ kernel_device_get_physdev_manufacturer (MMKernelDevice *self)
 {
     g_return_val_if_fail (MM_IS_KERNEL_DEVICE_GENERIC (self), 0);
 
-    return MM_KERNEL_DEVICE_GENERIC (self)->priv->physdev_manufacturer;
+    return (MM_KERNEL_DEVICE_GENERIC (self)->priv->physdev ?
+            MM_KERNEL_DEVICE_GENERIC (self)->priv->physdev->manufacturer :
+            NULL);
 }
 
 static gboolean
@@ -558,273 +646,55 @@ kernel_device_cmp (MMKernelDevice *a,
 
 /*****************************************************************************/
 
-static gboolean
-string_match (const gchar *str,
-              const gchar *original_pattern)
-{
-    gchar    *pattern;
-    gchar    *start;
-    gboolean  open_prefix = FALSE;
-    gboolean  open_suffix = FALSE;
-    gboolean  match;
-
-    pattern = g_strdup (original_pattern);
-    start = pattern;
-
-    if (start[0] == '*') {
-        open_prefix = TRUE;
-        start++;
-    }
-
-    if (start[strlen (start) - 1] == '*') {
-        open_suffix = TRUE;
-        start[strlen (start) - 1] = '\0';
-    }
-
-    if (open_suffix && !open_prefix)
-        match = g_str_has_prefix (str, start);
-    else if (!open_suffix && open_prefix)
-        match = g_str_has_suffix (str, start);
-    else if (open_suffix && open_prefix)
-        match = !!strstr (str, start);
-    else
-        match = g_str_equal (str, start);
-
-    g_free (pattern);
-    return match;
-}
-
-static gboolean
-check_condition (MMKernelDeviceGeneric *self,
-                 MMUdevRuleMatch       *match)
+static const gchar *
+rules_get_property (const gchar *property,
+                    gpointer     user_data)
 {
-    gboolean condition_equal;
-
-    condition_equal = (match->type == MM_UDEV_RULE_MATCH_TYPE_EQUAL);
-
-    /* We only apply 'add' rules */
-    if (g_str_equal (match->parameter, "ACTION"))
-        return ((!!strstr (match->value, "add")) == condition_equal);
-
-    /* We look for the subsystem string in the whole sysfs path.
-     *
-     * Note that we're not really making a difference between "SUBSYSTEMS"
-     * (where the whole device tree is checked) and "SUBSYSTEM" (where just one
-     * single device is checked), because a lot of the MM udev rules are meant
-     * to just tag the physical device (e.g. with ID_MM_DEVICE_IGNORE) instead
-     * of the single ports. In our case with the custom parsing, we do tag all
-     * independent ports.
-     */
-    if (g_str_equal (match->parameter, "SUBSYSTEMS") || g_str_equal (match->parameter, "SUBSYSTEM"))
-        return ((self->priv->sysfs_path && !!strstr (self->priv->sysfs_path, match->value)) == condition_equal);
-
-    /* Exact DRIVER match? We also include the check for DRIVERS, even if we
-     * only apply it to this port driver. */
-    if (g_str_equal (match->parameter, "DRIVER") || g_str_equal (match->parameter, "DRIVERS"))
-        return ((!g_strcmp0 (match->value, mm_kernel_device_get_driver (MM_KERNEL_DEVICE (self)))) == condition_equal);
-
-    /* Device name checks */
-    if (g_str_equal (match->parameter, "KERNEL"))
-        return (string_match (mm_kernel_device_get_name (MM_KERNEL_DEVICE (self)), match->value) == condition_equal);
-
-    /* Device sysfs path checks; we allow both a direct match and a prefix patch */
-    if (g_str_equal (match->parameter, "DEVPATH")) {
-        gchar    *prefix_match = NULL;
-        gboolean  result = FALSE;
-
-        /* If sysfs path invalid (e.g. path doesn't exist), no match */
-        if (!self->priv->sysfs_path)
-            return FALSE;
-
-        /* If not already doing a prefix match, do an implicit one. This is so that
-         * we can add properties to the usb_device owning all ports, and then apply
-         * the property to all ports individually processed here. */
-        if (match->value[0] && match->value[strlen (match->value) - 1] != '*')
-            prefix_match = g_strdup_printf ("%s/*", match->value);
-
-        if (string_match (self->priv->sysfs_path, match->value) == condition_equal) {
-            result = TRUE;
-            goto out;
-        }
-
-        if (prefix_match && string_match (self->priv->sysfs_path, prefix_match) == condition_equal) {
-            result = TRUE;
-            goto out;
-        }
-
-        if (g_str_has_prefix (self->priv->sysfs_path, "/sys")) {
-            if (string_match (&self->priv->sysfs_path[4], match->value) == condition_equal) {
-                result = TRUE;
-                goto out;
-            }
-            if (prefix_match && string_match (&self->priv->sysfs_path[4], prefix_match) == condition_equal) {
-                result = TRUE;
-                goto out;
-            }
-        }
-    out:
-        g_free (prefix_match);
-        return result;
-    }
-
-    /* Attributes checks */
-    if (g_str_has_prefix (match->parameter, "ATTRS")) {
-        gchar    *attribute;
-        gchar    *contents = NULL;
-        gboolean  result = FALSE;
-        guint     val;
-
-        attribute = g_strdup (&match->parameter[5]);
-        g_strdelimit (attribute, "{}", ' ');
-        g_strstrip (attribute);
-
-        /* VID/PID directly from our API */
-        if (g_str_equal (attribute, "idVendor"))
-            result = ((mm_get_uint_from_hex_str (match->value, &val)) &&
-                      ((mm_kernel_device_get_physdev_vid (MM_KERNEL_DEVICE (self)) == val) == condition_equal));
-        else if (g_str_equal (attribute, "idProduct"))
-            result = ((mm_get_uint_from_hex_str (match->value, &val)) &&
-                      ((mm_kernel_device_get_physdev_pid (MM_KERNEL_DEVICE (self)) == val) == condition_equal));
-        /* manufacturer in the physdev */
-        else if (g_str_equal (attribute, "manufacturer"))
-            result = ((self->priv->physdev_manufacturer && g_str_equal (self->priv->physdev_manufacturer, match->value)) == condition_equal);
-        /* product in the physdev */
-        else if (g_str_equal (attribute, "product"))
-            result = ((self->priv->physdev_product && g_str_equal (self->priv->physdev_product, match->value)) == condition_equal);
-        /* interface class/subclass/protocol/number in the interface */
-        else if (g_str_equal (attribute, "bInterfaceClass"))
-            result = (g_str_equal (match->value, "?*") || ((mm_get_uint_from_hex_str (match->value, &val)) &&
-                                                           ((self->priv->interface_class == val) == condition_equal)));
-        else if (g_str_equal (attribute, "bInterfaceSubClass"))
-            result = (g_str_equal (match->value, "?*") || ((mm_get_uint_from_hex_str (match->value, &val)) &&
-                                                           ((self->priv->interface_subclass == val) == condition_equal)));
-        else if (g_str_equal (attribute, "bInterfaceProtocol"))
-            result = (g_str_equal (match->value, "?*") || ((mm_get_uint_from_hex_str (match->value, &val)) &&
-                                                           ((self->priv->interface_protocol == val) == condition_equal)));
-        else if (g_str_equal (attribute, "bInterfaceNumber"))
-            result = (g_str_equal (match->value, "?*") || ((mm_get_uint_from_hex_str (match->value, &val)) &&
-                                                           ((self->priv->interface_number == val) == condition_equal)));
-        else
-            mm_warn ("Unknown attribute: %s", attribute);
-
-        g_free (contents);
-        g_free (attribute);
-        return result;
-    }
-
-    /* Previously set property checks */
-    if (g_str_has_prefix (match->parameter, "ENV")) {
-        gchar    *property;
-        gboolean  result = FALSE;
-
-        property = g_strdup (&match->parameter[3]);
-        g_strdelimit (property, "{}", ' ');
-        g_strstrip (property);
-
-        result = ((!g_strcmp0 ((const gchar *) g_object_get_data (G_OBJECT (self), property), match->value)) == condition_equal);
-
-        g_free (property);
-        return result;
-    }
-
-    mm_warn ("Unknown match condition parameter: %s", match->parameter);
-    return FALSE;
+    return (const gchar *) g_object_get_data (G_OBJECT (user_data), property);
 }
 
-static guint
-check_rule (MMKernelDeviceGeneric *self,
-            guint                  rule_i)
+static void
+rules_set_property (const gchar    *property,
+                    const gchar    *value,
+                    GDestroyNotify  value_destroy,
+                    gpointer        user_data)
 {
-    MMUdevRule *rule;
-    gboolean    apply = TRUE;
-
-    g_assert (rule_i < self->priv->rules->len);
-
-    rule = &g_array_index (self->priv->rules, MMUdevRule, rule_i);
-    if (rule->conditions) {
-        guint condition_i;
-
-        for (condition_i = 0; condition_i < rule->conditions->len; condition_i++) {
-            MMUdevRuleMatch *match;
-
-            match = &g_array_index (rule->conditions, MMUdevRuleMatch, condition_i);
-            if (!check_condition (self, match)) {
-                apply = FALSE;
-                break;
-            }
-        }
-    }
-
-    if (apply) {
-        switch (rule->result.type) {
-        case MM_UDEV_RULE_RESULT_TYPE_PROPERTY: {
-            gchar *property_value_read = NULL;
-
-            if (g_str_equal (rule->result.content.property.value, "$attr{bInterfaceClass}"))
-                property_value_read = g_strdup_printf ("%02x", self->priv->interface_class);
-            else if (g_str_equal (rule->result.content.property.value, "$attr{bInterfaceSubClass}"))
-                property_value_read = g_strdup_printf ("%02x", self->priv->interface_subclass);
-            else if (g_str_equal (rule->result.content.property.value, "$attr{bInterfaceProtocol}"))
-                property_value_read = g_strdup_printf ("%02x", self->priv->interface_protocol);
-            else if (g_str_equal (rule->result.content.property.value, "$attr{bInterfaceNumber}"))
-                property_value_read = g_strdup_printf ("%02x", self->priv->interface_number);
-
-            /* add new property */
-            mm_dbg ("(%s/%s) property added: %s=%s",
-                    mm_kernel_event_properties_get_subsystem (self->priv->properties),
-                    mm_kernel_event_properties_get_name      (self->priv->properties),
-                    rule->result.content.property.name,
-                    property_value_read ? property_value_read : rule->result.content.property.value);
-
-            if (!property_value_read)
-                /* NOTE: we keep a reference to the list of rules ourselves, so it isn't
-                 * an issue if we re-use the same string (i.e. without g_strdup-ing it)
-                 * as a property value. */
-                g_object_set_data (G_OBJECT (self),
-                                   rule->result.content.property.name,
-                                   rule->result.content.property.value);
-            else
-                g_object_set_data_full (G_OBJECT (self),
-                                        rule->result.content.property.name,
-                                        property_value_read,
-                                        g_free);
-            break;
-        }
-
-        case MM_UDEV_RULE_RESULT_TYPE_LABEL:
-            /* noop */
-            break;
-
-        case MM_UDEV_RULE_RESULT_TYPE_GOTO_INDEX:
-            /* Jump to a new index */
-            return rule->result.content.index;
-
-        case MM_UDEV_RULE_RESULT_TYPE_GOTO_TAG:
-        case MM_UDEV_RULE_RESULT_TYPE_UNKNOWN:
-            g_assert_not_reached ();
-        }
-    }
-
-    /* Go to the next rule */
-    return rule_i + 1;
+    /* NOTE: we keep a reference to the list of rules ourselves, so it isn't
+     * an issue if we re-use the same string (i.e. without g_strdup-ing it)
+     * as a property value. */
+    g_object_set_data_full (G_OBJECT (user_data), property, (gpointer) value, value_destroy);
 }
 
 static void
 preload_properties (MMKernelDeviceGeneric *self)
 {
-    guint i;
+    MMUdevRulesDevice device;
 
     g_assert (self->priv->rules);
     g_assert (self->priv->rules->len > 0);
 
-    /* Start to process rules */
-    i = 0;
-    while (i < self->priv->rules->len) {
-        guint next_rule;
-
-        next_rule = check_rule (self, i);
-        i = next_rule;
+    memset (&device, 0, sizeof (device));
+    device.subsystem            = mm_kernel_event_properties_get_subsystem (self->priv->properties);
+    device.name                 = mm_kernel_event_properties_get_name (self->priv->properties);
+    device.sysfs_path           = self->priv->sysfs_path;
+    device.driver               = self->priv->driver;
+    if (self->priv->physdev) {
+        device.physdev_vid          = self->priv->physdev->vid;
+        device.physdev_pid          = self->priv->physdev->pid;
+        device.physdev_manufacturer = self->priv->physdev->manufacturer;
+        device.physdev_product      = self->priv->physdev->product;
     }
+    device.interface_class      = self->priv->interface_class;
+    device.interface_subclass   = self->priv->interface_subclass;
+    device.interface_protocol   = self->priv->interface_protocol;
+    device.interface_number     = self->priv->interface_number;
+
+    mm_kernel_device_generic_rules_apply (self->priv->rules,
+                                          &device,
+                                          TRUE,
+                                          rules_get_property,
+                                          rules_set_property,
+                                          self);
 }
 
 static void
@@ -834,9 +704,13 @@ check_preload (MMKernelDeviceGeneric *self)
     if (!self->priv->properties || !self->priv->rules)
         return;
 
-    /* Don't preload on "remove" actions, where we don't have the device any more */
-    if (g_strcmp0 (mm_kernel_event_properties_get_action (self->priv->properties), "remove") == 0)
+    /* Don't preload on "remove" actions, where we don't have the device any more;
+     * just make sure we don't reuse the physdev contents we may have cached */
+    if (g_strcmp0 (mm_kernel_event_properties_get_action (self->priv->properties), "remove") == 0) {
+        physdev_info_invalidate (mm_kernel_event_properties_get_subsystem (self->priv->properties),
+                                 mm_kernel_event_properties_get_name      (self->priv->properties));
         return;
+    }
 
     /* Don't preload for devices in the 'virtual' subsystem */
     if (g_strcmp0 (mm_kernel_event_properties_get_subsystem (self->priv->properties), "virtual") == 0)
@@ -1041,8 +915,7 @@ dispose (GObject *object)
 {
     MMKernelDeviceGeneric *self = MM_KERNEL_DEVICE_GENERIC (object);
 
-    g_clear_pointer (&self->priv->physdev_product,      g_free);
-    g_clear_pointer (&self->priv->physdev_manufacturer, g_free);
+    g_clear_pointer (&self->priv->physdev,              physdev_info_unref);
     g_clear_pointer (&self->priv->physdev_sysfs_path,   g_free);
     g_clear_pointer (&self->priv->interface_sysfs_path, g_free);
     g_clear_pointer (&self->priv->sysfs_path,           g_free);
@@ -27,6 +27,7 @@
 #include "ModemManager.h"
 
 #include "mm-base-manager.h"
+#include "mm-plugin-manager.h"
 #include "mm-log.h"
 #include "mm-context.h"
 
@@ -130,6 +131,24 @@ name_lost_cb (GDBusConnection *connection,
     g_main_loop_quit (loop);
 }
 
+static gboolean
+generate_plugin_manifest (const gchar *path)
+{
+    MMPluginManager *plugin_manager;
+    GError *error = NULL;
+
+    plugin_manager = mm_plugin_manager_new (mm_context_get_test_plugin_dir (), NULL, &error);
+    if (!plugin_manager || !mm_plugin_manager_write_manifest (plugin_manager, path, &error)) {
+        g_printerr ("error: couldn't generate plugin manifest: %s\n", error->message);
+        g_error_free (error);
+        g_clear_object (&plugin_manager);
+        return FALSE;
+    }
+
+    g_object_unref (plugin_manager);
+    return TRUE;
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -151,6 +170,14 @@ main (int argc, char *argv[])
         exit (1);
     }
 
+    if (mm_context_get_plugin_manifest ()) {
+        gboolean generated;
+
+        generated = generate_plugin_manifest (mm_context_get_plugin_manifest ());
+        mm_log_shutdown ();
+        return generated ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     g_unix_signal_add (SIGTERM, quit_cb, NULL);
     g_unix_signal_add (SIGINT, quit_cb, NULL);
 
@@ -36,8 +36,11 @@
 #include "mm-base-modem-at.h"
 #include "mm-base-modem.h"
 #include "mm-log.h"
+#include "mm-context.h"
 #include "mm-modem-helpers.h"
 #include "mm-bearer-stats.h"
+#include "mm-net-stats.h"
+#include "mm-net-link-watch.h"
 
 /* We require up to 20s to get a proper IP when using PPP */
 #define BEARER_IP_TIMEOUT_DEFAULT 20
@@ -46,9 +49,10 @@
 
 #define BEARER_STATS_UPDATE_TIMEOUT 30
 
-/* Initial connectivity check after 30s, then each 5s */
+/* Unless the implementation reports connection status changes through
+ * events, initial connectivity check after 30s, then each 20s */
 #define BEARER_CONNECTION_MONITOR_INITIAL_TIMEOUT 30
-#define BEARER_CONNECTION_MONITOR_TIMEOUT          5
+#define BEARER_CONNECTION_MONITOR_TIMEOUT         20
 
 G_DEFINE_TYPE (MMBaseBearer, mm_base_bearer, MM_GDBUS_TYPE_BEARER_SKELETON)
 
@@ -96,6 +100,15 @@ struct _MMBaseBearerPrivate {
     guint connection_monitor_id;
     /* Flag to specify whether connection monitoring is supported or not */
     gboolean load_connection_status_unsupported;
+    /* Whether a connection status check is running, and whether another one
+     * was requested meanwhile */
+    gboolean load_connection_status_ongoing;
+    gboolean load_connection_status_pending;
+    /* Flag to specify whether connection status changes are reported through
+     * events, so that there's no need to poll */
+    gboolean connection_monitor_events;
+    /* Network interface link watch */
+    guint connection_monitor_link_id;
 
     /*-- 3GPP specific --*/
     guint deferred_3gpp_unregistration_id;
@@ -120,6 +133,8 @@ struct _MMBaseBearerPrivate {
     GTimer *duration_timer;
     /* Flag to specify whether reloading stats is supported or not */
     gboolean reload_stats_unsupported;
+    /* Network interface counters, if stats are read from them */
+    MMNetStatsReader *net_stats;
 };
 
 /*****************************************************************************/
@@ -155,6 +170,11 @@ connection_monitor_stop (MMBaseBearer *self)
         g_source_remove (self->priv->connection_monitor_id);
         self->priv->connection_monitor_id = 0;
     }
+
+    if (self->priv->connection_monitor_link_id) {
+        mm_net_link_watch_remove (self->priv->connection_monitor_link_id);
+        self->priv->connection_monitor_link_id = 0;
+    }
 }
 
 static void
@@ -164,12 +184,17 @@ load_connection_status_ready (MMBaseBearer *self,
     GError                   *error = NULL;
     MMBearerConnectionStatus  status;
 
+    self->priv->load_connection_status_ongoing = FALSE;
+
     status = MM_BASE_BEARER_GET_CLASS (self)->load_connection_status_finish (self, res, &error);
     if (status == MM_BEARER_CONNECTION_STATUS_UNKNOWN) {
         /* Only warn if not reporting an "unsupported" error */
         if (!g_error_matches (error, MM_CORE_ERROR, MM_CORE_ERROR_UNSUPPORTED)) {
             mm_warn ("checking if connected failed: %s", error->message);
             g_error_free (error);
+            /* Retry right away if something changed while checking */
+            if (self->priv->load_connection_status_pending)
+                mm_base_bearer_check_connection_status (self);
             return;
         }
 
@@ -177,7 +202,11 @@ load_connection_status_ready (MMBaseBearer *self,
          * ignore the error and remove the timeout. */
         mm_dbg ("Connection monitoring is unsupported by the device");
         self->priv->load_connection_status_unsupported = TRUE;
-        connection_monitor_stop (self);
+        self->priv->load_connection_status_pending = FALSE;
+        if (self->priv->connection_monitor_id) {
+            g_source_remove (self->priv->connection_monitor_id);
+            self->priv->connection_monitor_id = 0;
+        }
         g_error_free (error);
         return;
     }
@@ -186,26 +215,43 @@ load_connection_status_ready (MMBaseBearer *self,
     g_assert (status == MM_BEARER_CONNECTION_STATUS_CONNECTED || status == MM_BEARER_CONNECTION_STATUS_DISCONNECTED);
     mm_dbg ("connection status loaded: %s", mm_bearer_connection_status_get_string (status));
     mm_base_bearer_report_connection_status (self, status);
+
+    /* The status loaded may predate an event received while checking, so
+     * check once more; this is a no-op if no longer connected */
+    if (self->priv->load_connection_status_pending)
+        mm_base_bearer_check_connection_status (self);
 }
 
-static gboolean
-connection_monitor_cb (MMBaseBearer *self)
+/* Runs a single connection status check at a time; requests received while
+ * one is running are coalesced into a single check run afterwards */
+static void
+load_connection_status (MMBaseBearer *self)
 {
-    /* If the implementation knows how to load connection status, run it */
+    if (self->priv->load_connection_status_ongoing) {
+        self->priv->load_connection_status_pending = TRUE;
+        return;
+    }
+
+    self->priv->load_connection_status_ongoing = TRUE;
+    self->priv->load_connection_status_pending = FALSE;
     MM_BASE_BEARER_GET_CLASS (self)->load_connection_status (
         self,
         (GAsyncReadyCallback)load_connection_status_ready,
         NULL);
+}
+
+static gboolean
+connection_monitor_cb (MMBaseBearer *self)
+{
+    /* If the implementation knows how to load connection status, run it */
+    load_connection_status (self);
     return G_SOURCE_CONTINUE;
 }
 
 static gboolean
 initial_connection_monitor_cb (MMBaseBearer *self)
 {
-    MM_BASE_BEARER_GET_CLASS (self)->load_connection_status (
-        self,
-        (GAsyncReadyCallback)load_connection_status_ready,
-        NULL);
+    load_connection_status (self);
 
     /* Add new monitor timeout at a higher rate */
     self->priv->connection_monitor_id = g_timeout_add_seconds (BEARER_CONNECTION_MONITOR_TIMEOUT,
@@ -216,9 +262,57 @@ initial_connection_monitor_cb (MMBaseBearer *self)
     return G_SOURCE_REMOVE;
 }
 
+void
+mm_base_bearer_check_connection_status (MMBaseBearer *self)
+{
+    self->priv->load_connection_status_pending = FALSE;
+
+    if (self->priv->status != MM_BEARER_STATUS_CONNECTED)
+        return;
+
+    if (!MM_BASE_BEARER_GET_CLASS (self)->load_connection_status ||
+        !MM_BASE_BEARER_GET_CLASS (self)->load_connection_status_finish ||
+        self->priv->load_connection_status_unsupported)
+        return;
+
+    load_connection_status (self);
+}
+
+static void
+connection_monitor_link_cb (const gchar *iface,
+                            gboolean removed,
+                            MMBaseBearer *self)
+{
+    mm_dbg ("Network interface '%s' %s", iface, removed ? "removed" : "lost carrier");
+
+    /* Some drivers drop carrier while still connected, so only trust the
+     * interface going away if the connection status can't be checked */
+    if (removed &&
+        (!MM_BASE_BEARER_GET_CLASS (self)->load_connection_status ||
+         !MM_BASE_BEARER_GET_CLASS (self)->load_connection_status_finish ||
+         self->priv->load_connection_status_unsupported)) {
+        mm_base_bearer_report_connection_status (self, MM_BEARER_CONNECTION_STATUS_DISCONNECTED);
+        return;
+    }
+
+    mm_base_bearer_check_connection_status (self);
+}
+
 static void
 connection_monitor_start (MMBaseBearer *self)
 {
+    const gchar *interface;
+
+    /* Watch the network interface, if any; this doesn't involve the modem
+     * at all. For PPP the interface is the TTY, which is never reported. */
+    interface = mm_gdbus_bearer_get_interface (MM_GDBUS_BEARER (self));
+    if (interface) {
+        g_assert (!self->priv->connection_monitor_link_id);
+        self->priv->connection_monitor_link_id = mm_net_link_watch_add (interface,
+                                                                        (MMNetLinkWatchFn) connection_monitor_link_cb,
+                                                                        self);
+    }
+
     /* If not implemented, don't schedule anything */
     if (!MM_BASE_BEARER_GET_CLASS (self)->load_connection_status ||
         !MM_BASE_BEARER_GET_CLASS (self)->load_connection_status_finish)
@@ -227,6 +321,12 @@ connection_monitor_start (MMBaseBearer *self)
     if (self->priv->load_connection_status_unsupported)
         return;
 
+    /* No need to poll if we're told about disconnections */
+    if (self->priv->connection_monitor_events) {
+        mm_dbg ("Connection status reported through events, not polling");
+        return;
+    }
+
     /* Schedule initial check */
     g_assert (!self->priv->connection_monitor_id);
     self->priv->connection_monitor_id = g_timeout_add_seconds (BEARER_CONNECTION_MONITOR_INITIAL_TIMEOUT,
@@ -265,6 +365,11 @@ bearer_stats_stop (MMBaseBearer *self)
         g_source_remove (self->priv->stats_update_id);
         self->priv->stats_update_id = 0;
     }
+
+    if (self->priv->net_stats) {
+        mm_net_stats_reader_free (self->priv->net_stats);
+        self->priv->net_stats = NULL;
+    }
 }
 
 static void
@@ -321,9 +426,42 @@ stats_update_cb (MMBaseBearer *self)
     return G_SOURCE_CONTINUE;
 }
 
+static gboolean
+net_stats_update_cb (MMBaseBearer *self)
+{
+    const MMNetStats *net_stats;
+    GError           *error = NULL;
+
+    /* The interface may be going away along with the connection, just keep
+     * the last values until we're told about it */
+    if (!mm_net_stats_reader_update (self->priv->net_stats, g_get_monotonic_time (), &error)) {
+        mm_dbg ("Couldn't update network interface stats: %s", error->message);
+        g_error_free (error);
+        return G_SOURCE_CONTINUE;
+    }
+
+    net_stats = mm_net_stats_reader_peek (self->priv->net_stats);
+    mm_bearer_stats_set_duration        (self->priv->stats, (guint32) g_timer_elapsed (self->priv->duration_timer, NULL));
+    mm_bearer_stats_set_rx_bytes        (self->priv->stats, net_stats->rx_bytes);
+    mm_bearer_stats_set_tx_bytes        (self->priv->stats, net_stats->tx_bytes);
+    mm_bearer_stats_set_rx_packets      (self->priv->stats, net_stats->rx_packets);
+    mm_bearer_stats_set_tx_packets      (self->priv->stats, net_stats->tx_packets);
+    mm_bearer_stats_set_rx_rate         (self->priv->stats, net_stats->rx_rate.current);
+    mm_bearer_stats_set_tx_rate         (self->priv->stats, net_stats->tx_rate.current);
+    mm_bearer_stats_set_rx_rate_average (self->priv->stats, net_stats->rx_rate.average);
+    mm_bearer_stats_set_tx_rate_average (self->priv->stats, net_stats->tx_rate.average);
+    mm_bearer_stats_set_rx_rate_peak    (self->priv->stats, net_stats->rx_rate.peak);
+    mm_bearer_stats_set_tx_rate_peak    (self->priv->stats, net_stats->tx_rate.peak);
+    bearer_update_interface_stats (self);
+    return G_SOURCE_CONTINUE;
+}
+
 static void
-bearer_stats_start (MMBaseBearer *self)
+bearer_stats_start (MMBaseBearer *self,
+                    const gchar *interface)
 {
+    guint interval;
+
     /* Allocate new stats object. If there was one already created from a
      * previous run, deallocate it */
     g_assert (!self->priv->stats);
@@ -333,8 +471,32 @@ bearer_stats_start (MMBaseBearer *self)
     g_assert (!self->priv->duration_timer);
     self->priv->duration_timer = g_timer_new ();
 
-    /* Schedule */
     g_assert (!self->priv->stats_update_id);
+
+    /* If requested, read the counters of the network interface instead of
+     * querying the modem; this is cheap enough to be done every second. If
+     * the data port isn't a network interface (e.g. PPP over a TTY), fall
+     * back to the modem. */
+    interval = mm_context_get_bearer_stats_interval ();
+    if (interval > 0 && interface) {
+        GError *error = NULL;
+
+        g_assert (!self->priv->net_stats);
+        self->priv->net_stats = mm_net_stats_reader_new (interface, g_get_monotonic_time (), &error);
+        if (self->priv->net_stats) {
+            self->priv->stats_update_id = g_timeout_add_seconds (interval,
+                                                                 (GSourceFunc) net_stats_update_cb,
+                                                                 self);
+            net_stats_update_cb (self);
+            return;
+        }
+
+        mm_dbg ("Couldn't read stats from interface '%s', loading them from the modem: %s",
+                interface, error->message);
+        g_error_free (error);
+    }
+
+    /* Schedule */
     self->priv->stats_update_id = g_timeout_add_seconds (BEARER_STATS_UPDATE_TIMEOUT,
                                                          (GSourceFunc) stats_update_cb,
                                                          self);
@@ -397,7 +559,7 @@ bearer_update_status_connected (MMBaseBearer *self,
         mm_bearer_ip_config_get_dictionary (ipv6_config));
 
     /* Start statistics */
-    bearer_stats_start (self);
+    bearer_stats_start (self, interface);
 
     /* Start connection monitor, if supported */
     connection_monitor_start (self);
@@ -1238,6 +1400,22 @@ report_connection_status (MMBaseBearer *self,
         bearer_update_status (self, MM_BEARER_STATUS_DISCONNECTED);
 }
 
+void
+mm_base_bearer_set_connection_monitor_events (MMBaseBearer *self,
+                                              gboolean enabled)
+{
+    if (self->priv->connection_monitor_events == enabled)
+        return;
+
+    self->priv->connection_monitor_events = enabled;
+
+    /* Reschedule polling if already connected */
+    if (self->priv->status == MM_BEARER_STATUS_CONNECTED) {
+        connection_monitor_stop (self);
+        connection_monitor_start (self);
+    }
+}
+
 void
 mm_base_bearer_report_connection_status (MMBaseBearer *self,
                                          MMBearerConnectionStatus status)
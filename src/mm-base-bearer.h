@@ -157,4 +157,16 @@ void mm_base_bearer_disconnect_force (MMBaseBearer *self);
 void mm_base_bearer_report_connection_status (MMBaseBearer *self,
                                               MMBearerConnectionStatus status);
 
+/* Implementations which get connection status changes reported through
+ * unsolicited events (and which will therefore call
+ * mm_base_bearer_report_connection_status() on their own) may let the base
+ * class know, so that load_connection_status() isn't polled. */
+void mm_base_bearer_set_connection_monitor_events (MMBaseBearer *self,
+                                                   gboolean enabled);
+
+/* Run load_connection_status() right away, if supported and connected; e.g.
+ * when an event suggests the connection may have been lost. If a check is
+ * already running, another one is run once it finishes. */
+void mm_base_bearer_check_connection_status (MMBaseBearer *self);
+
 #endif /* MM_BASE_BEARER_H */
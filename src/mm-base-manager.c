@@ -215,6 +215,9 @@ device_removed (MMBaseManager  *self,
     subsys = mm_kernel_device_get_subsystem (kernel_device);
     name = mm_kernel_device_get_name (kernel_device);
 
+    /* Don't reuse the filter results of this device any more */
+    mm_filter_port_removed (self->priv->filter, kernel_device);
+
     if (!g_str_has_prefix (subsys, "usb") ||
         (name && g_str_has_prefix (name, "cdc-wdm"))) {
         /* Handle tty/net/wdm port removal */
@@ -608,6 +611,7 @@ mm_base_manager_start (MMBaseManager *self,
     mm_dbg ("Starting %s device scan...", manual_scan ? "manual" : "automatic");
     process_scan (self, manual_scan);
     mm_dbg ("Finished device scan...");
+    mm_filter_report_rule_hits (self->priv->filter);
 #else
     mm_dbg ("Unsupported %s device scan...", manual_scan ? "manual" : "automatic");
 #endif
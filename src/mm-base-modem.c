@@ -87,6 +87,8 @@ struct _MMBaseModemPrivate {
     MMPortSerialAt *secondary;
     MMPortSerialQcdm *qcdm;
     GList *data;
+    /* Data ports being used by bearers still connecting; not owned */
+    GList *reserved_data;
 
     /* GPS-enabled modems will have an AT port for control, and a raw serial
      * port to receive all GPS traces */
@@ -712,9 +714,11 @@ mm_base_modem_peek_best_data_port (MMBaseModem *self,
 
     g_return_val_if_fail (MM_IS_BASE_MODEM (self), NULL);
 
-    /* Return first not-connected data port */
+    /* Return first not-connected data port, skipping the ones reserved by
+     * bearers being connected */
     for (l = self->priv->data; l; l = g_list_next (l)) {
         if (!mm_port_get_connected ((MMPort *)l->data) &&
+            !g_list_find (self->priv->reserved_data, l->data) &&
             (mm_port_get_port_type ((MMPort *)l->data) == type ||
              type == MM_PORT_TYPE_UNKNOWN)) {
             return (MMPort *)l->data;
@@ -724,6 +728,28 @@ mm_base_modem_peek_best_data_port (MMBaseModem *self,
     return NULL;
 }
 
+gboolean
+mm_base_modem_reserve_data_port (MMBaseModem *self,
+                                 MMPort *port)
+{
+    g_return_val_if_fail (MM_IS_BASE_MODEM (self), FALSE);
+
+    if (g_list_find (self->priv->reserved_data, port))
+        return FALSE;
+
+    self->priv->reserved_data = g_list_prepend (self->priv->reserved_data, port);
+    return TRUE;
+}
+
+void
+mm_base_modem_release_data_port (MMBaseModem *self,
+                                 MMPort *port)
+{
+    g_return_if_fail (MM_IS_BASE_MODEM (self));
+
+    self->priv->reserved_data = g_list_remove (self->priv->reserved_data, port);
+}
+
 GList *
 mm_base_modem_get_data_ports (MMBaseModem *self)
 {
@@ -1454,6 +1480,8 @@ dispose (GObject *object)
 
     g_clear_object (&self->priv->primary);
     g_clear_object (&self->priv->secondary);
+    g_list_free (self->priv->reserved_data);
+    self->priv->reserved_data = NULL;
     g_list_free_full (self->priv->data, g_object_unref);
     self->priv->data = NULL;
     g_clear_object (&self->priv->qcdm);
@@ -150,6 +150,12 @@ MMPortSerialAt   *mm_base_modem_get_best_at_port      (MMBaseModem *self, GError
 MMPort           *mm_base_modem_get_best_data_port    (MMBaseModem *self, MMPortType type);
 GList            *mm_base_modem_get_data_ports        (MMBaseModem *self);
 
+/* While a bearer is connecting, the data port it uses is not yet flagged as
+ * connected; reserving it ensures that bearers connecting at the same time
+ * don't get the same best data port. Returns FALSE if already reserved. */
+gboolean          mm_base_modem_reserve_data_port     (MMBaseModem *self, MMPort *port);
+void              mm_base_modem_release_data_port     (MMBaseModem *self, MMPort *port);
+
 MMModemPortInfo *mm_base_modem_get_port_infos         (MMBaseModem *self,
                                                        guint *n_port_infos);
 
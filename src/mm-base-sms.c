@@ -31,6 +31,7 @@
 #include "mm-iface-modem.h"
 #include "mm-iface-modem-messaging.h"
 #include "mm-sms-part-3gpp.h"
+#include "mm-sms-storage-cache.h"
 #include "mm-base-modem-at.h"
 #include "mm-base-modem.h"
 #include "mm-log.h"
@@ -895,6 +896,9 @@ store_msg_data_ready (MMBaseModem *modem,
     /* Set the index in the part we hold */
     mm_sms_part_set_index ((MMSmsPart *)ctx->current->data, (guint)idx);
 
+    /* Any cached listing of this storage no longer matches its contents */
+    mm_sms_storage_cache_invalidate (ctx->modem, ctx->storage);
+
     ctx->current = g_list_next (ctx->current);
     sms_store_next_part (task);
 }
@@ -1184,6 +1188,10 @@ send_from_storage_ready (MMBaseModem *modem,
     mm_sms_part_set_message_reference ((MMSmsPart *)ctx->current->data,
                                        (guint)message_reference);
 
+    /* Modems may update the status of the stored part once sent */
+    mm_sms_storage_cache_invalidate (ctx->modem,
+                                     mm_base_sms_get_storage (MM_BASE_SMS (g_task_get_source_object (task))));
+
     ctx->current = g_list_next (ctx->current);
     sms_send_next_part (task);
 }
@@ -1345,9 +1353,11 @@ delete_part_ready (MMBaseModem *modem,
                    GAsyncResult *res,
                    GTask *task)
 {
+    MMBaseSms *self;
     SmsDeletePartsContext *ctx;
     GError *error = NULL;
 
+    self = g_task_get_source_object (task);
     ctx = g_task_get_task_data (task);
 
     mm_base_modem_at_command_finish (modem, res, &error);
@@ -1357,7 +1367,12 @@ delete_part_ready (MMBaseModem *modem,
                 mm_sms_part_get_index ((MMSmsPart *)ctx->current->data),
                 error->message);
         g_error_free (error);
-    }
+        /* Unsure about what the storage holds now */
+        mm_sms_storage_cache_invalidate (ctx->modem, mm_base_sms_get_storage (self));
+    } else
+        mm_sms_storage_cache_remove_part (ctx->modem,
+                                          mm_base_sms_get_storage (self),
+                                          mm_sms_part_get_index ((MMSmsPart *)ctx->current->data));
 
     /* We reset the index, as there is no longer that part */
     mm_sms_part_set_index ((MMSmsPart *)ctx->current->data, SMS_PART_INVALID_INDEX);
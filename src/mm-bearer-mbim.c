@@ -219,6 +219,7 @@ typedef enum {
 } ConnectStep;
 
 typedef struct {
+    MMBaseModem *modem;
     MbimDevice *device;
     MMBearerProperties *properties;
     ConnectStep step;
@@ -232,9 +233,11 @@ connect_context_free (ConnectContext *ctx)
 {
     if (ctx->connect_result)
         mm_bearer_connect_result_unref (ctx->connect_result);
+    mm_base_modem_release_data_port (ctx->modem, ctx->data);
     g_object_unref (ctx->data);
     g_object_unref (ctx->properties);
     g_object_unref (ctx->device);
+    g_object_unref (ctx->modem);
     g_slice_free (ConnectContext, ctx);
 }
 
@@ -1141,13 +1144,16 @@ _connect (MMBaseBearer *self,
         return;
     }
 
-    g_object_unref (modem);
-
     mm_dbg ("Launching connection with data port (%s/%s)",
             mm_port_subsys_get_string (mm_port_get_subsys (data)),
             mm_port_get_device (data));
 
+    /* Bearers use different session IDs, so others may connect through
+     * other data ports in the meantime */
+    mm_base_modem_reserve_data_port (modem, data);
+
     ctx = g_slice_new0 (ConnectContext);
+    ctx->modem = modem;
     ctx->device = g_object_ref (device);;
     ctx->data = g_object_ref (data);
     ctx->step = CONNECT_STEP_FIRST;
@@ -411,6 +411,7 @@ typedef enum {
 
 typedef struct {
     MMBearerQmi *self;
+    MMBaseModem *modem;
     ConnectStep step;
     MMPort *data;
     MMPortQmi *qmi;
@@ -478,8 +479,10 @@ connect_context_free (ConnectContext *ctx)
     g_clear_object (&ctx->client_ipv6);
     g_clear_object (&ctx->ipv4_config);
     g_clear_object (&ctx->ipv6_config);
+    mm_base_modem_release_data_port (ctx->modem, ctx->data);
     g_object_unref (ctx->data);
     g_object_unref (ctx->qmi);
+    g_object_unref (ctx->modem);
     g_object_unref (ctx->self);
     g_slice_free (ConnectContext, ctx);
 }
@@ -1484,6 +1487,13 @@ connect_context_step (GTask *task)
                 ctx->self->priv->client_ipv6 = g_object_ref (ctx->client_ipv6);
             }
 
+            /* Disconnections are reported through packet service status
+             * indications in every connected client, no need to poll */
+            mm_base_bearer_set_connection_monitor_events (
+                MM_BASE_BEARER (ctx->self),
+                (!ctx->self->priv->packet_data_handle_ipv4 || ctx->self->priv->packet_service_status_ipv4_indication_id) &&
+                (!ctx->self->priv->packet_data_handle_ipv6 || ctx->self->priv->packet_service_status_ipv6_indication_id));
+
             /* Set operation result */
             g_task_return_pointer (
                 task,
@@ -1589,16 +1599,19 @@ _connect (MMBaseBearer *self,
         return;
     }
 
-    g_object_unref (modem);
-
     mm_dbg ("Launching connection with QMI port (%s/%s) and data port (%s/%s)",
             mm_port_subsys_get_string (mm_port_get_subsys (MM_PORT (qmi))),
             mm_port_get_device (MM_PORT (qmi)),
             mm_port_subsys_get_string (mm_port_get_subsys (data)),
             mm_port_get_device (data));
 
+    /* Each bearer has its own data port, and therefore its own QMI port and
+     * WDS clients, so several bearers may be connected at the same time */
+    mm_base_modem_reserve_data_port (modem, data);
+
     ctx = g_slice_new0 (ConnectContext);
     ctx->self = g_object_ref (self);
+    ctx->modem = modem;
     ctx->qmi = qmi;
     ctx->data = data;
     ctx->step = CONNECT_STEP_FIRST;
@@ -0,0 +1,180 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ */
+
+#include <string.h>
+
+#include "mm-bit-stream.h"
+
+/*****************************************************************************/
+/* Reader */
+
+void
+mm_bit_reader_init (MMBitReader *reader,
+                    const guint8 *data,
+                    gsize len)
+{
+    reader->data = data;
+    reader->len = len;
+    reader->bit_offset = 0;
+}
+
+gsize
+mm_bit_reader_get_remaining (const MMBitReader *reader)
+{
+    return (reader->len * 8) - reader->bit_offset;
+}
+
+gboolean
+mm_bit_reader_skip (MMBitReader *reader,
+                    guint n_bits)
+{
+    if (mm_bit_reader_get_remaining (reader) < n_bits)
+        return FALSE;
+
+    reader->bit_offset += n_bits;
+    return TRUE;
+}
+
+gboolean
+mm_bit_reader_read (MMBitReader *reader,
+                    guint n_bits,
+                    guint32 *out)
+{
+    guint32 value = 0;
+    gsize bit_offset;
+
+    g_assert (n_bits <= 32);
+
+    if (mm_bit_reader_get_remaining (reader) < n_bits)
+        return FALSE;
+
+    /* Take as many bits as available in each byte at once */
+    bit_offset = reader->bit_offset;
+    while (n_bits > 0) {
+        guint in_byte;
+        guint n;
+
+        in_byte = 8 - (bit_offset & 7);
+        n = MIN (in_byte, n_bits);
+        value = (value << n) | ((reader->data[bit_offset >> 3] >> (in_byte - n)) & ((1 << n) - 1));
+        bit_offset += n;
+        n_bits -= n;
+    }
+
+    reader->bit_offset = bit_offset;
+    if (out)
+        *out = value;
+    return TRUE;
+}
+
+gboolean
+mm_bit_reader_read_bytes (MMBitReader *reader,
+                          guint8 *out,
+                          gsize n_bytes)
+{
+    const guint8 *src;
+    guint shift;
+    gsize i;
+
+    if (mm_bit_reader_get_remaining (reader) / 8 < n_bytes)
+        return FALSE;
+
+    src = &reader->data[reader->bit_offset >> 3];
+    shift = reader->bit_offset & 7;
+
+    if (shift == 0)
+        memcpy (out, src, n_bytes);
+    else {
+        /* Each output byte is made of the tail of one input byte and the
+         * head of the next one, which is always within bounds as we're
+         * not aligned */
+        for (i = 0; i < n_bytes; i++)
+            out[i] = (guint8)((src[i] << shift) | (src[i + 1] >> (8 - shift)));
+    }
+
+    reader->bit_offset += n_bytes * 8;
+    return TRUE;
+}
+
+/*****************************************************************************/
+/* Writer */
+
+void
+mm_bit_writer_init (MMBitWriter *writer,
+                    guint8 *data,
+                    gsize len)
+{
+    writer->data = data;
+    writer->len = len;
+    writer->bit_offset = 0;
+}
+
+gsize
+mm_bit_writer_get_length (const MMBitWriter *writer)
+{
+    return (writer->bit_offset + 7) / 8;
+}
+
+gboolean
+mm_bit_writer_write (MMBitWriter *writer,
+                     guint n_bits,
+                     guint32 value)
+{
+    gsize bit_offset;
+
+    g_assert (n_bits <= 32);
+
+    if ((writer->len * 8) - writer->bit_offset < n_bits)
+        return FALSE;
+
+    /* Fill in as many bits as available in each byte at once */
+    bit_offset = writer->bit_offset;
+    while (n_bits > 0) {
+        guint in_byte;
+        guint n;
+        guint8 mask;
+        guint8 bits;
+
+        in_byte = 8 - (bit_offset & 7);
+        n = MIN (in_byte, n_bits);
+        mask = (guint8)(((1 << n) - 1) << (in_byte - n));
+        bits = (guint8)(((value >> (n_bits - n)) << (in_byte - n)) & mask);
+        writer->data[bit_offset >> 3] = (writer->data[bit_offset >> 3] & ~mask) | bits;
+        bit_offset += n;
+        n_bits -= n;
+    }
+
+    writer->bit_offset = bit_offset;
+    return TRUE;
+}
+
+gboolean
+mm_bit_writer_write_bytes (MMBitWriter *writer,
+                           const guint8 *bytes,
+                           gsize n_bytes)
+{
+    gsize i;
+
+    if (((writer->len * 8) - writer->bit_offset) / 8 < n_bytes)
+        return FALSE;
+
+    if ((writer->bit_offset & 7) == 0) {
+        memcpy (&writer->data[writer->bit_offset >> 3], bytes, n_bytes);
+        writer->bit_offset += n_bytes * 8;
+        return TRUE;
+    }
+
+    for (i = 0; i < n_bytes; i++)
+        mm_bit_writer_write (writer, 8, bytes[i]);
+    return TRUE;
+}
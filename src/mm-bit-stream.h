@@ -0,0 +1,76 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ */
+
+#ifndef MM_BIT_STREAM_H
+#define MM_BIT_STREAM_H
+
+#include <glib.h>
+
+/* Bounds-checked readers and writers of bit fields packed most significant
+ * bit first, as used e.g. in CDMA SMS PDUs:
+ *
+ * Byte 0            Byte 1
+ * [7|6|5|4|3|2|1|0] [7|6|5|4|3|2|1|0]
+ *
+ * Both are plain structs meant to live in the stack; none of the operations
+ * allocate memory. */
+
+/*****************************************************************************/
+/* Reader */
+
+typedef struct {
+    const guint8 *data;
+    gsize         len;
+    gsize         bit_offset;
+} MMBitReader;
+
+void     mm_bit_reader_init           (MMBitReader *reader,
+                                       const guint8 *data,
+                                       gsize len);
+gsize    mm_bit_reader_get_remaining  (const MMBitReader *reader);
+gboolean mm_bit_reader_skip           (MMBitReader *reader,
+                                       guint n_bits);
+/* n_bits <= 32 */
+gboolean mm_bit_reader_read           (MMBitReader *reader,
+                                       guint n_bits,
+                                       guint32 *out);
+gboolean mm_bit_reader_read_bytes     (MMBitReader *reader,
+                                       guint8 *out,
+                                       gsize n_bytes);
+
+/*****************************************************************************/
+/* Writer
+ *
+ * Bits are written over whatever the buffer holds, so it doesn't need to be
+ * cleared beforehand. */
+
+typedef struct {
+    guint8 *data;
+    gsize   len;
+    gsize   bit_offset;
+} MMBitWriter;
+
+void     mm_bit_writer_init           (MMBitWriter *writer,
+                                       guint8 *data,
+                                       gsize len);
+/* Number of bytes written to, including a last partial one */
+gsize    mm_bit_writer_get_length     (const MMBitWriter *writer);
+/* n_bits <= 32 */
+gboolean mm_bit_writer_write          (MMBitWriter *writer,
+                                       guint n_bits,
+                                       guint32 value);
+gboolean mm_bit_writer_write_bytes    (MMBitWriter *writer,
+                                       const guint8 *bytes,
+                                       gsize n_bytes);
+
+#endif /* MM_BIT_STREAM_H */
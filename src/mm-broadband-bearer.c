@@ -28,10 +28,12 @@
 #include <libmm-glib.h>
 
 #include "mm-broadband-bearer.h"
+#include "mm-broadband-modem.h"
 #include "mm-iface-modem.h"
 #include "mm-iface-modem-3gpp.h"
 #include "mm-iface-modem-cdma.h"
 #include "mm-base-modem-at.h"
+#include "mm-bearer-list.h"
 #include "mm-log.h"
 #include "mm-modem-helpers.h"
 #include "mm-port-enums-types.h"
@@ -132,6 +134,7 @@ detailed_connect_context_free (DetailedConnectContext *ctx)
     if (ctx->data) {
         if (ctx->close_data_on_exit)
             mm_port_serial_close (MM_PORT_SERIAL (ctx->data));
+        mm_base_modem_release_data_port (ctx->modem, ctx->data);
         g_object_unref (ctx->data);
     }
     g_object_unref (ctx->modem);
@@ -176,7 +179,18 @@ common_get_at_data_port (MMBaseModem *modem,
 
     g_assert (MM_IS_PORT_SERIAL_AT (data));
 
+    /* Only the primary port fallback may already be taken, by another bearer
+     * connecting at the same time */
+    if (!mm_base_modem_reserve_data_port (modem, data)) {
+        g_set_error (error,
+                     MM_CORE_ERROR,
+                     MM_CORE_ERROR_IN_PROGRESS,
+                     "Couldn't connect: data port already being connected");
+        return NULL;
+    }
+
     if (!mm_port_serial_open (MM_PORT_SERIAL (data), error)) {
+        mm_base_modem_release_data_port (modem, data);
         g_prefix_error (error, "Couldn't connect: cannot keep data port open.");
         return NULL;
     }
@@ -456,8 +470,10 @@ dial_3gpp_context_free (Dial3gppContext *ctx)
 {
     if (ctx->saved_error)
         g_error_free (ctx->saved_error);
-    if (ctx->dial_port)
+    if (ctx->dial_port) {
+        mm_base_modem_release_data_port (ctx->modem, MM_PORT (ctx->dial_port));
         g_object_unref (ctx->dial_port);
+    }
     g_object_unref (ctx->primary);
     g_object_unref (ctx->modem);
     g_slice_free (Dial3gppContext, ctx);
@@ -660,33 +676,31 @@ initialize_pdp_context_ready (MMBaseModem  *modem,
     mm_base_modem_at_command_full_finish (modem, res, &error);
     if (error) {
         mm_warn ("Couldn't initialize PDP context with our APN: '%s'", error->message);
+        /* We don't know how the context was left */
+        mm_broadband_modem_invalidate_3gpp_pdp_contexts (MM_BROADBAND_MODEM (modem));
         g_task_return_error (task, error);
-    } else
+    } else {
+        /* Keep the cached list in sync, so that reconnections with the same
+         * settings can use the context right away */
+        mm_broadband_modem_update_3gpp_pdp_context (MM_BROADBAND_MODEM (modem),
+                                                    ctx->cid,
+                                                    ctx->ip_family,
+                                                    mm_bearer_properties_get_apn (mm_base_bearer_peek_config (MM_BASE_BEARER (ctx->self))));
         g_task_return_int (task, (gssize) ctx->cid);
+    }
     g_object_unref (task);
 }
 
 static void
-find_cid_ready (MMBaseModem  *modem,
-                GAsyncResult *res,
-                GTask        *task)
+cid_selected (GTask *task)
 {
     gchar                   *apn;
     gchar                   *command;
-    GError                  *error = NULL;
     const gchar             *pdp_type;
     CidSelection3gppContext *ctx;
 
     ctx = (CidSelection3gppContext *) g_task_get_task_data (task);
 
-    mm_base_modem_at_sequence_full_finish (modem, res, NULL, &error);
-    if (error) {
-        mm_warn ("Couldn't find best CID to use: '%s'", error->message);
-        g_task_return_error (task, error);
-        g_object_unref (task);
-        return;
-    }
-
     /* Validate requested PDP type */
     pdp_type = mm_3gpp_get_pdp_type_from_ip_family (ctx->ip_family);
     if (!pdp_type) {
@@ -701,9 +715,13 @@ find_cid_ready (MMBaseModem  *modem,
         return;
     }
 
-    /* If no error reported, we must have a valid CID to be used */
+    /* We must have a valid CID to be used */
     g_assert (ctx->cid != 0);
 
+    /* Claim it right away, so that other bearers connecting at the same time
+     * pick a different one */
+    ctx->self->priv->cid = ctx->cid;
+
     /* If there's already a PDP context defined, just use it */
     if (ctx->use_existing_cid) {
         g_task_return_int (task, (gssize) ctx->cid);
@@ -728,121 +746,209 @@ find_cid_ready (MMBaseModem  *modem,
 }
 
 static gboolean
-parse_cid_range (MMBaseModem              *modem,
-                 CidSelection3gppContext  *ctx,
-                 const gchar              *command,
-                 const gchar              *response,
-                 gboolean                  last_command,
-                 const GError             *error,
-                 GVariant                **result,
-                 GError                  **result_error)
+cid_selection_3gpp_return_if_cancelled (GTask *task)
 {
-    GError *inner_error = NULL;
-    GList  *formats, *l;
-    guint   cid;
+    CidSelection3gppContext *ctx;
 
-    /* If cancelled, set result error */
-    if (g_cancellable_is_cancelled (ctx->cancellable)) {
-        g_set_error (result_error, MM_CORE_ERROR, MM_CORE_ERROR_CANCELLED,
-                     "Connection setup operation has been cancelled");
+    ctx = (CidSelection3gppContext *) g_task_get_task_data (task);
+    if (!g_cancellable_is_cancelled (ctx->cancellable))
         return FALSE;
-    }
 
-    if (error) {
-        mm_dbg ("Unexpected +CGDCONT error: '%s'", error->message);
-        mm_dbg ("Defaulting to CID=1");
-        ctx->cid = 1;
-        return TRUE;
-    }
+    g_task_return_new_error (task, MM_CORE_ERROR, MM_CORE_ERROR_CANCELLED,
+                             "Connection setup operation has been cancelled");
+    g_object_unref (task);
+    return TRUE;
+}
 
-    formats = mm_3gpp_parse_cgdcont_test_response (response, &inner_error);
-    if (inner_error) {
-        mm_dbg ("Error parsing +CGDCONT test response: '%s'", inner_error->message);
-        mm_dbg ("Defaulting to CID=1");
-        g_error_free (inner_error);
-        ctx->cid = 1;
-        return TRUE;
+typedef struct {
+    MMBroadbandBearer *self;
+    guint              cid;
+    gboolean           in_use;
+} CidInUseContext;
+
+static void
+cid_in_use_foreach (MMBaseBearer    *bearer,
+                    CidInUseContext *ctx)
+{
+    if (bearer == MM_BASE_BEARER (ctx->self) ||
+        !MM_IS_BROADBAND_BEARER (bearer) ||
+        mm_base_bearer_get_status (bearer) == MM_BEARER_STATUS_DISCONNECTED)
+        return;
+
+    if (mm_broadband_bearer_get_3gpp_cid (MM_BROADBAND_BEARER (bearer)) == ctx->cid)
+        ctx->in_use = TRUE;
+}
+
+/* Whether the CID is used by another bearer, connected or being connected */
+static gboolean
+cid_in_use (CidSelection3gppContext *ctx,
+            guint                    cid)
+{
+    MMBearerList    *list = NULL;
+    CidInUseContext  in_use_ctx;
+
+    g_object_get (ctx->modem,
+                  MM_IFACE_MODEM_BEARER_LIST, &list,
+                  NULL);
+    if (!list)
+        return FALSE;
+
+    in_use_ctx.self = ctx->self;
+    in_use_ctx.cid = cid;
+    in_use_ctx.in_use = FALSE;
+    mm_bearer_list_foreach (list, (MMBearerListForeachFunc) cid_in_use_foreach, &in_use_ctx);
+    g_object_unref (list);
+
+    return in_use_ctx.in_use;
+}
+
+static gboolean
+select_default_cid (CidSelection3gppContext  *ctx,
+                    GError                  **error)
+{
+    if (cid_in_use (ctx, 1)) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_TOO_MANY,
+                     "No free CID left: the default CID 1 is in use");
+        return FALSE;
     }
 
-    cid = 0;
+    mm_dbg ("Defaulting to CID=1");
+    ctx->cid = 1;
+    return TRUE;
+}
+
+static gboolean
+select_cid_from_formats (CidSelection3gppContext  *ctx,
+                         GList                    *formats,
+                         GError                  **error)
+{
+    GList *l;
+
     for (l = formats; l; l = g_list_next (l)) {
         MM3gppPdpContextFormat *format = l->data;
+        gchar                  *ip_family_str;
+        guint                   cid;
 
         /* Found exact PDP type? */
-        if (format->pdp_type == ctx->ip_family) {
-            gchar *ip_family_str;
+        if (format->pdp_type != ctx->ip_family)
+            continue;
+
+        ip_family_str = mm_bearer_ip_family_build_string_from_mask (format->pdp_type);
 
-            ip_family_str = mm_bearer_ip_family_build_string_from_mask (format->pdp_type);
-            if (ctx->max_cid < format->max_cid) {
-                cid = ctx->max_cid + 1;
+        /* Contexts being defined by other bearers aren't listed yet */
+        for (cid = ctx->max_cid + 1; cid <= format->max_cid; cid++) {
+            if (!cid_in_use (ctx, cid)) {
                 mm_dbg ("Using empty CID %u with PDP type '%s'", cid, ip_family_str);
-            } else {
-                cid = ctx->max_cid;
-                mm_dbg ("Re-using CID %u (max) with PDP type '%s'", cid, ip_family_str);
+                ctx->cid = cid;
+                g_free (ip_family_str);
+                return TRUE;
             }
-            g_free (ip_family_str);
-            break;
         }
-    }
 
-    mm_3gpp_pdp_context_format_list_free (formats);
+        /* No empty one left, so overwrite the last one defined */
+        if (ctx->max_cid > 0 && !cid_in_use (ctx, ctx->max_cid)) {
+            mm_dbg ("Re-using CID %u (max) with PDP type '%s'", ctx->max_cid, ip_family_str);
+            ctx->cid = ctx->max_cid;
+            g_free (ip_family_str);
+            return TRUE;
+        }
 
-    if (cid == 0) {
-        mm_dbg ("Defaulting to CID=1");
-        cid = 1;
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_TOO_MANY,
+                     "No free CID left with PDP type '%s'", ip_family_str);
+        g_free (ip_family_str);
+        return FALSE;
     }
 
-    ctx->cid = cid;
-    return TRUE;
+    return select_default_cid (ctx, error);
 }
 
-static gboolean
-parse_pdp_list (MMBaseModem             *modem,
-                CidSelection3gppContext *ctx,
-                const gchar             *command,
-                const gchar             *response,
-                gboolean                 last_command,
-                const GError            *error,
-                GVariant               **result,
-                GError                 **result_error)
+static void
+cgdcont_test_ready (MMBaseModem  *modem,
+                    GAsyncResult *res,
+                    GTask        *task)
 {
-    GError *inner_error = NULL;
-    GList *pdp_list;
-    GList *l;
-    guint cid;
+    CidSelection3gppContext *ctx;
+    const gchar             *response;
+    GError                  *error = NULL;
+    GList                   *formats;
 
-    /* If cancelled, set result error */
-    if (g_cancellable_is_cancelled (ctx->cancellable)) {
-        g_set_error (result_error, MM_CORE_ERROR, MM_CORE_ERROR_CANCELLED,
-                     "Connection setup operation has been cancelled");
-        return FALSE;
+    ctx = (CidSelection3gppContext *) g_task_get_task_data (task);
+
+    response = mm_base_modem_at_command_full_finish (modem, res, &error);
+
+    if (cid_selection_3gpp_return_if_cancelled (task)) {
+        g_clear_error (&error);
+        return;
     }
 
-    /* Some Android phones don't support querying existing PDP contexts,
-     * but will accept setting the APN.  So if CGDCONT? isn't supported,
-     * just ignore that error and hope for the best. (bgo #637327)
-     */
-    if (g_error_matches (error,
-                         MM_MOBILE_EQUIPMENT_ERROR,
-                         MM_MOBILE_EQUIPMENT_ERROR_NOT_SUPPORTED)) {
-        mm_dbg ("Querying PDP context list is unsupported");
-        return FALSE;
+    if (error) {
+        mm_dbg ("Unexpected +CGDCONT error: '%s'", error->message);
+        g_clear_error (&error);
+        select_default_cid (ctx, &error);
+        goto out;
     }
 
+    formats = mm_3gpp_parse_cgdcont_test_response (response, &error);
     if (error) {
-        mm_dbg ("Unexpected +CGDCONT? error: '%s'", error->message);
-        return FALSE;
+        mm_dbg ("Error parsing +CGDCONT test response: '%s'", error->message);
+        g_clear_error (&error);
+        select_default_cid (ctx, &error);
+        goto out;
     }
 
-    pdp_list = mm_3gpp_parse_cgdcont_read_response (response, &inner_error);
-    if (!pdp_list) {
-        if (inner_error) {
-            mm_dbg ("%s", inner_error->message);
-            g_error_free (inner_error);
-        } else {
-            /* No predefined PDP contexts found */
-            mm_dbg ("No PDP contexts found");
+    select_cid_from_formats (ctx, formats, &error);
+    mm_broadband_modem_take_3gpp_pdp_context_formats (MM_BROADBAND_MODEM (modem), formats);
+
+out:
+    if (error) {
+        g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
+    }
+    cid_selected (task);
+}
+
+static void
+find_cid_in_formats (GTask *task)
+{
+    CidSelection3gppContext *ctx;
+    GList                   *formats;
+
+    ctx = (CidSelection3gppContext *) g_task_get_task_data (task);
+
+    if (mm_broadband_modem_peek_3gpp_pdp_context_formats (MM_BROADBAND_MODEM (ctx->modem), &formats)) {
+        GError *error = NULL;
+
+        if (!select_cid_from_formats (ctx, formats, &error)) {
+            g_task_return_error (task, error);
+            g_object_unref (task);
+            return;
         }
+        cid_selected (task);
+        return;
+    }
+
+    mm_base_modem_at_command_full (ctx->modem,
+                                   ctx->primary,
+                                   "+CGDCONT=?",
+                                   3,
+                                   TRUE, /* allow caching, it's a test command */
+                                   FALSE, /* raw */
+                                   NULL, /* cancellable */
+                                   (GAsyncReadyCallback) cgdcont_test_ready,
+                                   task);
+}
+
+static gboolean
+select_cid_from_pdp_list (CidSelection3gppContext *ctx,
+                          GList                   *pdp_list)
+{
+    GList *l;
+    guint  cid;
+
+    if (!pdp_list) {
+        /* No predefined PDP contexts found */
+        mm_dbg ("No PDP contexts found");
         return FALSE;
     }
 
@@ -866,6 +972,13 @@ parse_pdp_list (MMBaseModem             *modem,
     for (l = pdp_list; l; l = g_list_next (l)) {
         MM3gppPdpContext *pdp = l->data;
 
+        if (ctx->max_cid < pdp->cid)
+            ctx->max_cid = pdp->cid;
+
+        /* Contexts used by other bearers can't be shared */
+        if (cid_in_use (ctx, pdp->cid))
+            continue;
+
         if (pdp->pdp_type == ctx->ip_family) {
             const gchar *apn;
 
@@ -893,11 +1006,7 @@ parse_pdp_list (MMBaseModem             *modem,
                 cid = pdp->cid;
             }
         }
-
-        if (ctx->max_cid < pdp->cid)
-            ctx->max_cid = pdp->cid;
     }
-    mm_3gpp_pdp_context_list_free (pdp_list);
 
     if (cid > 0) {
         ctx->cid = cid;
@@ -907,11 +1016,70 @@ parse_pdp_list (MMBaseModem             *modem,
     return FALSE;
 }
 
-static const MMBaseModemAtCommand find_cid_sequence[] = {
-    { "+CGDCONT?",  3, FALSE, (MMBaseModemAtResponseProcessor) parse_pdp_list  },
-    { "+CGDCONT=?", 3, TRUE,  (MMBaseModemAtResponseProcessor) parse_cid_range },
-    { NULL }
-};
+static void
+find_cid_in_pdp_list (GTask *task,
+                      GList *pdp_list)
+{
+    CidSelection3gppContext *ctx;
+
+    ctx = (CidSelection3gppContext *) g_task_get_task_data (task);
+
+    if (select_cid_from_pdp_list (ctx, pdp_list))
+        cid_selected (task);
+    else
+        find_cid_in_formats (task);
+}
+
+static void
+cgdcont_query_ready (MMBaseModem  *modem,
+                     GAsyncResult *res,
+                     GTask        *task)
+{
+    const gchar *response;
+    GError      *error = NULL;
+    GList       *pdp_list;
+
+    response = mm_base_modem_at_command_full_finish (modem, res, &error);
+
+    if (cid_selection_3gpp_return_if_cancelled (task)) {
+        g_clear_error (&error);
+        return;
+    }
+
+    /* Some Android phones don't support querying existing PDP contexts,
+     * but will accept setting the APN.  So if CGDCONT? isn't supported,
+     * just ignore that error and hope for the best. (bgo #637327)
+     */
+    if (g_error_matches (error,
+                         MM_MOBILE_EQUIPMENT_ERROR,
+                         MM_MOBILE_EQUIPMENT_ERROR_NOT_SUPPORTED)) {
+        mm_dbg ("Querying PDP context list is unsupported");
+        g_error_free (error);
+        /* Not going to change, so don't ask again */
+        mm_broadband_modem_take_3gpp_pdp_contexts (MM_BROADBAND_MODEM (modem), NULL);
+        find_cid_in_formats (task);
+        return;
+    }
+
+    if (error) {
+        mm_dbg ("Unexpected +CGDCONT? error: '%s'", error->message);
+        g_error_free (error);
+        find_cid_in_formats (task);
+        return;
+    }
+
+    pdp_list = mm_3gpp_parse_cgdcont_read_response (response, &error);
+    if (error) {
+        mm_dbg ("%s", error->message);
+        g_error_free (error);
+        find_cid_in_formats (task);
+        return;
+    }
+
+    /* The cache owns the list from now on */
+    mm_broadband_modem_take_3gpp_pdp_contexts (MM_BROADBAND_MODEM (modem), pdp_list);
+    find_cid_in_pdp_list (task, pdp_list);
+}
 
 static void
 cid_selection_3gpp (MMBroadbandBearer   *self,
@@ -923,6 +1091,7 @@ cid_selection_3gpp (MMBroadbandBearer   *self,
 {
     GTask                   *task;
     CidSelection3gppContext *ctx;
+    GList                   *pdp_list;
 
     ctx = g_slice_new0 (CidSelection3gppContext);
     ctx->self        = g_object_ref (self);
@@ -935,14 +1104,24 @@ cid_selection_3gpp (MMBroadbandBearer   *self,
     g_task_set_task_data (task, ctx, (GDestroyNotify) cid_selection_3gpp_context_free);
 
     mm_dbg ("Looking for best CID...");
-    mm_base_modem_at_sequence_full (ctx->modem,
-                                    ctx->primary,
-                                    find_cid_sequence,
-                                    ctx, /* also passed as response processor context */
-                                    NULL, /* response_processor_context_free */
-                                    NULL, /* cancellable */
-                                    (GAsyncReadyCallback) find_cid_ready,
-                                    task);
+
+    /* If we already know the PDP contexts, e.g. when reconnecting, there's
+     * no need to query them again */
+    if (mm_broadband_modem_peek_3gpp_pdp_contexts (MM_BROADBAND_MODEM (modem), &pdp_list)) {
+        mm_dbg ("Using cached PDP context list");
+        find_cid_in_pdp_list (task, pdp_list);
+        return;
+    }
+
+    mm_base_modem_at_command_full (ctx->modem,
+                                   ctx->primary,
+                                   "+CGDCONT?",
+                                   3,
+                                   FALSE,
+                                   FALSE, /* raw */
+                                   NULL, /* cancellable */
+                                   (GAsyncReadyCallback) cgdcont_query_ready,
+                                   task);
 }
 
 /*****************************************************************************/
@@ -1015,6 +1194,9 @@ dial_3gpp_ready (MMBroadbandBearer *self,
     if (!ctx->data) {
         /* Clear CID when it failed to connect. */
         self->priv->cid = 0;
+        /* The context may have been changed behind our back, so don't trust
+         * the cached list in the next attempt */
+        mm_broadband_modem_invalidate_3gpp_pdp_contexts (MM_BROADBAND_MODEM (ctx->modem));
         g_task_return_error (task, error);
         g_object_unref (task);
         return;
@@ -1161,6 +1343,22 @@ connect_succeeded (GTask *task,
      * may already be set as connected, but no big deal. */
     mm_port_set_connected (self->priv->port, TRUE);
 
+    /* If the modem reports packet domain events, the context going away will
+     * be notified, so there's no need to poll for it. Only if we know which
+     * context we're using, though. */
+    if (connection_type == CONNECTION_TYPE_3GPP && self->priv->cid) {
+        MMBaseModem *modem = NULL;
+
+        g_object_get (self,
+                      MM_BASE_BEARER_MODEM, &modem,
+                      NULL);
+        mm_base_bearer_set_connection_monitor_events (
+            MM_BASE_BEARER (self),
+            MM_IS_BROADBAND_MODEM (modem) && mm_broadband_modem_get_3gpp_cgev_enabled (MM_BROADBAND_MODEM (modem)));
+        g_clear_object (&modem);
+    } else
+        mm_base_bearer_set_connection_monitor_events (MM_BASE_BEARER (self), FALSE);
+
     /* Set operation result */
     g_task_return_pointer (task,
                            result,
@@ -11343,6 +11343,9 @@ iface_modem_messaging_init (MMIfaceModemMessaging *iface)
     iface->set_default_storage_finish = messaging_set_default_storage_finish;
     iface->load_initial_sms_parts = load_initial_sms_parts;
     iface->load_initial_sms_parts_finish = load_initial_sms_parts_finish;
+    /* Stored parts can't be read one by one, so they're never loaded on demand */
+    iface->load_sms_part = NULL;
+    iface->load_sms_part_finish = NULL;
     iface->setup_unsolicited_events = messaging_setup_unsolicited_events;
     iface->setup_unsolicited_events_finish = messaging_setup_unsolicited_events_finish;
     iface->cleanup_unsolicited_events = messaging_cleanup_unsolicited_events;
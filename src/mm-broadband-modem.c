@@ -44,6 +44,7 @@
 #include "mm-broadband-bearer.h"
 #include "mm-bearer-list.h"
 #include "mm-sms-list.h"
+#include "mm-sms-storage-cache.h"
 #include "mm-sms-part-3gpp.h"
 #include "mm-call-list.h"
 #include "mm-base-sim.h"
@@ -112,6 +113,7 @@ enum {
     PROP_MODEM_CDMA_EVDO_NETWORK_SUPPORTED,
     PROP_MODEM_MESSAGING_SMS_LIST,
     PROP_MODEM_MESSAGING_SMS_PDU_MODE,
+    PROP_MODEM_MESSAGING_SMS_LAZY_EXPORT,
     PROP_MODEM_MESSAGING_SMS_DEFAULT_STORAGE,
     PROP_MODEM_VOICE_CALL_LIST,
     PROP_MODEM_SIMPLE_STATUS,
@@ -169,6 +171,13 @@ struct _MMBroadbandModemPrivate {
     /* Implementation helpers */
     GPtrArray *modem_3gpp_registration_regex;
     MMModem3gppFacility modem_3gpp_ignored_facility_locks;
+    gboolean modem_3gpp_cgev_enabled;
+    /* Cached +CGDCONT? and +CGDCONT=? results, so that bearers don't need
+     * to query them on every connection attempt */
+    gboolean modem_3gpp_pdp_contexts_cached;
+    GList *modem_3gpp_pdp_contexts;
+    gboolean modem_3gpp_pdp_context_formats_cached;
+    GList *modem_3gpp_pdp_context_formats;
 
     /*<--- Modem 3GPP USSD interface --->*/
     /* Properties */
@@ -190,6 +199,11 @@ struct _MMBroadbandModemPrivate {
     gboolean has_spservice;
     gboolean has_speri;
     gint evdo_pilot_rssi;
+    /* QCDM responses fetched in the same batch as the Call Manager state, for
+     * the HDR state and 1x serving system checks which follow it */
+    GByteArray *qcdm_hdr_state_prefetch;
+    GByteArray *qcdm_cdma_status_prefetch;
+    gint64 qcdm_prefetch_time;
 
     /*<--- Modem Simple interface --->*/
     /* Properties */
@@ -205,13 +219,22 @@ struct _MMBroadbandModemPrivate {
     GObject *modem_messaging_dbus_skeleton;
     MMSmsList *modem_messaging_sms_list;
     gboolean modem_messaging_sms_pdu_mode;
+    gboolean modem_messaging_sms_lazy_export;
     MMSmsStorage modem_messaging_sms_default_storage;
     /* Implementation helpers */
     gboolean sms_supported_modes_checked;
     gboolean mem1_storage_locked;
     MMSmsStorage current_sms_mem1_storage;
+    gint current_sms_mem1_used;
     gboolean mem2_storage_locked;
     MMSmsStorage current_sms_mem2_storage;
+    /* New message indications waiting to be read */
+    GArray *pending_sms_parts;
+    guint pending_sms_parts_timeout_id;
+    gboolean pending_sms_parts_reading;
+    /* Keeping the link open while sending batches (+CMMS) */
+    gboolean sms_more_messages_enabled;
+    gboolean sms_more_messages_unsupported;
 
     /*<--- Modem Voice interface --->*/
     /* Properties */
@@ -1776,7 +1799,11 @@ supported_ip_families_cgdcont_test_ready (MMBaseModem *self,
         for (l = formats; l; l = g_list_next (l))
             mask |= ((MM3gppPdpContextFormat *)(l->data))->pdp_type;
 
-        mm_3gpp_pdp_context_format_list_free (formats);
+        /* Keep them around for the CID selection of the bearers */
+        if (!error)
+            mm_broadband_modem_take_3gpp_pdp_context_formats (MM_BROADBAND_MODEM (self), formats);
+        else
+            mm_3gpp_pdp_context_format_list_free (formats);
     }
 
     if (error)
@@ -2726,6 +2753,84 @@ set_unsolicited_events_handlers (MMBroadbandModem *self,
     g_regex_unref (ciev_regex);
 }
 
+typedef struct {
+    MM3gppCgev type;
+    guint      cid;
+} CgevContext;
+
+static void
+cgev_report_bearer (MMBaseBearer *bearer,
+                    CgevContext  *ctx)
+{
+    guint cid;
+
+    /* Only AT-controlled bearers know about the context they're using */
+    if (!MM_IS_BROADBAND_BEARER (bearer) ||
+        mm_base_bearer_get_status (bearer) != MM_BEARER_STATUS_CONNECTED)
+        return;
+
+    cid = mm_broadband_bearer_get_3gpp_cid (MM_BROADBAND_BEARER (bearer));
+    if (ctx->type == MM_3GPP_CGEV_DETACH || (cid && ctx->cid == cid)) {
+        mm_base_bearer_report_connection_status (bearer, MM_BEARER_CONNECTION_STATUS_DISCONNECTED);
+        return;
+    }
+
+    /* If the event doesn't say which context went away, let the bearer
+     * find out whether it was its own */
+    if (!ctx->cid)
+        mm_base_bearer_check_connection_status (bearer);
+}
+
+static void
+cgev_received (MMPortSerialAt *port,
+               GMatchInfo *info,
+               MMBroadbandModem *self)
+{
+    CgevContext  ctx;
+    gchar       *str;
+
+    str = g_match_info_fetch (info, 1);
+    if (!str)
+        return;
+
+    ctx.type = mm_3gpp_parse_cgev_indication (str, &ctx.cid);
+    if (ctx.type != MM_3GPP_CGEV_UNKNOWN) {
+        mm_dbg ("Packet domain event received: '%s'", str);
+        if (self->priv->modem_bearer_list)
+            mm_bearer_list_foreach (self->priv->modem_bearer_list,
+                                    (MMBearerListForeachFunc) cgev_report_bearer,
+                                    &ctx);
+    }
+    g_free (str);
+}
+
+static void
+set_cgev_unsolicited_events_handlers (MMBroadbandModem *self,
+                                      gboolean enable)
+{
+    MMPortSerialAt *ports[2];
+    GRegex *cgev_regex;
+    guint i;
+
+    cgev_regex = mm_3gpp_cgev_regex_get ();
+    ports[0] = mm_base_modem_peek_port_primary (MM_BASE_MODEM (self));
+    ports[1] = mm_base_modem_peek_port_secondary (MM_BASE_MODEM (self));
+
+    for (i = 0; i < 2; i++) {
+        if (!ports[i])
+            continue;
+
+        mm_port_serial_at_add_unsolicited_msg_handler (
+            ports[i],
+            cgev_regex,
+            enable ? (MMPortSerialAtUnsolicitedMsgFn) cgev_received : NULL,
+            enable ? self : NULL,
+            NULL);
+    }
+
+    g_regex_unref (cgev_regex);
+}
+
 static void
 cmer_format_check_ready (MMBroadbandModem   *self,
                          GAsyncResult       *res,
@@ -2869,6 +2974,9 @@ modem_3gpp_setup_unsolicited_events (MMIfaceModem3gpp *_self,
 
     task = g_task_new (self, NULL, callback, user_data);
 
+    /* Packet domain events don't depend on indicators */
+    set_cgev_unsolicited_events_handlers (self, TRUE);
+
     /* Load supported indicators */
     if (!self->priv->modem_cind_support_checked) {
         mm_dbg ("Checking indicator support...");
@@ -2900,6 +3008,8 @@ modem_3gpp_cleanup_unsolicited_events (MMIfaceModem3gpp *_self,
 
     task = g_task_new (self, NULL, callback, user_data);
 
+    set_cgev_unsolicited_events_handlers (self, FALSE);
+
     /* If supported, go on */
     if (self->priv->modem_cind_support_checked && self->priv->modem_cind_supported)
         set_unsolicited_events_handlers (self, FALSE);
@@ -2916,6 +3026,9 @@ typedef struct {
     gboolean enable;
     gboolean cmer_primary_done;
     gboolean cmer_secondary_done;
+    gboolean cgerep_primary_done;
+    gboolean cgerep_secondary_done;
+    gboolean cgerep_enabled;
 } UnsolicitedEventsContext;
 
 static void
@@ -2943,22 +3056,42 @@ unsolicited_events_setup_ready (MMBroadbandModem *self,
     UnsolicitedEventsContext *ctx;
     GError *error = NULL;
 
+    ctx = g_task_get_task_data (task);
+
     mm_base_modem_at_command_finish (MM_BASE_MODEM (self), res, &error);
-    if (!error) {
-        /* Run on next port, if any */
-        run_unsolicited_events_setup (task);
-        return;
+    if (error) {
+        mm_dbg ("Couldn't %s event reporting: '%s'",
+                ctx->enable ? "enable" : "disable",
+                error->message);
+        g_error_free (error);
+        /* Ignore errors, but don't try in other ports */
+        ctx->cmer_primary_done = TRUE;
+        ctx->cmer_secondary_done = TRUE;
     }
 
+    run_unsolicited_events_setup (task);
+}
+
+static void
+cgerep_setup_ready (MMBroadbandModem *self,
+                    GAsyncResult *res,
+                    GTask *task)
+{
+    UnsolicitedEventsContext *ctx;
+    GError *error = NULL;
+
     ctx = g_task_get_task_data (task);
 
-    mm_dbg ("Couldn't %s event reporting: '%s'",
-            ctx->enable ? "enable" : "disable",
-            error->message);
-    g_error_free (error);
-    /* Consider this operation complete, ignoring errors */
-    g_task_return_boolean (task, TRUE);
-    g_object_unref (task);
+    mm_base_modem_at_command_finish (MM_BASE_MODEM (self), res, &error);
+    if (error) {
+        mm_dbg ("Couldn't %s packet domain event reporting: '%s'",
+                ctx->enable ? "enable" : "disable",
+                error->message);
+        g_error_free (error);
+    } else if (ctx->enable)
+        ctx->cgerep_enabled = TRUE;
+
+    run_unsolicited_events_setup (task);
 }
 
 static void
@@ -2971,12 +3104,14 @@ run_unsolicited_events_setup (GTask *task)
     self = g_task_get_source_object (task);
     ctx = g_task_get_task_data (task);
 
-    if (!ctx->cmer_primary_done) {
-        ctx->cmer_primary_done = TRUE;
-        port = mm_base_modem_peek_port_primary (MM_BASE_MODEM (self));
-    } else if (!ctx->cmer_secondary_done) {
-        ctx->cmer_secondary_done = TRUE;
-        port = mm_base_modem_peek_port_secondary (MM_BASE_MODEM (self));
+    if (ctx->command) {
+        if (!ctx->cmer_primary_done) {
+            ctx->cmer_primary_done = TRUE;
+            port = mm_base_modem_peek_port_primary (MM_BASE_MODEM (self));
+        } else if (!ctx->cmer_secondary_done) {
+            ctx->cmer_secondary_done = TRUE;
+            port = mm_base_modem_peek_port_secondary (MM_BASE_MODEM (self));
+        }
     }
 
     /* Enable unsolicited events in given port */
@@ -2993,7 +3128,32 @@ run_unsolicited_events_setup (GTask *task)
         return;
     }
 
+    /* Packet domain events let bearers know about disconnections without
+     * polling the context status. Mode 2 buffers them while the port is in
+     * data mode. */
+    if (!ctx->cgerep_primary_done) {
+        ctx->cgerep_primary_done = TRUE;
+        port = mm_base_modem_peek_port_primary (MM_BASE_MODEM (self));
+    } else if (!ctx->cgerep_secondary_done) {
+        ctx->cgerep_secondary_done = TRUE;
+        port = mm_base_modem_peek_port_secondary (MM_BASE_MODEM (self));
+    }
+
+    if (port) {
+        mm_base_modem_at_command_full (MM_BASE_MODEM (self),
+                                       port,
+                                       ctx->enable ? "+CGEREP=2" : "+CGEREP=0",
+                                       3,
+                                       FALSE,
+                                       FALSE, /* raw */
+                                       NULL, /* cancellable */
+                                       (GAsyncReadyCallback)cgerep_setup_ready,
+                                       task);
+        return;
+    }
+
     /* If no more ports, we're fully done now */
+    self->priv->modem_3gpp_cgev_enabled = ctx->cgerep_enabled;
     g_task_return_boolean (task, TRUE);
     g_object_unref (task);
 }
@@ -3004,33 +3164,24 @@ modem_3gpp_enable_unsolicited_events (MMIfaceModem3gpp *_self,
                                       gpointer user_data)
 {
     MMBroadbandModem *self = MM_BROADBAND_MODEM (_self);
+    UnsolicitedEventsContext *ctx;
     GTask *task;
 
     task = g_task_new (self, NULL, callback, user_data);
 
+    ctx = g_new0 (UnsolicitedEventsContext, 1);
+    ctx->enable = TRUE;
+    g_task_set_task_data (task, ctx, (GDestroyNotify)unsolicited_events_context_free);
+
     /* If supported, go on */
     if (self->priv->modem_cind_support_checked && self->priv->modem_cind_supported) {
-        gchar *cmd;
-
         /* If CMER command available, launch it */
-        cmd = mm_3gpp_build_cmer_set_request (self->priv->modem_cmer_enable_mode, self->priv->modem_cmer_ind);
-        if (cmd) {
-            UnsolicitedEventsContext *ctx;
-
-            ctx = g_new0 (UnsolicitedEventsContext, 1);
-            ctx->enable = TRUE;
-            ctx->command = cmd;
-
-            g_task_set_task_data (task, ctx, (GDestroyNotify)unsolicited_events_context_free);
-
-            run_unsolicited_events_setup (task);
-            return;
-        }
-        mm_dbg ("Skipping +CMER enable command: not supported");
+        ctx->command = mm_3gpp_build_cmer_set_request (self->priv->modem_cmer_enable_mode, self->priv->modem_cmer_ind);
+        if (!ctx->command)
+            mm_dbg ("Skipping +CMER enable command: not supported");
     }
 
-    g_task_return_boolean (task, TRUE);
-    g_object_unref (task);
+    run_unsolicited_events_setup (task);
 }
 
 static void
@@ -3039,32 +3190,26 @@ modem_3gpp_disable_unsolicited_events (MMIfaceModem3gpp *_self,
                                        gpointer user_data)
 {
     MMBroadbandModem *self = MM_BROADBAND_MODEM (_self);
+    UnsolicitedEventsContext *ctx;
     GTask *task;
 
     task = g_task_new (self, NULL, callback, user_data);
 
+    /* Bearers can't rely on packet domain events from now on */
+    self->priv->modem_3gpp_cgev_enabled = FALSE;
+
+    ctx = g_new0 (UnsolicitedEventsContext, 1);
+    g_task_set_task_data (task, ctx, (GDestroyNotify)unsolicited_events_context_free);
+
     /* If CIND supported, go on */
     if (self->priv->modem_cind_support_checked && self->priv->modem_cind_supported) {
-        gchar *cmd;
-
         /* If CMER command available, launch it */
-        cmd = mm_3gpp_build_cmer_set_request (self->priv->modem_cmer_disable_mode, MM_3GPP_CMER_IND_NONE);
-        if (cmd) {
-            UnsolicitedEventsContext *ctx;
-
-            ctx = g_new0 (UnsolicitedEventsContext, 1);
-            ctx->command = cmd;
-
-            g_task_set_task_data (task, ctx, (GDestroyNotify)unsolicited_events_context_free);
-
-            run_unsolicited_events_setup (task);
-            return;
-        }
-        mm_dbg ("Skipping +CMER disable command: not supported");
+        ctx->command = mm_3gpp_build_cmer_set_request (self->priv->modem_cmer_disable_mode, MM_3GPP_CMER_IND_NONE);
+        if (!ctx->command)
+            mm_dbg ("Skipping +CMER disable command: not supported");
     }
 
-    g_task_return_boolean (task, TRUE);
-    g_object_unref (task);
+    run_unsolicited_events_setup (task);
 }
 
 /*****************************************************************************/
@@ -3619,6 +3764,9 @@ modem_command (MMIfaceModem *self,
                gpointer user_data)
 {
 
+    /* We can't know what the user is doing, e.g. defining PDP contexts */
+    mm_broadband_modem_invalidate_3gpp_pdp_contexts (MM_BROADBAND_MODEM (self));
+
     mm_base_modem_at_command (MM_BASE_MODEM (self), cmd, timeout,
                               FALSE,
                               callback,
@@ -5826,11 +5974,17 @@ lock_storages_cpms_set_ready (MMBaseModem *_self,
 {
     MMBroadbandModem *self = MM_BROADBAND_MODEM (_self);
     LockSmsStoragesContext *ctx;
+    const gchar *response;
+    guint mem1_used = 0;
     GError *error = NULL;
 
     ctx = g_task_get_task_data (task);
 
-    mm_base_modem_at_command_finish (_self, res, &error);
+    /* Keep track of how many messages there are in mem1; it's used to check
+     * whether cached listings of the storage are still valid */
+    self->priv->current_sms_mem1_used = -1;
+
+    response = mm_base_modem_at_command_finish (_self, res, &error);
     if (error) {
         /* Reset previous storages and set unlocked */
         if (ctx->mem1_locked) {
@@ -5842,10 +5996,14 @@ lock_storages_cpms_set_ready (MMBaseModem *_self,
             self->priv->mem2_storage_locked = FALSE;
         }
         g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
     }
-    else
-        g_task_return_boolean (task, TRUE);
 
+    if (mm_3gpp_parse_cpms_set_response (response, &mem1_used, NULL, NULL))
+        self->priv->current_sms_mem1_used = (gint)mem1_used;
+
+    g_task_return_boolean (task, TRUE);
     g_object_unref (task);
 }
 
@@ -6043,6 +6201,13 @@ cmgf_set_ready (MMBroadbandModem *self,
         mm_dbg ("Successfully set preferred SMS mode: '%s'",
                 self->priv->modem_messaging_sms_pdu_mode ? "PDU" : "text");
 
+    /* Stored parts can't be read again one by one in text mode, so they can't
+     * be loaded on demand */
+    if (!self->priv->modem_messaging_sms_pdu_mode && self->priv->modem_messaging_sms_list)
+        g_object_set (self->priv->modem_messaging_sms_list,
+                      MM_SMS_LIST_LAZY_EXPORT, FALSE,
+                      NULL);
+
     g_task_return_boolean (task, TRUE);
     g_object_unref (task);
 }
@@ -6127,152 +6292,541 @@ modem_messaging_setup_sms_format (MMIfaceModemMessaging *self,
 }
 
 /*****************************************************************************/
-/* Setup/cleanup messaging related unsolicited events (Messaging interface) */
+/* List SMS parts in PDU mode
+ *
+ * The +CMGL response is streamed: each entry is parsed and handed over to the
+ * SMS list as soon as it's received, instead of waiting for the whole
+ * listing, which may be really long with full storages. */
 
-static gboolean
-modem_messaging_setup_cleanup_unsolicited_events_finish (MMIfaceModemMessaging *self,
-                                                         GAsyncResult *res,
-                                                         GError **error)
+typedef struct {
+    MMPortSerialAt *port;
+    MMSmsStorage storage;
+    MMSmsStorageSnapshot *snapshot;
+} ListPduPartsContext;
+
+static void
+list_pdu_parts_context_free (ListPduPartsContext *ctx)
 {
-    return g_task_propagate_boolean (G_TASK (res), error);
+    g_object_unref (ctx->port);
+    g_slice_free (ListPduPartsContext, ctx);
 }
 
-typedef struct {
-    guint idx;
-} SmsPartContext;
+static MMSmsState
+sms_state_from_index (guint index)
+{
+    /* We merge unread and read messages in the same state */
+    switch (index) {
+    case 0: /* received, unread */
+    case 1: /* received, read */
+        return MM_SMS_STATE_RECEIVED;
+    case 2:
+        return MM_SMS_STATE_STORED;
+    case 3:
+        return MM_SMS_STATE_SENT;
+    default:
+        return MM_SMS_STATE_UNKNOWN;
+    }
+}
 
 static void
-sms_part_ready (MMBroadbandModem *self,
-                GAsyncResult *res,
-                GTask *task)
+take_sms_part_from_pdu_info (MMBroadbandModem *self,
+                             MMSmsStorage storage,
+                             MMSmsState state,
+                             MM3gppPduInfo *info)
 {
-    SmsPartContext *ctx;
     MMSmsPart *part;
-    MM3gppPduInfo *info;
-    const gchar *response;
     GError *error = NULL;
 
-    /* Always always always unlock mem1 storage. Warned you've been. */
-    mm_broadband_modem_unlock_sms_storages (self, TRUE, FALSE);
-
-    response = mm_base_modem_at_command_finish (MM_BASE_MODEM (self), res, &error);
-    if (error) {
-        /* We're really ignoring this error afterwards, as we don't have a callback
-         * passed to the async operation, so just log the error here. */
-        mm_warn ("Couldn't retrieve SMS part: '%s'",
-                 error->message);
-        g_task_return_error (task, error);
-        g_object_unref (task);
-        return;
-    }
-
-    ctx = g_task_get_task_data (task);
-
-    info = mm_3gpp_parse_cmgr_read_response (response, ctx->idx, &error);
-    if (!info) {
-        mm_warn ("Couldn't parse SMS part: '%s'",
-                 error->message);
-        g_task_return_error (task, error);
-        g_object_unref (task);
-        return;
-    }
-
     part = mm_sms_part_3gpp_new_from_pdu (info->index, info->pdu, &error);
     if (part) {
-        mm_dbg ("Correctly parsed PDU (%d)", ctx->idx);
+        mm_dbg ("Correctly parsed PDU (%d)", info->index);
         mm_iface_modem_messaging_take_part (MM_IFACE_MODEM_MESSAGING (self),
                                             part,
-                                            MM_SMS_STATE_RECEIVED,
-                                            self->priv->modem_messaging_sms_default_storage);
+                                            state,
+                                            storage);
     } else {
         /* Don't treat the error as critical */
-        mm_dbg ("Error parsing PDU (%d): %s", ctx->idx, error->message);
+        mm_dbg ("Error parsing PDU (%d): %s", info->index, error->message);
         g_error_free (error);
     }
+}
 
-    /* All done */
-    mm_3gpp_pdu_info_free (info);
-    g_task_return_boolean (task, TRUE);
-    g_object_unref (task);
+static void
+take_listed_sms_part (MMBroadbandModem *self,
+                      ListPduPartsContext *ctx,
+                      MM3gppPduInfo *info)
+{
+    /* Listed PDUs either build up a new snapshot of the storage, or update
+     * the one already cached */
+    if (ctx->snapshot)
+        mm_sms_storage_snapshot_add (ctx->snapshot, info->index, info->status, info->pdu);
+    else
+        mm_sms_storage_cache_add_part (MM_BASE_MODEM (self), ctx->storage, info->index, info->status, info->pdu);
+
+    take_sms_part_from_pdu_info (self, ctx->storage, sms_state_from_index (info->status), info);
 }
 
 static void
-indication_lock_storages_ready (MMBroadbandModem *self,
-                                GAsyncResult *res,
-                                GTask *task)
+cmgl_entry_received (MMPortSerialAt *port,
+                     GMatchInfo *match_info,
+                     GTask *task)
 {
-    SmsPartContext *ctx;
-    gchar *command;
+    ListPduPartsContext *ctx;
+    MM3gppPduInfo *info;
     GError *error = NULL;
 
-    if (!mm_broadband_modem_lock_sms_storages_finish (self, res, &error)) {
-        /* TODO: we should either make this lock() never fail, by automatically
-         * retrying after some time, or otherwise retry here. */
-        g_task_return_error (task, error);
-        g_object_unref (task);
+    ctx = g_task_get_task_data (task);
+
+    info = mm_3gpp_parse_pdu_cmgl_entry (match_info, &error);
+    if (!info) {
+        mm_dbg ("Couldn't parse SMS list entry: '%s'", error->message);
+        g_error_free (error);
         return;
     }
 
-    /* Storage now set and locked */
+    take_listed_sms_part (g_task_get_source_object (task), ctx, info);
+    mm_3gpp_pdu_info_free (info);
+}
 
-    /* Retrieve the message */
-    ctx = g_task_get_task_data (task);
-    command = g_strdup_printf ("+CMGR=%d", ctx->idx);
-    mm_base_modem_at_command (MM_BASE_MODEM (self),
-                              command,
-                              10,
-                              FALSE,
-                              (GAsyncReadyCallback)sms_part_ready,
-                              task);
-    g_free (command);
+static gboolean
+list_pdu_parts_finish (MMBroadbandModem *self,
+                       GAsyncResult *res,
+                       GError **error)
+{
+    return g_task_propagate_boolean (G_TASK (res), error);
 }
 
 static void
-cmti_received (MMPortSerialAt *port,
-               GMatchInfo *info,
-               MMBroadbandModem *self)
+list_pdu_parts_ready (MMBaseModem *self,
+                      GAsyncResult *res,
+                      GTask *task)
 {
-    SmsPartContext *ctx;
-    GTask *task;
-    guint idx = 0;
-    MMSmsStorage storage;
-    gchar *str;
+    ListPduPartsContext *ctx;
+    const gchar *response;
+    GError *error = NULL;
+    GList *info_list;
+    GList *l;
 
-    if (!mm_get_uint_from_match_info (info, 2, &idx))
-        return;
+    ctx = g_task_get_task_data (task);
+    mm_port_serial_at_set_response_entry_handler (ctx->port, NULL, NULL, NULL, NULL);
 
-    /* The match info gives us in which storage the index applies */
-    str = mm_get_string_unquoted_from_match_info (info, 1);
-    storage = mm_common_get_sms_storage_from_string (str, NULL);
-    if (storage == MM_SMS_STORAGE_UNKNOWN) {
-        mm_dbg ("Skipping CMTI indication, unknown storage '%s' reported", str);
-        g_free (str);
+    response = mm_base_modem_at_command_full_finish (self, res, &error);
+    if (!response) {
+        g_task_return_error (task, error);
+        g_object_unref (task);
         return;
     }
-    g_free (str);
 
-    /* Don't signal multiple times if there are multiple CMTI notifications for a message */
-    if (mm_sms_list_has_part (self->priv->modem_messaging_sms_list,
-                              storage,
-                              idx)) {
-        mm_dbg ("Skipping CMTI indication, part already processed");
+    /* Streamed entries are no longer in the response; but there may still be
+     * some, e.g. if the last PDU came without the trailing <CR><LF> */
+    info_list = mm_3gpp_parse_pdu_cmgl_response (response, &error);
+    if (error) {
+        g_task_return_error (task, error);
+        g_object_unref (task);
         return;
     }
 
-    ctx = g_new (SmsPartContext, 1);
-    ctx->idx = idx;
+    for (l = info_list; l; l = g_list_next (l))
+        take_listed_sms_part (MM_BROADBAND_MODEM (self), ctx, (MM3gppPduInfo *)l->data);
+    mm_3gpp_pdu_info_list_free (info_list);
 
-    task = g_task_new (self, NULL, NULL, NULL);
-    g_task_set_task_data (task, ctx, g_free);
+    g_task_return_boolean (task, TRUE);
+    g_object_unref (task);
+}
+
+static void
+list_pdu_parts (MMBroadbandModem *self,
+                const gchar *command,
+                MMSmsStorage storage,
+                MMSmsStorageSnapshot *snapshot,
+                GAsyncReadyCallback callback,
+                gpointer user_data)
+{
+    ListPduPartsContext *ctx;
+    MMPortSerialAt *port;
+    GRegex *regex;
+    GError *error = NULL;
+    GTask *task;
+
+    port = mm_base_modem_peek_best_at_port (MM_BASE_MODEM (self), &error);
+    if (!port) {
+        g_task_report_error (self, callback, user_data, list_pdu_parts, error);
+        return;
+    }
+
+    ctx = g_slice_new (ListPduPartsContext);
+    ctx->port = g_object_ref (port);
+    ctx->storage = storage;
+    ctx->snapshot = snapshot;
+
+    task = g_task_new (self, NULL, callback, user_data);
+    g_task_set_task_data (task, ctx, (GDestroyNotify)list_pdu_parts_context_free);
+
+    regex = mm_3gpp_cmgl_pdu_entry_regex_get ();
+    mm_port_serial_at_set_response_entry_handler (port,
+                                                  regex,
+                                                  (MMPortSerialAtUnsolicitedMsgFn)cmgl_entry_received,
+                                                  task,
+                                                  NULL);
+    g_regex_unref (regex);
+
+    mm_base_modem_at_command_full (MM_BASE_MODEM (self),
+                                   port,
+                                   command,
+                                   20,
+                                   FALSE,
+                                   FALSE,
+                                   NULL,
+                                   (GAsyncReadyCallback)list_pdu_parts_ready,
+                                   task);
+}
+
+/*****************************************************************************/
+/* Setup/cleanup messaging related unsolicited events (Messaging interface) */
+
+static gboolean
+modem_messaging_setup_cleanup_unsolicited_events_finish (MMIfaceModemMessaging *self,
+                                                         GAsyncResult *res,
+                                                         GError **error)
+{
+    return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+/* New message indications (+CMTI) usually come in bursts, e.g. when the
+ * network delivers all the messages queued while we were out of coverage.
+ * Instead of reading each part as soon as it's indicated, indications are
+ * collected for a short while, and then all the pending parts in the same
+ * storage are read at once: with a single +CMGL listing the unread messages
+ * in PDU mode, or with one +CMGR after the other otherwise. */
+#define CMTI_COALESCE_TIMEOUT_MS 500
+
+/* If the storages cannot be locked, e.g. because they're in use by someone
+ * else, reading the parts is retried after doubling the delay each time, and
+ * the parts are dropped after a few attempts. */
+#define PENDING_SMS_PARTS_MAX_LOCK_ATTEMPTS 5
+
+typedef struct {
+    MMSmsStorage storage;
+    guint idx;
+    guint lock_attempts;
+} PendingSmsPart;
+
+typedef struct {
+    MMSmsStorage storage;
+    GArray *indices;
+    guint current;
+    guint lock_attempts;
+} ReadPendingSmsPartsContext;
+
+static void
+read_pending_sms_parts_context_free (ReadPendingSmsPartsContext *ctx)
+{
+    g_array_unref (ctx->indices);
+    g_slice_free (ReadPendingSmsPartsContext, ctx);
+}
+
+static void read_pending_sms_parts (MMBroadbandModem *self);
+
+static gboolean
+pending_sms_parts_timeout_cb (MMBroadbandModem *self)
+{
+    self->priv->pending_sms_parts_timeout_id = 0;
+    read_pending_sms_parts (self);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+schedule_pending_sms_parts_read (MMBroadbandModem *self)
+{
+    guint lock_attempts;
+
+    /* Indications received while reading are collected for the next round */
+    if (self->priv->pending_sms_parts_reading ||
+        self->priv->pending_sms_parts_timeout_id ||
+        self->priv->pending_sms_parts->len == 0)
+        return;
+
+    /* The first part is the one read next */
+    lock_attempts = g_array_index (self->priv->pending_sms_parts, PendingSmsPart, 0).lock_attempts;
+
+    /* No reference taken, the source is removed when disabling or disposing */
+    self->priv->pending_sms_parts_timeout_id =
+        g_timeout_add (CMTI_COALESCE_TIMEOUT_MS << lock_attempts,
+                       (GSourceFunc)pending_sms_parts_timeout_cb,
+                       self);
+}
+
+static void
+clear_pending_sms_parts (MMBroadbandModem *self)
+{
+    if (self->priv->pending_sms_parts_timeout_id) {
+        g_source_remove (self->priv->pending_sms_parts_timeout_id);
+        self->priv->pending_sms_parts_timeout_id = 0;
+    }
+    if (self->priv->pending_sms_parts)
+        g_array_set_size (self->priv->pending_sms_parts, 0);
+}
+
+static void read_next_pending_sms_part (GTask *task);
+
+static void
+pending_sms_part_read_ready (MMBroadbandModem *self,
+                             GAsyncResult *res,
+                             GTask *task)
+{
+    ReadPendingSmsPartsContext *ctx;
+    MM3gppPduInfo *info;
+    const gchar *response;
+    guint idx;
+    GError *error = NULL;
+
+    ctx = g_task_get_task_data (task);
+    idx = g_array_index (ctx->indices, guint, ctx->current++);
+
+    /* Errors reading one part don't stop reading the next ones */
+    response = mm_base_modem_at_command_finish (MM_BASE_MODEM (self), res, &error);
+    if (error) {
+        mm_warn ("Couldn't retrieve SMS part: '%s'", error->message);
+        g_error_free (error);
+    } else {
+        info = mm_3gpp_parse_cmgr_read_response (response, idx, &error);
+        if (!info) {
+            mm_warn ("Couldn't parse SMS part: '%s'", error->message);
+            g_error_free (error);
+        } else {
+            mm_sms_storage_cache_add_part (MM_BASE_MODEM (self), ctx->storage, idx, info->status, info->pdu);
+            take_sms_part_from_pdu_info (self, ctx->storage, MM_SMS_STATE_RECEIVED, info);
+            mm_3gpp_pdu_info_free (info);
+        }
+    }
+
+    read_next_pending_sms_part (task);
+}
+
+static void
+read_next_pending_sms_part (GTask *task)
+{
+    MMBroadbandModem *self;
+    ReadPendingSmsPartsContext *ctx;
+    gchar *command;
+
+    self = g_task_get_source_object (task);
+    ctx = g_task_get_task_data (task);
+
+    /* Skip the parts already listed */
+    while (ctx->current < ctx->indices->len &&
+           mm_sms_list_has_part (self->priv->modem_messaging_sms_list,
+                                 ctx->storage,
+                                 g_array_index (ctx->indices, guint, ctx->current)))
+        ctx->current++;
+
+    if (ctx->current == ctx->indices->len) {
+        /* Always always always unlock mem1 storage. Warned you've been. */
+        mm_broadband_modem_unlock_sms_storages (self, TRUE, FALSE);
+        g_task_return_boolean (task, TRUE);
+        g_object_unref (task);
+        return;
+    }
+
+    command = g_strdup_printf ("+CMGR=%u", g_array_index (ctx->indices, guint, ctx->current));
+    mm_base_modem_at_command (MM_BASE_MODEM (self),
+                              command,
+                              10,
+                              FALSE,
+                              (GAsyncReadyCallback)pending_sms_part_read_ready,
+                              task);
+    g_free (command);
+}
+
+static void
+pending_sms_parts_list_ready (MMBroadbandModem *self,
+                              GAsyncResult *res,
+                              GTask *task)
+{
+    GError *error = NULL;
+
+    /* Listed parts are already taken */
+    if (!list_pdu_parts_finish (self, res, &error)) {
+        /* Not fatal, parts not listed get read one by one */
+        mm_dbg ("Couldn't list unread SMS parts: '%s'", error->message);
+        g_error_free (error);
+    }
+
+    /* Read whatever wasn't listed */
+    read_next_pending_sms_part (task);
+}
+
+static void
+pending_sms_parts_lock_storages_ready (MMBroadbandModem *self,
+                                       GAsyncResult *res,
+                                       GTask *task)
+{
+    ReadPendingSmsPartsContext *ctx;
+    GError *error = NULL;
+
+    ctx = g_task_get_task_data (task);
+
+    if (!mm_broadband_modem_lock_sms_storages_finish (self, res, &error)) {
+        guint i;
+
+        if (ctx->lock_attempts + 1 >= PENDING_SMS_PARTS_MAX_LOCK_ATTEMPTS) {
+            mm_warn ("Dropping %u new SMS parts in storage '%s': couldn't lock storages after %u attempts",
+                     ctx->indices->len, mm_sms_storage_get_string (ctx->storage), ctx->lock_attempts + 1);
+            g_task_return_error (task, error);
+            g_object_unref (task);
+            return;
+        }
+
+        /* Storages may be in use by someone else, so queue the parts again
+         * and retry after a while */
+        for (i = 0; i < ctx->indices->len; i++) {
+            PendingSmsPart pending;
+
+            pending.storage = ctx->storage;
+            pending.idx = g_array_index (ctx->indices, guint, i);
+            pending.lock_attempts = ctx->lock_attempts + 1;
+            g_array_append_val (self->priv->pending_sms_parts, pending);
+        }
+        g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
+    }
+
+    /* Storage now set and locked */
+
+    /* A single part is read directly */
+    if (!self->priv->modem_messaging_sms_pdu_mode || ctx->indices->len == 1) {
+        read_next_pending_sms_part (task);
+        return;
+    }
+
+    /* List all unread parts; "REC UNREAD" is 0 in PDU mode */
+    list_pdu_parts (self,
+                    "+CMGL=0",
+                    ctx->storage,
+                    NULL,
+                    (GAsyncReadyCallback)pending_sms_parts_list_ready,
+                    task);
+}
+
+static void
+read_pending_sms_parts_ready (MMBroadbandModem *self,
+                              GAsyncResult *res)
+{
+    GError *error = NULL;
+
+    if (!g_task_propagate_boolean (G_TASK (res), &error)) {
+        mm_dbg ("Couldn't read new SMS parts: '%s'", error->message);
+        g_error_free (error);
+    }
+
+    self->priv->pending_sms_parts_reading = FALSE;
+    schedule_pending_sms_parts_read (self);
+}
+
+static void
+read_pending_sms_parts (MMBroadbandModem *self)
+{
+    ReadPendingSmsPartsContext *ctx;
+    GTask *task;
+    guint i;
+
+    g_assert (!self->priv->pending_sms_parts_reading);
+
+    ctx = g_slice_new0 (ReadPendingSmsPartsContext);
+    ctx->indices = g_array_new (FALSE, FALSE, sizeof (guint));
+
+    /* Take all the pending parts in the same storage as the first one; the
+     * ones in other storages will be read afterwards */
+    while (self->priv->pending_sms_parts->len > 0 && ctx->indices->len == 0) {
+        ctx->storage = g_array_index (self->priv->pending_sms_parts, PendingSmsPart, 0).storage;
+        for (i = 0; i < self->priv->pending_sms_parts->len;) {
+            PendingSmsPart *pending;
+
+            pending = &g_array_index (self->priv->pending_sms_parts, PendingSmsPart, i);
+            if (pending->storage != ctx->storage) {
+                i++;
+                continue;
+            }
+            if (!mm_sms_list_has_part (self->priv->modem_messaging_sms_list,
+                                       pending->storage,
+                                       pending->idx)) {
+                g_array_append_val (ctx->indices, pending->idx);
+                ctx->lock_attempts = MAX (ctx->lock_attempts, pending->lock_attempts);
+            }
+            g_array_remove_index (self->priv->pending_sms_parts, i);
+        }
+    }
+
+    if (ctx->indices->len == 0) {
+        read_pending_sms_parts_context_free (ctx);
+        return;
+    }
+
+    mm_dbg ("Reading %u new SMS parts from storage '%s'",
+            ctx->indices->len, mm_sms_storage_get_string (ctx->storage));
+
+    self->priv->pending_sms_parts_reading = TRUE;
+    task = g_task_new (self, NULL, (GAsyncReadyCallback)read_pending_sms_parts_ready, NULL);
+    g_task_set_task_data (task, ctx, (GDestroyNotify)read_pending_sms_parts_context_free);
 
     /* First, request to set the proper storage to read from */
     mm_broadband_modem_lock_sms_storages (self,
-                                          storage,
+                                          ctx->storage,
                                           MM_SMS_STORAGE_UNKNOWN,
-                                          (GAsyncReadyCallback)indication_lock_storages_ready,
+                                          (GAsyncReadyCallback)pending_sms_parts_lock_storages_ready,
                                           task);
 }
 
+static void
+cmti_received (MMPortSerialAt *port,
+               GMatchInfo *info,
+               MMBroadbandModem *self)
+{
+    PendingSmsPart new_part;
+    guint idx = 0;
+    guint i;
+    MMSmsStorage storage;
+    gchar *str;
+
+    if (!mm_get_uint_from_match_info (info, 2, &idx))
+        return;
+
+    /* The match info gives us in which storage the index applies */
+    str = mm_get_string_unquoted_from_match_info (info, 1);
+    storage = mm_common_get_sms_storage_from_string (str, NULL);
+    if (storage == MM_SMS_STORAGE_UNKNOWN) {
+        mm_dbg ("Skipping CMTI indication, unknown storage '%s' reported", str);
+        g_free (str);
+        return;
+    }
+    g_free (str);
+
+    /* Don't signal multiple times if there are multiple CMTI notifications for a message */
+    if (mm_sms_list_has_part (self->priv->modem_messaging_sms_list,
+                              storage,
+                              idx)) {
+        mm_dbg ("Skipping CMTI indication, part already processed");
+        return;
+    }
+
+    for (i = 0; i < self->priv->pending_sms_parts->len; i++) {
+        PendingSmsPart *pending;
+
+        pending = &g_array_index (self->priv->pending_sms_parts, PendingSmsPart, i);
+        if (pending->storage == storage && pending->idx == idx) {
+            mm_dbg ("Skipping CMTI indication, part already pending");
+            return;
+        }
+    }
+
+    new_part.storage = storage;
+    new_part.idx = idx;
+    new_part.lock_attempts = 0;
+    g_array_append_val (self->priv->pending_sms_parts, new_part);
+    schedule_pending_sms_parts_read (self);
+}
+
 static void
 cds_received (MMPortSerialAt *port,
               GMatchInfo *info,
@@ -6349,6 +6903,10 @@ set_messaging_unsolicited_events_handlers (MMIfaceModemMessaging *self,
     g_regex_unref (cmti_regex);
     g_regex_unref (cds_regex);
 
+    /* Indications already received are not read any more */
+    if (!enable)
+        clear_pending_sms_parts (MM_BROADBAND_MODEM (self));
+
     task = g_task_new (self, NULL, callback, user_data);
     g_task_return_boolean (task, TRUE);
     g_object_unref (task);
@@ -6517,8 +7075,17 @@ modem_messaging_enable_unsolicited_events (MMIfaceModemMessaging *self,
 
 typedef struct {
     MMSmsStorage list_storage;
+    MMSmsStorageSnapshot *snapshot;
 } ListPartsContext;
 
+static void
+list_parts_context_free (ListPartsContext *ctx)
+{
+    if (ctx->snapshot)
+        mm_sms_storage_snapshot_free (ctx->snapshot);
+    g_free (ctx);
+}
+
 static gboolean
 modem_messaging_load_initial_sms_parts_finish (MMIfaceModemMessaging *self,
                                                GAsyncResult *res,
@@ -6671,78 +7238,60 @@ next:
     g_object_unref (task);
 }
 
-static MMSmsState
-sms_state_from_index (guint index)
-{
-    /* We merge unread and read messages in the same state */
-    switch (index) {
-    case 0: /* received, unread */
-    case 1: /* received, read */
-        return MM_SMS_STATE_RECEIVED;
-    case 2:
-        return MM_SMS_STATE_STORED;
-    case 3:
-        return MM_SMS_STATE_SENT;
-    default:
-        return MM_SMS_STATE_UNKNOWN;
-    }
-}
-
 static void
 sms_pdu_part_list_ready (MMBroadbandModem *self,
                          GAsyncResult *res,
                          GTask *task)
 {
     ListPartsContext *ctx;
-    const gchar *response;
     GError *error = NULL;
-    GList *info_list;
-    GList *l;
 
     /* Always always always unlock mem1 storage. Warned you've been. */
     mm_broadband_modem_unlock_sms_storages (self, TRUE, FALSE);
 
-    response = mm_base_modem_at_command_finish (MM_BASE_MODEM (self), res, &error);
-    if (error) {
-        g_task_return_error (task, error);
-        g_object_unref (task);
-        return;
-    }
-
-    info_list = mm_3gpp_parse_pdu_cmgl_response (response, &error);
-    if (error) {
+    /* Listed parts are already taken */
+    if (!list_pdu_parts_finish (self, res, &error)) {
         g_task_return_error (task, error);
         g_object_unref (task);
         return;
     }
 
+    /* Keep the full listing, so that it's not needed next time */
     ctx = g_task_get_task_data (task);
-
-    for (l = info_list; l; l = g_list_next (l)) {
-        MM3gppPduInfo *info = l->data;
-        MMSmsPart *part;
-
-        part = mm_sms_part_3gpp_new_from_pdu (info->index, info->pdu, &error);
-        if (part) {
-            mm_dbg ("Correctly parsed PDU (%d)", info->index);
-            mm_iface_modem_messaging_take_part (MM_IFACE_MODEM_MESSAGING (self),
-                                                part,
-                                                sms_state_from_index (info->status),
-                                                ctx->list_storage);
-        } else {
-            /* Don't treat the error as critical */
-            mm_dbg ("Error parsing PDU (%d): %s", info->index, error->message);
-            g_clear_error (&error);
-        }
-    }
-
-    mm_3gpp_pdu_info_list_free (info_list);
+    mm_sms_storage_cache_take (MM_BASE_MODEM (self), ctx->list_storage, ctx->snapshot);
+    ctx->snapshot = NULL;
 
     /* We consider all done */
     g_task_return_boolean (task, TRUE);
     g_object_unref (task);
 }
 
+static void
+take_cached_sms_part (guint index,
+                      guint status,
+                      const guint8 *pdu,
+                      gsize pdu_len,
+                      GTask *task)
+{
+    ListPartsContext *ctx;
+    MMSmsPart *part;
+    GError *error = NULL;
+
+    ctx = g_task_get_task_data (task);
+
+    part = mm_sms_part_3gpp_new_from_binary_pdu (index, pdu, pdu_len, &error);
+    if (!part) {
+        mm_dbg ("Error parsing cached PDU (%u): %s", index, error->message);
+        g_error_free (error);
+        return;
+    }
+
+    mm_iface_modem_messaging_take_part (MM_IFACE_MODEM_MESSAGING (g_task_get_source_object (task)),
+                                        part,
+                                        sms_state_from_index (status),
+                                        ctx->list_storage);
+}
+
 static void
 list_parts_lock_storages_ready (MMBroadbandModem *self,
                                 GAsyncResult *res,
@@ -6762,15 +7311,46 @@ list_parts_lock_storages_ready (MMBroadbandModem *self,
 
     /* Get SMS parts from ALL types.
      * Different command to be used if we are on Text or PDU mode */
+    if (self->priv->modem_messaging_sms_pdu_mode) {
+        ListPartsContext *ctx;
+
+        ctx = g_task_get_task_data (task);
+
+        /* If the storage holds as many messages as when it was last listed
+         * (and nothing was stored or deleted by us since then), reuse that
+         * listing instead of transferring all PDUs again. Note that a
+         * message deleted and another one received while the modem wasn't
+         * watching the storage keep the count; the cache therefore doesn't
+         * trust listings left unwatched for longer than a short while. */
+        if (self->priv->current_sms_mem1_used >= 0 &&
+            mm_sms_storage_cache_foreach (MM_BASE_MODEM (self),
+                                          ctx->list_storage,
+                                          (guint)self->priv->current_sms_mem1_used,
+                                          (MMSmsStorageCacheForeachFn)take_cached_sms_part,
+                                          task)) {
+            mm_dbg ("Reused cached listing of SMS parts in storage '%s'",
+                    mm_sms_storage_get_string (ctx->list_storage));
+            mm_broadband_modem_unlock_sms_storages (self, TRUE, FALSE);
+            g_task_return_boolean (task, TRUE);
+            g_object_unref (task);
+            return;
+        }
+
+        ctx->snapshot = mm_sms_storage_snapshot_new ();
+        list_pdu_parts (self,
+                        "+CMGL=4",
+                        ctx->list_storage,
+                        ctx->snapshot,
+                        (GAsyncReadyCallback)sms_pdu_part_list_ready,
+                        task);
+        return;
+    }
+
     mm_base_modem_at_command (MM_BASE_MODEM (self),
-                              (MM_BROADBAND_MODEM (self)->priv->modem_messaging_sms_pdu_mode ?
-                               "+CMGL=4" :
-                               "+CMGL=\"ALL\""),
+                              "+CMGL=\"ALL\"",
                               20,
                               FALSE,
-                              (GAsyncReadyCallback) (MM_BROADBAND_MODEM (self)->priv->modem_messaging_sms_pdu_mode ?
-                                                     sms_pdu_part_list_ready :
-                                                     sms_text_part_list_ready),
+                              (GAsyncReadyCallback)sms_text_part_list_ready,
                               task);
 }
 
@@ -6780,24 +7360,316 @@ modem_messaging_load_initial_sms_parts (MMIfaceModemMessaging *self,
                                         GAsyncReadyCallback callback,
                                         gpointer user_data)
 {
-    ListPartsContext *ctx;
+    ListPartsContext *ctx;
+    GTask *task;
+
+    ctx = g_new0 (ListPartsContext, 1);
+    ctx->list_storage = storage;
+
+    task = g_task_new (self, NULL, callback, user_data);
+    g_task_set_task_data (task, ctx, (GDestroyNotify)list_parts_context_free);
+
+    mm_dbg ("Listing SMS parts in storage '%s'",
+            mm_sms_storage_get_string (storage));
+
+    /* First, request to set the proper storage to read from */
+    mm_broadband_modem_lock_sms_storages (MM_BROADBAND_MODEM (self),
+                                          storage,
+                                          MM_SMS_STORAGE_UNKNOWN,
+                                          (GAsyncReadyCallback)list_parts_lock_storages_ready,
+                                          task);
+}
+
+/*****************************************************************************/
+/* Load a single stored SMS part (Messaging interface) */
+
+static MMSmsPart *
+modem_messaging_load_sms_part_finish (MMIfaceModemMessaging *self,
+                                      GAsyncResult *res,
+                                      GError **error)
+{
+    return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+static void
+load_sms_part_read_ready (MMBroadbandModem *self,
+                          GAsyncResult *res,
+                          GTask *task)
+{
+    MM3gppPduInfo *info;
+    MMSmsPart *part;
+    const gchar *response;
+    guint idx;
+    GError *error = NULL;
+
+    /* Always always always unlock mem1 storage. Warned you've been. */
+    mm_broadband_modem_unlock_sms_storages (self, TRUE, FALSE);
+
+    response = mm_base_modem_at_command_finish (MM_BASE_MODEM (self), res, &error);
+    if (error) {
+        g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
+    }
+
+    idx = GPOINTER_TO_UINT (g_task_get_task_data (task));
+    info = mm_3gpp_parse_cmgr_read_response (response, idx, &error);
+    if (!info) {
+        g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
+    }
+
+    part = mm_sms_part_3gpp_new_from_pdu (idx, info->pdu, &error);
+    mm_3gpp_pdu_info_free (info);
+    if (!part)
+        g_task_return_error (task, error);
+    else
+        g_task_return_pointer (task, part, (GDestroyNotify)mm_sms_part_free);
+    g_object_unref (task);
+}
+
+static void
+load_sms_part_lock_storages_ready (MMBroadbandModem *self,
+                                   GAsyncResult *res,
+                                   GTask *task)
+{
+    GError *error = NULL;
+    gchar *command;
+
+    if (!mm_broadband_modem_lock_sms_storages_finish (self, res, &error)) {
+        g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
+    }
+
+    /* Storage now set and locked */
+    command = g_strdup_printf ("+CMGR=%u", GPOINTER_TO_UINT (g_task_get_task_data (task)));
+    mm_base_modem_at_command (MM_BASE_MODEM (self),
+                              command,
+                              10,
+                              FALSE,
+                              (GAsyncReadyCallback)load_sms_part_read_ready,
+                              task);
+    g_free (command);
+}
+
+static void
+modem_messaging_load_sms_part (MMIfaceModemMessaging *self,
+                               MMSmsStorage storage,
+                               guint index,
+                               GAsyncReadyCallback callback,
+                               gpointer user_data)
+{
+    GTask *task;
+
+    task = g_task_new (self, NULL, callback, user_data);
+    g_task_set_task_data (task, GUINT_TO_POINTER (index), NULL);
+
+    /* Only PDU mode responses can be parsed into single parts */
+    if (!MM_BROADBAND_MODEM (self)->priv->modem_messaging_sms_pdu_mode) {
+        g_task_return_new_error (task,
+                                 MM_CORE_ERROR,
+                                 MM_CORE_ERROR_UNSUPPORTED,
+                                 "Cannot load single SMS parts in text mode");
+        g_object_unref (task);
+        return;
+    }
+
+    mm_broadband_modem_lock_sms_storages (MM_BROADBAND_MODEM (self),
+                                          storage,
+                                          MM_SMS_STORAGE_UNKNOWN,
+                                          (GAsyncReadyCallback)load_sms_part_lock_storages_ready,
+                                          task);
+}
+
+/*****************************************************************************/
+/* Send PDU (Messaging interface) */
+
+typedef struct {
+    gchar *cmd;
+    gchar *msg_data;
+    gboolean more_to_send;
+} SendPduContext;
+
+static void
+send_pdu_context_free (SendPduContext *ctx)
+{
+    g_free (ctx->cmd);
+    g_free (ctx->msg_data);
+    g_slice_free (SendPduContext, ctx);
+}
+
+static gboolean
+modem_messaging_send_pdu_finish (MMIfaceModemMessaging *self,
+                                 GAsyncResult *res,
+                                 guint *message_reference,
+                                 GError **error)
+{
+    GError *inner_error = NULL;
+    gssize value;
+
+    value = g_task_propagate_int (G_TASK (res), &inner_error);
+    if (inner_error) {
+        g_propagate_error (error, inner_error);
+        return FALSE;
+    }
+
+    if (message_reference)
+        *message_reference = (guint)value;
+    return TRUE;
+}
+
+static void
+send_pdu_msg_data_ready (MMBaseModem *self,
+                         GAsyncResult *res,
+                         GTask *task)
+{
+    const gchar *response;
+    gint rv = 0;
+    gint message_reference = -1;
+    GError *error = NULL;
+
+    response = mm_base_modem_at_command_finish (self, res, &error);
+    if (!response) {
+        /* The link is surely not kept open after an error */
+        MM_BROADBAND_MODEM (self)->priv->sms_more_messages_enabled = FALSE;
+        g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
+    }
+
+    if (strstr (response, "+CMGS"))
+        rv = sscanf (strstr (response, "+CMGS"), "+CMGS: %d", &message_reference);
+
+    if (rv != 1 || message_reference < 0) {
+        g_task_return_new_error (task,
+                                 MM_CORE_ERROR,
+                                 MM_CORE_ERROR_FAILED,
+                                 "Couldn't read message reference: "
+                                 "%d fields parsed from response '%s'",
+                                 rv, response);
+        g_object_unref (task);
+        return;
+    }
+
+    g_task_return_int (task, message_reference);
+    g_object_unref (task);
+}
+
+static void
+send_pdu_cmgs_ready (MMBaseModem *self,
+                     GAsyncResult *res,
+                     GTask *task)
+{
+    SendPduContext *ctx;
+    GError *error = NULL;
+
+    if (!mm_base_modem_at_command_finish (self, res, &error)) {
+        MM_BROADBAND_MODEM (self)->priv->sms_more_messages_enabled = FALSE;
+        g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
+    }
+
+    ctx = g_task_get_task_data (task);
+    mm_base_modem_at_command_raw (self,
+                                  ctx->msg_data,
+                                  10,
+                                  FALSE,
+                                  (GAsyncReadyCallback)send_pdu_msg_data_ready,
+                                  task);
+}
+
+static void
+send_pdu_cmgs (GTask *task)
+{
+    MMBroadbandModem *self;
+    SendPduContext *ctx;
+
+    self = g_task_get_source_object (task);
+    ctx = g_task_get_task_data (task);
+
+    /* Once the last one is sent, the modem falls back to closing the link */
+    if (!ctx->more_to_send)
+        self->priv->sms_more_messages_enabled = FALSE;
+
+    mm_base_modem_at_command (MM_BASE_MODEM (self),
+                              ctx->cmd,
+                              30,
+                              FALSE,
+                              (GAsyncReadyCallback)send_pdu_cmgs_ready,
+                              task);
+}
+
+static void
+send_pdu_cmms_ready (MMBaseModem *_self,
+                     GAsyncResult *res,
+                     GTask *task)
+{
+    MMBroadbandModem *self = MM_BROADBAND_MODEM (_self);
+    GError *error = NULL;
+
+    if (!mm_base_modem_at_command_finish (_self, res, &error)) {
+        /* Not fatal, messages are just sent one link at a time */
+        mm_dbg ("Couldn't keep SMS link open: '%s'", error->message);
+        self->priv->sms_more_messages_unsupported = TRUE;
+        g_error_free (error);
+    } else
+        self->priv->sms_more_messages_enabled = TRUE;
+
+    send_pdu_cmgs (task);
+}
+
+static void
+modem_messaging_send_pdu (MMIfaceModemMessaging *_self,
+                          const guint8 *pdu,
+                          guint pdu_len,
+                          guint msgstart,
+                          gboolean more_to_send,
+                          GAsyncReadyCallback callback,
+                          gpointer user_data)
+{
+    MMBroadbandModem *self = MM_BROADBAND_MODEM (_self);
+    SendPduContext *ctx;
     GTask *task;
-
-    ctx = g_new (ListPartsContext, 1);
-    ctx->list_storage = storage;
+    gchar *hex;
 
     task = g_task_new (self, NULL, callback, user_data);
-    g_task_set_task_data (task, ctx, g_free);
 
-    mm_dbg ("Listing SMS parts in storage '%s'",
-            mm_sms_storage_get_string (storage));
+    if (!self->priv->modem_messaging_sms_pdu_mode) {
+        g_task_return_new_error (task,
+                                 MM_CORE_ERROR,
+                                 MM_CORE_ERROR_UNSUPPORTED,
+                                 "Cannot send PDU: modem not in PDU mode");
+        g_object_unref (task);
+        return;
+    }
 
-    /* First, request to set the proper storage to read from */
-    mm_broadband_modem_lock_sms_storages (MM_BROADBAND_MODEM (self),
-                                          storage,
-                                          MM_SMS_STORAGE_UNKNOWN,
-                                          (GAsyncReadyCallback)list_parts_lock_storages_ready,
-                                          task);
+    hex = mm_utils_bin2hexstr (pdu, pdu_len);
+
+    ctx = g_slice_new0 (SendPduContext);
+    /* CMGS length is the size of the PDU without SMSC information */
+    ctx->cmd = g_strdup_printf ("+CMGS=%u", pdu_len - msgstart);
+    ctx->msg_data = g_strdup_printf ("%s\x1a", hex);
+    ctx->more_to_send = more_to_send;
+    g_task_set_task_data (task, ctx, (GDestroyNotify)send_pdu_context_free);
+    g_free (hex);
+
+    /* Ask the modem to keep the link open if more messages will follow */
+    if (more_to_send &&
+        !self->priv->sms_more_messages_enabled &&
+        !self->priv->sms_more_messages_unsupported) {
+        mm_base_modem_at_command (MM_BASE_MODEM (self),
+                                  "+CMMS=1",
+                                  3,
+                                  FALSE,
+                                  (GAsyncReadyCallback)send_pdu_cmms_ready,
+                                  task);
+        return;
+    }
+
+    send_pdu_cmgs (task);
 }
 
 /*****************************************************************************/
@@ -7300,6 +8172,42 @@ modem_cdma_cleanup_unsolicited_events (MMIfaceModemCdma *self,
                                                  user_data);
 }
 
+/*****************************************************************************/
+/* QCDM responses prefetched along with the Call Manager state (CDMA interface) */
+
+/* A registration check runs all its QCDM steps right one after the other */
+#define QCDM_PREFETCH_MAX_AGE_US (5 * G_USEC_PER_SEC)
+
+static void
+qcdm_prefetch_clear (MMBroadbandModem *self)
+{
+    if (self->priv->qcdm_hdr_state_prefetch) {
+        g_byte_array_unref (self->priv->qcdm_hdr_state_prefetch);
+        self->priv->qcdm_hdr_state_prefetch = NULL;
+    }
+    if (self->priv->qcdm_cdma_status_prefetch) {
+        g_byte_array_unref (self->priv->qcdm_cdma_status_prefetch);
+        self->priv->qcdm_cdma_status_prefetch = NULL;
+    }
+}
+
+/* Takes the prefetched response out of @slot, if still fresh */
+static GByteArray *
+qcdm_prefetch_take (MMBroadbandModem *self,
+                    GByteArray **slot)
+{
+    GByteArray *response;
+
+    response = *slot;
+    *slot = NULL;
+    if (response &&
+        (g_get_monotonic_time () - self->priv->qcdm_prefetch_time) > QCDM_PREFETCH_MAX_AGE_US) {
+        g_byte_array_unref (response);
+        return NULL;
+    }
+    return response;
+}
+
 /*****************************************************************************/
 /* HDR state check (CDMA interface) */
 
@@ -7339,28 +8247,17 @@ modem_cdma_get_hdr_state_finish (MMIfaceModemCdma *self,
 }
 
 static void
-hdr_subsys_state_info_ready (MMPortSerialQcdm *port,
-                             GAsyncResult *res,
-                             GTask *task)
+hdr_subsys_state_info_process (GTask *task,
+                               GByteArray *response)
 {
     QcdmResult *result;
     HdrStateResults *results;
     gint err = QCDM_SUCCESS;
-    GError *error = NULL;
-    GByteArray *response;
-
-    response = mm_port_serial_qcdm_command_finish (port, res, &error);
-    if (error) {
-        g_task_return_error (task, error);
-        g_object_unref (task);
-        return;
-    }
 
     /* Parse the response */
     result = qcdm_cmd_hdr_subsys_state_info_result ((const gchar *) response->data,
                                                     response->len,
                                                     &err);
-    g_byte_array_unref (response);
     if (!result) {
         g_task_return_new_error (task,
                                  MM_CORE_ERROR,
@@ -7384,6 +8281,25 @@ hdr_subsys_state_info_ready (MMPortSerialQcdm *port,
     g_object_unref (task);
 }
 
+static void
+hdr_subsys_state_info_ready (MMPortSerialQcdm *port,
+                             GAsyncResult *res,
+                             GTask *task)
+{
+    GError *error = NULL;
+    GByteArray *response;
+
+    response = mm_port_serial_qcdm_command_finish (port, res, &error);
+    if (error) {
+        g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
+    }
+
+    hdr_subsys_state_info_process (task, response);
+    g_byte_array_unref (response);
+}
+
 static void
 modem_cdma_get_hdr_state (MMIfaceModemCdma *self,
                           GAsyncReadyCallback callback,
@@ -7396,6 +8312,15 @@ modem_cdma_get_hdr_state (MMIfaceModemCdma *self,
 
     task = g_task_new (self, NULL, callback, user_data);
 
+    /* Already got along with the Call Manager state? */
+    hdrstate = qcdm_prefetch_take (MM_BROADBAND_MODEM (self),
+                                   &MM_BROADBAND_MODEM (self)->priv->qcdm_hdr_state_prefetch);
+    if (hdrstate) {
+        hdr_subsys_state_info_process (task, hdrstate);
+        g_byte_array_unref (hdrstate);
+        return;
+    }
+
     qcdm = mm_base_modem_peek_port_qcdm (MM_BASE_MODEM (self));
     if (!qcdm) {
         g_task_return_new_error (task,
@@ -7439,18 +8364,24 @@ typedef struct {
 } CallManagerStateResults;
 
 typedef struct {
-    MMBroadbandModem *self;
-    GSimpleAsyncResult *result;
     MMPortSerialQcdm *qcdm;
+    /* Position of the prefetched responses in the batch, or -1 */
+    gint hdr_state_idx;
+    gint cdma_status_idx;
 } CallManagerStateContext;
 
 static void
-cm_state_cleanup_port (MMPortSerial *port)
+call_manager_state_context_free (CallManagerStateContext *ctx)
 {
-    mm_port_serial_close (port);
-    g_object_unref (port);
+    mm_port_serial_close (MM_PORT_SERIAL (ctx->qcdm));
+    g_object_unref (ctx->qcdm);
+    g_slice_free (CallManagerStateContext, ctx);
 }
 
+static void modem_cdma_get_cdma1x_serving_system (MMIfaceModemCdma *self,
+                                                  GAsyncReadyCallback callback,
+                                                  gpointer user_data);
+
 static gboolean
 modem_cdma_get_call_manager_state_finish (MMIfaceModemCdma *self,
                                           GAsyncResult *res,
@@ -7472,28 +8403,17 @@ modem_cdma_get_call_manager_state_finish (MMIfaceModemCdma *self,
 }
 
 static void
-cm_subsys_state_info_ready (MMPortSerialQcdm *port,
-                            GAsyncResult *res,
-                            GTask *task)
+cm_subsys_state_info_complete (GTask *task,
+                               GByteArray *response)
 {
     QcdmResult *result;
     CallManagerStateResults *results;
     gint err = QCDM_SUCCESS;
-    GError *error = NULL;
-    GByteArray *response;
-
-    response = mm_port_serial_qcdm_command_finish (port, res, &error);
-    if (error) {
-        g_task_return_error (task, error);
-        g_object_unref (task);
-        return;
-    }
 
     /* Parse the response */
     result = qcdm_cmd_cm_subsys_state_info_result ((const gchar *) response->data,
                                                    response->len,
                                                    &err);
-    g_byte_array_unref (response);
     if (!result) {
         g_task_return_new_error (task,
                                  MM_CORE_ERROR,
@@ -7514,6 +8434,77 @@ cm_subsys_state_info_ready (MMPortSerialQcdm *port,
     g_object_unref (task);
 }
 
+static void
+cm_subsys_state_info_single_ready (MMPortSerialQcdm *port,
+                                   GAsyncResult *res,
+                                   GTask *task)
+{
+    GError *error = NULL;
+    GByteArray *response;
+
+    response = mm_port_serial_qcdm_command_finish (port, res, &error);
+    if (!response) {
+        g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
+    }
+
+    cm_subsys_state_info_complete (task, response);
+    g_byte_array_unref (response);
+}
+
+static void
+cm_subsys_state_info_ready (MMPortSerialQcdm *port,
+                            GAsyncResult *res,
+                            GTask *task)
+{
+    MMBroadbandModem *self;
+    CallManagerStateContext *ctx;
+    GError *error = NULL;
+    GPtrArray *responses;
+    GByteArray *response;
+
+    responses = mm_port_serial_qcdm_command_batch_finish (port, res, &error);
+    if (!responses) {
+        g_task_return_error (task, error);
+        g_object_unref (task);
+        return;
+    }
+
+    /* Keep the responses for the checks which follow; the ones missing after
+     * a timeout are just queried again by those checks */
+    self = g_task_get_source_object (task);
+    ctx = g_task_get_task_data (task);
+    if (ctx->hdr_state_idx >= 0 && g_ptr_array_index (responses, ctx->hdr_state_idx))
+        self->priv->qcdm_hdr_state_prefetch = g_byte_array_ref (g_ptr_array_index (responses, ctx->hdr_state_idx));
+    if (ctx->cdma_status_idx >= 0 && g_ptr_array_index (responses, ctx->cdma_status_idx))
+        self->priv->qcdm_cdma_status_prefetch = g_byte_array_ref (g_ptr_array_index (responses, ctx->cdma_status_idx));
+    self->priv->qcdm_prefetch_time = g_get_monotonic_time ();
+
+    response = g_ptr_array_index (responses, 0);
+    if (!response) {
+        GByteArray *cmd;
+
+        /* The CM state response itself was lost, ask for it alone */
+        g_ptr_array_unref (responses);
+        mm_dbg ("No CM subsys state info in batch, querying it alone");
+        cmd = g_byte_array_sized_new (25);
+        cmd->len = qcdm_cmd_cm_subsys_state_info_new ((gchar *) cmd->data, 25);
+        g_assert (cmd->len);
+        mm_port_serial_qcdm_command (ctx->qcdm,
+                                     cmd,
+                                     3,
+                                     NULL,
+                                     (GAsyncReadyCallback)cm_subsys_state_info_single_ready,
+                                     task);
+        g_byte_array_unref (cmd);
+        return;
+    }
+
+    cm_subsys_state_info_complete (task, response);
+    g_ptr_array_unref (responses);
+}
+
 static void
 modem_cdma_get_call_manager_state (MMIfaceModemCdma *self,
                                    GAsyncReadyCallback callback,
@@ -7521,11 +8512,15 @@ modem_cdma_get_call_manager_state (MMIfaceModemCdma *self,
 {
     MMPortSerialQcdm *qcdm;
     GTask *task;
-    GByteArray *cmstate;
+    CallManagerStateContext *ctx;
+    GPtrArray *commands;
+    GByteArray *cmd;
     GError *error = NULL;
 
     task = g_task_new (self, NULL, callback, user_data);
 
+    qcdm_prefetch_clear (MM_BROADBAND_MODEM (self));
+
     qcdm = mm_base_modem_peek_port_qcdm (MM_BASE_MODEM (self));
     if (!qcdm) {
         g_task_return_new_error (task,
@@ -7542,22 +8537,45 @@ modem_cdma_get_call_manager_state (MMIfaceModemCdma *self,
         return;
     }
 
-    g_task_set_task_data (task,
-                          g_object_ref (qcdm),
-                          (GDestroyNotify) cm_state_cleanup_port);
+    ctx = g_slice_new (CallManagerStateContext);
+    ctx->qcdm = g_object_ref (qcdm);
+    ctx->hdr_state_idx = -1;
+    ctx->cdma_status_idx = -1;
+    g_task_set_task_data (task, ctx, (GDestroyNotify) call_manager_state_context_free);
 
-    /* Setup command */
-    cmstate = g_byte_array_sized_new (25);
-    cmstate->len = qcdm_cmd_cm_subsys_state_info_new ((gchar *) cmstate->data, 25);
-    g_assert (cmstate->len);
+    /* Setup commands: when online, the Call Manager state check is followed
+     * by the HDR state and 1x serving system ones, so if we're the ones
+     * implementing them, query everything in a single round trip */
+    commands = g_ptr_array_new_with_free_func ((GDestroyNotify) g_byte_array_unref);
 
-    mm_port_serial_qcdm_command (qcdm,
-                                 cmstate,
-                                 3,
-                                 NULL,
-                                 (GAsyncReadyCallback)cm_subsys_state_info_ready,
-                                 task);
-    g_byte_array_unref (cmstate);
+    cmd = g_byte_array_sized_new (25);
+    cmd->len = qcdm_cmd_cm_subsys_state_info_new ((gchar *) cmd->data, 25);
+    g_assert (cmd->len);
+    g_ptr_array_add (commands, cmd);
+
+    if (MM_IFACE_MODEM_CDMA_GET_INTERFACE (self)->get_hdr_state == modem_cdma_get_hdr_state) {
+        cmd = g_byte_array_sized_new (25);
+        cmd->len = qcdm_cmd_hdr_subsys_state_info_new ((gchar *) cmd->data, 25);
+        g_assert (cmd->len);
+        ctx->hdr_state_idx = commands->len;
+        g_ptr_array_add (commands, cmd);
+    }
+
+    if (MM_IFACE_MODEM_CDMA_GET_INTERFACE (self)->get_cdma1x_serving_system == modem_cdma_get_cdma1x_serving_system) {
+        cmd = g_byte_array_sized_new (25);
+        cmd->len = qcdm_cmd_cdma_status_new ((gchar *) cmd->data, 25);
+        g_assert (cmd->len);
+        ctx->cdma_status_idx = commands->len;
+        g_ptr_array_add (commands, cmd);
+    }
+
+    mm_port_serial_qcdm_command_batch (qcdm,
+                                       commands,
+                                       3,
+                                       NULL,
+                                       (GAsyncReadyCallback)cm_subsys_state_info_ready,
+                                       task);
+    g_ptr_array_unref (commands);
 }
 
 /*****************************************************************************/
@@ -7751,27 +8769,14 @@ serving_system_query_css (GTask *task)
 }
 
 static void
-qcdm_cdma_status_ready (MMPortSerialQcdm *port,
-                        GAsyncResult *res,
-                        GTask *task)
+qcdm_cdma_status_process (GTask *task,
+                          GByteArray *response)
 {
     QcdmResult *result = NULL;
     guint32 sid = MM_MODEM_CDMA_SID_UNKNOWN;
     guint32 nid = MM_MODEM_CDMA_NID_UNKNOWN;
     guint32 rxstate = 0;
     gint err = QCDM_SUCCESS;
-    GError *error = NULL;
-    GByteArray *response;
-
-    response = mm_port_serial_qcdm_command_finish (port, res, &error);
-    if (error) {
-        mm_dbg ("Failed to get cdma status: %s", error->message);
-        g_clear_error (&error);
-
-        /* Fall back to AT+CSS */
-        serving_system_query_css (task);
-        return;
-    }
 
     result = qcdm_cmd_cdma_status_result ((const gchar *) response->data,
                                           response->len,
@@ -7779,15 +8784,12 @@ qcdm_cdma_status_ready (MMPortSerialQcdm *port,
     if (!result) {
         if (err != QCDM_SUCCESS)
             mm_dbg ("Failed to parse cdma status command result: %d", err);
-        g_byte_array_unref (response);
 
         /* Fall back to AT+CSS */
         serving_system_query_css (task);
         return;
     }
 
-    g_byte_array_unref (response);
-
     qcdm_result_get_u32 (result, QCDM_CMD_CDMA_STATUS_ITEM_RX_STATE, &rxstate);
     qcdm_result_get_u32 (result, QCDM_CMD_CDMA_STATUS_ITEM_SID, &sid);
     qcdm_result_get_u32 (result, QCDM_CMD_CDMA_STATUS_ITEM_NID, &nid);
@@ -7810,6 +8812,28 @@ qcdm_cdma_status_ready (MMPortSerialQcdm *port,
                                              (sid == MM_MODEM_CDMA_SID_UNKNOWN) ? 0 : 'Z');
 }
 
+static void
+qcdm_cdma_status_ready (MMPortSerialQcdm *port,
+                        GAsyncResult *res,
+                        GTask *task)
+{
+    GError *error = NULL;
+    GByteArray *response;
+
+    response = mm_port_serial_qcdm_command_finish (port, res, &error);
+    if (error) {
+        mm_dbg ("Failed to get cdma status: %s", error->message);
+        g_clear_error (&error);
+
+        /* Fall back to AT+CSS */
+        serving_system_query_css (task);
+        return;
+    }
+
+    qcdm_cdma_status_process (task, response);
+    g_byte_array_unref (response);
+}
+
 static void
 modem_cdma_get_cdma1x_serving_system (MMIfaceModemCdma *self,
                                       GAsyncReadyCallback callback,
@@ -7822,6 +8846,15 @@ modem_cdma_get_cdma1x_serving_system (MMIfaceModemCdma *self,
 
     task = g_task_new (self, NULL, callback, user_data);
 
+    /* Already got along with the Call Manager state? */
+    cdma_status = qcdm_prefetch_take (MM_BROADBAND_MODEM (self),
+                                      &MM_BROADBAND_MODEM (self)->priv->qcdm_cdma_status_prefetch);
+    if (cdma_status) {
+        qcdm_cdma_status_process (task, cdma_status);
+        g_byte_array_unref (cdma_status);
+        return;
+    }
+
     qcdm = mm_base_modem_peek_port_qcdm (MM_BASE_MODEM (self));
     if (!qcdm) {
         /* Fall back to AT+CSS */
@@ -9604,6 +10637,10 @@ disable (MMBaseModem *self,
     DisablingContext *ctx;
     GTask *task;
 
+    /* While disabled, the ports may be used by other programs to update the
+     * PDP contexts */
+    mm_broadband_modem_invalidate_3gpp_pdp_contexts (MM_BROADBAND_MODEM (self));
+
     ctx = g_new0 (DisablingContext, 1);
     ctx->self = g_object_ref (self);
     ctx->step = DISABLING_STEP_FIRST;
@@ -10622,6 +11659,103 @@ mm_broadband_modem_get_current_charset (MMBroadbandModem *self)
     return self->priv->modem_current_charset;
 }
 
+/*****************************************************************************/
+
+gboolean
+mm_broadband_modem_get_3gpp_cgev_enabled (MMBroadbandModem *self)
+{
+    return self->priv->modem_3gpp_cgev_enabled;
+}
+
+gboolean
+mm_broadband_modem_peek_3gpp_pdp_contexts (MMBroadbandModem *self,
+                                           GList **pdp_list)
+{
+    if (!self->priv->modem_3gpp_pdp_contexts_cached)
+        return FALSE;
+    *pdp_list = self->priv->modem_3gpp_pdp_contexts;
+    return TRUE;
+}
+
+void
+mm_broadband_modem_take_3gpp_pdp_contexts (MMBroadbandModem *self,
+                                           GList *pdp_list)
+{
+    mm_3gpp_pdp_context_list_free (self->priv->modem_3gpp_pdp_contexts);
+    self->priv->modem_3gpp_pdp_contexts = pdp_list;
+    self->priv->modem_3gpp_pdp_contexts_cached = TRUE;
+}
+
+static gint
+pdp_context_cmp (MM3gppPdpContext *a,
+                 MM3gppPdpContext *b)
+{
+    return (a->cid - b->cid);
+}
+
+void
+mm_broadband_modem_update_3gpp_pdp_context (MMBroadbandModem *self,
+                                            guint cid,
+                                            MMBearerIpFamily pdp_type,
+                                            const gchar *apn)
+{
+    MM3gppPdpContext *pdp = NULL;
+    GList *l;
+
+    if (!self->priv->modem_3gpp_pdp_contexts_cached)
+        return;
+
+    for (l = self->priv->modem_3gpp_pdp_contexts; l; l = g_list_next (l)) {
+        if (((MM3gppPdpContext *)(l->data))->cid == cid) {
+            pdp = l->data;
+            break;
+        }
+    }
+
+    if (!pdp) {
+        pdp = g_slice_new0 (MM3gppPdpContext);
+        pdp->cid = cid;
+        self->priv->modem_3gpp_pdp_contexts = g_list_insert_sorted (self->priv->modem_3gpp_pdp_contexts,
+                                                                    pdp,
+                                                                    (GCompareFunc) pdp_context_cmp);
+    }
+
+    pdp->pdp_type = pdp_type;
+    g_free (pdp->apn);
+    pdp->apn = g_strdup (apn);
+}
+
+void
+mm_broadband_modem_invalidate_3gpp_pdp_contexts (MMBroadbandModem *self)
+{
+    if (!self->priv->modem_3gpp_pdp_contexts_cached)
+        return;
+
+    mm_dbg ("Invalidating cached PDP context list");
+    mm_3gpp_pdp_context_list_free (self->priv->modem_3gpp_pdp_contexts);
+    self->priv->modem_3gpp_pdp_contexts = NULL;
+    self->priv->modem_3gpp_pdp_contexts_cached = FALSE;
+}
+
+gboolean
+mm_broadband_modem_peek_3gpp_pdp_context_formats (MMBroadbandModem *self,
+                                                  GList **formats)
+{
+    if (!self->priv->modem_3gpp_pdp_context_formats_cached)
+        return FALSE;
+    *formats = self->priv->modem_3gpp_pdp_context_formats;
+    return TRUE;
+}
+
+void
+mm_broadband_modem_take_3gpp_pdp_context_formats (MMBroadbandModem *self,
+                                                  GList *formats)
+{
+    mm_3gpp_pdp_context_format_list_free (self->priv->modem_3gpp_pdp_context_formats);
+    self->priv->modem_3gpp_pdp_context_formats = formats;
+    self->priv->modem_3gpp_pdp_context_formats_cached = TRUE;
+}
+
 gchar *
 mm_broadband_modem_create_device_identifier (MMBroadbandModem *self,
                                              const gchar *ati,
@@ -10662,6 +11796,9 @@ after_hotswap_event_disable_ready (MMBaseModem *self,
 void
 mm_broadband_modem_update_sim_hot_swap_detected (MMBroadbandModem *self)
 {
+    /* The PDP contexts are stored in the SIM in most modems */
+    mm_broadband_modem_invalidate_3gpp_pdp_contexts (self);
+
     if (self->priv->sim_hot_swap_ports_ctx) {
         mm_dbg ("Releasing SIM hot swap ports context");
         ports_context_unref (self->priv->sim_hot_swap_ports_ctx);
@@ -10798,6 +11935,9 @@ set_property (GObject *object,
     case PROP_MODEM_MESSAGING_SMS_PDU_MODE:
         self->priv->modem_messaging_sms_pdu_mode = g_value_get_boolean (value);
         break;
+    case PROP_MODEM_MESSAGING_SMS_LAZY_EXPORT:
+        self->priv->modem_messaging_sms_lazy_export = g_value_get_boolean (value);
+        break;
     case PROP_MODEM_MESSAGING_SMS_DEFAULT_STORAGE:
         self->priv->modem_messaging_sms_default_storage = g_value_get_enum (value);
         break;
@@ -10910,6 +12050,9 @@ get_property (GObject *object,
     case PROP_MODEM_MESSAGING_SMS_PDU_MODE:
         g_value_set_boolean (value, self->priv->modem_messaging_sms_pdu_mode);
         break;
+    case PROP_MODEM_MESSAGING_SMS_LAZY_EXPORT:
+        g_value_set_boolean (value, self->priv->modem_messaging_sms_lazy_export);
+        break;
     case PROP_MODEM_MESSAGING_SMS_DEFAULT_STORAGE:
         g_value_set_enum (value, self->priv->modem_messaging_sms_default_storage);
         break;
@@ -10942,6 +12085,7 @@ mm_broadband_modem_init (MMBroadbandModem *self)
                                               MM_TYPE_BROADBAND_MODEM,
                                               MMBroadbandModemPrivate);
     self->priv->modem_state = MM_MODEM_STATE_UNKNOWN;
+    self->priv->pending_sms_parts = g_array_new (FALSE, FALSE, sizeof (PendingSmsPart));
     self->priv->modem_3gpp_registration_regex = mm_3gpp_creg_regex_get (TRUE);
     self->priv->modem_current_charset = MM_MODEM_CHARSET_UNKNOWN;
     self->priv->modem_3gpp_registration_state = MM_MODEM_3GPP_REGISTRATION_STATE_UNKNOWN;
@@ -10955,6 +12099,7 @@ mm_broadband_modem_init (MMBroadbandModem *self)
     self->priv->modem_cdma_evdo_network_supported = TRUE;
     self->priv->modem_messaging_sms_default_storage = MM_SMS_STORAGE_UNKNOWN;
     self->priv->current_sms_mem1_storage = MM_SMS_STORAGE_UNKNOWN;
+    self->priv->current_sms_mem1_used = -1;
     self->priv->current_sms_mem2_storage = MM_SMS_STORAGE_UNKNOWN;
     self->priv->sim_hot_swap_supported = FALSE;
     self->priv->periodic_signal_check_disabled = FALSE;
@@ -10978,6 +12123,13 @@ finalize (GObject *object)
     if (self->priv->modem_3gpp_registration_regex)
         mm_3gpp_creg_regex_destroy (self->priv->modem_3gpp_registration_regex);
 
+    mm_3gpp_pdp_context_list_free (self->priv->modem_3gpp_pdp_contexts);
+    mm_3gpp_pdp_context_format_list_free (self->priv->modem_3gpp_pdp_context_formats);
+
+    g_array_unref (self->priv->pending_sms_parts);
+
+    qcdm_prefetch_clear (self);
+
     G_OBJECT_CLASS (mm_broadband_modem_parent_class)->finalize (object);
 }
 
@@ -11033,6 +12185,7 @@ dispose (GObject *object)
 
     g_clear_object (&self->priv->modem_sim);
     g_clear_object (&self->priv->modem_bearer_list);
+    clear_pending_sms_parts (self);
     g_clear_object (&self->priv->modem_messaging_sms_list);
     g_clear_object (&self->priv->modem_voice_call_list);
     g_clear_object (&self->priv->modem_simple_status);
@@ -11230,6 +12383,8 @@ iface_modem_messaging_init (MMIfaceModemMessaging *iface)
     iface->setup_sms_format_finish = modem_messaging_setup_sms_format_finish;
     iface->load_initial_sms_parts = modem_messaging_load_initial_sms_parts;
     iface->load_initial_sms_parts_finish = modem_messaging_load_initial_sms_parts_finish;
+    iface->load_sms_part = modem_messaging_load_sms_part;
+    iface->load_sms_part_finish = modem_messaging_load_sms_part_finish;
     iface->setup_unsolicited_events = modem_messaging_setup_unsolicited_events;
     iface->setup_unsolicited_events_finish = modem_messaging_setup_cleanup_unsolicited_events_finish;
     iface->enable_unsolicited_events = modem_messaging_enable_unsolicited_events;
@@ -11237,6 +12392,8 @@ iface_modem_messaging_init (MMIfaceModemMessaging *iface)
     iface->cleanup_unsolicited_events = modem_messaging_cleanup_unsolicited_events;
     iface->cleanup_unsolicited_events_finish = modem_messaging_setup_cleanup_unsolicited_events_finish;
     iface->create_sms = modem_messaging_create_sms;
+    iface->send_pdu = modem_messaging_send_pdu;
+    iface->send_pdu_finish = modem_messaging_send_pdu_finish;
     iface->init_current_storages = modem_messaging_init_current_storages;
     iface->init_current_storages_finish = modem_messaging_init_current_storages_finish;
 }
@@ -11424,6 +12581,10 @@ mm_broadband_modem_class_init (MMBroadbandModemClass *klass)
                                       PROP_MODEM_MESSAGING_SMS_PDU_MODE,
                                       MM_IFACE_MODEM_MESSAGING_SMS_PDU_MODE);
 
+    g_object_class_override_property (object_class,
+                                      PROP_MODEM_MESSAGING_SMS_LAZY_EXPORT,
+                                      MM_IFACE_MODEM_MESSAGING_SMS_LAZY_EXPORT);
+
     g_object_class_override_property (object_class,
                                       PROP_MODEM_MESSAGING_SMS_DEFAULT_STORAGE,
                                       MM_IFACE_MODEM_MESSAGING_SMS_DEFAULT_STORAGE);
@@ -112,6 +112,29 @@ gchar *mm_broadband_modem_take_and_convert_to_current_charset (MMBroadbandModem
 
 MMModemCharset mm_broadband_modem_get_current_charset (MMBroadbandModem *self);
 
+/* Whether +CGEV packet domain events are reported, so that bearers don't need
+ * to poll their connection status */
+gboolean mm_broadband_modem_get_3gpp_cgev_enabled (MMBroadbandModem *self);
+
+/* Cache of the PDP context list (+CGDCONT?) and of the supported PDP context
+ * formats (+CGDCONT=?), shared by all the bearers of the modem. The peek
+ * methods return FALSE if there is nothing cached; an empty list is a valid
+ * cached value. The take methods transfer ownership of the given list. */
+gboolean mm_broadband_modem_peek_3gpp_pdp_contexts        (MMBroadbandModem *self,
+                                                           GList **pdp_list);
+void     mm_broadband_modem_take_3gpp_pdp_contexts        (MMBroadbandModem *self,
+                                                           GList *pdp_list);
+/* Update the cached list after the given context has been (re)defined */
+void     mm_broadband_modem_update_3gpp_pdp_context       (MMBroadbandModem *self,
+                                                           guint cid,
+                                                           MMBearerIpFamily pdp_type,
+                                                           const gchar *apn);
+void     mm_broadband_modem_invalidate_3gpp_pdp_contexts  (MMBroadbandModem *self);
+gboolean mm_broadband_modem_peek_3gpp_pdp_context_formats (MMBroadbandModem *self,
+                                                           GList **formats);
+void     mm_broadband_modem_take_3gpp_pdp_context_formats (MMBroadbandModem *self,
+                                                           GList *formats);
+
 /* Create a unique device identifier string using the ATI and ATI1 replies and some
  * additional internal info */
 gchar *mm_broadband_modem_create_device_identifier (MMBroadbandModem *self,
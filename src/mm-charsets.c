@@ -95,21 +95,18 @@ charset_iconv_to (MMModemCharset charset)
     return NULL;
 }
 
-static const char *
-charset_iconv_from (MMModemCharset charset)
-{
-    CharsetEntry *iter = &charset_map[0];
-
-    g_return_val_if_fail (charset != MM_MODEM_CHARSET_UNKNOWN, NULL);
-
-    while (iter->gsm_name) {
-        if (iter->charset == charset)
-            return iter->iconv_from_name;
-        iter++;
-    }
-    g_warn_if_reached ();
-    return NULL;
-}
+/* Native codecs, defined below */
+static gboolean charset_has_codec     (MMModemCharset  charset);
+static gboolean charset_decode        (MMModemCharset  charset,
+                                       const guint8   *src,
+                                       gsize           src_len,
+                                       gboolean        src_hex,
+                                       GString        *out);
+static gboolean charset_encode        (MMModemCharset  charset,
+                                       const gchar    *utf8,
+                                       GByteArray     *out);
+static gchar   *charset_encode_to_hex (MMModemCharset  charset,
+                                       const gchar    *utf8);
 
 gboolean
 mm_modem_charset_byte_array_append (GByteArray *array,
@@ -117,102 +114,104 @@ mm_modem_charset_byte_array_append (GByteArray *array,
                                     gboolean quoted,
                                     MMModemCharset charset)
 {
-    const char *iconv_to;
-    char *converted;
-    GError *error = NULL;
-    gsize written = 0;
+    GByteArray *encoded;
 
     g_return_val_if_fail (array != NULL, FALSE);
     g_return_val_if_fail (utf8 != NULL, FALSE);
+    g_return_val_if_fail (charset == MM_MODEM_CHARSET_UTF8 ||
+                          charset_has_codec (charset) ||
+                          charset_iconv_to (charset) != NULL, FALSE);
+
+    encoded = g_byte_array_new ();
+
+    /* Try with the native codecs first, and only fall back to iconv if some
+     * character needs to be transliterated */
+    if (charset == MM_MODEM_CHARSET_UTF8)
+        g_byte_array_append (encoded, (const guint8 *) utf8, strlen (utf8));
+    else if (!charset_has_codec (charset) || !charset_encode (charset, utf8, encoded)) {
+        const char *iconv_to;
+        char *converted;
+        GError *error = NULL;
+        gsize written = 0;
 
-    iconv_to = charset_iconv_to (charset);
-    g_return_val_if_fail (iconv_to != NULL, FALSE);
+        /* No iconv fallback for the charsets only known by the native codecs,
+         * e.g. if the input isn't valid UTF-8 */
+        iconv_to = charset_iconv_to (charset);
+        if (!iconv_to) {
+            g_byte_array_unref (encoded);
+            return FALSE;
+        }
 
-    converted = g_convert (utf8, -1, iconv_to, "UTF-8", NULL, &written, &error);
-    if (!converted) {
-        if (error) {
-            mm_warn ("failed to convert '%s' to %s character set: (%d) %s",
-                     utf8, iconv_to, error->code, error->message);
-            g_error_free (error);
+        converted = g_convert (utf8, -1, iconv_to, "UTF-8", NULL, &written, &error);
+        if (!converted) {
+            if (error) {
+                mm_warn ("failed to convert '%s' to %s character set: (%d) %s",
+                         utf8, iconv_to, error->code, error->message);
+                g_error_free (error);
+            }
+            g_byte_array_unref (encoded);
+            return FALSE;
         }
-        return FALSE;
+
+        g_byte_array_set_size (encoded, 0);
+        g_byte_array_append (encoded, (const guint8 *) converted, written);
+        g_free (converted);
     }
 
     if (quoted)
         g_byte_array_append (array, (const guint8 *) "\"", 1);
-    g_byte_array_append (array, (const guint8 *) converted, written);
+    g_byte_array_append (array, encoded->data, encoded->len);
     if (quoted)
         g_byte_array_append (array, (const guint8 *) "\"", 1);
 
-    g_free (converted);
+    g_byte_array_unref (encoded);
     return TRUE;
 }
 
 char *
 mm_modem_charset_hex_to_utf8 (const char *src, MMModemCharset charset)
 {
-    char *unconverted, *converted;
-    const char *iconv_from;
-    gsize unconverted_len = 0;
-    GError *error = NULL;
+    GString *converted;
+    gsize src_len;
 
     g_return_val_if_fail (src != NULL, NULL);
     g_return_val_if_fail (charset != MM_MODEM_CHARSET_UNKNOWN, NULL);
+    g_return_val_if_fail (charset == MM_MODEM_CHARSET_UTF8 ||
+                          charset == MM_MODEM_CHARSET_IRA  ||
+                          charset_has_codec (charset), NULL);
 
-    iconv_from = charset_iconv_from (charset);
-    g_return_val_if_fail (iconv_from != NULL, FALSE);
-
-    unconverted = mm_utils_hexstr2bin (src, &unconverted_len);
-    if (!unconverted)
-        return NULL;
+    if (charset == MM_MODEM_CHARSET_UTF8 || charset == MM_MODEM_CHARSET_IRA) {
+        gsize unconverted_len = 0;
 
-    if (charset == MM_MODEM_CHARSET_UTF8 || charset == MM_MODEM_CHARSET_IRA)
-        return unconverted;
-
-    converted = g_convert (unconverted, unconverted_len,
-                           "UTF-8//TRANSLIT", iconv_from,
-                           NULL, NULL, &error);
-    if (!converted || error) {
-        g_clear_error (&error);
-        converted = NULL;
+        return mm_utils_hexstr2bin (src, &unconverted_len);
     }
 
-    g_free (unconverted);
+    /* Length must be a multiple of 2 */
+    src_len = strlen (src);
+    g_return_val_if_fail ((src_len % 2) == 0, NULL);
 
-    return converted;
+    /* Hex decoding and charset conversion done in one single pass */
+    converted = g_string_sized_new (src_len / 2 + 1);
+    if (!charset_decode (charset, (const guint8 *) src, src_len / 2, TRUE, converted)) {
+        g_string_free (converted, TRUE);
+        return NULL;
+    }
+    return g_string_free (converted, FALSE);
 }
 
 char *
 mm_modem_charset_utf8_to_hex (const char *src, MMModemCharset charset)
 {
-    gsize converted_len = 0;
-    char *converted;
-    const char *iconv_to;
-    GError *error = NULL;
-    gchar *hex;
-
     g_return_val_if_fail (src != NULL, NULL);
     g_return_val_if_fail (charset != MM_MODEM_CHARSET_UNKNOWN, NULL);
-
-    iconv_to = charset_iconv_from (charset);
-    g_return_val_if_fail (iconv_to != NULL, FALSE);
+    g_return_val_if_fail (charset == MM_MODEM_CHARSET_UTF8 ||
+                          charset == MM_MODEM_CHARSET_IRA  ||
+                          charset_has_codec (charset), NULL);
 
     if (charset == MM_MODEM_CHARSET_UTF8 || charset == MM_MODEM_CHARSET_IRA)
         return g_strdup (src);
 
-    converted = g_convert (src, strlen (src),
-                           iconv_to, "UTF-8//TRANSLIT",
-                           NULL, &converted_len, &error);
-    if (!converted || error) {
-        g_clear_error (&error);
-        g_free (converted);
-        return NULL;
-    }
-
-    /* Get hex representation of the string */
-    hex = mm_utils_bin2hexstr ((guint8 *)converted, converted_len);
-    g_free (converted);
-    return hex;
+    return charset_encode_to_hex (charset, src);
 }
 
 /* GSM 03.38 encoding conversion stuff */
@@ -312,25 +311,6 @@ gsm_def_char_to_utf8 (const guint8 gsm, guint8 out_utf8[2])
     return gsm_def_utf8_alphabet[gsm].len;
 }
 
-static gboolean
-utf8_to_gsm_def_char (const char *utf8, guint32 len, guint8 *out_gsm)
-{
-    int i;
-
-    if (len > 0 && len < 4) {
-        for (i = 0; i < GSM_DEF_ALPHABET_SIZE; i++) {
-            if (gsm_def_utf8_alphabet[i].len == len) {
-                if (memcmp (&gsm_def_utf8_alphabet[i].chars[0], utf8, len) == 0) {
-                    *out_gsm = i;
-                    return TRUE;
-                }
-            }
-        }
-    }
-    return FALSE;
-}
-
-
 #define EONE(a, g)        { {a, 0x00, 0x00}, 1, g }
 #define ETHR(a, b, c, g)  { {a, b,    c},    3, g }
 
@@ -365,22 +345,78 @@ gsm_ext_char_to_utf8 (const guint8 gsm, guint8 out_utf8[3])
     return 0;
 }
 
-static gboolean
-utf8_to_gsm_ext_char (const char *utf8, guint32 len, guint8 *out_gsm)
+/* Reverse lookup table from unicode code point to GSM char, covering all the
+ * chars in both the default and extended alphabets except for the euro sign,
+ * which is handled separately. Each entry is either 0 (no GSM representation)
+ * or the GSM char with one of the flags below. */
+#define GSM_ENCODE_TABLE_SIZE 0x400
+#define GSM_ENCODE_DEF        0x100
+#define GSM_ENCODE_EXT        0x200
+#define GSM_EURO_SIGN         0x20AC
+#define GSM_EXT_EURO          0x65
+
+static guint16 gsm_encode_table[GSM_ENCODE_TABLE_SIZE];
+
+static void
+gsm_encode_table_init (void)
 {
-    int i;
+    static gsize initialized = 0;
+
+    if (g_once_init_enter (&initialized)) {
+        guint i;
+
+        for (i = 0; i < GSM_DEF_ALPHABET_SIZE; i++) {
+            gunichar c;
+
+            /* The escape char isn't a valid UTF-8 char by itself */
+            if (i == GSM_ESCAPE_CHAR)
+                continue;
+            c = g_utf8_get_char (gsm_def_utf8_alphabet[i].chars);
+            g_assert (c < GSM_ENCODE_TABLE_SIZE);
+            gsm_encode_table[c] = GSM_ENCODE_DEF | i;
+        }
 
-    if (len > 0 && len < 4) {
         for (i = 0; i < GSM_EXT_ALPHABET_SIZE; i++) {
-            if (gsm_ext_utf8_alphabet[i].len == len) {
-                if (memcmp (&gsm_ext_utf8_alphabet[i].chars[0], utf8, len) == 0) {
-                    *out_gsm = gsm_ext_utf8_alphabet[i].gsm;
-                    return TRUE;
-                }
-            }
+            gunichar c;
+
+            c = g_utf8_get_char (gsm_ext_utf8_alphabet[i].chars);
+            if (c == GSM_EURO_SIGN)
+                continue;
+            g_assert (c < GSM_ENCODE_TABLE_SIZE);
+            gsm_encode_table[c] = GSM_ENCODE_EXT | gsm_ext_utf8_alphabet[i].gsm;
         }
+
+        g_once_init_leave (&initialized, 1);
     }
-    return FALSE;
+}
+
+/* Returns the number of GSM chars needed (1, or 2 if escaped), 0 if none */
+static guint
+unichar_to_gsm (gunichar c, guint8 out_gsm[2])
+{
+    guint16 entry;
+
+    if (c == GSM_EURO_SIGN) {
+        out_gsm[0] = GSM_ESCAPE_CHAR;
+        out_gsm[1] = GSM_EXT_EURO;
+        return 2;
+    }
+
+    if (c >= GSM_ENCODE_TABLE_SIZE)
+        return 0;
+
+    gsm_encode_table_init ();
+    entry = gsm_encode_table[c];
+    if (entry & GSM_ENCODE_DEF) {
+        out_gsm[0] = entry & 0xFF;
+        return 1;
+    }
+    if (entry & GSM_ENCODE_EXT) {
+        out_gsm[0] = GSM_ESCAPE_CHAR;
+        out_gsm[1] = entry & 0xFF;
+        return 2;
+    }
+    return 0;
 }
 
 guint8 *
@@ -423,9 +459,7 @@ guint8 *
 mm_charset_utf8_to_unpacked_gsm (const char *utf8, guint32 *out_len)
 {
     GByteArray *gsm;
-    const char *c = utf8, *next = c;
-    static const guint8 gesc = GSM_ESCAPE_CHAR;
-    int i = 0;
+    const char *c;
 
     g_return_val_if_fail (utf8 != NULL, NULL);
     g_return_val_if_fail (out_len != NULL, NULL);
@@ -441,39 +475,82 @@ mm_charset_utf8_to_unpacked_gsm (const char *utf8, guint32 *out_len)
         return g_byte_array_free (gsm, FALSE);
     }
 
-    while (next && *next) {
-        guint8 gch = 0x3f;  /* 0x3f == '?' */
-
-        next = g_utf8_next_char (c);
+    for (c = utf8; *c; c = g_utf8_next_char (c)) {
+        guint8 gch[2];
+        guint  gch_len;
 
-        /* Try escaped chars first, then default alphabet */
-        if (utf8_to_gsm_ext_char (c, next - c, &gch)) {
-            /* Add the escape char */
-            g_byte_array_append (gsm, &gesc, 1);
-            g_byte_array_append (gsm, &gch, 1);
-        } else if (utf8_to_gsm_def_char (c, next - c, &gch))
-            g_byte_array_append (gsm, &gch, 1);
-
-        c = next;
-        i++;
+        gch_len = unichar_to_gsm (g_utf8_get_char (c), gch);
+        if (gch_len)
+            g_byte_array_append (gsm, gch, gch_len);
     }
 
     *out_len = gsm->len;
     return g_byte_array_free (gsm, FALSE);
 }
 
+/* Upper half (0x80-0xFF) of the PC code pages; the lower half is ASCII */
+static const gunichar pccp437_table[128] = {
+    0x00c7, 0x00fc, 0x00e9, 0x00e2, 0x00e4, 0x00e0, 0x00e5, 0x00e7, 0x00ea,
+    0x00eb, 0x00e8, 0x00ef, 0x00ee, 0x00ec, 0x00c4, 0x00c5, 0x00c9, 0x00e6,
+    0x00c6, 0x00f4, 0x00f6, 0x00f2, 0x00fb, 0x00f9, 0x00ff, 0x00d6, 0x00dc,
+    0x00a2, 0x00a3, 0x00a5, 0x20a7, 0x0192, 0x00e1, 0x00ed, 0x00f3, 0x00fa,
+    0x00f1, 0x00d1, 0x00aa, 0x00ba, 0x00bf, 0x2310, 0x00ac, 0x00bd, 0x00bc,
+    0x00a1, 0x00ab, 0x00bb, 0x2591, 0x2592, 0x2593, 0x2502, 0x2524, 0x2561,
+    0x2562, 0x2556, 0x2555, 0x2563, 0x2551, 0x2557, 0x255d, 0x255c, 0x255b,
+    0x2510, 0x2514, 0x2534, 0x252c, 0x251c, 0x2500, 0x253c, 0x255e, 0x255f,
+    0x255a, 0x2554, 0x2569, 0x2566, 0x2560, 0x2550, 0x256c, 0x2567, 0x2568,
+    0x2564, 0x2565, 0x2559, 0x2558, 0x2552, 0x2553, 0x256b, 0x256a, 0x2518,
+    0x250c, 0x2588, 0x2584, 0x258c, 0x2590, 0x2580, 0x03b1, 0x00df, 0x0393,
+    0x03c0, 0x03a3, 0x03c3, 0x00b5, 0x03c4, 0x03a6, 0x0398, 0x03a9, 0x03b4,
+    0x221e, 0x03c6, 0x03b5, 0x2229, 0x2261, 0x00b1, 0x2265, 0x2264, 0x2320,
+    0x2321, 0x00f7, 0x2248, 0x00b0, 0x2219, 0x00b7, 0x221a, 0x207f, 0x00b2,
+    0x25a0, 0x00a0
+};
+
+static const gunichar pcdn_table[128] = {
+    0x00c7, 0x00fc, 0x00e9, 0x00e2, 0x00e4, 0x00e0, 0x00e5, 0x00e7, 0x00ea,
+    0x00eb, 0x00e8, 0x00ef, 0x00ee, 0x00ec, 0x00c4, 0x00c5, 0x00c9, 0x00e6,
+    0x00c6, 0x00f4, 0x00f6, 0x00f2, 0x00fb, 0x00f9, 0x00ff, 0x00d6, 0x00dc,
+    0x00f8, 0x00a3, 0x00d8, 0x00d7, 0x0192, 0x00e1, 0x00ed, 0x00f3, 0x00fa,
+    0x00f1, 0x00d1, 0x00aa, 0x00ba, 0x00bf, 0x00ae, 0x00ac, 0x00bd, 0x00bc,
+    0x00a1, 0x00ab, 0x00bb, 0x2591, 0x2592, 0x2593, 0x2502, 0x2524, 0x00c1,
+    0x00c2, 0x00c0, 0x00a9, 0x2563, 0x2551, 0x2557, 0x255d, 0x00a2, 0x00a5,
+    0x2510, 0x2514, 0x2534, 0x252c, 0x251c, 0x2500, 0x253c, 0x00e3, 0x00c3,
+    0x255a, 0x2554, 0x2569, 0x2566, 0x2560, 0x2550, 0x256c, 0x00a4, 0x00f0,
+    0x00d0, 0x00ca, 0x00cb, 0x00c8, 0x0131, 0x00cd, 0x00ce, 0x00cf, 0x2518,
+    0x250c, 0x2588, 0x2584, 0x00a6, 0x00cc, 0x2580, 0x00d3, 0x00df, 0x00d4,
+    0x00d2, 0x00f5, 0x00d5, 0x00b5, 0x00fe, 0x00de, 0x00da, 0x00db, 0x00d9,
+    0x00fd, 0x00dd, 0x00af, 0x00b4, 0x00ad, 0x00b1, 0x2017, 0x00be, 0x00b6,
+    0x00a7, 0x00f7, 0x00b8, 0x00b0, 0x00a8, 0x00b7, 0x00b9, 0x00b3, 0x00b2,
+    0x25a0, 0x00a0
+};
+
 static gboolean
-gsm_is_subset (gunichar c, const char *utf8, gsize ulen)
+unichar_to_table_byte (gunichar c, const gunichar table[128], guint8 *out_byte)
 {
-    guint8 gsm;
+    guint i;
 
-    if (utf8_to_gsm_def_char (utf8, ulen, &gsm))
-        return TRUE;
-    if (utf8_to_gsm_ext_char (utf8, ulen, &gsm))
+    if (c <= 0x7F) {
+        *out_byte = c;
         return TRUE;
+    }
+    for (i = 0; i < 128; i++) {
+        if (c == table[i]) {
+            *out_byte = 0x80 + i;
+            return TRUE;
+        }
+    }
     return FALSE;
 }
 
+static gboolean
+gsm_is_subset (gunichar c, const char *utf8, gsize ulen)
+{
+    guint8 gsm[2];
+
+    return (unichar_to_gsm (c, gsm) > 0);
+}
+
 static gboolean
 ira_is_subset (gunichar c, const char *utf8, gsize ulen)
 {
@@ -495,63 +572,17 @@ iso88591_is_subset (gunichar c, const char *utf8, gsize ulen)
 static gboolean
 pccp437_is_subset (gunichar c, const char *utf8, gsize ulen)
 {
-    static const gunichar t[] = {
-        0x00c7, 0x00fc, 0x00e9, 0x00e2, 0x00e4, 0x00e0, 0x00e5, 0x00e7, 0x00ea,
-        0x00eb, 0x00e8, 0x00ef, 0x00ee, 0x00ec, 0x00c4, 0x00c5, 0x00c9, 0x00e6,
-        0x00c6, 0x00f4, 0x00f6, 0x00f2, 0x00fb, 0x00f9, 0x00ff, 0x00d6, 0x00dc,
-        0x00a2, 0x00a3, 0x00a5, 0x20a7, 0x0192, 0x00e1, 0x00ed, 0x00f3, 0x00fa,
-        0x00f1, 0x00d1, 0x00aa, 0x00ba, 0x00bf, 0x2310, 0x00ac, 0x00bd, 0x00bc,
-        0x00a1, 0x00ab, 0x00bb, 0x2591, 0x2592, 0x2593, 0x2502, 0x2524, 0x2561,
-        0x2562, 0x2556, 0x2555, 0x2563, 0x2551, 0x2557, 0x255d, 0x255c, 0x255b,
-        0x2510, 0x2514, 0x2534, 0x252c, 0x251c, 0x2500, 0x253c, 0x255e, 0x255f,
-        0x255a, 0x2554, 0x2569, 0x2566, 0x2560, 0x2550, 0x256c, 0x2567, 0x2568,
-        0x2564, 0x2565, 0x2559, 0x2558, 0x2552, 0x2553, 0x256b, 0x256a, 0x2518,
-        0x250c, 0x2588, 0x2584, 0x258c, 0x2590, 0x2580, 0x03b1, 0x00df, 0x0393,
-        0x03c0, 0x03a3, 0x03c3, 0x00b5, 0x03c4, 0x03a6, 0x0398, 0x03a9, 0x03b4,
-        0x221e, 0x03c6, 0x03b5, 0x2229, 0x2261, 0x00b1, 0x2265, 0x2264, 0x2320,
-        0x2321, 0x00f7, 0x2248, 0x00b0, 0x2219, 0x00b7, 0x221a, 0x207f, 0x00b2,
-        0x25a0, 0x00a0
-    };
-    int i;
+    guint8 b;
 
-    if (c <= 0x7F)
-        return TRUE;
-    for (i = 0; i < sizeof (t) / sizeof (t[0]); i++) {
-        if (c == t[i])
-            return TRUE;
-    }
-    return FALSE;
+    return unichar_to_table_byte (c, pccp437_table, &b);
 }
 
 static gboolean
 pcdn_is_subset (gunichar c, const char *utf8, gsize ulen)
 {
-    static const gunichar t[] = {
-        0x00c7, 0x00fc, 0x00e9, 0x00e2, 0x00e4, 0x00e0, 0x00e5, 0x00e7, 0x00ea,
-        0x00eb, 0x00e8, 0x00ef, 0x00ee, 0x00ec, 0x00c4, 0x00c5, 0x00c9, 0x00e6,
-        0x00c6, 0x00f4, 0x00f6, 0x00f2, 0x00fb, 0x00f9, 0x00ff, 0x00d6, 0x00dc,
-        0x00f8, 0x00a3, 0x00d8, 0x00d7, 0x0192, 0x00e1, 0x00ed, 0x00f3, 0x00fa,
-        0x00f1, 0x00d1, 0x00aa, 0x00ba, 0x00bf, 0x00ae, 0x00ac, 0x00bd, 0x00bc,
-        0x00a1, 0x00ab, 0x00bb, 0x2591, 0x2592, 0x2593, 0x2502, 0x2524, 0x00c1,
-        0x00c2, 0x00c0, 0x00a9, 0x2563, 0x2551, 0x2557, 0x255d, 0x00a2, 0x00a5,
-        0x2510, 0x2514, 0x2534, 0x252c, 0x251c, 0x2500, 0x253c, 0x00e3, 0x00c3,
-        0x255a, 0x2554, 0x2569, 0x2566, 0x2560, 0x2550, 0x256c, 0x00a4, 0x00f0,
-        0x00d0, 0x00ca, 0x00cb, 0x00c8, 0x0131, 0x00cd, 0x00ce, 0x00cf, 0x2518,
-        0x250c, 0x2588, 0x2584, 0x00a6, 0x00cc, 0x2580, 0x00d3, 0x00df, 0x00d4,
-        0x00d2, 0x00f5, 0x00d5, 0x00b5, 0x00fe, 0x00de, 0x00da, 0x00db, 0x00d9,
-        0x00fd, 0x00dd, 0x00af, 0x00b4, 0x00ad, 0x00b1, 0x2017, 0x00be, 0x00b6,
-        0x00a7, 0x00f7, 0x00b8, 0x00b0, 0x00a8, 0x00b7, 0x00b9, 0x00b3, 0x00b2,
-        0x25a0, 0x00a0
-    };
-    int i;
+    guint8 b;
 
-    if (c <= 0x7F)
-        return TRUE;
-    for (i = 0; i < sizeof (t) / sizeof (t[0]); i++) {
-        if (c == t[i])
-            return TRUE;
-    }
-    return FALSE;
+    return unichar_to_table_byte (c, pcdn_table, &b);
 }
 
 typedef struct {
@@ -618,40 +649,94 @@ mm_charset_can_convert_to (const char *utf8,
     return TRUE;
 }
 
+/*
+ * Septet packing works on blocks of 8 septets (56 bits, 7 octets) at a time:
+ * the block is loaded as a little endian 64-bit word, and the septets are
+ * spread to (or gathered from) the 8 octets of another word with three
+ * shift-and-mask steps (28, 14 and 7 bit lanes). As 56 is a multiple of 8,
+ * every block of the same string starts at the same bit offset within its
+ * first octet. Whatever doesn't fill a whole block is done one septet at a
+ * time.
+ */
+
+#define SEPTETS_PER_BLOCK 8
+#define BLOCK_OCTETS      7
+
+static inline guint64
+load_le64 (const guint8 *p)
+{
+    guint64 w;
+
+    memcpy (&w, p, sizeof (w));
+    return GUINT64_FROM_LE (w);
+}
+
+static inline void
+store_le64 (guint8  *p,
+            guint64  w)
+{
+    w = GUINT64_TO_LE (w);
+    memcpy (p, &w, sizeof (w));
+}
+
+static inline guint64
+septets_spread (guint64 x)
+{
+    x &= G_GUINT64_CONSTANT (0x00FFFFFFFFFFFFFF);
+    x = ((x & G_GUINT64_CONSTANT (0x00FFFFFFF0000000)) << 4) | (x & G_GUINT64_CONSTANT (0x000000000FFFFFFF));
+    x = ((x & G_GUINT64_CONSTANT (0x0FFFC0000FFFC000)) << 2) | (x & G_GUINT64_CONSTANT (0x00003FFF00003FFF));
+    x = ((x & G_GUINT64_CONSTANT (0x3F803F803F803F80)) << 1) | (x & G_GUINT64_CONSTANT (0x007F007F007F007F));
+    return x;
+}
+
+static inline guint64
+septets_gather (guint64 x)
+{
+    x &= G_GUINT64_CONSTANT (0x7F7F7F7F7F7F7F7F);
+    x = (x & G_GUINT64_CONSTANT (0x007F007F007F007F)) | ((x & G_GUINT64_CONSTANT (0x7F007F007F007F00)) >> 1);
+    x = (x & G_GUINT64_CONSTANT (0x00003FFF00003FFF)) | ((x & G_GUINT64_CONSTANT (0x3FFF00003FFF0000)) >> 2);
+    x = (x & G_GUINT64_CONSTANT (0x000000000FFFFFFF)) | ((x & G_GUINT64_CONSTANT (0x0FFFFFFF00000000)) >> 4);
+    return x;
+}
+
 guint8 *
 mm_charset_gsm_unpack (const guint8 *gsm,
                        guint32 num_septets,
                        guint8 start_offset,  /* in _bits_ */
                        guint32 *out_unpacked_len)
 {
-    GByteArray *unpacked;
-    int i;
-
-    unpacked = g_byte_array_sized_new (num_septets + 1);
-
-    for (i = 0; i < num_septets; i++) {
-        guint8 bits_here, bits_in_next, octet, offset, c;
+    guint8 *unpacked;
+    const guint8 *block;
+    guint32 gsm_len, i;
+    guint shift;
+
+    unpacked = g_malloc (num_septets + 1);
+
+    /* Octets we're allowed to read from the input */
+    gsm_len = (start_offset + (num_septets * 7) + 7) / 8;
+
+    /* Full blocks, while a whole 64-bit word can be read from the input */
+    block = &gsm[start_offset / 8];
+    shift = start_offset % 8;
+    for (i = 0;
+         i + SEPTETS_PER_BLOCK <= num_septets && (block - gsm) + sizeof (guint64) <= gsm_len;
+         i += SEPTETS_PER_BLOCK, block += BLOCK_OCTETS)
+        store_le64 (&unpacked[i], septets_spread (load_le64 (block) >> shift));
+
+    /* Remaining septets */
+    for (; i < num_septets; i++) {
         guint32 start_bit;
+        guint16 bits;
 
-        start_bit = start_offset + (i * 7); /* Overall bit offset of char in buffer */
-        offset = start_bit % 8;  /* Offset to start of char in this byte */
-        bits_here = offset ? (8 - offset) : 7;
-        bits_in_next = 7 - bits_here;
-
-        /* Grab bits in the current byte */
-        octet = gsm[start_bit / 8];
-        c = (octet >> offset) & (0xFF >> (8 - bits_here));
-
-        /* Grab any bits that spilled over to next byte */
-        if (bits_in_next) {
-            octet = gsm[(start_bit / 8) + 1];
-            c |= (octet & (0xFF >> (8 - bits_in_next))) << bits_here;
-        }
-        g_byte_array_append (unpacked, &c, 1);
+        start_bit = start_offset + (i * 7);
+        bits = gsm[start_bit / 8];
+        if ((start_bit % 8) > 1)
+            bits |= gsm[(start_bit / 8) + 1] << 8;
+        unpacked[i] = (bits >> (start_bit % 8)) & 0x7F;
     }
 
-    *out_unpacked_len = unpacked->len;
-    return g_byte_array_free (unpacked, FALSE);
+    *out_unpacked_len = num_septets;
+    return unpacked;
 }
 
 guint8 *
@@ -661,28 +746,35 @@ mm_charset_gsm_pack (const guint8 *src,
                      guint32 *out_packed_len)
 {
     guint8 *packed;
-    guint octet = 0, lshift, plen;
-    int i = 0;
+    guint8 *block;
+    guint plen;
+    guint32 i;
 
     g_return_val_if_fail (start_offset < 8, NULL);
 
-    plen = (src_len * 7) + start_offset; /* total length in bits */
-    if (plen % 8)
-        plen += 8;
-    plen /= 8;  /* now in bytes */
-
+    plen = ((src_len * 7) + start_offset + 7) / 8; /* total length in bytes */
     packed = g_malloc0 (plen);
 
-    for (i = 0, lshift = start_offset; i < src_len; i++) {
-        packed[octet] |= (src[i] & 0x7F) << lshift;
-        if (lshift > 1) {
-            /* Grab the lost bits and add to next octet */
-            g_assert (octet + 1 < plen);
-            packed[octet + 1] = (src[i] & 0x7F) >> (8 - lshift);
+    /* Full blocks, while a whole 64-bit word can be written to the output.
+     * The first octet of each block may already hold the last bits of the
+     * previous one, so merge instead of overwriting. */
+    for (i = 0, block = packed;
+         i + SEPTETS_PER_BLOCK <= src_len && (block - packed) + sizeof (guint64) <= plen;
+         i += SEPTETS_PER_BLOCK, block += BLOCK_OCTETS)
+        store_le64 (block, load_le64 (block) | (septets_gather (load_le64 (&src[i])) << start_offset));
+
+    /* Remaining septets */
+    for (; i < src_len; i++) {
+        guint32 start_bit;
+        guint16 bits;
+
+        start_bit = start_offset + (i * 7);
+        bits = (src[i] & 0x7F) << (start_bit % 8);
+        packed[start_bit / 8] |= bits & 0xFF;
+        if (bits >> 8) {
+            g_assert ((start_bit / 8) + 1 < plen);
+            packed[(start_bit / 8) + 1] |= bits >> 8;
         }
-        if (lshift)
-            octet++;
-        lshift = lshift ? lshift - 1 : 7;
     }
 
     if (out_packed_len)
@@ -690,6 +782,345 @@ mm_charset_gsm_pack (const guint8 *src,
     return packed;
 }
 
+/*****************************************************************************/
+/* Native codecs
+ *
+ * Table-driven conversions between UTF-8 and the charsets supported by the
+ * modems, so that we don't need to open a new iconv descriptor (g_convert())
+ * for every single string we read or write.
+ */
+
+static gboolean
+charset_has_codec (MMModemCharset charset)
+{
+    switch (charset) {
+    case MM_MODEM_CHARSET_GSM:
+    case MM_MODEM_CHARSET_IRA:
+    case MM_MODEM_CHARSET_8859_1:
+    case MM_MODEM_CHARSET_UCS2:
+    case MM_MODEM_CHARSET_PCCP437:
+    case MM_MODEM_CHARSET_PCDN:
+        return TRUE;
+    case MM_MODEM_CHARSET_UNKNOWN:
+    case MM_MODEM_CHARSET_UTF8:
+    case MM_MODEM_CHARSET_HEX:
+    default:
+        return FALSE;
+    }
+}
+
+/* Reads the i-th byte of the input, which may be given in hex; -1 if invalid */
+static inline gint
+input_byte (const guint8 *src,
+            gsize         i,
+            gboolean      src_hex)
+{
+    gint hi;
+    gint lo;
+
+    if (!src_hex)
+        return src[i];
+
+    hi = g_ascii_xdigit_value (src[2 * i]);
+    lo = g_ascii_xdigit_value (src[2 * i + 1]);
+    if (hi < 0 || lo < 0)
+        return -1;
+    return (hi << 4) | lo;
+}
+
+#define NON_ASCII_MASK G_GUINT64_CONSTANT (0x8080808080808080)
+
+/* Length of the leading run of ASCII bytes, checked one word at a time */
+static gsize
+ascii_run_length (const guint8 *src,
+                  gsize         len)
+{
+    gsize i;
+
+    for (i = 0; i + 8 <= len; i += 8) {
+        guint64 word;
+
+        memcpy (&word, &src[i], 8);
+        if (word & NON_ASCII_MASK)
+            break;
+    }
+    while (i < len && src[i] < 0x80)
+        i++;
+    return i;
+}
+
+static gboolean
+ucs2_decode (const guint8 *src,
+             gsize         src_len,
+             gboolean      src_hex,
+             GString      *out)
+{
+    gsize i;
+
+    if (src_len % 2)
+        return FALSE;
+
+    for (i = 0; i < src_len; i += 2) {
+        gint     hi;
+        gint     lo;
+        gunichar c;
+
+        hi = input_byte (src, i, src_hex);
+        lo = input_byte (src, i + 1, src_hex);
+        if (hi < 0 || lo < 0)
+            return FALSE;
+        c = (hi << 8) | lo;
+
+        /* Some modems really give UTF-16, so accept valid surrogate pairs */
+        if (c >= 0xD800 && c <= 0xDBFF) {
+            gunichar low;
+
+            if (i + 3 >= src_len)
+                return FALSE;
+            hi = input_byte (src, i + 2, src_hex);
+            lo = input_byte (src, i + 3, src_hex);
+            if (hi < 0 || lo < 0)
+                return FALSE;
+            low = (hi << 8) | lo;
+            if (low < 0xDC00 || low > 0xDFFF)
+                return FALSE;
+            c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+            i += 2;
+        } else if (c >= 0xDC00 && c <= 0xDFFF)
+            return FALSE;
+
+        g_string_append_unichar (out, c);
+    }
+
+    return TRUE;
+}
+
+static gboolean
+gsm_decode (const guint8 *src,
+            gsize         src_len,
+            gboolean      src_hex,
+            GString      *out)
+{
+    gsize i;
+
+    for (i = 0; i < src_len; i++) {
+        guint8 uchars[4];
+        guint8 ulen = 0;
+        gint   b;
+
+        b = input_byte (src, i, src_hex);
+        if (b < 0)
+            return FALSE;
+
+        if (b == GSM_ESCAPE_CHAR) {
+            /* Extended alphabet, decode next char */
+            if (i + 1 < src_len) {
+                gint next;
+
+                next = input_byte (src, i + 1, src_hex);
+                if (next < 0)
+                    return FALSE;
+                ulen = gsm_ext_char_to_utf8 (next, uchars);
+                if (ulen)
+                    i++;
+            }
+            /* A lone escape char is shown as a non-breaking space */
+            if (!ulen) {
+                g_string_append_unichar (out, 0x00A0);
+                continue;
+            }
+        } else if (b < GSM_DEF_ALPHABET_SIZE)
+            ulen = gsm_def_char_to_utf8 (b, uchars);
+
+        if (ulen)
+            g_string_append_len (out, (const gchar *) uchars, ulen);
+        else
+            g_string_append_c (out, '?');
+    }
+
+    return TRUE;
+}
+
+/* Decodes src_len bytes from src, which may be given in hex (and therefore
+ * be twice as long), appending the UTF-8 result to out */
+static gboolean
+charset_decode (MMModemCharset  charset,
+                const guint8   *src,
+                gsize           src_len,
+                gboolean        src_hex,
+                GString        *out)
+{
+    const gunichar *table = NULL;
+    gsize           i = 0;
+
+    switch (charset) {
+    case MM_MODEM_CHARSET_UCS2:
+        return ucs2_decode (src, src_len, src_hex, out);
+    case MM_MODEM_CHARSET_GSM:
+        return gsm_decode (src, src_len, src_hex, out);
+    case MM_MODEM_CHARSET_PCCP437:
+        table = pccp437_table;
+        break;
+    case MM_MODEM_CHARSET_PCDN:
+        table = pcdn_table;
+        break;
+    case MM_MODEM_CHARSET_IRA:
+    case MM_MODEM_CHARSET_8859_1:
+        break;
+    default:
+        g_assert_not_reached ();
+    }
+
+    /* Single byte charsets, all of them ASCII compatible */
+    while (i < src_len) {
+        gint b;
+
+        if (!src_hex) {
+            gsize run;
+
+            run = ascii_run_length (&src[i], src_len - i);
+            if (run) {
+                g_string_append_len (out, (const gchar *) &src[i], run);
+                i += run;
+                continue;
+            }
+        }
+
+        b = input_byte (src, i++, src_hex);
+        if (b < 0)
+            return FALSE;
+        if (b < 0x80)
+            g_string_append_c (out, b);
+        else if (charset == MM_MODEM_CHARSET_IRA)
+            return FALSE;
+        else
+            g_string_append_unichar (out, table ? table[b - 0x80] : (gunichar) b);
+    }
+
+    return TRUE;
+}
+
+/* Encodes the UTF-8 string into the given charset, appending the result to out.
+ * Fails if any char cannot be represented, except for GSM, where unknown chars
+ * are replaced with '?' as there is no other way to transliterate them. */
+static gboolean
+charset_encode (MMModemCharset  charset,
+                const gchar    *utf8,
+                GByteArray     *out)
+{
+    const gchar *p;
+    const gchar *end;
+    gboolean     ascii_compatible;
+
+    if (!g_utf8_validate (utf8, -1, &end))
+        return FALSE;
+
+    ascii_compatible = (charset != MM_MODEM_CHARSET_GSM && charset != MM_MODEM_CHARSET_UCS2);
+
+    p = utf8;
+    while (p < end) {
+        gunichar c;
+        guint8   bytes[4];
+        guint    n_bytes = 1;
+
+        if (ascii_compatible) {
+            gsize run;
+
+            run = ascii_run_length ((const guint8 *) p, end - p);
+            if (run) {
+                g_byte_array_append (out, (const guint8 *) p, run);
+                p += run;
+                continue;
+            }
+        }
+
+        c = g_utf8_get_char (p);
+        p = g_utf8_next_char (p);
+
+        switch (charset) {
+        case MM_MODEM_CHARSET_GSM:
+            n_bytes = unichar_to_gsm (c, bytes);
+            if (!n_bytes) {
+                bytes[0] = '?';
+                n_bytes = 1;
+            }
+            break;
+        case MM_MODEM_CHARSET_IRA:
+            if (c > 0x7F)
+                return FALSE;
+            bytes[0] = c;
+            break;
+        case MM_MODEM_CHARSET_8859_1:
+            if (c > 0xFF)
+                return FALSE;
+            bytes[0] = c;
+            break;
+        case MM_MODEM_CHARSET_PCCP437:
+            if (!unichar_to_table_byte (c, pccp437_table, &bytes[0]))
+                return FALSE;
+            break;
+        case MM_MODEM_CHARSET_PCDN:
+            if (!unichar_to_table_byte (c, pcdn_table, &bytes[0]))
+                return FALSE;
+            break;
+        case MM_MODEM_CHARSET_UCS2:
+            if (c <= 0xFFFF) {
+                bytes[0] = c >> 8;
+                bytes[1] = c & 0xFF;
+                n_bytes = 2;
+            } else {
+                guint16 high;
+                guint16 low;
+
+                /* Surrogate pair */
+                c -= 0x10000;
+                high = 0xD800 + (c >> 10);
+                low  = 0xDC00 + (c & 0x3FF);
+                bytes[0] = high >> 8;
+                bytes[1] = high & 0xFF;
+                bytes[2] = low >> 8;
+                bytes[3] = low & 0xFF;
+                n_bytes = 4;
+            }
+            break;
+        default:
+            g_assert_not_reached ();
+        }
+
+        g_byte_array_append (out, bytes, n_bytes);
+    }
+
+    return TRUE;
+}
+
+static gchar *
+charset_encode_to_hex (MMModemCharset  charset,
+                       const gchar    *utf8)
+{
+    static const gchar  hexdigits[] = "0123456789ABCDEF";
+    GByteArray         *encoded;
+    gchar              *hex;
+    guint               i;
+
+    encoded = g_byte_array_sized_new (strlen (utf8) * 2);
+    if (!charset_encode (charset, utf8, encoded)) {
+        g_byte_array_unref (encoded);
+        return NULL;
+    }
+
+    hex = g_malloc (encoded->len * 2 + 1);
+    for (i = 0; i < encoded->len; i++) {
+        hex[2 * i]     = hexdigits[encoded->data[i] >> 4];
+        hex[2 * i + 1] = hexdigits[encoded->data[i] & 0x0F];
+    }
+    hex[2 * encoded->len] = '\0';
+
+    g_byte_array_unref (encoded);
+    return hex;
+}
+
+/*****************************************************************************/
+
 /* We do all our best to get the given string, which is possibly given in the
  * specified charset, to UTF8. It may happen that the given string is really
  * the hex representation of the charset-encoded string, so we need to cope with
@@ -717,17 +1148,15 @@ mm_charset_take_and_convert_to_utf8 (gchar *str, MMModemCharset charset)
     case MM_MODEM_CHARSET_8859_1:
     case MM_MODEM_CHARSET_PCCP437:
     case MM_MODEM_CHARSET_PCDN: {
-        const gchar *iconv_from;
-        GError *error = NULL;
+        GString *converted;
+        gsize    len;
 
-        iconv_from = charset_iconv_from (charset);
-        utf8 = g_convert (str, strlen (str),
-                          "UTF-8//TRANSLIT", iconv_from,
-                          NULL, NULL, &error);
-        if (!utf8 || error) {
-            g_clear_error (&error);
-            utf8 = NULL;
-        }
+        len = strlen (str);
+        converted = g_string_sized_new (len + 1);
+        if (charset_decode (charset, (const guint8 *) str, len, FALSE, converted))
+            utf8 = g_string_free (converted, FALSE);
+        else
+            g_string_free (converted, TRUE);
 
         g_free (str);
         break;
@@ -840,44 +1269,32 @@ mm_utf8_take_and_convert_to_charset (gchar *str,
     case MM_MODEM_CHARSET_8859_1:
     case MM_MODEM_CHARSET_PCCP437:
     case MM_MODEM_CHARSET_PCDN: {
-        const gchar *iconv_to;
-        GError *error = NULL;
-
-        iconv_to = charset_iconv_from (charset);
-        encoded = g_convert (str, strlen (str),
-                             iconv_to, "UTF-8",
-                             NULL, NULL, &error);
-        if (!encoded || error) {
-            g_clear_error (&error);
-            encoded = NULL;
+        GByteArray *converted;
+
+        converted = g_byte_array_sized_new (strlen (str) + 1);
+        if (!charset_encode (charset, str, converted))
+            g_byte_array_unref (converted);
+        else if (memchr (converted->data, 0x00, converted->len)) {
+            /* '@' is 0x00 in the GSM alphabet, so it cannot be given in a
+             * NUL-terminated string; use mm_modem_charset_byte_array_append()
+             * if it's really needed */
+            mm_dbg ("cannot convert '%s' to %s character set: it would be truncated",
+                    str, mm_modem_charset_to_string (charset));
+            g_byte_array_unref (converted);
+        } else {
+            g_byte_array_append (converted, (const guint8 *) "\0", 1);
+            encoded = (gchar *) g_byte_array_free (converted, FALSE);
         }
 
         g_free (str);
         break;
     }
 
-    case MM_MODEM_CHARSET_UCS2: {
-        const gchar *iconv_to;
-        gsize encoded_len = 0;
-        GError *error = NULL;
-        gchar *hex;
-
-        iconv_to = charset_iconv_from (charset);
-        encoded = g_convert (str, strlen (str),
-                             iconv_to, "UTF-8",
-                             NULL, &encoded_len, &error);
-        if (!encoded || error) {
-            g_clear_error (&error);
-            encoded = NULL;
-        }
-
+    case MM_MODEM_CHARSET_UCS2:
         /* Get hex representation of the string */
-        hex = mm_utils_bin2hexstr ((guint8 *)encoded, encoded_len);
-        g_free (encoded);
-        encoded = hex;
+        encoded = charset_encode_to_hex (charset, str);
         g_free (str);
         break;
-    }
 
     /* If the given charset is ASCII or UTF8, we really expect the final string
      * already here. */
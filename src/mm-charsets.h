@@ -71,6 +71,11 @@ guint8 *mm_charset_gsm_pack (const guint8 *src,
                              guint8 start_offset,  /* in bits */
                              guint32 *out_packed_len);
 
+/* Note that a GSM encoded string cannot hold '@' (0x00 in the GSM default
+ * alphabet) when given as a NUL-terminated string: the conversion to GSM fails
+ * if the result would contain it, and the conversion from GSM can only see
+ * the string up to it. Use mm_modem_charset_byte_array_append() and
+ * mm_charset_gsm_unpacked_to_utf8() when the length must be kept. */
 gchar *mm_charset_take_and_convert_to_utf8 (gchar *str, MMModemCharset charset);
 
 gchar *mm_utf8_take_and_convert_to_charset (gchar *str,
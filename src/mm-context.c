@@ -41,6 +41,8 @@ static gboolean      debug;
 static MMFilterRule  filter_policy = MM_FILTER_POLICY_DEFAULT;
 static gboolean      no_auto_scan = NO_AUTO_SCAN_DEFAULT;
 static const gchar  *initial_kernel_events;
+static const gchar  *plugin_manifest;
+static gint          bearer_stats_interval;
 
 static gboolean
 filter_policy_option_arg (const gchar  *option_name,
@@ -90,6 +92,16 @@ static const GOptionEntry entries[] = {
         "Path to initial kernel events file",
         "[PATH]"
     },
+    {
+        "generate-plugin-manifest", 0, 0, G_OPTION_ARG_FILENAME, &plugin_manifest,
+        "Load all plugins, write their filters to the given manifest file and exit",
+        "[PATH]"
+    },
+    {
+        "bearer-stats-interval", 0, 0, G_OPTION_ARG_INT, &bearer_stats_interval,
+        "Read bearer statistics from the network interface counters every given number of seconds",
+        "[SECONDS]"
+    },
     {
         "debug", 0, 0, G_OPTION_ARG_NONE, &debug,
         "Run with extended debugging capabilities",
@@ -120,12 +132,24 @@ mm_context_get_initial_kernel_events (void)
     return initial_kernel_events;
 }
 
+const gchar *
+mm_context_get_plugin_manifest (void)
+{
+    return plugin_manifest;
+}
+
 gboolean
 mm_context_get_no_auto_scan (void)
 {
     return no_auto_scan;
 }
 
+guint
+mm_context_get_bearer_stats_interval (void)
+{
+    return (guint) bearer_stats_interval;
+}
+
 MMFilterRule
 mm_context_get_filter_policy (void)
 {
@@ -340,6 +364,11 @@ mm_context_init (gint argc,
             log_show_ts = TRUE;
     }
 
+    if (bearer_stats_interval < 0) {
+        g_warning ("error: --bearer-stats-interval must not be negative");
+        exit (1);
+    }
+
     /* Initial kernel events processing may only be used if autoscan is disabled */
 #if defined WITH_UDEV
     if (!no_auto_scan && initial_kernel_events) {
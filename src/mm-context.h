@@ -31,6 +31,9 @@ void mm_context_init (gint    argc,
 gboolean     mm_context_get_debug                 (void);
 const gchar *mm_context_get_initial_kernel_events (void);
 gboolean     mm_context_get_no_auto_scan          (void);
+const gchar *mm_context_get_plugin_manifest       (void);
+/* 0 if bearer stats should be loaded from the modem */
+guint        mm_context_get_bearer_stats_interval (void);
 
 /* Filter support */
 MMFilterRule mm_context_get_filter_policy (void);
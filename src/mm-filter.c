@@ -30,10 +30,160 @@ enum {
     LAST_PROP
 };
 
+/* Number of bits in MM_FILTER_RULE_ALL */
+#define N_FILTER_RULES 13
+G_STATIC_ASSERT (MM_FILTER_RULE_ALL == ((1 << N_FILTER_RULES) - 1));
+
 struct _MMFilterPrivate {
     MMFilterRule enabled_rules;
+    /* physdev uid -> PhysdevVerdict */
+    GHashTable *physdev_verdicts;
+    /* "subsystem/name" of each port -> physdev uid */
+    GHashTable *port_physdevs;
+    /* Number of times each rule decided the result */
+    guint rule_hits[N_FILTER_RULES];
 };
 
+#define RULE_HIT(self, rule) self->priv->rule_hits[g_bit_nth_lsf (rule, -1)]++
+
+/*****************************************************************************/
+/* Per-device verdict
+ *
+ * Most of the rule checks depend only on the physical device (i.e. on the
+ * global udev properties and on the physdev subsystem), so they're evaluated
+ * once for the first port and the result is reused for all its siblings. The
+ * verdict is forgotten as soon as any of the ports is removed.
+ */
+
+typedef enum {
+    PHYSDEV_VERDICT_NONE                  = 0,
+    PHYSDEV_VERDICT_EVALUATED             = 1 << 0,
+    PHYSDEV_VERDICT_PROCESS               = 1 << 1,
+    PHYSDEV_VERDICT_IGNORE                = 1 << 2,
+    PHYSDEV_VERDICT_MANUAL_SCAN_ONLY      = 1 << 3,
+    PHYSDEV_VERDICT_PLATFORM              = 1 << 4,
+    PHYSDEV_VERDICT_PLATFORM_DRIVER_PROBE = 1 << 5,
+} PhysdevVerdict;
+
+static PhysdevVerdict
+physdev_verdict_evaluate (MMFilter       *self,
+                          MMKernelDevice *port)
+{
+    PhysdevVerdict  verdict = PHYSDEV_VERDICT_EVALUATED;
+    const gchar    *physdev_subsystem;
+
+    if ((self->priv->enabled_rules & MM_FILTER_RULE_EXPLICIT_WHITELIST) &&
+        mm_kernel_device_get_global_property_as_boolean (port, "ID_MM_DEVICE_PROCESS"))
+        verdict |= PHYSDEV_VERDICT_PROCESS;
+
+    /* The remaining checks are all tty-specific */
+    if (!(self->priv->enabled_rules & MM_FILTER_RULE_TTY))
+        return verdict;
+
+    if ((self->priv->enabled_rules & MM_FILTER_RULE_TTY_BLACKLIST) &&
+        mm_kernel_device_get_global_property_as_boolean (port, "ID_MM_DEVICE_IGNORE"))
+        verdict |= PHYSDEV_VERDICT_IGNORE;
+
+    if ((self->priv->enabled_rules & MM_FILTER_RULE_TTY_MANUAL_SCAN_ONLY) &&
+        mm_kernel_device_get_global_property_as_boolean (port, "ID_MM_DEVICE_MANUAL_SCAN_ONLY"))
+        verdict |= PHYSDEV_VERDICT_MANUAL_SCAN_ONLY;
+
+    if (self->priv->enabled_rules & MM_FILTER_RULE_TTY_PLATFORM_DRIVER) {
+        physdev_subsystem = mm_kernel_device_get_physdev_subsystem (port);
+        if (!g_strcmp0 (physdev_subsystem, "platform") ||
+            !g_strcmp0 (physdev_subsystem, "pci") ||
+            !g_strcmp0 (physdev_subsystem, "pnp") ||
+            !g_strcmp0 (physdev_subsystem, "sdio")) {
+            verdict |= PHYSDEV_VERDICT_PLATFORM;
+            if (mm_kernel_device_get_global_property_as_boolean (port, "ID_MM_PLATFORM_DRIVER_PROBE"))
+                verdict |= PHYSDEV_VERDICT_PLATFORM_DRIVER_PROBE;
+        }
+    }
+
+    return verdict;
+}
+
+static PhysdevVerdict
+physdev_verdict_get (MMFilter       *self,
+                     MMKernelDevice *port)
+{
+    PhysdevVerdict  verdict;
+    const gchar    *physdev_uid;
+
+    /* Virtual devices have no physdev to share the verdict with */
+    if (!mm_kernel_device_get_physdev_sysfs_path (port))
+        return physdev_verdict_evaluate (self, port);
+
+    physdev_uid = mm_kernel_device_get_physdev_uid (port);
+    verdict = GPOINTER_TO_UINT (g_hash_table_lookup (self->priv->physdev_verdicts, physdev_uid));
+    if (!verdict) {
+        verdict = physdev_verdict_evaluate (self, port);
+        g_hash_table_insert (self->priv->physdev_verdicts, g_strdup (physdev_uid), GUINT_TO_POINTER (verdict));
+    }
+
+    /* Remove events may not be able to provide the physdev uid, so keep track
+     * of the port name as well */
+    g_hash_table_insert (self->priv->port_physdevs,
+                         g_strdup_printf ("%s/%s", mm_kernel_device_get_subsystem (port), mm_kernel_device_get_name (port)),
+                         g_strdup (physdev_uid));
+
+    return verdict;
+}
+
+void
+mm_filter_port_removed (MMFilter       *self,
+                        MMKernelDevice *port)
+{
+    gchar       *key;
+    const gchar *physdev_uid;
+
+    key = g_strdup_printf ("%s/%s", mm_kernel_device_get_subsystem (port), mm_kernel_device_get_name (port));
+    physdev_uid = g_hash_table_lookup (self->priv->port_physdevs, key);
+    if (physdev_uid) {
+        g_hash_table_remove (self->priv->physdev_verdicts, physdev_uid);
+        g_hash_table_remove (self->priv->port_physdevs, key);
+    }
+    g_free (key);
+}
+
+guint
+mm_filter_get_rule_hits (MMFilter     *self,
+                         MMFilterRule  rule)
+{
+    g_return_val_if_fail (MM_IS_FILTER (self), 0);
+    g_return_val_if_fail (rule != MM_FILTER_RULE_NONE && (rule & MM_FILTER_RULE_ALL) == rule, 0);
+    /* Exactly one rule expected */
+    g_return_val_if_fail ((rule & (rule - 1)) == 0, 0);
+
+    return self->priv->rule_hits[g_bit_nth_lsf (rule, -1)];
+}
+
+void
+mm_filter_report_rule_hits (MMFilter *self)
+{
+    GFlagsClass *flags_class;
+    guint        i;
+
+    g_return_if_fail (MM_IS_FILTER (self));
+
+    flags_class = g_type_class_ref (MM_TYPE_FILTER_RULE);
+
+    mm_dbg ("[filter] rule hits:");
+    for (i = 0; i < N_FILTER_RULES; i++) {
+        GFlagsValue *flags_value;
+
+        if (!self->priv->rule_hits[i])
+            continue;
+
+        flags_value = g_flags_get_first_value (flags_class, (1 << i));
+        g_assert (flags_value);
+        mm_dbg ("[filter]   %s: %u", flags_value->value_nick, self->priv->rule_hits[i]);
+    }
+    mm_dbg ("[filter]   cached device verdicts: %u", g_hash_table_size (self->priv->physdev_verdicts));
+
+    g_type_class_unref (flags_class);
+}
+
 /*****************************************************************************/
 
 gboolean
@@ -41,19 +191,22 @@ mm_filter_port (MMFilter        *self,
                 MMKernelDevice  *port,
                 gboolean         manual_scan)
 {
-    const gchar *subsystem;
-    const gchar *name;
+    const gchar    *subsystem;
+    const gchar    *name;
+    PhysdevVerdict  verdict;
 
     subsystem = mm_kernel_device_get_subsystem (port);
     name      = mm_kernel_device_get_name      (port);
+    verdict   = physdev_verdict_get (self, port);
 
     /* If the device is explicitly whitelisted, we process every port. Also
      * allow specifying this flag per-port instead of for the full device, e.g.
      * for platform tty ports where there's only one port anyway. */
     if ((self->priv->enabled_rules & MM_FILTER_RULE_EXPLICIT_WHITELIST) &&
-        (mm_kernel_device_get_global_property_as_boolean (port, "ID_MM_DEVICE_PROCESS") ||
+        ((verdict & PHYSDEV_VERDICT_PROCESS) ||
          mm_kernel_device_get_property_as_boolean (port, "ID_MM_DEVICE_PROCESS"))) {
         mm_dbg ("[filter] (%s/%s) port allowed: device is whitelisted", subsystem, name);
+        RULE_HIT (self, MM_FILTER_RULE_EXPLICIT_WHITELIST);
         return TRUE;
     }
 
@@ -61,6 +214,7 @@ mm_filter_port (MMFilter        *self,
     if ((self->priv->enabled_rules & MM_FILTER_RULE_VIRTUAL) &&
         (!mm_kernel_device_get_physdev_sysfs_path (port))) {
         mm_dbg ("[filter] (%s/%s) port filtered: virtual device", subsystem, name);
+        RULE_HIT (self, MM_FILTER_RULE_VIRTUAL);
         return FALSE;
     }
 
@@ -68,6 +222,7 @@ mm_filter_port (MMFilter        *self,
     if ((self->priv->enabled_rules & MM_FILTER_RULE_NET) &&
         (g_strcmp0 (subsystem, "net") == 0)) {
         mm_dbg ("[filter] (%s/%s) port allowed: net device", subsystem, name);
+        RULE_HIT (self, MM_FILTER_RULE_NET);
         return TRUE;
     }
 
@@ -76,42 +231,41 @@ mm_filter_port (MMFilter        *self,
         (g_strcmp0 (subsystem, "usb") == 0 || g_strcmp0 (subsystem, "usbmisc") == 0) &&
         (name && g_str_has_prefix (name, "cdc-wdm"))) {
         mm_dbg ("[filter] (%s/%s) port allowed: cdc-wdm device", subsystem, name);
+        RULE_HIT (self, MM_FILTER_RULE_CDC_WDM);
         return TRUE;
     }
 
     /* If this is a tty device, we may allow it */
     if ((self->priv->enabled_rules & MM_FILTER_RULE_TTY) &&
         (g_strcmp0 (subsystem, "tty") == 0)) {
-        const gchar *physdev_subsystem;
         const gchar *driver;
 
         /* Blacklist rules first */
 
         /* Ignore blacklisted tty devices. */
         if ((self->priv->enabled_rules & MM_FILTER_RULE_TTY_BLACKLIST) &&
-            (mm_kernel_device_get_global_property_as_boolean (port, "ID_MM_DEVICE_IGNORE"))) {
+            (verdict & PHYSDEV_VERDICT_IGNORE)) {
             mm_dbg ("[filter] (%s/%s): port filtered: device is blacklisted", subsystem, name);
+            RULE_HIT (self, MM_FILTER_RULE_TTY_BLACKLIST);
             return FALSE;
         }
 
         /* Is the device in the manual-only greylist? If so, return if this is an
          * automatic scan. */
         if ((self->priv->enabled_rules & MM_FILTER_RULE_TTY_MANUAL_SCAN_ONLY) &&
-            (!manual_scan && mm_kernel_device_get_global_property_as_boolean (port, "ID_MM_DEVICE_MANUAL_SCAN_ONLY"))) {
+            (!manual_scan && (verdict & PHYSDEV_VERDICT_MANUAL_SCAN_ONLY))) {
             mm_dbg ("[filter] (%s/%s): port filtered: device probed only in manual scan", subsystem, name);
+            RULE_HIT (self, MM_FILTER_RULE_TTY_MANUAL_SCAN_ONLY);
             return FALSE;
         }
 
         /* Mixed blacklist/whitelist rules */
 
         /* If the physdev is a 'platform' or 'pnp' device that's not whitelisted, ignore it */
-        physdev_subsystem = mm_kernel_device_get_physdev_subsystem (port);
         if ((self->priv->enabled_rules & MM_FILTER_RULE_TTY_PLATFORM_DRIVER) &&
-            (!g_strcmp0 (physdev_subsystem, "platform") ||
-             !g_strcmp0 (physdev_subsystem, "pci") ||
-             !g_strcmp0 (physdev_subsystem, "pnp") ||
-             !g_strcmp0 (physdev_subsystem, "sdio"))) {
-            if (!mm_kernel_device_get_global_property_as_boolean (port, "ID_MM_PLATFORM_DRIVER_PROBE")) {
+            (verdict & PHYSDEV_VERDICT_PLATFORM)) {
+            RULE_HIT (self, MM_FILTER_RULE_TTY_PLATFORM_DRIVER);
+            if (!(verdict & PHYSDEV_VERDICT_PLATFORM_DRIVER_PROBE)) {
                 mm_dbg ("[filter] (%s/%s): port filtered: port's parent platform driver is not whitelisted", subsystem, name);
                 return FALSE;
             }
@@ -122,6 +276,7 @@ mm_filter_port (MMFilter        *self,
         /* Default allowed? */
         if (self->priv->enabled_rules & MM_FILTER_RULE_TTY_DEFAULT_ALLOWED) {
             mm_dbg ("[filter] (%s/%s) port allowed", subsystem, name);
+            RULE_HIT (self, MM_FILTER_RULE_TTY_DEFAULT_ALLOWED);
             return TRUE;
         }
 
@@ -136,6 +291,7 @@ mm_filter_port (MMFilter        *self,
              !g_strcmp0 (driver, "nozomi") ||
              !g_strcmp0 (driver, "sierra"))) {
             mm_dbg ("[filter] (%s/%s): port allowed: modem-specific kernel driver detected", subsystem, name);
+            RULE_HIT (self, MM_FILTER_RULE_TTY_DRIVER);
             return TRUE;
         }
 
@@ -162,12 +318,14 @@ mm_filter_port (MMFilter        *self,
             (mm_kernel_device_get_interface_subclass (port) == 2) &&
             (mm_kernel_device_get_interface_protocol (port) >= 1) && (mm_kernel_device_get_interface_protocol (port) <= 6)) {
             mm_dbg ("[filter] (%s/%s): port allowed: cdc-acm interface reported AT-capable", subsystem, name);
+            RULE_HIT (self, MM_FILTER_RULE_TTY_ACM_INTERFACE);
             return TRUE;
         }
 
         /* Default forbidden? flag the port as maybe-forbidden, and go on */
         if (self->priv->enabled_rules & MM_FILTER_RULE_TTY_DEFAULT_FORBIDDEN) {
             g_object_set_data (G_OBJECT (port), FILTER_PORT_MAYBE_FORBIDDEN, GUINT_TO_POINTER (TRUE));
+            RULE_HIT (self, MM_FILTER_RULE_TTY_DEFAULT_FORBIDDEN);
             return TRUE;
         }
 
@@ -204,6 +362,7 @@ mm_filter_device_and_port (MMFilter       *self,
             if (!g_strcmp0 (mm_port_probe_get_port_subsys (MM_PORT_PROBE (l->data)), "net")) {
                 mm_dbg ("[filter] (%s/%s): port allowed: device also exports a net interface (%s)",
                         subsystem, name, mm_port_probe_get_port_name (MM_PORT_PROBE (l->data)));
+                RULE_HIT (self, MM_FILTER_RULE_TTY_WITH_NET);
                 return TRUE;
             }
         }
@@ -347,6 +506,19 @@ static void
 mm_filter_init (MMFilter *self)
 {
     self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, MM_TYPE_FILTER, MMFilterPrivate);
+    self->priv->physdev_verdicts = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    self->priv->port_physdevs    = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+}
+
+static void
+finalize (GObject *object)
+{
+    MMFilter *self = MM_FILTER (object);
+
+    g_hash_table_unref (self->priv->port_physdevs);
+    g_hash_table_unref (self->priv->physdev_verdicts);
+
+    G_OBJECT_CLASS (mm_filter_parent_class)->finalize (object);
 }
 
 static void
@@ -359,6 +531,7 @@ mm_filter_class_init (MMFilterClass *klass)
     /* Virtual methods */
     object_class->set_property = set_property;
     object_class->get_property = get_property;
+    object_class->finalize     = finalize;
 
     g_object_class_install_property (
         object_class, PROP_ENABLED_RULES,
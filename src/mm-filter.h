@@ -134,4 +134,11 @@ gboolean mm_filter_device_and_port (MMFilter       *self,
                                     MMDevice       *device,
                                     MMKernelDevice *port);
 
+void mm_filter_port_removed (MMFilter       *self,
+                             MMKernelDevice *port);
+
+guint mm_filter_get_rule_hits (MMFilter     *self,
+                               MMFilterRule  rule);
+void  mm_filter_report_rule_hits (MMFilter *self);
+
 #endif /* MM_FILTER_H */
@@ -20,6 +20,8 @@
 #include "mm-iface-modem.h"
 #include "mm-iface-modem-messaging.h"
 #include "mm-sms-list.h"
+#include "mm-sms-part-3gpp.h"
+#include "mm-sms-storage-cache.h"
 #include "mm-log.h"
 
 #define SUPPORT_CHECKED_TAG "messaging-support-checked-tag"
@@ -32,6 +34,14 @@ static GQuark storage_context_quark;
 
 /*****************************************************************************/
 
+static gboolean
+list_has_local_multipart_reference (const gchar *number,
+                                    guint8 reference,
+                                    MMSmsList *list)
+{
+    return mm_sms_list_has_local_multipart_reference (list, number, reference);
+}
+
 guint8
 mm_iface_modem_messaging_get_local_multipart_reference (MMIfaceModemMessaging *self,
                                                         const gchar *number,
@@ -39,43 +49,31 @@ mm_iface_modem_messaging_get_local_multipart_reference (MMIfaceModemMessaging *s
 {
     MMSmsList *list = NULL;
     guint8 reference;
-    guint8 first;
 
-    /* Start by looking for a random number */
-    reference = g_random_int_range (1,255);
-
-    /* Then, look for the given reference in user-created messages */
+    /* Look for a reference not used in user-created messages */
     g_object_get (self,
                   MM_IFACE_MODEM_MESSAGING_SMS_LIST, &list,
                   NULL);
     if (!list)
-        return reference;
-
-    first = reference;
-    do {
-        if (!mm_sms_list_has_local_multipart_reference (list, number, reference)) {
-            g_object_unref (list);
-            return reference;
-        }
-
-        if (reference == 255)
-            reference = 1;
-        else
-            reference++;
-    }
-    while (reference != first);
+        return g_random_int_range (1, 256);
 
+    reference = mm_sms_part_3gpp_reserve_reference (NULL,
+                                                    number,
+                                                    (MMSmsPart3gppReferenceInUseFn)list_has_local_multipart_reference,
+                                                    list);
     g_object_unref (list);
 
-    /* We were not able to find a new valid multipart reference :/
-     * return an error */
-    g_set_error (error,
-                 MM_CORE_ERROR,
-                 MM_CORE_ERROR_TOO_MANY,
-                 "Cannot create multipart SMS: No valid multipart reference "
-                 "available for destination number '%s'",
-                 number);
-    return 0;
+    if (!reference) {
+        /* We were not able to find a new valid multipart reference :/
+         * return an error */
+        g_set_error (error,
+                     MM_CORE_ERROR,
+                     MM_CORE_ERROR_TOO_MANY,
+                     "Cannot create multipart SMS: No valid multipart reference "
+                     "available for destination number '%s'",
+                     number);
+    }
+    return reference;
 }
 
 /*****************************************************************************/
@@ -362,13 +360,382 @@ handle_create (MmGdbusModemMessaging *skeleton,
 }
 
 /*****************************************************************************/
+/* Batch send
+ *
+ * No SMS object is created or exported for the messages in the batch, and
+ * results are reported with one signal per message. The PDUs of the messages
+ * are built a few messages ahead, each time a PDU has been given to the modem,
+ * so that building them doesn't delay the next PDU while the link to the
+ * network is kept open. Knowing the next valid message also tells whether
+ * there's more to send after each PDU. The multipart references used within
+ * the batch are reserved until the batch is finished, as they're not in the
+ * SMS list. */
+
+/* Number of valid messages built ahead, including the one being sent */
+#define BATCH_MESSAGES_AHEAD 3
+
+typedef struct {
+    guint8 *pdu;
+    guint pdu_len;
+    guint msgstart;
+} BatchPdu;
+
+typedef struct {
+    guint index;
+    /* PDUs of the message, or the error building them */
+    GArray *pdus;
+    GError *error;
+} BatchMessage;
+
+typedef struct {
+    MMIfaceModemMessaging *self;
+    MmGdbusModemMessaging *skeleton;
+    MMSmsList *list;
+    guint id;
+    GVariant *messages;
+    guint n_messages;
+    /* Index of the next message to build */
+    guint next_message;
+    /* Messages built, the first one being sent */
+    GQueue built;
+    guint n_built_valid;
+    /* Next PDU to send of the first message */
+    guint current;
+    GHashTable *reserved_references;
+} SendBatchContext;
+
+static void
+batch_pdu_clear (BatchPdu *batch_pdu)
+{
+    g_free (batch_pdu->pdu);
+}
+
+static void
+batch_message_free (BatchMessage *message)
+{
+    if (message->pdus)
+        g_array_unref (message->pdus);
+    if (message->error)
+        g_error_free (message->error);
+    g_slice_free (BatchMessage, message);
+}
+
+static void
+send_batch_context_free (SendBatchContext *ctx)
+{
+    g_queue_foreach (&ctx->built, (GFunc)batch_message_free, NULL);
+    g_queue_clear (&ctx->built);
+    g_hash_table_unref (ctx->reserved_references);
+    g_variant_unref (ctx->messages);
+    if (ctx->list)
+        g_object_unref (ctx->list);
+    g_object_unref (ctx->skeleton);
+    g_object_unref (ctx->self);
+    g_slice_free (SendBatchContext, ctx);
+}
+
+static GArray *
+batch_message_generate_pdus (SendBatchContext *ctx,
+                             const gchar *number,
+                             const gchar *text,
+                             GError **error)
+{
+    GArray *pdus;
+    GList *parts;
+    GList *l;
+
+    if (!number[0] || !text[0]) {
+        g_set_error (error,
+                     MM_CORE_ERROR,
+                     MM_CORE_ERROR_INVALID_ARGS,
+                     "Both number and text are required");
+        return NULL;
+    }
+
+    parts = mm_sms_part_3gpp_new_submit_parts (number,
+                                               text,
+                                               ctx->reserved_references,
+                                               ctx->list ? (MMSmsPart3gppReferenceInUseFn)list_has_local_multipart_reference : NULL,
+                                               ctx->list,
+                                               error);
+    if (!parts)
+        return NULL;
+
+    pdus = g_array_new (FALSE, FALSE, sizeof (BatchPdu));
+    g_array_set_clear_func (pdus, (GDestroyNotify)batch_pdu_clear);
+    for (l = parts; l; l = g_list_next (l)) {
+        BatchPdu batch_pdu = { 0 };
+
+        batch_pdu.pdu = mm_sms_part_3gpp_get_submit_pdu ((MMSmsPart *)l->data,
+                                                         &batch_pdu.pdu_len,
+                                                         &batch_pdu.msgstart,
+                                                         error);
+        if (!batch_pdu.pdu) {
+            g_array_unref (pdus);
+            pdus = NULL;
+            break;
+        }
+        g_array_append_val (pdus, batch_pdu);
+    }
+
+    g_list_free_full (parts, (GDestroyNotify)mm_sms_part_free);
+    return pdus;
+}
+
+/* Builds messages until enough valid ones are ready, or there are no more */
+static void
+send_batch_build_ahead (SendBatchContext *ctx)
+{
+    while (ctx->n_built_valid < BATCH_MESSAGES_AHEAD && ctx->next_message < ctx->n_messages) {
+        BatchMessage *message;
+        const gchar *number;
+        const gchar *text;
+
+        message = g_slice_new0 (BatchMessage);
+        message->index = ctx->next_message++;
+        g_variant_get_child (ctx->messages, message->index, "(&s&s)", &number, &text);
+        message->pdus = batch_message_generate_pdus (ctx, number, text, &message->error);
+        if (message->pdus)
+            ctx->n_built_valid++;
+        g_queue_push_tail (&ctx->built, message);
+    }
+}
+
+static void
+send_batch_message_done (SendBatchContext *ctx)
+{
+    BatchMessage *message;
+
+    message = g_queue_pop_head (&ctx->built);
+    if (message->pdus)
+        ctx->n_built_valid--;
+    batch_message_free (message);
+    ctx->current = 0;
+}
+
+static void send_batch_next (SendBatchContext *ctx);
+
+static void
+send_batch_pdu_ready (MMIfaceModemMessaging *self,
+                      GAsyncResult *res,
+                      SendBatchContext *ctx)
+{
+    BatchMessage *message;
+    guint message_reference = 0;
+    GError *error = NULL;
+
+    message = g_queue_peek_head (&ctx->built);
+
+    if (!MM_IFACE_MODEM_MESSAGING_GET_INTERFACE (self)->send_pdu_finish (self, res, &message_reference, &error)) {
+        mm_dbg ("Couldn't send message %u of batch %u: '%s'",
+                message->index, ctx->id, error->message);
+        mm_gdbus_modem_messaging_emit_batch_message_sent (ctx->skeleton,
+                                                          ctx->id,
+                                                          message->index,
+                                                          0,
+                                                          error->message);
+        g_error_free (error);
+        /* The remaining parts of the message are not sent */
+        send_batch_message_done (ctx);
+    } else if (++ctx->current == message->pdus->len) {
+        mm_gdbus_modem_messaging_emit_batch_message_sent (ctx->skeleton,
+                                                          ctx->id,
+                                                          message->index,
+                                                          message_reference,
+                                                          "");
+        send_batch_message_done (ctx);
+    }
+
+    send_batch_next (ctx);
+}
+
+static void
+send_batch_next (SendBatchContext *ctx)
+{
+    BatchMessage *message;
+    BatchPdu *batch_pdu;
+    gboolean more_to_send;
+
+    /* Only needed for the first message, the next ones are built while the
+     * previous PDUs are being sent */
+    send_batch_build_ahead (ctx);
+
+    /* Report the messages which couldn't be built, in order */
+    while ((message = g_queue_peek_head (&ctx->built)) && !message->pdus) {
+        mm_gdbus_modem_messaging_emit_batch_message_sent (ctx->skeleton,
+                                                          ctx->id,
+                                                          message->index,
+                                                          0,
+                                                          message->error->message);
+        send_batch_message_done (ctx);
+    }
+
+    if (!message) {
+        mm_dbg ("Batch %u finished", ctx->id);
+        send_batch_context_free (ctx);
+        return;
+    }
+
+    /* More parts of this message, or another valid message already built */
+    more_to_send = (ctx->current + 1 < message->pdus->len || ctx->n_built_valid > 1);
+
+    batch_pdu = &g_array_index (message->pdus, BatchPdu, ctx->current);
+    MM_IFACE_MODEM_MESSAGING_GET_INTERFACE (ctx->self)->send_pdu (
+        ctx->self,
+        batch_pdu->pdu,
+        batch_pdu->pdu_len,
+        batch_pdu->msgstart,
+        more_to_send,
+        (GAsyncReadyCallback)send_batch_pdu_ready,
+        ctx);
+
+    /* Build the next messages while this PDU is being sent */
+    send_batch_build_ahead (ctx);
+}
+
+typedef struct {
+    MmGdbusModemMessaging *skeleton;
+    GDBusMethodInvocation *invocation;
+    MMIfaceModemMessaging *self;
+    GVariant *messages;
+} HandleSendBatchContext;
+
+static void
+handle_send_batch_context_free (HandleSendBatchContext *ctx)
+{
+    g_object_unref (ctx->skeleton);
+    g_object_unref (ctx->invocation);
+    g_object_unref (ctx->self);
+    g_variant_unref (ctx->messages);
+    g_free (ctx);
+}
+
+static void
+handle_send_batch_auth_ready (MMBaseModem *self,
+                              GAsyncResult *res,
+                              HandleSendBatchContext *ctx)
+{
+    static guint batch_ids = 0;
+    MMModemState modem_state = MM_MODEM_STATE_UNKNOWN;
+    SendBatchContext *batch;
+    GError *error = NULL;
+
+    if (!mm_base_modem_authorize_finish (self, res, &error)) {
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+        handle_send_batch_context_free (ctx);
+        return;
+    }
+
+    g_object_get (self,
+                  MM_IFACE_MODEM_STATE, &modem_state,
+                  NULL);
+
+    if (modem_state < MM_MODEM_STATE_ENABLED) {
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_WRONG_STATE,
+                                               "Cannot send batch: device not yet enabled");
+        handle_send_batch_context_free (ctx);
+        return;
+    }
+
+    if (!mm_iface_modem_is_3gpp (MM_IFACE_MODEM (self)) ||
+        !MM_IFACE_MODEM_MESSAGING_GET_INTERFACE (self)->send_pdu ||
+        !MM_IFACE_MODEM_MESSAGING_GET_INTERFACE (self)->send_pdu_finish) {
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_UNSUPPORTED,
+                                               "Cannot send batch: not supported by this modem");
+        handle_send_batch_context_free (ctx);
+        return;
+    }
+
+    batch = g_slice_new0 (SendBatchContext);
+    batch->self = g_object_ref (ctx->self);
+    batch->skeleton = g_object_ref (ctx->skeleton);
+    batch->id = ++batch_ids;
+    batch->messages = g_variant_ref (ctx->messages);
+    batch->n_messages = g_variant_n_children (ctx->messages);
+    g_queue_init (&batch->built);
+    batch->reserved_references = mm_sms_part_3gpp_reserved_references_new ();
+    g_object_get (self,
+                  MM_IFACE_MODEM_MESSAGING_SMS_LIST, &batch->list,
+                  NULL);
+
+    mm_dbg ("Sending batch %u: %u messages", batch->id, batch->n_messages);
+
+    /* Complete the DBus call before any result is reported */
+    mm_gdbus_modem_messaging_complete_send_batch (ctx->skeleton, ctx->invocation, batch->id);
+    handle_send_batch_context_free (ctx);
+
+    send_batch_next (batch);
+}
+
+static gboolean
+handle_send_batch (MmGdbusModemMessaging *skeleton,
+                   GDBusMethodInvocation *invocation,
+                   GVariant *messages,
+                   MMIfaceModemMessaging *self)
+{
+    HandleSendBatchContext *ctx;
+
+    ctx = g_new (HandleSendBatchContext, 1);
+    ctx->skeleton = g_object_ref (skeleton);
+    ctx->invocation = g_object_ref (invocation);
+    ctx->self = g_object_ref (self);
+    ctx->messages = g_variant_ref (messages);
+
+    mm_base_modem_authorize (MM_BASE_MODEM (self),
+                             invocation,
+                             MM_AUTHORIZATION_MESSAGING,
+                             (GAsyncReadyCallback)handle_send_batch_auth_ready,
+                             ctx);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+typedef struct {
+    MmGdbusModemMessaging *skeleton;
+    GDBusMethodInvocation *invocation;
+} HandleListContext;
+
+static void
+handle_list_context_free (HandleListContext *ctx)
+{
+    g_object_unref (ctx->skeleton);
+    g_object_unref (ctx->invocation);
+    g_free (ctx);
+}
+
+static void
+handle_list_load_deferred_ready (MMSmsList *list,
+                                 GAsyncResult *res,
+                                 HandleListContext *ctx)
+{
+    GStrv paths;
+    GError *error = NULL;
+
+    if (!mm_sms_list_load_deferred_finish (list, res, &error)) {
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+        handle_list_context_free (ctx);
+        return;
+    }
+
+    paths = mm_sms_list_get_paths (list);
+    mm_gdbus_modem_messaging_complete_list (ctx->skeleton,
+                                            ctx->invocation,
+                                            (const gchar *const *)paths);
+    g_strfreev (paths);
+    handle_list_context_free (ctx);
+}
 
 static gboolean
 handle_list (MmGdbusModemMessaging *skeleton,
              GDBusMethodInvocation *invocation,
              MMIfaceModemMessaging *self)
 {
-    GStrv paths;
+    HandleListContext *ctx;
     MMSmsList *list = NULL;
     MMModemState modem_state;
 
@@ -397,11 +764,14 @@ handle_list (MmGdbusModemMessaging *skeleton,
         return TRUE;
     }
 
-    paths = mm_sms_list_get_paths (list);
-    mm_gdbus_modem_messaging_complete_list (skeleton,
-                                            invocation,
-                                            (const gchar *const *)paths);
-    g_strfreev (paths);
+    ctx = g_new (HandleListContext, 1);
+    ctx->skeleton = g_object_ref (skeleton);
+    ctx->invocation = g_object_ref (invocation);
+
+    /* Create the objects of all stored messages not yet loaded */
+    mm_sms_list_load_deferred (list,
+                               (GAsyncReadyCallback)handle_list_load_deferred_ready,
+                               ctx);
     g_object_unref (list);
     return TRUE;
 }
@@ -609,6 +979,9 @@ interface_disabling_step (GTask *task)
 
     switch (ctx->step) {
     case DISABLING_STEP_FIRST:
+        /* Messages received or deleted from now on won't be reported, so the
+         * cached listings of the storages may become outdated */
+        mm_sms_storage_cache_unwatch (MM_BASE_MODEM (self));
         /* Fall down to next step */
         ctx->step++;
 
@@ -789,6 +1162,20 @@ set_default_storage_ready (MMIfaceModemMessaging *self,
     interface_enabling_step (task);
 }
 
+static void
+initial_sms_parts_loaded (MMIfaceModemMessaging *self)
+{
+    MMSmsList *list = NULL;
+
+    g_object_get (self,
+                  MM_IFACE_MODEM_MESSAGING_SMS_LIST, &list,
+                  NULL);
+    if (list) {
+        mm_sms_list_initial_load_done (list);
+        g_object_unref (list);
+    }
+}
+
 static void
 load_initial_sms_parts_from_storages (GTask *task)
 {
@@ -896,6 +1283,44 @@ get_best_initial_default_sms_storage (MMIfaceModemMessaging *self)
     return default_storages_preference[i];
 }
 
+static gboolean
+sms_lazy_export_enabled (MMIfaceModemMessaging *self)
+{
+    gboolean lazy_export = FALSE;
+    GList *ports;
+    GList *l;
+
+    /* Stored parts can only be loaded on demand if they can be read one by one */
+    if (!MM_IFACE_MODEM_MESSAGING_GET_INTERFACE (self)->load_sms_part ||
+        !MM_IFACE_MODEM_MESSAGING_GET_INTERFACE (self)->load_sms_part_finish)
+        return FALSE;
+
+    /* Either requested by the plugin... */
+    g_object_get (self,
+                  MM_IFACE_MODEM_MESSAGING_SMS_LAZY_EXPORT, &lazy_export,
+                  NULL);
+    if (lazy_export)
+        return TRUE;
+
+    /* ...or with a udev tag in the device */
+    ports = mm_base_modem_find_ports (MM_BASE_MODEM (self),
+                                      MM_PORT_SUBSYS_UNKNOWN,
+                                      MM_PORT_TYPE_UNKNOWN,
+                                      NULL);
+    for (l = ports; l; l = g_list_next (l)) {
+        MMKernelDevice *kernel_device;
+
+        kernel_device = mm_port_peek_kernel_device (MM_PORT (l->data));
+        if (kernel_device) {
+            lazy_export = mm_kernel_device_get_global_property_as_boolean (kernel_device, "ID_MM_SMS_LAZY_EXPORT");
+            break;
+        }
+    }
+    g_list_free_full (ports, g_object_unref);
+
+    return lazy_export;
+}
+
 static void
 interface_enabling_step (GTask *task)
 {
@@ -914,8 +1339,12 @@ interface_enabling_step (GTask *task)
     switch (ctx->step) {
     case ENABLING_STEP_FIRST: {
         MMSmsList *list;
+        gboolean lazy_export;
 
-        list = mm_sms_list_new (MM_BASE_MODEM (self));
+        lazy_export = sms_lazy_export_enabled (self);
+        if (lazy_export)
+            mm_dbg ("SMS objects for stored messages will be created when listed");
+        list = mm_sms_list_new (MM_BASE_MODEM (self), lazy_export);
         g_object_set (self,
                       MM_IFACE_MODEM_MESSAGING_SMS_LIST, list,
                       NULL);
@@ -987,6 +1416,9 @@ interface_enabling_step (GTask *task)
         ctx->step++;
 
     case ENABLING_STEP_SETUP_UNSOLICITED_EVENTS:
+        /* Parts received from now on are new messages */
+        initial_sms_parts_loaded (self);
+
         /* Allow setting up unsolicited events */
         if (MM_IFACE_MODEM_MESSAGING_GET_INTERFACE (self)->setup_unsolicited_events &&
             MM_IFACE_MODEM_MESSAGING_GET_INTERFACE (self)->setup_unsolicited_events_finish) {
@@ -1333,6 +1765,10 @@ interface_initialization_step (GTask *task)
                           "handle-list",
                           G_CALLBACK (handle_list),
                           self);
+        g_signal_connect (ctx->skeleton,
+                          "handle-send-batch",
+                          G_CALLBACK (handle_send_batch),
+                          self);
 
         /* Finally, export the new interface */
         mm_gdbus_object_skeleton_set_modem_messaging (MM_GDBUS_OBJECT_SKELETON (self),
@@ -1439,6 +1875,14 @@ iface_modem_messaging_init (gpointer g_iface)
                                FALSE,
                                G_PARAM_READWRITE));
 
+    g_object_interface_install_property
+        (g_iface,
+         g_param_spec_boolean (MM_IFACE_MODEM_MESSAGING_SMS_LAZY_EXPORT,
+                               "Lazy export",
+                               "Whether SMS objects for stored messages are only created when listed",
+                               FALSE,
+                               G_PARAM_READWRITE));
+
     g_object_interface_install_property
         (g_iface,
          g_param_spec_enum (MM_IFACE_MODEM_MESSAGING_SMS_DEFAULT_STORAGE,
@@ -33,6 +33,7 @@
 #define MM_IFACE_MODEM_MESSAGING_DBUS_SKELETON       "iface-modem-messaging-dbus-skeleton"
 #define MM_IFACE_MODEM_MESSAGING_SMS_LIST            "iface-modem-messaging-sms-list"
 #define MM_IFACE_MODEM_MESSAGING_SMS_PDU_MODE        "iface-modem-messaging-sms-pdu-mode"
+#define MM_IFACE_MODEM_MESSAGING_SMS_LAZY_EXPORT     "iface-modem-messaging-sms-lazy-export"
 #define MM_IFACE_MODEM_MESSAGING_SMS_DEFAULT_STORAGE "iface-modem-messaging-sms-default-storage"
 
 typedef struct _MMIfaceModemMessaging MMIfaceModemMessaging;
@@ -129,8 +130,34 @@ struct _MMIfaceModemMessaging {
                                                GAsyncResult *res,
                                                GError **error);
 
+    /* Load a single stored SMS part (async).
+     * Used to load on demand the initial parts, with lazy export */
+    void (* load_sms_part) (MMIfaceModemMessaging *self,
+                            MMSmsStorage storage,
+                            guint index,
+                            GAsyncReadyCallback callback,
+                            gpointer user_data);
+    MMSmsPart * (* load_sms_part_finish) (MMIfaceModemMessaging *self,
+                                          GAsyncResult *res,
+                                          GError **error);
+
     /* Create SMS objects */
     MMBaseSms * (* create_sms) (MMIfaceModemMessaging *self);
+
+    /* Send a single SUBMIT PDU, not bound to any SMS object (async);
+     * more_to_send tells whether more PDUs will be sent right after this one,
+     * so that the link to the network may be kept open. Used to send batches. */
+    void (* send_pdu) (MMIfaceModemMessaging *self,
+                       const guint8 *pdu,
+                       guint pdu_len,
+                       guint msgstart,
+                       gboolean more_to_send,
+                       GAsyncReadyCallback callback,
+                       gpointer user_data);
+    gboolean (* send_pdu_finish) (MMIfaceModemMessaging *self,
+                                  GAsyncResult *res,
+                                  guint *message_reference,
+                                  GError **error);
 };
 
 GType mm_iface_modem_messaging_get_type (void);
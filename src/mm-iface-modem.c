@@ -25,6 +25,7 @@
 #include "mm-base-modem.h"
 #include "mm-base-modem-at.h"
 #include "mm-base-sim.h"
+#include "mm-broadband-modem.h"
 #include "mm-bearer-list.h"
 #include "mm-log.h"
 #include "mm-context.h"
@@ -1940,6 +1941,10 @@ handle_reset_auth_ready (MMBaseModem *self,
         return;
     }
 
+    /* Whatever the outcome, the PDP contexts may no longer be the ones we know */
+    if (MM_IS_BROADBAND_MODEM (self))
+        mm_broadband_modem_invalidate_3gpp_pdp_contexts (MM_BROADBAND_MODEM (self));
+
     MM_IFACE_MODEM_GET_INTERFACE (self)->reset (MM_IFACE_MODEM (self),
                                                 (GAsyncReadyCallback)handle_reset_ready,
                                                 ctx);
@@ -2025,6 +2030,10 @@ handle_factory_reset_auth_ready (MMBaseModem *self,
         return;
     }
 
+    /* Whatever the outcome, the PDP contexts may no longer be the ones we know */
+    if (MM_IS_BROADBAND_MODEM (self))
+        mm_broadband_modem_invalidate_3gpp_pdp_contexts (MM_BROADBAND_MODEM (self));
+
     MM_IFACE_MODEM_GET_INTERFACE (self)->factory_reset (MM_IFACE_MODEM (self),
                                                         ctx->code,
                                                         (GAsyncReadyCallback)handle_factory_reset_ready,
@@ -847,6 +847,17 @@ mm_3gpp_cds_regex_get (void)
                         NULL);
 }
 
+/*************************************************************************/
+
+GRegex *
+mm_3gpp_cgev_regex_get (void)
+{
+    return g_regex_new ("\\r\\n\\+CGEV:\\s*(.*)\\r\\n",
+                        G_REGEX_RAW | G_REGEX_OPTIMIZE,
+                        0,
+                        NULL);
+}
+
 /*************************************************************************/
 /* AT+WS46=? response parser
  *
@@ -1595,6 +1606,56 @@ mm_3gpp_parse_cgact_read_response (const gchar *reply,
     return list;
 }
 
+/*************************************************************************/
+/* +CGEV unsolicited message parser
+ *
+ * Examples (3GPP TS 27.007, section 10.1.19):
+ *   +CGEV: NW DETACH
+ *   +CGEV: ME PDN DEACT 1
+ *   +CGEV: NW DEACT "IP","10.0.0.2",1
+ *   +CGEV: NW DEACT 1,2,0     (secondary context, ignored)
+ */
+
+MM3gppCgev
+mm_3gpp_parse_cgev_indication (const gchar *str,
+                               guint *out_cid)
+{
+    MM3gppCgev   result = MM_3GPP_CGEV_UNKNOWN;
+    const gchar *args;
+    gchar      **fields;
+    guint        cid = 0;
+
+    while (g_ascii_isspace (*str))
+        str++;
+
+    if (g_str_has_prefix (str, "NW DETACH") || g_str_has_prefix (str, "ME DETACH"))
+        result = MM_3GPP_CGEV_DETACH;
+    else if (g_str_has_prefix (str, "NW PDN DEACT ") || g_str_has_prefix (str, "ME PDN DEACT ")) {
+        /* <cid>[,<WLAN_Offload>] */
+        args = str + strlen ("NW PDN DEACT ");
+        fields = g_strsplit (args, ",", -1);
+        if (fields[0] && mm_get_uint_from_str (g_strstrip (fields[0]), &cid))
+            result = MM_3GPP_CGEV_DEACTIVATED;
+        g_strfreev (fields);
+    } else if (g_str_has_prefix (str, "NW DEACT ") || g_str_has_prefix (str, "ME DEACT ")) {
+        /* <PDP_type>,<PDP_addr>[,<cid>]; a number in the first field
+         * means <p_cid>,<cid>,<event_type> instead, i.e. a secondary
+         * context which doesn't tell anything about the bearer */
+        args = str + strlen ("NW DEACT ");
+        fields = g_strsplit (args, ",", -1);
+        if (fields[0] && !g_ascii_isdigit (*g_strstrip (fields[0]))) {
+            if (!fields[1] || !fields[2] || !mm_get_uint_from_str (g_strstrip (fields[2]), &cid))
+                cid = 0;
+            result = MM_3GPP_CGEV_DEACTIVATED;
+        }
+        g_strfreev (fields);
+    }
+
+    if (out_cid)
+        *out_cid = cid;
+    return result;
+}
+
 /*************************************************************************/
 
 static gulong
@@ -2702,6 +2763,42 @@ end:
     return ret;
 }
 
+gboolean
+mm_3gpp_parse_cpms_set_response (const gchar *reply,
+                                 guint *mem1_used,
+                                 guint *mem1_total,
+                                 GError **error)
+{
+    GRegex *r;
+    GMatchInfo *match_info = NULL;
+    guint used = 0;
+    guint total = 0;
+    gboolean ret = FALSE;
+
+    /* +CPMS: <used1>,<total1>,<used2>,<total2>,<used3>,<total3> */
+    r = g_regex_new ("\\+CPMS:\\s*(\\d+)\\s*,\\s*(\\d+)", G_REGEX_RAW, 0, NULL);
+    g_assert (r);
+
+    if (!g_regex_match (r, reply, 0, &match_info) ||
+        !mm_get_uint_from_match_info (match_info, 1, &used) ||
+        !mm_get_uint_from_match_info (match_info, 2, &total)) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Could not parse CPMS set response '%s'", reply);
+        goto end;
+    }
+
+    if (mem1_used)
+        *mem1_used = used;
+    if (mem1_total)
+        *mem1_total = total;
+    ret = TRUE;
+
+end:
+    g_match_info_free (match_info);
+    g_regex_unref (r);
+    return ret;
+}
+
 gboolean
 mm_3gpp_get_cpms_storage_match (GMatchInfo *match_info,
                                 const gchar *match_name,
@@ -3239,6 +3336,42 @@ mm_3gpp_pdu_info_list_free (GList *info_list)
     g_list_free_full (info_list, (GDestroyNotify)mm_3gpp_pdu_info_free);
 }
 
+GRegex *
+mm_3gpp_cmgl_pdu_entry_regex_get (void)
+{
+    /* Unlike the one used to parse whole responses, this one requires the
+     * trailing <CR><LF>, so that it only matches complete entries while the
+     * response is still being received. Example:
+     * +CMGL: 17,3,35<CR><LF>079100F40D1101000F001000B917118336058F300001954747A0E4ACF41F27298CDCE83C6EF371B0402814020<CR><LF>
+     */
+    return g_regex_new ("\\+CMGL:\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,([^\\r\\n]*)\\r\\n([^\\r\\n]*)\\r\\n",
+                        G_REGEX_RAW | G_REGEX_OPTIMIZE,
+                        0,
+                        NULL);
+}
+
+MM3gppPduInfo *
+mm_3gpp_parse_pdu_cmgl_entry (GMatchInfo *match_info,
+                              GError **error)
+{
+    MM3gppPduInfo *info;
+
+    info = g_new0 (MM3gppPduInfo, 1);
+    if (!mm_get_int_from_match_info (match_info, 1, &info->index) ||
+        !mm_get_int_from_match_info (match_info, 2, &info->status) ||
+        (info->pdu = mm_get_string_unquoted_from_match_info (match_info, 4)) == NULL) {
+        g_set_error (error,
+                     MM_CORE_ERROR,
+                     MM_CORE_ERROR_FAILED,
+                     "Error parsing +CMGL entry: '%s'",
+                     g_match_info_get_string (match_info));
+        mm_3gpp_pdu_info_free (info);
+        return NULL;
+    }
+
+    return info;
+}
+
 GList *
 mm_3gpp_parse_pdu_cmgl_response (const gchar *str,
                                  GError **error)
@@ -3263,18 +3396,11 @@ mm_3gpp_parse_pdu_cmgl_response (const gchar *str,
     while (!inner_error && g_match_info_matches (match_info)) {
         MM3gppPduInfo *info;
 
-        info = g_new0 (MM3gppPduInfo, 1);
-        if (mm_get_int_from_match_info (match_info, 1, &info->index) &&
-            mm_get_int_from_match_info (match_info, 2, &info->status) &&
-            (info->pdu = mm_get_string_unquoted_from_match_info (match_info, 4)) != NULL) {
+        info = mm_3gpp_parse_pdu_cmgl_entry (match_info, &inner_error);
+        if (info) {
             /* Append to our list of results and keep on */
-            list = g_list_append (list, info);
+            list = g_list_prepend (list, info);
             g_match_info_next (match_info, &inner_error);
-        } else {
-            inner_error = g_error_new (MM_CORE_ERROR,
-                                       MM_CORE_ERROR_FAILED,
-                                       "Error parsing +CMGL response: '%s'",
-                                       str);
         }
     }
 
@@ -3287,7 +3413,7 @@ mm_3gpp_parse_pdu_cmgl_response (const gchar *str,
         return NULL;
     }
 
-    return list;
+    return g_list_reverse (list);
 }
 
 /*************************************************************************/
@@ -123,6 +123,7 @@ GRegex    *mm_3gpp_ciev_regex_get (void);
 GRegex    *mm_3gpp_cusd_regex_get (void);
 GRegex    *mm_3gpp_cmti_regex_get (void);
 GRegex    *mm_3gpp_cds_regex_get (void);
+GRegex    *mm_3gpp_cgev_regex_get (void);
 
 /* AT+WS46=? response parser: returns array of MMModemMode values */
 GArray *mm_3gpp_parse_ws46_test_response (const gchar  *response,
@@ -181,6 +182,18 @@ void mm_3gpp_pdp_context_active_list_free (GList *pdp_active_list);
 GList *mm_3gpp_parse_cgact_read_response (const gchar *reply,
                                           GError **error);
 
+/* +CGEV (packet domain event) unsolicited message parser; only the events
+ * telling that contexts are gone are reported */
+typedef enum { /*< underscore_name=mm_3gpp_cgev >*/
+    MM_3GPP_CGEV_UNKNOWN,
+    /* All contexts deactivated */
+    MM_3GPP_CGEV_DETACH,
+    /* Context with the given CID deactivated, or unknown one if CID is 0 */
+    MM_3GPP_CGEV_DEACTIVATED,
+} MM3gppCgev;
+MM3gppCgev mm_3gpp_parse_cgev_indication (const gchar *str,
+                                          guint *out_cid);
+
 /* CREG/CGREG response/unsolicited message parser */
 gboolean mm_3gpp_parse_creg_response (GMatchInfo *info,
                                       MMModem3gppRegistrationState *out_reg_state,
@@ -208,6 +221,11 @@ gboolean mm_3gpp_parse_cpms_query_response (const gchar *reply,
                                             MMSmsStorage *mem1,
                                             MMSmsStorage *mem2,
                                             GError** error);
+/* AT+CPMS=... (Set SMS storage) response parser */
+gboolean mm_3gpp_parse_cpms_set_response (const gchar *reply,
+                                          guint *mem1_used,
+                                          guint *mem1_total,
+                                          GError **error);
 gboolean mm_3gpp_get_cpms_storage_match (GMatchInfo *match_info,
                                          const gchar *match_name,
                                          MMSmsStorage *storage,
@@ -276,6 +294,12 @@ void   mm_3gpp_pdu_info_list_free      (GList *info_list);
 GList *mm_3gpp_parse_pdu_cmgl_response (const gchar *str,
                                         GError **error);
 
+/* Streamed AT+CMGL=4 response entries; the regex only matches complete
+ * entries, including the <CR><LF> after the PDU */
+GRegex        *mm_3gpp_cmgl_pdu_entry_regex_get (void);
+MM3gppPduInfo *mm_3gpp_parse_pdu_cmgl_entry     (GMatchInfo *match_info,
+                                                 GError **error);
+
 /* AT+CMGR (Read message) response parser */
 MM3gppPduInfo *mm_3gpp_parse_cmgr_read_response (const gchar *reply,
                                                  guint index,
@@ -0,0 +1,227 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/if.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+#include <glib-unix.h>
+
+#include "mm-net-link-watch.h"
+#include "mm-log.h"
+
+typedef struct {
+    guint             id;
+    gchar            *iface;
+    gboolean          carrier;
+    MMNetLinkWatchFn  callback;
+    gpointer          user_data;
+} Watch;
+
+static gint    netlink_fd = -1;
+static guint   netlink_source_id;
+static GList  *watches;
+static guint   next_id = 1;
+
+static Watch *
+find_watch (guint id)
+{
+    GList *l;
+
+    for (l = watches; l; l = g_list_next (l)) {
+        if (((Watch *)l->data)->id == id)
+            return l->data;
+    }
+    return NULL;
+}
+
+static void
+process_link_message (const struct nlmsghdr *hdr)
+{
+    const struct ifinfomsg *ifi;
+    const struct rtattr    *rta;
+    const gchar            *iface = NULL;
+    gboolean                removed;
+    gboolean                carrier;
+    gint                    len;
+    GArray                 *ids;
+    GList                  *l;
+    guint                   i;
+
+    if (hdr->nlmsg_len < NLMSG_LENGTH (sizeof (struct ifinfomsg)))
+        return;
+
+    ifi = NLMSG_DATA (hdr);
+    len = IFLA_PAYLOAD (hdr);
+    for (rta = IFLA_RTA (ifi); RTA_OK (rta, len); rta = RTA_NEXT (rta, len)) {
+        if (rta->rta_type == IFLA_IFNAME && RTA_PAYLOAD (rta) > 0) {
+            iface = RTA_DATA (rta);
+            /* Must be NUL-terminated within the attribute */
+            if (((const gchar *) RTA_DATA (rta))[RTA_PAYLOAD (rta) - 1] != '\0')
+                iface = NULL;
+            break;
+        }
+    }
+    if (!iface)
+        return;
+
+    removed = (hdr->nlmsg_type == RTM_DELLINK);
+    carrier = !removed && !!(ifi->ifi_flags & IFF_LOWER_UP);
+
+    /* Callbacks may add or remove watches, so first collect the ones to
+     * notify, and look each up again before calling it */
+    ids = g_array_new (FALSE, FALSE, sizeof (guint));
+    for (l = watches; l; l = g_list_next (l)) {
+        Watch *watch = l->data;
+
+        if (!g_str_equal (watch->iface, iface))
+            continue;
+
+        /* Only losing carrier is reported, not every link change */
+        if (removed || (watch->carrier && !carrier))
+            g_array_append_val (ids, watch->id);
+        watch->carrier = carrier;
+    }
+
+    for (i = 0; i < ids->len; i++) {
+        Watch *watch;
+
+        watch = find_watch (g_array_index (ids, guint, i));
+        if (watch)
+            watch->callback (iface, removed, watch->user_data);
+    }
+    g_array_unref (ids);
+}
+
+void
+mm_net_link_watch_process (const guint8 *buffer,
+                           gsize len)
+{
+    const struct nlmsghdr *hdr;
+    gint remaining;
+
+    remaining = (gint) len;
+    for (hdr = (const struct nlmsghdr *) buffer;
+         NLMSG_OK (hdr, remaining);
+         hdr = NLMSG_NEXT (hdr, remaining)) {
+        if (hdr->nlmsg_type == RTM_NEWLINK || hdr->nlmsg_type == RTM_DELLINK)
+            process_link_message (hdr);
+    }
+}
+
+static gboolean
+netlink_fd_cb (gint fd,
+               GIOCondition condition,
+               gpointer user_data)
+{
+    /* Links with many attributes may take more than a page */
+    guint8 buffer[16384];
+
+    while (netlink_fd >= 0) {
+        gssize n;
+
+        n = recv (netlink_fd, buffer, sizeof (buffer), 0);
+        if (n < 0) {
+            /* ENOBUFS means we lost events, nothing to do about them */
+            if (errno != EAGAIN && errno != EINTR && errno != ENOBUFS)
+                mm_warn ("Couldn't receive link events: %s", g_strerror (errno));
+            break;
+        }
+
+        mm_net_link_watch_process (buffer, (gsize) n);
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+netlink_open (void)
+{
+    struct sockaddr_nl addr;
+
+    netlink_fd = socket (AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE);
+    if (netlink_fd < 0) {
+        mm_warn ("Couldn't create netlink socket: %s", g_strerror (errno));
+        return FALSE;
+    }
+
+    memset (&addr, 0, sizeof (addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK;
+    if (bind (netlink_fd, (struct sockaddr *) &addr, sizeof (addr)) < 0) {
+        mm_warn ("Couldn't bind netlink socket: %s", g_strerror (errno));
+        close (netlink_fd);
+        netlink_fd = -1;
+        return FALSE;
+    }
+
+    netlink_source_id = g_unix_fd_add (netlink_fd, G_IO_IN, netlink_fd_cb, NULL);
+    return TRUE;
+}
+
+static void
+netlink_close (void)
+{
+    if (netlink_source_id) {
+        g_source_remove (netlink_source_id);
+        netlink_source_id = 0;
+    }
+    if (netlink_fd >= 0) {
+        close (netlink_fd);
+        netlink_fd = -1;
+    }
+}
+
+guint
+mm_net_link_watch_add (const gchar *iface,
+                       MMNetLinkWatchFn callback,
+                       gpointer user_data)
+{
+    Watch *watch;
+
+    g_return_val_if_fail (iface != NULL, 0);
+    g_return_val_if_fail (callback != NULL, 0);
+
+    if (netlink_fd < 0 && !netlink_open ())
+        return 0;
+
+    watch = g_slice_new0 (Watch);
+    watch->id = next_id++;
+    watch->iface = g_strdup (iface);
+    watch->carrier = TRUE;
+    watch->callback = callback;
+    watch->user_data = user_data;
+    watches = g_list_prepend (watches, watch);
+
+    return watch->id;
+}
+
+void
+mm_net_link_watch_remove (guint id)
+{
+    Watch *watch;
+
+    watch = find_watch (id);
+    g_return_if_fail (watch != NULL);
+
+    watches = g_list_remove (watches, watch);
+    g_free (watch->iface);
+    g_slice_free (Watch, watch);
+
+    if (!watches)
+        netlink_close ();
+}
@@ -0,0 +1,37 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ */
+
+#ifndef MM_NET_LINK_WATCH_H
+#define MM_NET_LINK_WATCH_H
+
+#include <glib.h>
+
+/* Notifications about network interfaces losing carrier or going away,
+ * received from the kernel through rtnetlink. All watches share a single
+ * netlink socket, which is only kept open while there are watches. */
+
+typedef void (* MMNetLinkWatchFn) (const gchar *iface,
+                                   gboolean removed,
+                                   gpointer user_data);
+
+/* Returns 0 if the link can't be watched */
+guint mm_net_link_watch_add    (const gchar *iface,
+                                MMNetLinkWatchFn callback,
+                                gpointer user_data);
+void  mm_net_link_watch_remove (guint id);
+
+/* Handles the rtnetlink messages in @buffer, as read from the socket */
+void  mm_net_link_watch_process (const guint8 *buffer,
+                                 gsize len);
+
+#endif /* MM_NET_LINK_WATCH_H */
@@ -0,0 +1,212 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <ModemManager.h>
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-net-stats.h"
+
+/* Time constant of the average throughput, in seconds */
+#define AVERAGE_TIME_CONSTANT 10.0
+
+/*****************************************************************************/
+/* Throughput estimator */
+
+void
+mm_net_rate_update (MMNetRate *rate,
+                    guint64 bytes,
+                    gdouble seconds,
+                    gdouble time_constant)
+{
+    gdouble alpha;
+
+    g_assert (seconds > 0);
+
+    rate->current = (guint64) ((gdouble) bytes * 8 / seconds + 0.5);
+    rate->peak = MAX (rate->peak, rate->current);
+
+    alpha = seconds / (time_constant + seconds);
+    rate->average = (guint64) ((gdouble) rate->average +
+                               alpha * ((gdouble) rate->current - (gdouble) rate->average) +
+                               0.5);
+}
+
+/*****************************************************************************/
+/* Reader */
+
+typedef enum {
+    COUNTER_RX_BYTES,
+    COUNTER_TX_BYTES,
+    COUNTER_RX_PACKETS,
+    COUNTER_TX_PACKETS,
+    N_COUNTERS
+} Counter;
+
+static const gchar *counter_names[N_COUNTERS] = {
+    [COUNTER_RX_BYTES]   = "rx_bytes",
+    [COUNTER_TX_BYTES]   = "tx_bytes",
+    [COUNTER_RX_PACKETS] = "rx_packets",
+    [COUNTER_TX_PACKETS] = "tx_packets",
+};
+
+struct _MMNetStatsReader {
+    gint       fds[N_COUNTERS];
+    guint64    last[N_COUNTERS];
+    gint64     last_timestamp;
+    MMNetStats stats;
+};
+
+static gboolean
+read_counters (MMNetStatsReader *self,
+               guint64 *values,
+               GError **error)
+{
+    guint i;
+
+    for (i = 0; i < N_COUNTERS; i++) {
+        gchar   buf[32];
+        gchar  *end = NULL;
+        gssize  n;
+
+        /* sysfs regenerates the attribute contents on every read from
+         * offset 0, so there's no need to reopen or seek */
+        n = pread (self->fds[i], buf, sizeof (buf) - 1, 0);
+        if (n <= 0) {
+            g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                         "Couldn't read '%s' counter: %s",
+                         counter_names[i],
+                         n < 0 ? g_strerror (errno) : "empty");
+            return FALSE;
+        }
+        buf[n] = '\0';
+
+        values[i] = g_ascii_strtoull (buf, &end, 10);
+        if (end == buf) {
+            g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                         "Couldn't parse '%s' counter", counter_names[i]);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+gboolean
+mm_net_stats_reader_update (MMNetStatsReader *self,
+                            gint64 timestamp,
+                            GError **error)
+{
+    guint64 values[N_COUNTERS];
+    guint64 delta[N_COUNTERS];
+    gdouble seconds;
+    guint   i;
+
+    if (!read_counters (self, values, error))
+        return FALSE;
+
+    for (i = 0; i < N_COUNTERS; i++) {
+        delta[i] = (values[i] >= self->last[i]) ? (values[i] - self->last[i]) : values[i];
+        self->last[i] = values[i];
+    }
+
+    self->stats.rx_bytes   += delta[COUNTER_RX_BYTES];
+    self->stats.tx_bytes   += delta[COUNTER_TX_BYTES];
+    self->stats.rx_packets += delta[COUNTER_RX_PACKETS];
+    self->stats.tx_packets += delta[COUNTER_TX_PACKETS];
+
+    /* Totals are always updated, but there's no rate to compute without
+     * time passing */
+    seconds = (gdouble) (timestamp - self->last_timestamp) / G_USEC_PER_SEC;
+    if (seconds > 0) {
+        mm_net_rate_update (&self->stats.rx_rate, delta[COUNTER_RX_BYTES], seconds, AVERAGE_TIME_CONSTANT);
+        mm_net_rate_update (&self->stats.tx_rate, delta[COUNTER_TX_BYTES], seconds, AVERAGE_TIME_CONSTANT);
+        self->last_timestamp = timestamp;
+    }
+
+    return TRUE;
+}
+
+const MMNetStats *
+mm_net_stats_reader_peek (MMNetStatsReader *self)
+{
+    return &self->stats;
+}
+
+void
+mm_net_stats_reader_free (MMNetStatsReader *self)
+{
+    guint i;
+
+    for (i = 0; i < N_COUNTERS; i++) {
+        if (self->fds[i] >= 0)
+            close (self->fds[i]);
+    }
+    g_slice_free (MMNetStatsReader, self);
+}
+
+MMNetStatsReader *
+mm_net_stats_reader_new_for_path (const gchar *path,
+                                  gint64 timestamp,
+                                  GError **error)
+{
+    MMNetStatsReader *self;
+    guint             i;
+
+    self = g_slice_new0 (MMNetStatsReader);
+    for (i = 0; i < N_COUNTERS; i++)
+        self->fds[i] = -1;
+
+    for (i = 0; i < N_COUNTERS; i++) {
+        gchar *filename;
+
+        filename = g_build_filename (path, counter_names[i], NULL);
+        self->fds[i] = open (filename, O_RDONLY | O_CLOEXEC);
+        if (self->fds[i] < 0) {
+            g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_UNSUPPORTED,
+                         "Couldn't open '%s': %s", filename, g_strerror (errno));
+            g_free (filename);
+            mm_net_stats_reader_free (self);
+            return NULL;
+        }
+        g_free (filename);
+    }
+
+    /* Totals are reported from this point onwards */
+    if (!read_counters (self, self->last, error)) {
+        mm_net_stats_reader_free (self);
+        return NULL;
+    }
+    self->last_timestamp = timestamp;
+
+    return self;
+}
+
+MMNetStatsReader *
+mm_net_stats_reader_new (const gchar *iface,
+                         gint64 timestamp,
+                         GError **error)
+{
+    MMNetStatsReader *self;
+    gchar            *path;
+
+    path = g_strdup_printf ("/sys/class/net/%s/statistics", iface);
+    self = mm_net_stats_reader_new_for_path (path, timestamp, error);
+    g_free (path);
+    return self;
+}
@@ -0,0 +1,74 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ */
+
+#ifndef MM_NET_STATS_H
+#define MM_NET_STATS_H
+
+#include <glib.h>
+
+/* Traffic statistics of a network interface, computed from the counters the
+ * kernel exposes in /sys/class/net/<iface>/statistics. The counter files are
+ * kept open and re-read from offset 0, so each update is four pread()s and
+ * doesn't involve the modem at all. */
+
+/*****************************************************************************/
+/* Throughput estimator */
+
+typedef struct {
+    /* All in bits per second */
+    guint64 current;
+    guint64 average;
+    guint64 peak;
+} MMNetRate;
+
+/* Account @bytes transferred during the last @seconds. The average is an
+ * exponentially weighted moving average with the given time constant, so
+ * that it decays the same way regardless of the update interval. */
+void mm_net_rate_update (MMNetRate *rate,
+                         guint64 bytes,
+                         gdouble seconds,
+                         gdouble time_constant);
+
+/*****************************************************************************/
+/* Reader */
+
+typedef struct {
+    /* Totals since the reader was created */
+    guint64   rx_bytes;
+    guint64   tx_bytes;
+    guint64   rx_packets;
+    guint64   tx_packets;
+    MMNetRate rx_rate;
+    MMNetRate tx_rate;
+} MMNetStats;
+
+typedef struct _MMNetStatsReader MMNetStatsReader;
+
+MMNetStatsReader *mm_net_stats_reader_new          (const gchar *iface,
+                                                    gint64 timestamp,
+                                                    GError **error);
+/* Same as above, reading the counter files from the given directory */
+MMNetStatsReader *mm_net_stats_reader_new_for_path (const gchar *path,
+                                                    gint64 timestamp,
+                                                    GError **error);
+void              mm_net_stats_reader_free         (MMNetStatsReader *self);
+
+/* @timestamp is a monotonic time in microseconds, as given by
+ * g_get_monotonic_time(). Counters going backwards (e.g. if the interface was
+ * recreated) are taken as having been reset to 0. */
+gboolean          mm_net_stats_reader_update       (MMNetStatsReader *self,
+                                                    gint64 timestamp,
+                                                    GError **error);
+const MMNetStats *mm_net_stats_reader_peek         (MMNetStatsReader *self);
+
+#endif /* MM_NET_STATS_H */
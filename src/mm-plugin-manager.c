@@ -54,11 +54,18 @@ struct _MMPluginManagerPrivate {
     GList *plugins;
     /* Last, the generic plugin. */
     MMPlugin *generic;
+    /* Plugins listed in the manifest which haven't been loaded yet, because
+     * no port has been found that they may support. */
+    GList *pending;
 
     /* List of ongoing device support checks */
     GList *device_contexts;
 };
 
+static void load_pending_plugins (MMPluginManager *self,
+                                  MMDevice        *device,
+                                  MMKernelDevice  *port);
+
 /*****************************************************************************/
 /* Build plugin list for a single port */
 
@@ -71,6 +78,9 @@ plugin_manager_build_plugins_list (MMPluginManager *self,
     GList *l;
     gboolean supported_found = FALSE;
 
+    /* Load all plugins not loaded yet which may support this port */
+    load_pending_plugins (self, device, port);
+
     for (l = self->priv->plugins; l && !supported_found; l = g_list_next (l)) {
         MMPluginSupportsHint hint;
 
@@ -1475,6 +1485,9 @@ mm_plugin_manager_device_support_check (MMPluginManager     *self,
 /*****************************************************************************/
 /* Look for plugin */
 
+static MMPlugin *load_pending_plugin_by_name (MMPluginManager *self,
+                                              const gchar     *plugin_name);
+
 MMPlugin *
 mm_plugin_manager_peek_plugin (MMPluginManager *self,
                                const gchar *plugin_name)
@@ -1491,11 +1504,56 @@ mm_plugin_manager_peek_plugin (MMPluginManager *self,
             return plugin;
     }
 
-    return NULL;
+    /* The plugin may not have been loaded yet */
+    return load_pending_plugin_by_name (self, plugin_name);
 }
 
 /*****************************************************************************/
 
+static void
+track_plugin (MMPluginManager *self,
+              MMPlugin        *plugin)
+{
+    mm_dbg ("[plugin manager] loaded plugin '%s'", mm_plugin_get_name (plugin));
+
+    if (g_str_equal (mm_plugin_get_name (plugin), MM_PLUGIN_GENERIC_NAME))
+        /* Generic plugin */
+        self->priv->generic = plugin;
+    else
+        /* Vendor specific plugin */
+        self->priv->plugins = g_list_append (self->priv->plugins, plugin);
+}
+
+#if defined WITH_BUILTIN_PLUGINS
+
+static gboolean
+load_plugins_from_table (MMPluginManager  *self,
+                         GError          **error)
+{
+    guint i;
+
+    mm_dbg ("[plugin manager] loading builtin plugins");
+
+    for (i = 0; mm_builtin_plugins[i]; i++) {
+        MMPlugin *plugin;
+
+        plugin = mm_builtin_plugins[i] ();
+        if (!plugin) {
+            mm_warn ("[plugin manager] could not load builtin plugin #%u: initialization failed", i);
+            continue;
+        }
+
+        track_plugin (self, plugin);
+    }
+
+    return TRUE;
+}
+
+#endif /* WITH_BUILTIN_PLUGINS */
+
+/* Name of the module file a plugin was loaded from */
+#define PLUGIN_MODULE_FILE_TAG "plugin-module-file"
+
 static MMPlugin *
 load_plugin (const gchar *path)
 {
@@ -1543,9 +1601,10 @@ load_plugin (const gchar *path)
     }
 
     plugin = (*plugin_create_func) ();
-    if (plugin)
+    if (plugin) {
         g_object_weak_ref (G_OBJECT (plugin), (GWeakNotify) g_module_close, module);
-    else
+        g_object_set_data_full (G_OBJECT (plugin), PLUGIN_MODULE_FILE_TAG, g_path_get_basename (path), g_free);
+    } else
         mm_warn ("[plugin manager] could not load plugin '%s': initialization failed", path_display);
 
 out:
@@ -1557,11 +1616,194 @@ out:
     return plugin;
 }
 
+/*****************************************************************************/
+/* Plugins loaded on demand
+ *
+ * When a manifest with the pre-probing filters of each plugin is found in the
+ * plugin directory, the plugins are not loaded right away; instead, they're
+ * loaded once a port is found which their filters don't discard. Modules not
+ * listed in the manifest, as well as the generic plugin, are always loaded.
+ */
+
+#define PLUGIN_MANIFEST_FILE "mm-plugins.manifest"
+
+typedef struct {
+    gchar    *path;
+    MMPlugin *filters;
+} PendingPlugin;
+
+static void
+pending_plugin_free (PendingPlugin *pending)
+{
+    g_free (pending->path);
+    g_object_unref (pending->filters);
+    g_slice_free (PendingPlugin, pending);
+}
+
+static void
+load_pending_plugin (MMPluginManager *self,
+                     GList           *link)
+{
+    PendingPlugin *pending;
+    MMPlugin      *plugin;
+
+    pending = (PendingPlugin *)link->data;
+    self->priv->pending = g_list_delete_link (self->priv->pending, link);
+
+    plugin = load_plugin (pending->path);
+    if (plugin)
+        track_plugin (self, plugin);
+    pending_plugin_free (pending);
+}
+
+static void
+load_pending_plugins (MMPluginManager *self,
+                      MMDevice        *device,
+                      MMKernelDevice  *port)
+{
+    GList *l;
+    GList *next;
+
+    for (l = self->priv->pending; l; l = next) {
+        PendingPlugin *pending;
+
+        next = g_list_next (l);
+        pending = (PendingPlugin *)l->data;
+
+        if (mm_plugin_discard_port_early (pending->filters, device, port) == MM_PLUGIN_SUPPORTS_HINT_UNSUPPORTED)
+            continue;
+
+        mm_dbg ("[plugin manager] loading plugin '%s' on demand for port '%s'",
+                mm_plugin_get_name (pending->filters),
+                mm_kernel_device_get_name (port));
+        load_pending_plugin (self, l);
+    }
+}
+
+static MMPlugin *
+load_pending_plugin_by_name (MMPluginManager *self,
+                             const gchar     *plugin_name)
+{
+    GList *l;
+
+    for (l = self->priv->pending; l; l = g_list_next (l)) {
+        PendingPlugin *pending = (PendingPlugin *)l->data;
+
+        if (g_str_equal (plugin_name, mm_plugin_get_name (pending->filters))) {
+            load_pending_plugin (self, l);
+            /* If loaded, it's the last one tracked */
+            return mm_plugin_manager_peek_plugin (self, plugin_name);
+        }
+    }
+
+    return NULL;
+}
+
+gboolean
+mm_plugin_manager_write_manifest (MMPluginManager  *self,
+                                  const gchar      *path,
+                                  GError          **error)
+{
+    GKeyFile *manifest;
+    GList    *plugins;
+    GList    *l;
+    gchar    *contents;
+    gsize     length;
+    gboolean  ret;
+
+    /* The manifest must list all plugins */
+    while (self->priv->pending)
+        load_pending_plugin (self, self->priv->pending);
+
+    manifest = g_key_file_new ();
+
+    plugins = g_list_copy (self->priv->plugins);
+    if (self->priv->generic)
+        plugins = g_list_prepend (plugins, self->priv->generic);
+
+    for (l = plugins; l; l = g_list_next (l)) {
+        const gchar *module_file;
+
+        /* Builtin plugins don't have a module */
+        module_file = g_object_get_data (G_OBJECT (l->data), PLUGIN_MODULE_FILE_TAG);
+        if (module_file)
+            mm_plugin_write_manifest_filters (MM_PLUGIN (l->data), manifest, module_file);
+    }
+    g_list_free (plugins);
+
+    contents = g_key_file_to_data (manifest, &length, NULL);
+    ret = g_file_set_contents (path, contents, length, error);
+    g_free (contents);
+    g_key_file_free (manifest);
+
+    return ret;
+}
+
+#if !defined WITH_BUILTIN_PLUGINS
+
+static GKeyFile *
+load_manifest (MMPluginManager *self)
+{
+    GKeyFile *manifest;
+    gchar    *path;
+    GError   *error = NULL;
+
+    path = g_build_filename (self->priv->plugin_dir, PLUGIN_MANIFEST_FILE, NULL);
+    manifest = g_key_file_new ();
+    if (!g_key_file_load_from_file (manifest, path, G_KEY_FILE_NONE, &error)) {
+        if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+            mm_warn ("[plugin manager] couldn't load plugin manifest: %s", error->message);
+        else
+            mm_dbg ("[plugin manager] no plugin manifest found: all plugins will be loaded");
+        g_error_free (error);
+        g_key_file_free (manifest);
+        manifest = NULL;
+    }
+    g_free (path);
+
+    return manifest;
+}
+
+/* Returns TRUE if the plugin will be loaded on demand */
 static gboolean
-load_plugins (MMPluginManager *self,
-              GError **error)
+track_pending_plugin (MMPluginManager *self,
+                      GKeyFile        *manifest,
+                      const gchar     *fname,
+                      const gchar     *path)
+{
+    PendingPlugin *pending;
+    MMPlugin      *filters;
+    GError        *error = NULL;
+
+    if (!g_key_file_has_group (manifest, fname))
+        return FALSE;
+
+    filters = mm_plugin_new_from_manifest_filters (manifest, fname, &error);
+    if (!filters) {
+        mm_warn ("[plugin manager] couldn't load manifest entry for '%s': %s", fname, error->message);
+        g_error_free (error);
+        return FALSE;
+    }
+
+    /* The generic plugin is always needed */
+    if (g_str_equal (mm_plugin_get_name (filters), MM_PLUGIN_GENERIC_NAME)) {
+        g_object_unref (filters);
+        return FALSE;
+    }
+
+    pending = g_slice_new0 (PendingPlugin);
+    pending->path = g_strdup (path);
+    pending->filters = filters;
+    self->priv->pending = g_list_append (self->priv->pending, pending);
+    return TRUE;
+}
+
+static gboolean
+load_plugins_from_dir (MMPluginManager  *self,
+                       GError          **error)
 {
     GDir *dir = NULL;
+    GKeyFile *manifest = NULL;
     const gchar *fname;
     gchar *plugindir_display = NULL;
 
@@ -1587,6 +1829,8 @@ load_plugins (MMPluginManager *self,
         goto out;
     }
 
+    manifest = load_manifest (self);
+
     while ((fname = g_dir_read_name (dir)) != NULL) {
         gchar *path;
         MMPlugin *plugin;
@@ -1595,46 +1839,84 @@ load_plugins (MMPluginManager *self,
             continue;
 
         path = g_module_build_path (self->priv->plugin_dir, fname);
+        if (manifest && track_pending_plugin (self, manifest, fname, path)) {
+            g_free (path);
+            continue;
+        }
         plugin = load_plugin (path);
         g_free (path);
 
         if (!plugin)
             continue;
 
-        mm_dbg ("[plugin manager] loaded plugin '%s'", mm_plugin_get_name (plugin));
-
-        if (g_str_equal (mm_plugin_get_name (plugin), MM_PLUGIN_GENERIC_NAME))
-            /* Generic plugin */
-            self->priv->generic = plugin;
-        else
-            /* Vendor specific plugin */
-            self->priv->plugins = g_list_append (self->priv->plugins, plugin);
+        track_plugin (self, plugin);
     }
 
+out:
+    if (manifest)
+        g_key_file_free (manifest);
+    if (dir)
+        g_dir_close (dir);
+    g_free (plugindir_display);
+
+    return (dir != NULL);
+}
+
+#endif /* !WITH_BUILTIN_PLUGINS */
+
+static gboolean
+load_plugins (MMPluginManager *self,
+              GError **error)
+{
+    GTimer *timer;
+    gboolean loaded;
+
+    timer = g_timer_new ();
+
+#if defined WITH_BUILTIN_PLUGINS
+    loaded = load_plugins_from_table (self, error);
+#else
+    loaded = load_plugins_from_dir (self, error);
+#endif
+
+    if (!loaded)
+        goto out;
+
     /* Check the generic plugin once all looped */
     if (!self->priv->generic)
         mm_warn ("[plugin manager] generic plugin not loaded");
 
     /* Treat as error if we don't find any plugin */
-    if (!self->priv->plugins && !self->priv->generic) {
+    if (!self->priv->plugins && !self->priv->generic && !self->priv->pending) {
+#if defined WITH_BUILTIN_PLUGINS
+        g_set_error (error,
+                     MM_CORE_ERROR,
+                     MM_CORE_ERROR_NO_PLUGINS,
+                     "no builtin plugins found");
+#else
+        gchar *plugindir_display;
+
+        plugindir_display = g_filename_display_name (self->priv->plugin_dir);
         g_set_error (error,
                      MM_CORE_ERROR,
                      MM_CORE_ERROR_NO_PLUGINS,
                      "no plugins found in plugin directory '%s'",
                      plugindir_display);
+        g_free (plugindir_display);
+#endif
         goto out;
     }
 
-    mm_dbg ("[plugin manager] successfully loaded %u plugins",
-            g_list_length (self->priv->plugins) + !!self->priv->generic);
+    mm_dbg ("[plugin manager] successfully loaded %u plugins in %.3lf ms (%u more on demand)",
+            g_list_length (self->priv->plugins) + !!self->priv->generic,
+            g_timer_elapsed (timer, NULL) * 1000.0,
+            g_list_length (self->priv->pending));
 
 out:
-    if (dir)
-        g_dir_close (dir);
-    g_free (plugindir_display);
+    g_timer_destroy (timer);
 
     /* Return TRUE if at least one plugin found */
-    return (self->priv->plugins || self->priv->generic);
+    return (self->priv->plugins || self->priv->generic || self->priv->pending);
 }
 
 MMPluginManager *
@@ -1722,6 +2004,10 @@ dispose (GObject *object)
         self->priv->plugins = NULL;
     }
     g_clear_object (&self->priv->generic);
+    if (self->priv->pending) {
+        g_list_free_full (self->priv->pending, (GDestroyNotify) pending_plugin_free);
+        self->priv->pending = NULL;
+    }
 
     g_free (self->priv->plugin_dir);
     self->priv->plugin_dir = NULL;
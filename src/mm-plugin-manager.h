@@ -63,5 +63,8 @@ MMPlugin *       mm_plugin_manager_device_support_check_finish (MMPluginManager
                                                                 GError              **error);
 MMPlugin        *mm_plugin_manager_peek_plugin                 (MMPluginManager      *self,
                                                                 const gchar          *plugin_name);
+gboolean         mm_plugin_manager_write_manifest              (MMPluginManager      *self,
+                                                                const gchar          *path,
+                                                                GError              **error);
 
 #endif /* MM_PLUGIN_MANAGER_H */
@@ -964,6 +964,11 @@ mm_plugin_create_modem (MMPlugin  *self,
             GError                  *inner_error = NULL;
             MMKernelDevice          *kernel_device;
             MMKernelEventProperties *properties;
+            MMPortSerialAtFlag       flags;
+
+            /* The first port is the primary one, any other is an additional
+             * data port */
+            flags = (i == 0 ? MM_PORT_SERIAL_AT_FLAG_PRIMARY : MM_PORT_SERIAL_AT_FLAG_PPP);
 
             properties = mm_kernel_event_properties_new ();
             mm_kernel_event_properties_set_action (properties, "add");
@@ -982,7 +987,7 @@ mm_plugin_create_modem (MMPlugin  *self,
             } else if (!mm_base_modem_grab_port (modem,
                                                  kernel_device,
                                                  MM_PORT_TYPE_AT,
-                                                 MM_PORT_SERIAL_AT_FLAG_NONE,
+                                                 flags,
                                                  &inner_error)) {
                 mm_warn ("Could not grab port (virtual/%s): '%s'",
                          virtual_ports[i],
@@ -1003,6 +1008,181 @@ mm_plugin_create_modem (MMPlugin  *self,
     return modem;
 }
 
+/*****************************************************************************/
+/* Plugin manifest support
+ *
+ * The pre-probing filters of each plugin may be stored in a manifest, so that
+ * the plugin manager can decide whether a plugin needs to be loaded at all
+ * without opening its module. The filters are loaded into a plain MMPlugin
+ * which is only ever used with mm_plugin_discard_port_early(). Only the
+ * presence of the vendor and product string filters matters for that check,
+ * so those are stored just as a flag.
+ */
+
+#define MANIFEST_KEY_STRING_FILTERS "string-filters"
+
+static void
+manifest_set_uint16_pair_array (GKeyFile             *manifest,
+                                const gchar          *group,
+                                const gchar          *key,
+                                const mm_uint16_pair *array)
+{
+    GPtrArray *list;
+    guint      i;
+
+    list = g_ptr_array_new_with_free_func (g_free);
+    for (i = 0; array[i].l; i++)
+        g_ptr_array_add (list, g_strdup_printf ("%04x:%04x", array[i].l, array[i].r));
+    g_key_file_set_string_list (manifest, group, key, (const gchar * const *) list->pdata, list->len);
+    g_ptr_array_unref (list);
+}
+
+static gboolean
+manifest_get_uint16_pair_array (GKeyFile        *manifest,
+                                const gchar     *group,
+                                const gchar     *key,
+                                mm_uint16_pair **out)
+{
+    gchar          **list;
+    gsize            n_items = 0;
+    mm_uint16_pair  *array;
+    guint            i;
+
+    list = g_key_file_get_string_list (manifest, group, key, &n_items, NULL);
+    if (!list)
+        return TRUE;
+
+    array = g_new0 (mm_uint16_pair, n_items + 1);
+    for (i = 0; i < n_items; i++) {
+        guint l, r;
+
+        if (sscanf (list[i], "%04x:%04x", &l, &r) != 2 || !l || l > G_MAXUINT16 || r > G_MAXUINT16) {
+            g_free (array);
+            g_strfreev (list);
+            return FALSE;
+        }
+        array[i].l = (guint16) l;
+        array[i].r = (guint16) r;
+    }
+    g_strfreev (list);
+
+    *out = array;
+    return TRUE;
+}
+
+void
+mm_plugin_write_manifest_filters (MMPlugin    *self,
+                                  GKeyFile    *manifest,
+                                  const gchar *group)
+{
+    g_key_file_set_string (manifest, group, MM_PLUGIN_NAME, self->priv->name);
+
+#define SET_STRV(key, value)                                            \
+    if (value)                                                          \
+        g_key_file_set_string_list (manifest, group, key,               \
+                                    (const gchar * const *) value,      \
+                                    g_strv_length (value))
+
+    SET_STRV (MM_PLUGIN_ALLOWED_SUBSYSTEMS, self->priv->subsystems);
+    SET_STRV (MM_PLUGIN_ALLOWED_DRIVERS,    self->priv->drivers);
+    SET_STRV (MM_PLUGIN_FORBIDDEN_DRIVERS,  self->priv->forbidden_drivers);
+    SET_STRV (MM_PLUGIN_ALLOWED_UDEV_TAGS,  self->priv->udev_tags);
+
+#undef SET_STRV
+
+    if (self->priv->vendor_ids) {
+        GPtrArray *list;
+        guint      i;
+
+        list = g_ptr_array_new_with_free_func (g_free);
+        for (i = 0; self->priv->vendor_ids[i]; i++)
+            g_ptr_array_add (list, g_strdup_printf ("%04x", self->priv->vendor_ids[i]));
+        g_key_file_set_string_list (manifest, group, MM_PLUGIN_ALLOWED_VENDOR_IDS,
+                                    (const gchar * const *) list->pdata, list->len);
+        g_ptr_array_unref (list);
+    }
+
+    if (self->priv->product_ids)
+        manifest_set_uint16_pair_array (manifest, group, MM_PLUGIN_ALLOWED_PRODUCT_IDS, self->priv->product_ids);
+    if (self->priv->forbidden_product_ids)
+        manifest_set_uint16_pair_array (manifest, group, MM_PLUGIN_FORBIDDEN_PRODUCT_IDS, self->priv->forbidden_product_ids);
+
+    g_key_file_set_boolean (manifest, group, MM_PLUGIN_ALLOWED_QMI,  self->priv->qmi);
+    g_key_file_set_boolean (manifest, group, MM_PLUGIN_ALLOWED_MBIM, self->priv->mbim);
+    g_key_file_set_boolean (manifest, group, MANIFEST_KEY_STRING_FILTERS,
+                            (self->priv->vendor_strings ||
+                             self->priv->product_strings ||
+                             self->priv->forbidden_product_strings));
+}
+
+MMPlugin *
+mm_plugin_new_from_manifest_filters (GKeyFile     *manifest,
+                                     const gchar  *group,
+                                     GError      **error)
+{
+    MMPlugin *self;
+    gchar    *name;
+    gchar   **vendor_ids;
+    gsize     n_vendor_ids = 0;
+
+    name = g_key_file_get_string (manifest, group, MM_PLUGIN_NAME, error);
+    if (!name)
+        return NULL;
+
+    self = MM_PLUGIN (g_object_new (MM_TYPE_PLUGIN,
+                                    MM_PLUGIN_NAME, name,
+                                    NULL));
+    g_free (name);
+
+    self->priv->subsystems        = g_key_file_get_string_list (manifest, group, MM_PLUGIN_ALLOWED_SUBSYSTEMS, NULL, NULL);
+    self->priv->drivers           = g_key_file_get_string_list (manifest, group, MM_PLUGIN_ALLOWED_DRIVERS,    NULL, NULL);
+    self->priv->forbidden_drivers = g_key_file_get_string_list (manifest, group, MM_PLUGIN_FORBIDDEN_DRIVERS,  NULL, NULL);
+    self->priv->udev_tags         = g_key_file_get_string_list (manifest, group, MM_PLUGIN_ALLOWED_UDEV_TAGS,  NULL, NULL);
+
+    vendor_ids = g_key_file_get_string_list (manifest, group, MM_PLUGIN_ALLOWED_VENDOR_IDS, &n_vendor_ids, NULL);
+    if (vendor_ids) {
+        guint i;
+
+        self->priv->vendor_ids = g_new0 (guint16, n_vendor_ids + 1);
+        for (i = 0; i < n_vendor_ids; i++) {
+            guint vid;
+
+            if (sscanf (vendor_ids[i], "%04x", &vid) != 1 || !vid || vid > G_MAXUINT16) {
+                g_strfreev (vendor_ids);
+                goto invalid;
+            }
+            self->priv->vendor_ids[i] = (guint16) vid;
+        }
+        g_strfreev (vendor_ids);
+    }
+
+    if (!manifest_get_uint16_pair_array (manifest, group, MM_PLUGIN_ALLOWED_PRODUCT_IDS, &self->priv->product_ids) ||
+        !manifest_get_uint16_pair_array (manifest, group, MM_PLUGIN_FORBIDDEN_PRODUCT_IDS, &self->priv->forbidden_product_ids))
+        goto invalid;
+
+    /* A missing key would read as FALSE, which for these is the most
+     * restrictive value; so require them explicitly */
+    if (!g_key_file_has_key (manifest, group, MM_PLUGIN_ALLOWED_QMI, NULL) ||
+        !g_key_file_has_key (manifest, group, MM_PLUGIN_ALLOWED_MBIM, NULL) ||
+        !g_key_file_has_key (manifest, group, MANIFEST_KEY_STRING_FILTERS, NULL))
+        goto invalid;
+
+    self->priv->qmi  = g_key_file_get_boolean (manifest, group, MM_PLUGIN_ALLOWED_QMI,  NULL);
+    self->priv->mbim = g_key_file_get_boolean (manifest, group, MM_PLUGIN_ALLOWED_MBIM, NULL);
+
+    /* An empty list of vendor strings is enough to flag the string filters */
+    if (g_key_file_get_boolean (manifest, group, MANIFEST_KEY_STRING_FILTERS, NULL))
+        self->priv->vendor_strings = g_new0 (gchar *, 1);
+
+    return self;
+
+invalid:
+    g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                 "invalid filters for plugin '%s' in manifest", self->priv->name);
+    g_object_unref (self);
+    return NULL;
+}
+
 /*****************************************************************************/
 
 static void
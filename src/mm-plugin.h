@@ -37,8 +37,18 @@
 #define VISIBILITY
 #endif
 
-#define MM_PLUGIN_DEFINE_MAJOR_VERSION VISIBILITY int mm_plugin_major_version = MM_PLUGIN_MAJOR_VERSION;
-#define MM_PLUGIN_DEFINE_MINOR_VERSION VISIBILITY int mm_plugin_minor_version = MM_PLUGIN_MINOR_VERSION;
+/* When plugins are built into the daemon there is no module to validate, and
+ * each plugin exposes a creator named after itself, which is referenced from
+ * the static builtin plugins table. */
+#if defined WITH_BUILTIN_PLUGINS
+# define MM_PLUGIN_DEFINE_MAJOR_VERSION
+# define MM_PLUGIN_DEFINE_MINOR_VERSION
+# define MM_PLUGIN_CREATE(name) mm_plugin_create_##name
+#else
+# define MM_PLUGIN_DEFINE_MAJOR_VERSION VISIBILITY int mm_plugin_major_version = MM_PLUGIN_MAJOR_VERSION;
+# define MM_PLUGIN_DEFINE_MINOR_VERSION VISIBILITY int mm_plugin_minor_version = MM_PLUGIN_MINOR_VERSION;
+# define MM_PLUGIN_CREATE(name) mm_plugin_create
+#endif
 
 #define MM_TYPE_PLUGIN            (mm_plugin_get_type ())
 #define MM_PLUGIN(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), MM_TYPE_PLUGIN, MMPlugin))
@@ -93,6 +103,11 @@ typedef struct _MMPluginPrivate MMPluginPrivate;
 
 typedef MMPlugin *(*MMPluginCreateFunc) (void);
 
+#if defined WITH_BUILTIN_PLUGINS
+/* NULL-terminated table of plugin creators, provided by the plugins library */
+extern const MMPluginCreateFunc mm_builtin_plugins[];
+#endif
+
 struct _MMPlugin {
     GObject parent;
     MMPluginPrivate *priv;
@@ -143,4 +158,12 @@ MMBaseModem *mm_plugin_create_modem (MMPlugin *plugin,
                                      MMDevice *device,
                                      GError **error);
 
+/* Pre-probing filters stored in the plugin manifest */
+void      mm_plugin_write_manifest_filters    (MMPlugin     *plugin,
+                                               GKeyFile     *manifest,
+                                               const gchar  *group);
+MMPlugin *mm_plugin_new_from_manifest_filters (GKeyFile     *manifest,
+                                               const gchar  *group,
+                                               GError      **error);
+
 #endif /* MM_PLUGIN_H */
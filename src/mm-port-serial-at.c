@@ -35,6 +35,14 @@ enum {
     LAST_PROP
 };
 
+typedef struct {
+    GRegex *regex;
+    MMPortSerialAtUnsolicitedMsgFn callback;
+    gboolean enable;
+    gpointer user_data;
+    GDestroyNotify notify;
+} MMAtUnsolicitedMsgHandler;
+
 struct _MMPortSerialAtPrivate {
     /* Response parser data */
     MMPortSerialAtResponseParserFn response_parser_fn;
@@ -43,6 +51,9 @@ struct _MMPortSerialAtPrivate {
 
     GSList *unsolicited_msg_handlers;
 
+    /* Handler for the entries of streamed responses */
+    MMAtUnsolicitedMsgHandler *response_entry_handler;
+
     MMPortSerialAtFlag flags;
 
     /* Properties */
@@ -170,13 +181,15 @@ parse_response (MMPortSerial *port,
 
 /*****************************************************************************/
 
-typedef struct {
-    GRegex *regex;
-    MMPortSerialAtUnsolicitedMsgFn callback;
-    gboolean enable;
-    gpointer user_data;
-    GDestroyNotify notify;
-} MMAtUnsolicitedMsgHandler;
+static void
+unsolicited_msg_handler_free (MMAtUnsolicitedMsgHandler *handler)
+{
+    if (handler->notify)
+        handler->notify (handler->user_data);
+
+    g_regex_unref (handler->regex);
+    g_slice_free (MMAtUnsolicitedMsgHandler, handler);
+}
 
 static gint
 unsolicited_msg_handler_cmp (MMAtUnsolicitedMsgHandler *handler,
@@ -242,6 +255,31 @@ mm_port_serial_at_enable_unsolicited_msg_handler (MMPortSerialAt *self,
     }
 }
 
+void
+mm_port_serial_at_set_response_entry_handler (MMPortSerialAt *self,
+                                              GRegex *regex,
+                                              MMPortSerialAtUnsolicitedMsgFn callback,
+                                              gpointer user_data,
+                                              GDestroyNotify notify)
+{
+    g_return_if_fail (MM_IS_PORT_SERIAL_AT (self));
+
+    if (self->priv->response_entry_handler) {
+        unsolicited_msg_handler_free (self->priv->response_entry_handler);
+        self->priv->response_entry_handler = NULL;
+    }
+
+    if (!regex)
+        return;
+
+    self->priv->response_entry_handler = g_slice_new (MMAtUnsolicitedMsgHandler);
+    self->priv->response_entry_handler->regex = g_regex_ref (regex);
+    self->priv->response_entry_handler->callback = callback;
+    self->priv->response_entry_handler->enable = TRUE;
+    self->priv->response_entry_handler->user_data = user_data;
+    self->priv->response_entry_handler->notify = notify;
+}
+
 static gboolean
 remove_eval_cb (const GMatchInfo *match_info,
                 GString *result,
@@ -257,6 +295,44 @@ remove_eval_cb (const GMatchInfo *match_info,
     return FALSE;
 }
 
+static void
+process_msg_handler (MMPortSerialAt *self,
+                     MMAtUnsolicitedMsgHandler *handler,
+                     GByteArray *response)
+{
+    GMatchInfo *match_info;
+    gboolean matches;
+
+    matches = g_regex_match_full (handler->regex,
+                                  (const char *) response->data,
+                                  response->len,
+                                  0, 0, &match_info, NULL);
+    if (handler->callback) {
+        while (g_match_info_matches (match_info)) {
+            handler->callback (self, match_info, handler->user_data);
+            g_match_info_next (match_info, NULL);
+        }
+    }
+
+    g_match_info_free (match_info);
+
+    if (matches) {
+        /* Remove matches */
+        char *str;
+        int result_len = response->len;
+
+        str = g_regex_replace_eval (handler->regex,
+                                    (const char *) response->data,
+                                    response->len,
+                                    0, 0,
+                                    remove_eval_cb, &result_len, NULL);
+
+        g_byte_array_remove_range (response, 0, response->len);
+        g_byte_array_append (response, (const guint8 *) str, result_len);
+        g_free (str);
+    }
+}
+
 static void
 parse_unsolicited (MMPortSerial *port, GByteArray *response)
 {
@@ -269,41 +345,15 @@ parse_unsolicited (MMPortSerial *port, GByteArray *response)
 
     for (iter = self->priv->unsolicited_msg_handlers; iter; iter = iter->next) {
         MMAtUnsolicitedMsgHandler *handler = (MMAtUnsolicitedMsgHandler *) iter->data;
-        GMatchInfo *match_info;
-        gboolean matches;
-
-        if (!handler->enable)
-            continue;
-
-        matches = g_regex_match_full (handler->regex,
-                                      (const char *) response->data,
-                                      response->len,
-                                      0, 0, &match_info, NULL);
-        if (handler->callback) {
-            while (g_match_info_matches (match_info)) {
-                handler->callback (self, match_info, handler->user_data);
-                g_match_info_next (match_info, NULL);
-            }
-        }
-
-        g_match_info_free (match_info);
 
-        if (matches) {
-            /* Remove matches */
-            char *str;
-            int result_len = response->len;
-
-            str = g_regex_replace_eval (handler->regex,
-                                        (const char *) response->data,
-                                        response->len,
-                                        0, 0,
-                                        remove_eval_cb, &result_len, NULL);
-
-            g_byte_array_remove_range (response, 0, response->len);
-            g_byte_array_append (response, (const guint8 *) str, result_len);
-            g_free (str);
-        }
+        if (handler->enable)
+            process_msg_handler (self, handler, response);
     }
+
+    /* Complete entries of a streamed response are also reported and removed
+     * right away, so that they don't pile up in the response buffer */
+    if (self->priv->response_entry_handler)
+        process_msg_handler (self, self->priv->response_entry_handler, response);
 }
 
 /*****************************************************************************/
@@ -612,17 +662,14 @@ finalize (GObject *object)
     MMPortSerialAt *self = MM_PORT_SERIAL_AT (object);
 
     while (self->priv->unsolicited_msg_handlers) {
-        MMAtUnsolicitedMsgHandler *handler = (MMAtUnsolicitedMsgHandler *) self->priv->unsolicited_msg_handlers->data;
-
-        if (handler->notify)
-            handler->notify (handler->user_data);
-
-        g_regex_unref (handler->regex);
-        g_slice_free (MMAtUnsolicitedMsgHandler, handler);
+        unsolicited_msg_handler_free ((MMAtUnsolicitedMsgHandler *) self->priv->unsolicited_msg_handlers->data);
         self->priv->unsolicited_msg_handlers = g_slist_delete_link (self->priv->unsolicited_msg_handlers,
                                                                     self->priv->unsolicited_msg_handlers);
     }
 
+    if (self->priv->response_entry_handler)
+        unsolicited_msg_handler_free (self->priv->response_entry_handler);
+
     if (self->priv->response_parser_notify)
         self->priv->response_parser_notify (self->priv->response_parser_user_data);
 
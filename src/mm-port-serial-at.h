@@ -90,6 +90,16 @@ void     mm_port_serial_at_enable_unsolicited_msg_handler (MMPortSerialAt *self,
                                                            GRegex *regex,
                                                            gboolean enable);
 
+/* While set, complete entries of the responses matching the given regex are
+ * reported with the callback as soon as they're received, and removed from
+ * the response, e.g. to process long listings as they arrive. It's meant to
+ * be set right before the command and cleared (NULL regex) right after. */
+void     mm_port_serial_at_set_response_entry_handler (MMPortSerialAt *self,
+                                                       GRegex *regex,
+                                                       MMPortSerialAtUnsolicitedMsgFn callback,
+                                                       gpointer user_data,
+                                                       GDestroyNotify notify);
+
 void     mm_port_serial_at_set_response_parser (MMPortSerialAt *self,
                                                 MMPortSerialAtResponseParserFn fn,
                                                 gpointer user_data,
@@ -33,108 +33,200 @@ G_DEFINE_TYPE (MMPortSerialQcdm, mm_port_serial_qcdm, MM_TYPE_PORT_SERIAL)
 
 struct _MMPortSerialQcdmPrivate {
     GSList *unsolicited_msg_handlers;
+
+    /* Streaming deframer: number of bytes at the start of the response buffer
+     * already known not to contain a frame marker. Frames are unescaped in
+     * place in the response buffer; only log frames for the unsolicited
+     * message handlers get copied, into a buffer reused for every frame. */
+    gsize       scan_offset;
+    GByteArray *frame;
+
+    /* Batched log consumer. Pending records refer to their payloads by
+     * offset into a single arena, which may be reallocated while queueing. */
+    MMPortSerialQcdmLogBatchFn log_consumer;
+    gpointer                   log_consumer_user_data;
+    GDestroyNotify             log_consumer_notify;
+    guint                      log_max_pending;
+    gboolean                   log_paused;
+    guint                      log_n_dropped;
+    guint                      log_resume_id;
+    GArray                    *log_pending;
+    GByteArray                *log_payloads;
+    GArray                    *log_batch;
+
+    /* Commands sent and not yet completed, oldest first, so that the one
+     * being replied to is always the head */
+    GQueue *commands;
 };
 
+/* Per-command context, used to match batched responses */
+typedef struct {
+    /* Unescaped commands of a batch, or NULL for single commands, whose
+     * response is just the next non-log frame */
+    GPtrArray *commands;
+    GPtrArray *responses;
+    guint      n_missing;
+} CommandContext;
+
+typedef struct {
+    guint16 log_code;
+    guint64 timestamp;
+    gsize   payload_offset;
+    gsize   payload_len;
+} PendingLog;
+
 /*****************************************************************************/
 
+static void dispatch_log (MMPortSerialQcdm *self,
+                          const guint8 *log,
+                          gsize log_len);
+static void queue_log    (MMPortSerialQcdm *self,
+                          const guint8 *log,
+                          gsize log_len);
+static void flush_logs   (MMPortSerialQcdm *self);
+static gboolean batch_take_response (CommandContext *ctx,
+                                     const guint8 *response,
+                                     gsize response_len);
+
+/* Unescapes and CRC-checks, in place, the frame of @frame_len bytes
+ * (including the trailing marker) at @start. */
 static gboolean
-find_qcdm_start (GByteArray *response, gsize *start)
-{
-    int i, last = -1;
-
-    /* Look for 3 bytes and a QCDM frame marker, ie enough data for a valid
-     * frame.  There will usually be three cases here; (1) a QCDM frame
-     * starting with data and terminated by 0x7E, and (2) a QCDM frame starting
-     * with 0x7E and ending with 0x7E, and (3) a non-QCDM frame that still
-     * uses HDLC framing (like Sierra CnS) that starts and ends with 0x7E.
-     */
-    for (i = 0; i < response->len; i++) {
-        if (response->data[i] == 0x7E) {
-            if (i > last + 3) {
-                /* Got a full QCDM frame; 3 non-0x7E bytes and a terminator */
-                if (start)
-                    *start = last + 1;
-                return TRUE;
-            }
+decode_frame (guint8 *start,
+              gsize frame_len,
+              gsize *out_len)
+{
+    gsize used = 0;
+    qcdmbool more = FALSE;
 
-            /* Save position of the last QCDM frame marker */
-            last = i;
-        }
-    }
-    return FALSE;
+    *out_len = 0;
+    return (dm_decapsulate_buffer ((const char *) start,
+                                   frame_len,
+                                   (char *) start,
+                                   frame_len,
+                                   out_len,
+                                   &used,
+                                   &more) &&
+            !more &&
+            *out_len > 0);
 }
 
+/* Extracts every complete frame available in @buffer: log frames are
+ * dispatched to the unsolicited message handlers right away, and the first
+ * non-log frame (if @parsed_response given) is returned as the response.
+ * When a batch is being replied to, non-log frames are instead collected
+ * until all of its responses are there. Any non-log frame found afterwards
+ * is left in the buffer for the next call. All the consumed data is removed
+ * from @buffer at once. */
 static MMPortSerialResponseType
-parse_qcdm (GByteArray *response,
-            gboolean want_log,
+parse_qcdm (MMPortSerialQcdm *self,
+            GByteArray *buffer,
             GByteArray **parsed_response,
             GError **error)
 {
-    gsize start = 0;
-    gsize used = 0;
-    gsize unescaped_len = 0;
-    guint8 *unescaped_buffer;
-    qcdmbool more = FALSE;
+    MMPortSerialResponseType result = MM_PORT_SERIAL_RESPONSE_NONE;
+    gsize consumed = 0;
+
+    /* Data removed from the buffer is reported with response_buffer_reset() */
+    g_assert (self->priv->scan_offset <= buffer->len);
+
+    while (consumed < buffer->len) {
+        guint8 *start;
+        const guint8 *marker;
+        gsize available;
+        gsize frame_len;
+        gsize decoded_len;
+        gboolean is_log;
+        CommandContext *ctx;
+
+        start = &buffer->data[consumed];
+        available = buffer->len - consumed;
+
+        /* Resume the scan for the frame marker where the previous one left */
+        marker = memchr (start + self->priv->scan_offset,
+                         DIAG_CONTROL_CHAR,
+                         available - self->priv->scan_offset);
+        if (!marker) {
+            self->priv->scan_offset = available;
+            break;
+        }
+        frame_len = marker - start + 1;
+        self->priv->scan_offset = 0;
 
-    /* Get the offset into the buffer of where the QCDM frame starts */
-    if (!find_qcdm_start (response, &start)) {
-        /* Discard the unparsable data right away, we do need a QCDM
-         * start, and anything that comes before it is unknown data
-         * that we'll never use. */
-        return MM_PORT_SERIAL_RESPONSE_NONE;
-    }
+        /* Need 3 bytes and a frame marker for a valid frame; anything shorter
+         * is just a leading marker or noise */
+        if (frame_len < 4) {
+            consumed += frame_len;
+            continue;
+        }
 
-    /* If there is anything before the start marker, remove it */
-    g_byte_array_remove_range (response, 0, start);
-    if (response->len == 0)
-        return MM_PORT_SERIAL_RESPONSE_NONE;
-
-    /* Try to decapsulate the response into a buffer */
-    unescaped_buffer = g_malloc (1024);
-    if (!dm_decapsulate_buffer ((const char *)(response->data),
-                                response->len,
-                                (char *)unescaped_buffer,
-                                1024,
-                                &unescaped_len,
-                                &used,
-                                &more)) {
-        /* Report an error right away. Not being able to decapsulate a QCDM
-         * packet once we got message start marker likely means that this
-         * data that we got is not a QCDM message. */
-        g_set_error (error,
-                     MM_SERIAL_ERROR,
-                     MM_SERIAL_ERROR_PARSE_FAILED,
-                     "Failed to unescape QCDM packet");
-        g_free (unescaped_buffer);
-        return MM_PORT_SERIAL_RESPONSE_ERROR;
-    }
+        /* Log frames are never escaped in their first byte */
+        is_log = (start[0] == DIAG_CMD_LOG);
+        if (!is_log && (!parsed_response || result != MM_PORT_SERIAL_RESPONSE_NONE)) {
+            /* Keep it for later, without scanning it again */
+            self->priv->scan_offset = frame_len - 1;
+            break;
+        }
+        consumed += frame_len;
 
-    if (more) {
-        /* Need more data, we leave the original byte array untouched so that
-         * we can retry later when more data arrives. */
-        g_free (unescaped_buffer);
-        return MM_PORT_SERIAL_RESPONSE_NONE;
-    }
+        if (!decode_frame (start, frame_len, &decoded_len)) {
+            if (is_log) {
+                mm_dbg ("(%s): discarding invalid QCDM log frame",
+                        mm_port_get_device (MM_PORT (self)));
+                continue;
+            }
 
-    if (want_log && unescaped_buffer[0] != DIAG_CMD_LOG) {
-        /* If we only want log items and this isn't one, don't remove this
-         * DM packet from the buffer.
-         */
-        g_free (unescaped_buffer);
-        return MM_PORT_SERIAL_RESPONSE_NONE;
+            /* Not being able to decapsulate a QCDM packet once we got the
+             * message end marker likely means that this data that we got is
+             * not a QCDM message. */
+            g_set_error (error,
+                         MM_SERIAL_ERROR,
+                         MM_SERIAL_ERROR_PARSE_FAILED,
+                         "Failed to unescape QCDM packet");
+            result = MM_PORT_SERIAL_RESPONSE_ERROR;
+            continue;
+        }
+
+        if (is_log) {
+            queue_log (self, start, decoded_len);
+            dispatch_log (self, start, decoded_len);
+            continue;
+        }
+
+        ctx = g_queue_peek_head (self->priv->commands);
+        if (ctx && ctx->commands) {
+            if (!batch_take_response (ctx, start, decoded_len)) {
+                mm_dbg ("(%s): discarding unexpected QCDM response (0x%02x)",
+                        mm_port_get_device (MM_PORT (self)), start[0]);
+                continue;
+            }
+            if (ctx->n_missing > 0)
+                continue;
+
+            /* The responses themselves are already in the context */
+            *parsed_response = g_byte_array_new ();
+        } else {
+            /* The response needs a copy of its own */
+            *parsed_response = g_byte_array_sized_new (decoded_len);
+            g_byte_array_append (*parsed_response, start, decoded_len);
+        }
+        result = MM_PORT_SERIAL_RESPONSE_BUFFER;
     }
 
-    /* Successfully decapsulated the DM command. We'll build a new byte array
-     * with the response, and leave the input buffer cleaned up. */
-    g_assert (unescaped_len <= 1024);
-    unescaped_buffer = g_realloc (unescaped_buffer, unescaped_len);
-    *parsed_response = g_byte_array_new_take (unescaped_buffer, unescaped_len);
+    if (consumed > 0)
+        g_byte_array_remove_range (buffer, 0, consumed);
+
+    /* One batch per read */
+    if (!self->priv->log_paused)
+        flush_logs (self);
 
-    /* Remove the data we used from the input buffer, leaving out any
-     * additional data that may already been received (e.g. from the following
-     * message). */
-    g_byte_array_remove_range (response, 0, used);
-    return MM_PORT_SERIAL_RESPONSE_BUFFER;
+    return result;
+}
+
+static void
+response_buffer_reset (MMPortSerial *port)
+{
+    /* Data removed from the buffer may have been scanned already */
+    MM_PORT_SERIAL_QCDM (port)->priv->scan_offset = 0;
 }
 
 static MMPortSerialResponseType
@@ -143,11 +235,42 @@ parse_response (MMPortSerial *port,
                 GByteArray **parsed_response,
                 GError **error)
 {
-    return parse_qcdm (response, FALSE, parsed_response, error);
+    return parse_qcdm (MM_PORT_SERIAL_QCDM (port), response, parsed_response, error);
 }
 
 /*****************************************************************************/
 
+/* Missing responses are left as NULL in the array */
+static void
+response_free (GByteArray *response)
+{
+    if (response)
+        g_byte_array_unref (response);
+}
+
+static void
+command_context_free (CommandContext *ctx)
+{
+    if (ctx->commands)
+        g_ptr_array_unref (ctx->commands);
+    if (ctx->responses)
+        g_ptr_array_unref (ctx->responses);
+    g_slice_free (CommandContext, ctx);
+}
+
+/* Takes the context of a completed command out of the queue */
+static CommandContext *
+command_context_finish (MMPortSerialQcdm *self,
+                        GTask *task)
+{
+    CommandContext *ctx;
+
+    ctx = g_task_get_task_data (task);
+    g_queue_remove (self->priv->commands, ctx);
+    g_task_set_task_data (task, NULL, NULL);
+    return ctx;
+}
+
 GByteArray *
 mm_port_serial_qcdm_command_finish (MMPortSerialQcdm *self,
                                     GAsyncResult *res,
@@ -164,6 +287,8 @@ serial_command_ready (MMPortSerial *port,
     GByteArray *response;
     GError *error = NULL;
 
+    command_context_free (command_context_finish (MM_PORT_SERIAL_QCDM (port), task));
+
     response = mm_port_serial_command_finish (port, res, &error);
     if (!response)
         g_task_return_error (task, error);
@@ -182,12 +307,17 @@ mm_port_serial_qcdm_command (MMPortSerialQcdm *self,
                              gpointer user_data)
 {
     GTask *task;
+    CommandContext *ctx;
 
     g_return_if_fail (MM_IS_PORT_SERIAL_QCDM (self));
     g_return_if_fail (command != NULL);
 
     task = g_task_new (self, cancellable, callback, user_data);
 
+    ctx = g_slice_new0 (CommandContext);
+    g_task_set_task_data (task, ctx, NULL);
+    g_queue_push_tail (self->priv->commands, ctx);
+
     /* 'command' is expected to be already CRC-ed and escaped */
     mm_port_serial_command (MM_PORT_SERIAL (self),
                             command,
@@ -198,6 +328,173 @@ mm_port_serial_qcdm_command (MMPortSerialQcdm *self,
                             task);
 }
 
+/*****************************************************************************/
+/* Batched commands */
+
+/* Whether @response replies to @command. Most responses just echo the command
+ * code, subsystem ones also the subsystem ID and command; and some of the
+ * error responses echo the whole command after their own code. */
+static gboolean
+response_matches_command (const guint8 *response,
+                          gsize response_len,
+                          const GByteArray *command)
+{
+    gsize n;
+
+    switch (response[0]) {
+    case DIAG_CMD_BAD_CMD:
+    case DIAG_CMD_BAD_PARM:
+    case DIAG_CMD_BAD_LEN:
+    case DIAG_CMD_BAD_DEV:
+    case DIAG_CMD_BAD_MODE:
+        response++;
+        response_len--;
+        break;
+    default:
+        break;
+    }
+
+    n = (command->data[0] == DIAG_CMD_SUBSYS) ? sizeof (DMCmdSubsysHeader) : 1;
+    if (response_len < n || command->len < n)
+        return FALSE;
+    return memcmp (response, command->data, n) == 0;
+}
+
+static gboolean
+batch_take_response (CommandContext *ctx,
+                     const guint8 *response,
+                     gsize response_len)
+{
+    guint i;
+    guint first_missing = G_MAXUINT;
+
+    for (i = 0; i < ctx->commands->len; i++) {
+        if (g_ptr_array_index (ctx->responses, i))
+            continue;
+        if (first_missing == G_MAXUINT)
+            first_missing = i;
+        if (response_matches_command (response, response_len, g_ptr_array_index (ctx->commands, i)))
+            break;
+    }
+
+    if (i == ctx->commands->len) {
+        /* Errors not echoing the command can only be matched by order */
+        if (first_missing == G_MAXUINT ||
+            (response[0] != DIAG_CMD_BAD_SPC_MODE && response[0] != DIAG_CMD_BAD_SEC_MODE))
+            return FALSE;
+        i = first_missing;
+    }
+
+    g_ptr_array_index (ctx->responses, i) = g_byte_array_sized_new (response_len);
+    g_byte_array_append (g_ptr_array_index (ctx->responses, i), response, response_len);
+    ctx->n_missing--;
+    return TRUE;
+}
+
+GPtrArray *
+mm_port_serial_qcdm_command_batch_finish (MMPortSerialQcdm *self,
+                                          GAsyncResult *res,
+                                          GError **error)
+{
+    return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+static void
+serial_command_batch_ready (MMPortSerial *port,
+                            GAsyncResult *res,
+                            GTask *task)
+{
+    CommandContext *ctx;
+    GByteArray *response;
+    GError *error = NULL;
+
+    ctx = command_context_finish (MM_PORT_SERIAL_QCDM (port), task);
+
+    response = mm_port_serial_command_finish (port, res, &error);
+    if (!response) {
+        /* On timeout, report whatever responses arrived, if any */
+        if (g_error_matches (error, MM_SERIAL_ERROR, MM_SERIAL_ERROR_RESPONSE_TIMEOUT) &&
+            ctx->n_missing < ctx->commands->len) {
+            mm_dbg ("(%s): timed out waiting for %u QCDM responses out of %u in batch",
+                    mm_port_get_device (MM_PORT (port)), ctx->n_missing, ctx->commands->len);
+            g_task_return_pointer (task, g_ptr_array_ref (ctx->responses), (GDestroyNotify)g_ptr_array_unref);
+            g_error_free (error);
+        } else
+            g_task_return_error (task, error);
+    } else {
+        g_task_return_pointer (task, g_ptr_array_ref (ctx->responses), (GDestroyNotify)g_ptr_array_unref);
+        g_byte_array_unref (response);
+    }
+
+    command_context_free (ctx);
+    g_object_unref (task);
+}
+
+void
+mm_port_serial_qcdm_command_batch (MMPortSerialQcdm *self,
+                                   GPtrArray *commands,
+                                   guint32 timeout_seconds,
+                                   GCancellable *cancellable,
+                                   GAsyncReadyCallback callback,
+                                   gpointer user_data)
+{
+    GTask *task;
+    CommandContext *ctx;
+    GByteArray *batch;
+    guint i;
+
+    g_return_if_fail (MM_IS_PORT_SERIAL_QCDM (self));
+    g_return_if_fail (commands != NULL && commands->len > 0);
+
+    task = g_task_new (self, cancellable, callback, user_data);
+
+    ctx = g_slice_new0 (CommandContext);
+    ctx->commands = g_ptr_array_new_full (commands->len, (GDestroyNotify)g_byte_array_unref);
+    ctx->responses = g_ptr_array_new_full (commands->len, (GDestroyNotify)response_free);
+    g_ptr_array_set_size (ctx->responses, commands->len);
+    ctx->n_missing = commands->len;
+    g_task_set_task_data (task, ctx, NULL);
+
+    /* All commands go out in a single write; the unescaped ones are kept to
+     * match the responses against */
+    batch = g_byte_array_new ();
+    for (i = 0; i < commands->len; i++) {
+        GByteArray *command = g_ptr_array_index (commands, i);
+        GByteArray *decoded;
+        gsize decoded_len = 0;
+
+        decoded = g_byte_array_sized_new (command->len);
+        g_byte_array_append (decoded, command->data, command->len);
+        if (!decode_frame (decoded->data, decoded->len, &decoded_len)) {
+            g_byte_array_unref (decoded);
+            g_byte_array_unref (batch);
+            command_context_free (ctx);
+            g_task_set_task_data (task, NULL, NULL);
+            g_task_return_new_error (task,
+                                     MM_CORE_ERROR,
+                                     MM_CORE_ERROR_INVALID_ARGS,
+                                     "Invalid QCDM command in batch (#%u)", i);
+            g_object_unref (task);
+            return;
+        }
+        g_byte_array_set_size (decoded, decoded_len);
+        g_ptr_array_add (ctx->commands, decoded);
+
+        g_byte_array_append (batch, command->data, command->len);
+    }
+
+    g_queue_push_tail (self->priv->commands, ctx);
+
+    mm_port_serial_command (MM_PORT_SERIAL (self),
+                            batch,
+                            timeout_seconds,
+                            FALSE, /* never cached */
+                            cancellable,
+                            (GAsyncReadyCallback)serial_command_batch_ready,
+                            task);
+    g_byte_array_unref (batch);
+}
+
 static void
 debug_log (MMPortSerial *port, const char *prefix, const char *buf, gsize len)
 {
@@ -287,38 +584,176 @@ mm_port_serial_qcdm_enable_unsolicited_msg_handler (MMPortSerialQcdm *self,
 }
 
 static void
-parse_unsolicited (MMPortSerial *port, GByteArray *response)
+dispatch_log (MMPortSerialQcdm *self,
+              const guint8 *log,
+              gsize log_len)
 {
-    MMPortSerialQcdm *self = MM_PORT_SERIAL_QCDM (port);
-    GByteArray *log_buffer = NULL;
     GSList *iter;
+    guint16 log_code;
+    gboolean copied = FALSE;
 
-    if (parse_qcdm (response,
-                    TRUE,
-                    &log_buffer,
-                    NULL) != MM_PORT_SERIAL_RESPONSE_BUFFER) {
-        return;
-    }
-
-    /* These should be guaranteed by parse_qcdm() */
-    g_return_if_fail (log_buffer);
-    g_return_if_fail (log_buffer->len > 0);
-    g_return_if_fail (log_buffer->data[0] == DIAG_CMD_LOG);
-
-    if (log_buffer->len < sizeof (DMCmdLog))
+    if (log_len < sizeof (DMCmdLog))
         return;
 
+    log_code = le16toh (((const DMCmdLog *) log)->log_code);
     for (iter = self->priv->unsolicited_msg_handlers; iter; iter = iter->next) {
         MMQcdmUnsolicitedMsgHandler *handler = (MMQcdmUnsolicitedMsgHandler *) iter->data;
-        DMCmdLog *log_cmd = (DMCmdLog *) log_buffer->data;
 
         if (!handler->enable)
             continue;
-        if (handler->log_code != le16toh (log_cmd->log_code))
+        if (handler->log_code != log_code)
+            continue;
+        if (!handler->callback)
             continue;
-        if (handler->callback)
-            handler->callback (self, log_buffer, handler->user_data);
+
+        /* Only copied when someone is interested in it */
+        if (!copied) {
+            g_byte_array_set_size (self->priv->frame, 0);
+            g_byte_array_append (self->priv->frame, log, log_len);
+            copied = TRUE;
+        }
+        handler->callback (self, self->priv->frame, handler->user_data);
+    }
+}
+
+/*****************************************************************************/
+
+static void
+queue_log (MMPortSerialQcdm *self,
+           const guint8 *log,
+           gsize log_len)
+{
+    QcdmLogRecord record;
+    PendingLog pending;
+
+    if (!self->priv->log_consumer)
+        return;
+
+    if (!qcdm_log_record_parse ((const char *) log, log_len, &record))
+        return;
+
+    if (self->priv->log_paused && self->priv->log_pending->len >= self->priv->log_max_pending) {
+        self->priv->log_n_dropped++;
+        return;
+    }
+
+    pending.log_code = record.log_code;
+    pending.timestamp = record.timestamp;
+    pending.payload_offset = self->priv->log_payloads->len;
+    pending.payload_len = record.payload_len;
+    g_byte_array_append (self->priv->log_payloads, record.payload, record.payload_len);
+    g_array_append_val (self->priv->log_pending, pending);
+}
+
+static void
+flush_logs (MMPortSerialQcdm *self)
+{
+    MMPortSerialQcdmLogBatchFn consumer;
+    guint n_dropped;
+    guint i;
+
+    if (!self->priv->log_consumer)
+        return;
+    if (self->priv->log_pending->len == 0 && self->priv->log_n_dropped == 0)
+        return;
+
+    /* Payload pointers are only fixed up now that the arena won't move */
+    g_array_set_size (self->priv->log_batch, self->priv->log_pending->len);
+    for (i = 0; i < self->priv->log_pending->len; i++) {
+        PendingLog *pending = &g_array_index (self->priv->log_pending, PendingLog, i);
+        QcdmLogRecord *record = &g_array_index (self->priv->log_batch, QcdmLogRecord, i);
+
+        record->log_code = pending->log_code;
+        record->timestamp = pending->timestamp;
+        record->payload = &self->priv->log_payloads->data[pending->payload_offset];
+        record->payload_len = pending->payload_len;
     }
+
+    n_dropped = self->priv->log_n_dropped;
+    self->priv->log_n_dropped = 0;
+    g_array_set_size (self->priv->log_pending, 0);
+
+    consumer = self->priv->log_consumer;
+    if (!consumer (self,
+                   (const QcdmLogRecord *) self->priv->log_batch->data,
+                   self->priv->log_batch->len,
+                   n_dropped,
+                   self->priv->log_consumer_user_data) &&
+        consumer == self->priv->log_consumer)
+        self->priv->log_paused = TRUE;
+
+    g_array_set_size (self->priv->log_batch, 0);
+    g_byte_array_set_size (self->priv->log_payloads, 0);
+}
+
+static gboolean
+resume_log_consumer_idle (MMPortSerialQcdm *self)
+{
+    self->priv->log_resume_id = 0;
+    if (!self->priv->log_paused)
+        flush_logs (self);
+    return G_SOURCE_REMOVE;
+}
+
+void
+mm_port_serial_qcdm_resume_log_consumer (MMPortSerialQcdm *self)
+{
+    g_return_if_fail (MM_IS_PORT_SERIAL_QCDM (self));
+
+    if (!self->priv->log_paused)
+        return;
+    self->priv->log_paused = FALSE;
+
+    /* Deliver whatever was kept while paused, but never from within the
+     * caller, which may well be the consumer itself */
+    if ((self->priv->log_pending->len > 0 || self->priv->log_n_dropped > 0) &&
+        !self->priv->log_resume_id)
+        self->priv->log_resume_id = g_idle_add ((GSourceFunc) resume_log_consumer_idle, self);
+}
+
+static void
+clear_log_consumer (MMPortSerialQcdm *self)
+{
+    if (self->priv->log_resume_id) {
+        g_source_remove (self->priv->log_resume_id);
+        self->priv->log_resume_id = 0;
+    }
+
+    if (self->priv->log_consumer_notify)
+        self->priv->log_consumer_notify (self->priv->log_consumer_user_data);
+
+    self->priv->log_consumer = NULL;
+    self->priv->log_consumer_user_data = NULL;
+    self->priv->log_consumer_notify = NULL;
+    self->priv->log_paused = FALSE;
+    self->priv->log_n_dropped = 0;
+    g_array_set_size (self->priv->log_pending, 0);
+    g_byte_array_set_size (self->priv->log_payloads, 0);
+}
+
+void
+mm_port_serial_qcdm_set_log_consumer (MMPortSerialQcdm *self,
+                                      MMPortSerialQcdmLogBatchFn callback,
+                                      guint max_pending,
+                                      gpointer user_data,
+                                      GDestroyNotify notify)
+{
+    g_return_if_fail (MM_IS_PORT_SERIAL_QCDM (self));
+
+    clear_log_consumer (self);
+
+    self->priv->log_consumer = callback;
+    self->priv->log_consumer_user_data = user_data;
+    self->priv->log_consumer_notify = notify;
+    self->priv->log_max_pending = max_pending;
+}
+
+/*****************************************************************************/
+
+static void
+parse_unsolicited (MMPortSerial *port, GByteArray *response)
+{
+    parse_qcdm (MM_PORT_SERIAL_QCDM (port), response, NULL, NULL);
 }
 
 /*****************************************************************************/
@@ -372,6 +807,11 @@ static void
 mm_port_serial_qcdm_init (MMPortSerialQcdm *self)
 {
     self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, MM_TYPE_PORT_SERIAL_QCDM, MMPortSerialQcdmPrivate);
+    self->priv->frame = g_byte_array_new ();
+    self->priv->log_pending = g_array_new (FALSE, FALSE, sizeof (PendingLog));
+    self->priv->log_payloads = g_byte_array_new ();
+    self->priv->log_batch = g_array_new (FALSE, FALSE, sizeof (QcdmLogRecord));
+    self->priv->commands = g_queue_new ();
 }
 
 static void
@@ -390,6 +830,13 @@ finalize (GObject *object)
                                                                     self->priv->unsolicited_msg_handlers);
     }
 
+    clear_log_consumer (self);
+    g_array_unref (self->priv->log_pending);
+    g_byte_array_unref (self->priv->log_payloads);
+    g_array_unref (self->priv->log_batch);
+    g_byte_array_unref (self->priv->frame);
+    g_queue_free_full (self->priv->commands, (GDestroyNotify)command_context_free);
+
     G_OBJECT_CLASS (mm_port_serial_qcdm_parent_class)->finalize (object);
 }
 
@@ -405,6 +852,7 @@ mm_port_serial_qcdm_class_init (MMPortSerialQcdmClass *klass)
     object_class->finalize = finalize;
     port_class->parse_unsolicited = parse_unsolicited;
     port_class->parse_response = parse_response;
+    port_class->response_buffer_reset = response_buffer_reset;
     port_class->config_fd = config_fd;
     port_class->debug_log = debug_log;
 }
@@ -21,6 +21,7 @@
 #include <glib-object.h>
 
 #include "mm-port-serial.h"
+#include "libqcdm/src/logs.h"
 
 #define MM_TYPE_PORT_SERIAL_QCDM            (mm_port_serial_qcdm_get_type ())
 #define MM_PORT_SERIAL_QCDM(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), MM_TYPE_PORT_SERIAL_QCDM, MMPortSerialQcdm))
@@ -57,6 +58,23 @@ GByteArray *mm_port_serial_qcdm_command_finish (MMPortSerialQcdm *self,
                                                 GAsyncResult *res,
                                                 GError **error);
 
+/* Sends all @commands (each already CRC-ed and escaped, as for
+ * mm_port_serial_qcdm_command()) in a single write, and completes once all of
+ * them got a response. Responses are matched to commands by command code, so
+ * they may come in any order; they're returned in the order of @commands.
+ * If only some of the responses arrived before the timeout, those are
+ * returned, with NULL in the place of the missing ones. */
+void       mm_port_serial_qcdm_command_batch        (MMPortSerialQcdm *self,
+                                                     GPtrArray *commands,
+                                                     guint32 timeout_seconds,
+                                                     GCancellable *cancellable,
+                                                     GAsyncReadyCallback callback,
+                                                     gpointer user_data);
+GPtrArray *mm_port_serial_qcdm_command_batch_finish (MMPortSerialQcdm *self,
+                                                     GAsyncResult *res,
+                                                     GError **error);
+
+/* @log_buffer is owned by the port and only valid during the callback */
 typedef void (*MMPortSerialQcdmUnsolicitedMsgFn) (MMPortSerialQcdm *port,
                                                   GByteArray *log_buffer,
                                                   gpointer user_data);
@@ -71,4 +89,24 @@ void     mm_port_serial_qcdm_enable_unsolicited_msg_handler (MMPortSerialQcdm *s
                                                              guint log_code,
                                                              gboolean enable);
 
+/* Batched log consumer: receives every log record decoded from a single read
+ * at once, plus the number of records dropped since the previous batch. The
+ * records and their payloads are only valid during the callback. Returning
+ * FALSE pauses delivery until mm_port_serial_qcdm_resume_log_consumer() is
+ * called; while paused, up to @max_pending records are kept and any further
+ * one is dropped. */
+typedef gboolean (*MMPortSerialQcdmLogBatchFn) (MMPortSerialQcdm *port,
+                                                const QcdmLogRecord *records,
+                                                guint n_records,
+                                                guint n_dropped,
+                                                gpointer user_data);
+
+void     mm_port_serial_qcdm_set_log_consumer    (MMPortSerialQcdm *self,
+                                                  MMPortSerialQcdmLogBatchFn callback,
+                                                  guint max_pending,
+                                                  gpointer user_data,
+                                                  GDestroyNotify notify);
+
+void     mm_port_serial_qcdm_resume_log_consumer (MMPortSerialQcdm *self);
+
 #endif /* MM_PORT_SERIAL_QCDM_H */
@@ -836,6 +836,15 @@ port_serial_queue_process (gpointer data)
     return G_SOURCE_REMOVE;
 }
 
+static void
+response_buffer_remove (MMPortSerial *self,
+                        guint len)
+{
+    g_byte_array_remove_range (self->priv->response, 0, len);
+    if (MM_PORT_SERIAL_GET_CLASS (self)->response_buffer_reset)
+        MM_PORT_SERIAL_GET_CLASS (self)->response_buffer_reset (self);
+}
+
 static void
 parse_response_buffer (MMPortSerial *self)
 {
@@ -902,14 +911,14 @@ common_input_available (MMPortSerial *self,
         mm_dbg ("(%s) unexpected port hangup!", device);
 
         if (self->priv->response->len)
-            g_byte_array_remove_range (self->priv->response, 0, self->priv->response->len);
+            response_buffer_remove (self, self->priv->response->len);
         port_serial_close_force (self);
         return G_SOURCE_REMOVE;
     }
 
     if (condition & G_IO_ERR) {
         if (self->priv->response->len)
-            g_byte_array_remove_range (self->priv->response, 0, self->priv->response->len);
+            response_buffer_remove (self, self->priv->response->len);
         return G_SOURCE_CONTINUE;
     }
 
@@ -971,7 +980,7 @@ common_input_available (MMPortSerial *self,
         if ((self->priv->response->len > SERIAL_BUF_SIZE) && self->priv->spew_control) {
             /* Notify listeners and then trim the buffer */
             g_signal_emit (self, signals[BUFFER_FULL], 0, self->priv->response);
-            g_byte_array_remove_range (self->priv->response, 0, (SERIAL_BUF_SIZE / 2));
+            response_buffer_remove (self, SERIAL_BUF_SIZE / 2);
         }
 
         /* See if we can parse anything. The response parsing may actually
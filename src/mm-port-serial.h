@@ -85,6 +85,13 @@ struct _MMPortSerialClass {
                                                 GByteArray **parsed_response,
                                                 GError **error);
 
+    /* Called whenever data is removed from the response buffer by anything
+     * other than parse_response(), e.g. when it's flushed after an I/O error
+     * or trimmed because it grew too long, so that implementations keeping
+     * state about the buffer contents can reset it.
+     */
+    void     (*response_buffer_reset) (MMPortSerial *self);
+
     /* Called to configure the serial port fd after it's opened.  On error, should
      * return FALSE and set 'error' as appropriate.
      */
@@ -34,6 +34,7 @@ G_DEFINE_TYPE (MMSmsList, mm_sms_list, G_TYPE_OBJECT);
 enum {
     PROP_0,
     PROP_MODEM,
+    PROP_LAZY_EXPORT,
     PROP_LAST
 };
 static GParamSpec *properties[PROP_LAST];
@@ -45,13 +46,259 @@ enum {
 };
 static guint signals[SIGNAL_LAST];
 
+/* Incomplete multipart messages whose parts aren't in any storage only live
+ * in our memory, and if the missing parts never arrive they would stay there
+ * forever. Those are expired when no new part is received for them in a
+ * while, or when there are too many parts waiting to be completed. Multipart
+ * messages with stored parts are never expired, so that the user can still
+ * request the removal of those parts. */
+#define MULTIPART_EXPIRY_TIMEOUT_SECS  (24 * 60 * 60)
+#define MULTIPART_MAX_INCOMPLETE_PARTS 1024
+
+typedef struct {
+    MMBaseSms *sms; /* not owned */
+    gchar *key;
+    gint64 last_update;
+    guint n_parts;
+    /* Link in the list of expirable multipart messages, or NULL */
+    GList *expirable_link;
+} MultipartEntry;
+
+/* Reverse links from an SMS object to its entries in the indexes, so that
+ * it can be removed from them without walking the whole indexes */
+typedef struct {
+    /* (storage, part index) keys in the parts index */
+    GArray *part_keys;
+    /* Entry in the multipart index, or NULL */
+    MultipartEntry *multipart;
+} IndexLinks;
+
+/* Stored parts found while loading the initial list, whose SMS objects are
+ * only created and exported when requested, if lazy export is enabled. The
+ * parts themselves aren't kept, they're read again from the storage when
+ * loaded; only what's needed to find them is. */
+typedef struct {
+    MMSmsStorage storage;
+    guint index;
+    MMSmsState state;
+    MMSmsPduType pdu_type;
+    gchar *number;
+    gchar *timestamp;
+    gboolean multipart;
+    guint concat_reference;
+} DeferredPart;
+
 struct _MMSmsListPrivate {
     /* The owner modem */
     MMBaseModem *modem;
+    /* Whether SMS objects for stored parts are created on demand */
+    gboolean lazy_export;
+    gboolean initial_load_done;
+    /* Deferred parts (DeferredPart), indexed in the parts index with a NULL
+     * SMS object */
+    GQueue deferred;
     /* List of sms objects */
     GList *list;
+    /* SMS objects added with mm_sms_list_add_sms() (not owned); their parts
+     * get stored after being added, so they're not in the parts index */
+    GList *local;
+    /* (storage, part index) -> SMS object (not owned) */
+    GHashTable *parts_index;
+    /* "number/reference" -> MultipartEntry */
+    GHashTable *multipart_index;
+    /* SMS object (not owned) -> IndexLinks */
+    GHashTable *index_links;
+    /* Expirable multipart messages (MultipartEntry, not owned), least
+     * recently updated first */
+    GQueue expirable;
+    guint n_expirable_parts;
 };
 
+/*****************************************************************************/
+/* Indexes */
+
+static gint64 *
+part_key_new (MMSmsStorage storage,
+              guint index)
+{
+    gint64 *key;
+
+    key = g_new (gint64, 1);
+    *key = ((gint64)storage << 32) | index;
+    return key;
+}
+
+static gchar *
+multipart_key_new (const gchar *number,
+                   guint reference)
+{
+    return g_strdup_printf ("%s/%u", number ? number : "", reference);
+}
+
+static DeferredPart *
+deferred_part_new (MMSmsPart *part,
+                   MMSmsState state,
+                   MMSmsStorage storage)
+{
+    DeferredPart *deferred;
+
+    deferred = g_slice_new0 (DeferredPart);
+    deferred->storage = storage;
+    deferred->index = mm_sms_part_get_index (part);
+    deferred->state = state;
+    deferred->pdu_type = mm_sms_part_get_pdu_type (part);
+    deferred->number = g_strdup (mm_sms_part_get_number (part));
+    deferred->timestamp = g_strdup (mm_sms_part_get_timestamp (part));
+    if (mm_sms_part_should_concat (part)) {
+        deferred->multipart = TRUE;
+        deferred->concat_reference = mm_sms_part_get_concat_reference (part);
+    }
+    return deferred;
+}
+
+static void
+deferred_part_free (DeferredPart *deferred)
+{
+    g_free (deferred->number);
+    g_free (deferred->timestamp);
+    g_slice_free (DeferredPart, deferred);
+}
+
+static void
+multipart_entry_free (MultipartEntry *entry)
+{
+    g_free (entry->key);
+    g_slice_free (MultipartEntry, entry);
+}
+
+static void
+index_links_free (IndexLinks *links)
+{
+    g_array_unref (links->part_keys);
+    g_slice_free (IndexLinks, links);
+}
+
+static IndexLinks *
+index_links_get (MMSmsList *self,
+                 MMBaseSms *sms)
+{
+    IndexLinks *links;
+
+    links = g_hash_table_lookup (self->priv->index_links, sms);
+    if (!links) {
+        links = g_slice_new0 (IndexLinks);
+        links->part_keys = g_array_new (FALSE, FALSE, sizeof (gint64));
+        g_hash_table_insert (self->priv->index_links, sms, links);
+    }
+    return links;
+}
+
+static void
+multipart_entry_set_expirable (MMSmsList *self,
+                               MultipartEntry *entry,
+                               gboolean expirable)
+{
+    if (entry->expirable_link) {
+        g_queue_unlink (&self->priv->expirable, entry->expirable_link);
+        g_assert (self->priv->n_expirable_parts >= entry->n_parts);
+        self->priv->n_expirable_parts -= entry->n_parts;
+        if (!expirable) {
+            g_list_free_1 (entry->expirable_link);
+            entry->expirable_link = NULL;
+            return;
+        }
+    } else if (!expirable)
+        return;
+    else
+        entry->expirable_link = g_list_alloc ();
+
+    /* (Re)queue as the most recently updated one */
+    entry->expirable_link->data = entry;
+    g_queue_push_tail_link (&self->priv->expirable, entry->expirable_link);
+    self->priv->n_expirable_parts += entry->n_parts;
+}
+
+static void
+index_part (MMSmsList *self,
+            MMBaseSms *sms,
+            MMSmsPart *part)
+{
+    guint index;
+    gint64 *key;
+
+    index = mm_sms_part_get_index (part);
+    if (index == SMS_PART_INVALID_INDEX)
+        return;
+
+    key = part_key_new (mm_base_sms_get_storage (sms), index);
+    g_array_append_val (index_links_get (self, sms)->part_keys, *key);
+    g_hash_table_replace (self->priv->parts_index, key, sms);
+}
+
+static void
+remove_from_indexes (MMSmsList *self,
+                     MMBaseSms *sms)
+{
+    IndexLinks *links;
+
+    links = g_hash_table_lookup (self->priv->index_links, sms);
+    if (links) {
+        guint i;
+
+        /* Part indexes may have already been reset when deleting, so use the
+         * keys the SMS was indexed with; and those may have been taken over
+         * by a newer SMS in the meantime */
+        for (i = 0; i < links->part_keys->len; i++) {
+            gint64 *key;
+
+            key = &g_array_index (links->part_keys, gint64, i);
+            if (g_hash_table_lookup (self->priv->parts_index, key) == sms)
+                g_hash_table_remove (self->priv->parts_index, key);
+        }
+
+        if (links->multipart) {
+            multipart_entry_set_expirable (self, links->multipart, FALSE);
+            g_hash_table_remove (self->priv->multipart_index, links->multipart->key);
+        }
+
+        g_hash_table_remove (self->priv->index_links, sms);
+    }
+
+    self->priv->local = g_list_remove (self->priv->local, sms);
+}
+
+static void
+expire_multiparts (MMSmsList *self)
+{
+    gint64 now;
+
+    now = g_get_monotonic_time ();
+    while (!g_queue_is_empty (&self->priv->expirable)) {
+        MultipartEntry *entry;
+        MMBaseSms *sms;
+        gchar *path;
+
+        entry = g_queue_peek_head (&self->priv->expirable);
+        if (self->priv->n_expirable_parts <= MULTIPART_MAX_INCOMPLETE_PARTS &&
+            (now - entry->last_update) < (MULTIPART_EXPIRY_TIMEOUT_SECS * G_USEC_PER_SEC))
+            break;
+
+        sms = entry->sms;
+        mm_dbg ("Expiring incomplete multipart SMS (reference: '%u', parts: %u)",
+                mm_base_sms_get_multipart_reference (sms), entry->n_parts);
+
+        /* The entry is freed here */
+        remove_from_indexes (self, sms);
+        self->priv->list = g_list_remove (self->priv->list, sms);
+
+        path = g_strdup (mm_base_sms_get_path (sms));
+        mm_base_sms_unexport (sms);
+        g_signal_emit (self, signals[SIGNAL_DELETED], 0, path);
+        g_free (path);
+        g_object_unref (sms);
+    }
+}
+
 /*****************************************************************************/
 
 gboolean
@@ -78,6 +325,17 @@ mm_sms_list_has_local_multipart_reference (MMSmsList *self,
         }
     }
 
+    /* Stored parts not yet loaded in SMS objects also hold references */
+    for (l = self->priv->deferred.head; l; l = g_list_next (l)) {
+        DeferredPart *deferred = l->data;
+
+        if (deferred->multipart &&
+            deferred->pdu_type == MM_SMS_PDU_TYPE_SUBMIT &&
+            deferred->concat_reference == reference &&
+            g_strcmp0 (deferred->number, number) == 0)
+            return TRUE;
+    }
+
     return FALSE;
 }
 
@@ -152,6 +410,7 @@ delete_ready (MMBaseSms *sms,
                             path,
                             (GCompareFunc)cmp_sms_by_path);
     if (l) {
+        remove_from_indexes (self, MM_BASE_SMS (l->data));
         g_object_unref (MM_BASE_SMS (l->data));
         self->priv->list = g_list_delete_link (self->priv->list, l);
     }
@@ -209,6 +468,7 @@ mm_sms_list_add_sms (MMSmsList *self,
                      MMBaseSms *sms)
 {
     self->priv->list = g_list_prepend (self->priv->list, g_object_ref (sms));
+    self->priv->local = g_list_prepend (self->priv->local, sms);
     g_signal_emit (self, signals[SIGNAL_ADDED], 0,
                    mm_base_sms_get_path (sms),
                    FALSE);
@@ -216,29 +476,6 @@ mm_sms_list_add_sms (MMSmsList *self,
 
 /*****************************************************************************/
 
-static guint
-cmp_sms_by_concat_reference (MMBaseSms *sms,
-                             gpointer user_data)
-{
-    if (!mm_base_sms_is_multipart (sms))
-        return -1;
-
-    return (GPOINTER_TO_UINT (user_data) - mm_base_sms_get_multipart_reference (sms));
-}
-
-typedef struct {
-    guint part_index;
-    MMSmsStorage storage;
-} PartIndexAndStorage;
-
-static guint
-cmp_sms_by_part_index_and_storage (MMBaseSms *sms,
-                                   PartIndexAndStorage *ctx)
-{
-    return !(mm_base_sms_get_storage (sms) == ctx->storage &&
-             mm_base_sms_has_part_index (sms, ctx->part_index));
-}
-
 static gboolean
 take_singlepart (MMSmsList *self,
                  MMSmsPart *part,
@@ -257,6 +494,7 @@ take_singlepart (MMSmsList *self,
         return FALSE;
 
     self->priv->list = g_list_prepend (self->priv->list, sms);
+    index_part (self, sms, part);
     g_signal_emit (self, signals[SIGNAL_ADDED], 0,
                    mm_base_sms_get_path (sms),
                    state == MM_SMS_STATE_RECEIVED);
@@ -270,17 +508,35 @@ take_multipart (MMSmsList *self,
                 MMSmsStorage storage,
                 GError **error)
 {
-    GList *l;
+    MultipartEntry *entry;
     MMBaseSms *sms;
     guint concat_reference;
+    gchar *key;
+    gboolean expirable;
 
     concat_reference = mm_sms_part_get_concat_reference (part);
-    l = g_list_find_custom (self->priv->list,
-                            GUINT_TO_POINTER (concat_reference),
-                            (GCompareFunc)cmp_sms_by_concat_reference);
-    if (l)
+    key = multipart_key_new (mm_sms_part_get_number (part), concat_reference);
+    entry = g_hash_table_lookup (self->priv->multipart_index, key);
+    if (entry) {
+        g_free (key);
+
         /* Try to take the part */
-        return mm_base_sms_multipart_take_part (MM_BASE_SMS (l->data), part, error);
+        if (!mm_base_sms_multipart_take_part (entry->sms, part, error))
+            return FALSE;
+
+        index_part (self, entry->sms, part);
+
+        /* Still expirable only if none of the parts is stored */
+        expirable = (!!entry->expirable_link &&
+                     mm_sms_part_get_index (part) == SMS_PART_INVALID_INDEX &&
+                     !mm_base_sms_multipart_is_complete (entry->sms));
+        multipart_entry_set_expirable (self, entry, FALSE);
+        entry->n_parts++;
+        entry->last_update = g_get_monotonic_time ();
+        multipart_entry_set_expirable (self, entry, expirable);
+        expire_multiparts (self);
+        return TRUE;
+    }
 
     /* Create new Multipart */
     sms = mm_base_sms_multipart_new (self->priv->modem,
@@ -290,15 +546,32 @@ take_multipart (MMSmsList *self,
                                      mm_sms_part_get_concat_max (part),
                                      part,
                                      error);
-    if (!sms)
+    if (!sms) {
+        g_free (key);
         return FALSE;
+    }
 
     self->priv->list = g_list_prepend (self->priv->list, sms);
+    index_part (self, sms, part);
+
+    entry = g_slice_new0 (MultipartEntry);
+    entry->sms = sms;
+    entry->key = key;
+    entry->n_parts = 1;
+    entry->last_update = g_get_monotonic_time ();
+    g_hash_table_insert (self->priv->multipart_index, entry->key, entry);
+    index_links_get (self, sms)->multipart = entry;
+    multipart_entry_set_expirable (self,
+                                   entry,
+                                   (mm_sms_part_get_index (part) == SMS_PART_INVALID_INDEX &&
+                                    !mm_base_sms_multipart_is_complete (sms)));
+
     g_signal_emit (self, signals[SIGNAL_ADDED], 0,
                    mm_base_sms_get_path (sms),
                    (state == MM_SMS_STATE_RECEIVED ||
                     state == MM_SMS_STATE_RECEIVING));
 
+    expire_multiparts (self);
     return TRUE;
 }
 
@@ -307,18 +580,206 @@ mm_sms_list_has_part (MMSmsList *self,
                       MMSmsStorage storage,
                       guint index)
 {
-    PartIndexAndStorage ctx;
+    gint64 key;
+    GList *l;
 
     if (storage == MM_SMS_STORAGE_UNKNOWN ||
         index == SMS_PART_INVALID_INDEX)
         return FALSE;
 
-    ctx.part_index = index;
-    ctx.storage = storage;
+    key = ((gint64)storage << 32) | index;
+    if (g_hash_table_contains (self->priv->parts_index, &key))
+        return TRUE;
 
-    return !!g_list_find_custom (self->priv->list,
-                                 &ctx,
-                                 (GCompareFunc)cmp_sms_by_part_index_and_storage);
+    /* Parts of locally created SMS objects are not indexed */
+    for (l = self->priv->local; l; l = g_list_next (l)) {
+        if (mm_base_sms_get_storage (MM_BASE_SMS (l->data)) == storage &&
+            mm_base_sms_has_part_index (MM_BASE_SMS (l->data), index))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+static gboolean take_part (MMSmsList *self,
+                           MMSmsPart *part,
+                           MMSmsState state,
+                           MMSmsStorage storage,
+                           GError **error);
+
+/* Deferred parts are loaded one after the other, reading them again from
+ * their storage */
+
+typedef struct {
+    GQueue parts;
+} LoadDeferredContext;
+
+static void
+load_deferred_context_free (LoadDeferredContext *ctx)
+{
+    while (!g_queue_is_empty (&ctx->parts))
+        deferred_part_free (g_queue_pop_head (&ctx->parts));
+    g_slice_free (LoadDeferredContext, ctx);
+}
+
+static void load_next_deferred_part (GTask *task);
+
+static void
+load_sms_part_ready (MMIfaceModemMessaging *modem,
+                     GAsyncResult *res,
+                     GTask *task)
+{
+    MMSmsList *self;
+    LoadDeferredContext *ctx;
+    DeferredPart *deferred;
+    MMSmsPart *part;
+    gint64 key;
+    GError *error = NULL;
+
+    self = g_task_get_source_object (task);
+    ctx = g_task_get_task_data (task);
+    deferred = g_queue_pop_head (&ctx->parts);
+
+    /* Drop the placeholder in the index, it's re-added once taken */
+    key = ((gint64)deferred->storage << 32) | deferred->index;
+    g_hash_table_remove (self->priv->parts_index, &key);
+
+    part = MM_IFACE_MODEM_MESSAGING_GET_INTERFACE (modem)->load_sms_part_finish (modem, res, &error);
+    if (!part) {
+        mm_dbg ("Couldn't load deferred SMS part at '%s/%u' (number: '%s', timestamp: '%s'): '%s'",
+                mm_sms_storage_get_string (deferred->storage),
+                deferred->index,
+                deferred->number ? deferred->number : "unknown",
+                deferred->timestamp ? deferred->timestamp : "unknown",
+                error->message);
+        g_error_free (error);
+    } else if (!take_part (self, part, deferred->state, deferred->storage, &error)) {
+        mm_dbg ("Couldn't take deferred SMS part: '%s'", error->message);
+        g_error_free (error);
+        mm_sms_part_free (part);
+    }
+
+    deferred_part_free (deferred);
+    load_next_deferred_part (task);
+}
+
+static void
+load_next_deferred_part (GTask *task)
+{
+    MMSmsList *self;
+    LoadDeferredContext *ctx;
+    DeferredPart *deferred;
+
+    self = g_task_get_source_object (task);
+    ctx = g_task_get_task_data (task);
+
+    if (g_queue_is_empty (&ctx->parts)) {
+        g_task_return_boolean (task, TRUE);
+        g_object_unref (task);
+        return;
+    }
+
+    deferred = g_queue_peek_head (&ctx->parts);
+    MM_IFACE_MODEM_MESSAGING_GET_INTERFACE (self->priv->modem)->load_sms_part (
+        MM_IFACE_MODEM_MESSAGING (self->priv->modem),
+        deferred->storage,
+        deferred->index,
+        (GAsyncReadyCallback)load_sms_part_ready,
+        task);
+}
+
+static void
+load_deferred_parts (MMSmsList *self,
+                     LoadDeferredContext *ctx,
+                     GAsyncReadyCallback callback,
+                     gpointer user_data)
+{
+    GTask *task;
+
+    task = g_task_new (self, NULL, callback, user_data);
+    g_task_set_task_data (task, ctx, (GDestroyNotify)load_deferred_context_free);
+    load_next_deferred_part (task);
+}
+
+static void
+load_deferred_multipart_ready (MMSmsList *self,
+                               GAsyncResult *res)
+{
+    /* Errors are only reported per part */
+    g_task_propagate_boolean (G_TASK (res), NULL);
+}
+
+/* Load the deferred parts of the given multipart message, so that they get
+ * merged with the new parts being taken */
+static void
+load_deferred_multipart (MMSmsList *self,
+                         const gchar *number,
+                         guint reference)
+{
+    LoadDeferredContext *ctx;
+    GList *l;
+    GList *next;
+
+    ctx = g_slice_new0 (LoadDeferredContext);
+    g_queue_init (&ctx->parts);
+
+    for (l = self->priv->deferred.head; l; l = next) {
+        DeferredPart *deferred = l->data;
+
+        next = g_list_next (l);
+        if (deferred->multipart &&
+            deferred->concat_reference == reference &&
+            g_strcmp0 (deferred->number, number) == 0) {
+            g_queue_push_tail (&ctx->parts, deferred);
+            g_queue_delete_link (&self->priv->deferred, l);
+        }
+    }
+
+    if (g_queue_is_empty (&ctx->parts)) {
+        load_deferred_context_free (ctx);
+        return;
+    }
+
+    mm_dbg ("Loading %u deferred parts of multipart SMS (reference: '%u')",
+            g_queue_get_length (&ctx->parts), reference);
+    load_deferred_parts (self, ctx, (GAsyncReadyCallback)load_deferred_multipart_ready, NULL);
+}
+
+gboolean
+mm_sms_list_load_deferred_finish (MMSmsList *self,
+                                  GAsyncResult *res,
+                                  GError **error)
+{
+    return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+void
+mm_sms_list_load_deferred (MMSmsList *self,
+                           GAsyncReadyCallback callback,
+                           gpointer user_data)
+{
+    LoadDeferredContext *ctx;
+
+    ctx = g_slice_new0 (LoadDeferredContext);
+    g_queue_init (&ctx->parts);
+
+    if (!g_queue_is_empty (&self->priv->deferred)) {
+        mm_dbg ("Loading %u deferred SMS parts", g_queue_get_length (&self->priv->deferred));
+        /* Move all parts to the context */
+        ctx->parts = self->priv->deferred;
+        g_queue_init (&self->priv->deferred);
+    }
+
+    load_deferred_parts (self, ctx, callback, user_data);
+}
+
+void
+mm_sms_list_initial_load_done (MMSmsList *self)
+{
+    self->priv->initial_load_done = TRUE;
+    if (!g_queue_is_empty (&self->priv->deferred))
+        mm_dbg ("Deferred loading %u stored SMS parts",
+                g_queue_get_length (&self->priv->deferred));
 }
 
 gboolean
@@ -328,18 +789,45 @@ mm_sms_list_take_part (MMSmsList *self,
                        MMSmsStorage storage,
                        GError **error)
 {
+    guint index;
+
+    index = mm_sms_part_get_index (part);
+
     /* Ensure we don't have already taken a part with the same index */
-    if (mm_sms_list_has_part (self,
-                              storage,
-                              mm_sms_part_get_index (part))) {
+    if (mm_sms_list_has_part (self, storage, index)) {
         g_set_error (error,
                      MM_CORE_ERROR,
                      MM_CORE_ERROR_FAILED,
                      "A part with index %u was already taken",
-                     mm_sms_part_get_index (part));
+                     index);
         return FALSE;
     }
 
+    if (self->priv->lazy_export &&
+        !self->priv->initial_load_done &&
+        storage != MM_SMS_STORAGE_UNKNOWN &&
+        index != SMS_PART_INVALID_INDEX) {
+        g_queue_push_tail (&self->priv->deferred, deferred_part_new (part, state, storage));
+        g_hash_table_insert (self->priv->parts_index, part_key_new (storage, index), NULL);
+        mm_sms_part_free (part);
+        return TRUE;
+    }
+
+    if (mm_sms_part_should_concat (part) && !g_queue_is_empty (&self->priv->deferred))
+        load_deferred_multipart (self,
+                                 mm_sms_part_get_number (part),
+                                 mm_sms_part_get_concat_reference (part));
+
+    return take_part (self, part, state, storage, error);
+}
+
+static gboolean
+take_part (MMSmsList *self,
+           MMSmsPart *part,
+           MMSmsState state,
+           MMSmsStorage storage,
+           GError **error)
+{
     /* Did we just get a part of a multi-part SMS? */
     if (mm_sms_part_should_concat (part)) {
         if (mm_sms_part_get_index (part) != SMS_PART_INVALID_INDEX)
@@ -369,11 +857,13 @@ mm_sms_list_take_part (MMSmsList *self,
 /*****************************************************************************/
 
 MMSmsList *
-mm_sms_list_new (MMBaseModem *modem)
+mm_sms_list_new (MMBaseModem *modem,
+                 gboolean lazy_export)
 {
     /* Create the object */
     return g_object_new  (MM_TYPE_SMS_LIST,
-                          MM_SMS_LIST_MODEM, modem,
+                          MM_SMS_LIST_MODEM,       modem,
+                          MM_SMS_LIST_LAZY_EXPORT, lazy_export,
                           NULL);
 }
 
@@ -390,6 +880,9 @@ set_property (GObject *object,
         g_clear_object (&self->priv->modem);
         self->priv->modem = g_value_dup_object (value);
         break;
+    case PROP_LAZY_EXPORT:
+        self->priv->lazy_export = g_value_get_boolean (value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -408,6 +901,9 @@ get_property (GObject *object,
     case PROP_MODEM:
         g_value_set_object (value, self->priv->modem);
         break;
+    case PROP_LAZY_EXPORT:
+        g_value_set_boolean (value, self->priv->lazy_export);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -421,6 +917,20 @@ mm_sms_list_init (MMSmsList *self)
     self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self,
                                               MM_TYPE_SMS_LIST,
                                               MMSmsListPrivate);
+    self->priv->parts_index = g_hash_table_new_full (g_int64_hash,
+                                                     g_int64_equal,
+                                                     g_free,
+                                                     NULL);
+    self->priv->multipart_index = g_hash_table_new_full (g_str_hash,
+                                                         g_str_equal,
+                                                         NULL,
+                                                         (GDestroyNotify)multipart_entry_free);
+    self->priv->index_links = g_hash_table_new_full (g_direct_hash,
+                                                     g_direct_equal,
+                                                     NULL,
+                                                     (GDestroyNotify)index_links_free);
+    g_queue_init (&self->priv->expirable);
+    g_queue_init (&self->priv->deferred);
 }
 
 static void
@@ -429,12 +939,33 @@ dispose (GObject *object)
     MMSmsList *self = MM_SMS_LIST (object);
 
     g_clear_object (&self->priv->modem);
+    while (!g_queue_is_empty (&self->priv->deferred))
+        deferred_part_free (g_queue_pop_head (&self->priv->deferred));
+    g_queue_clear (&self->priv->expirable);
+    self->priv->n_expirable_parts = 0;
+    g_hash_table_remove_all (self->priv->index_links);
+    g_hash_table_remove_all (self->priv->multipart_index);
+    g_hash_table_remove_all (self->priv->parts_index);
+    g_list_free (self->priv->local);
+    self->priv->local = NULL;
     g_list_free_full (self->priv->list, g_object_unref);
     self->priv->list = NULL;
 
     G_OBJECT_CLASS (mm_sms_list_parent_class)->dispose (object);
 }
 
+static void
+finalize (GObject *object)
+{
+    MMSmsList *self = MM_SMS_LIST (object);
+
+    g_hash_table_unref (self->priv->index_links);
+    g_hash_table_unref (self->priv->multipart_index);
+    g_hash_table_unref (self->priv->parts_index);
+
+    G_OBJECT_CLASS (mm_sms_list_parent_class)->finalize (object);
+}
+
 static void
 mm_sms_list_class_init (MMSmsListClass *klass)
 {
@@ -446,6 +977,7 @@ mm_sms_list_class_init (MMSmsListClass *klass)
     object_class->get_property = get_property;
     object_class->set_property = set_property;
     object_class->dispose = dispose;
+    object_class->finalize = finalize;
 
     /* Properties */
     properties[PROP_MODEM] =
@@ -456,6 +988,14 @@ mm_sms_list_class_init (MMSmsListClass *klass)
                              G_PARAM_READWRITE);
     g_object_class_install_property (object_class, PROP_MODEM, properties[PROP_MODEM]);
 
+    properties[PROP_LAZY_EXPORT] =
+        g_param_spec_boolean (MM_SMS_LIST_LAZY_EXPORT,
+                              "Lazy export",
+                              "Whether SMS objects for stored parts are only created when requested",
+                              FALSE,
+                              G_PARAM_READWRITE);
+    g_object_class_install_property (object_class, PROP_LAZY_EXPORT, properties[PROP_LAZY_EXPORT]);
+
     /* Signals */
     signals[SIGNAL_ADDED] =
         g_signal_new (MM_SMS_ADDED,
@@ -33,7 +33,8 @@ typedef struct _MMSmsList MMSmsList;
 typedef struct _MMSmsListClass MMSmsListClass;
 typedef struct _MMSmsListPrivate MMSmsListPrivate;
 
-#define MM_SMS_LIST_MODEM "sms-list-modem"
+#define MM_SMS_LIST_MODEM       "sms-list-modem"
+#define MM_SMS_LIST_LAZY_EXPORT "sms-list-lazy-export"
 
 #define MM_SMS_ADDED     "sms-added"
 #define MM_SMS_DELETED   "sms-deleted"
@@ -56,7 +57,8 @@ struct _MMSmsListClass {
 
 GType mm_sms_list_get_type (void);
 
-MMSmsList *mm_sms_list_new (MMBaseModem *modem);
+MMSmsList *mm_sms_list_new (MMBaseModem *modem,
+                            gboolean lazy_export);
 
 GStrv mm_sms_list_get_paths (MMSmsList *self);
 guint mm_sms_list_get_count (MMSmsList *self);
@@ -74,6 +76,17 @@ gboolean mm_sms_list_take_part (MMSmsList *self,
 void mm_sms_list_add_sms (MMSmsList *self,
                           MMBaseSms *sms);
 
+/* With lazy export, stored parts taken before the initial load is done are
+ * only loaded in SMS objects when explicitly requested, reading them again
+ * with the modem's load_sms_part() */
+void     mm_sms_list_initial_load_done    (MMSmsList *self);
+void     mm_sms_list_load_deferred        (MMSmsList *self,
+                                           GAsyncReadyCallback callback,
+                                           gpointer user_data);
+gboolean mm_sms_list_load_deferred_finish (MMSmsList *self,
+                                           GAsyncResult *res,
+                                           GError **error);
+
 void     mm_sms_list_delete_sms        (MMSmsList *self,
                                         const gchar *sms_path,
                                         GAsyncReadyCallback callback,
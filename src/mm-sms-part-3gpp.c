@@ -362,13 +362,15 @@ mm_sms_part_3gpp_new_from_pdu (guint index,
     return part;
 }
 
-MMSmsPart *
-mm_sms_part_3gpp_new_from_binary_pdu (guint index,
-                                      const guint8 *pdu,
-                                      gsize pdu_len,
-                                      GError **error)
+/*****************************************************************************/
+/* PDU view */
+
+gboolean
+mm_sms_part_3gpp_view_parse (MMSmsPart3gppView *view,
+                             const guint8 *pdu,
+                             gsize pdu_len,
+                             GError **error)
 {
-    MMSmsPart *sms_part;
     guint8 pdu_type;
     guint offset;
     guint smsc_addr_size_bytes;
@@ -381,15 +383,14 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
     guint tp_pid_offset = 0;
     guint tp_dcs_offset = 0;
     guint tp_user_data_len_offset = 0;
-    MMSmsEncoding user_data_encoding = MM_SMS_ENCODING_UNKNOWN;
-
-    /* Create the new MMSmsPart */
-    sms_part = mm_sms_part_new (index, MM_SMS_PDU_TYPE_UNKNOWN);
 
-    if (index != SMS_PART_INVALID_INDEX)
-        mm_dbg ("Parsing PDU (%u)...", index);
-    else
-        mm_dbg ("Parsing PDU...");
+    memset (view, 0, sizeof (MMSmsPart3gppView));
+    view->pdu = pdu;
+    view->pdu_len = pdu_len;
+    view->pdu_type = MM_SMS_PDU_TYPE_UNKNOWN;
+    view->encoding = MM_SMS_ENCODING_UNKNOWN;
+    view->delivery_state = MM_SMS_DELIVERY_STATE_UNKNOWN;
+    view->class = -1;
 
 #define PDU_SIZE_CHECK(required_size, check_descr_str)                 \
     if (pdu_len < required_size) {                                     \
@@ -400,8 +401,7 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
                      check_descr_str,                                  \
                      pdu_len,                                          \
                      required_size);                                   \
-        mm_sms_part_free (sms_part);                                   \
-        return NULL;                                                   \
+        return FALSE;                                                  \
     }
 
     offset = 0;
@@ -414,13 +414,10 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
     if (smsc_addr_size_bytes > 0) {
         PDU_SIZE_CHECK (offset + smsc_addr_size_bytes, "cannot read SMSC address");
         /* SMSC may not be given in DELIVER PDUs */
-        mm_sms_part_take_smsc (sms_part,
-                               sms_decode_address (&pdu[1], 2 * (smsc_addr_size_bytes - 1)));
-        mm_dbg ("  SMSC address parsed: '%s'", mm_sms_part_get_smsc (sms_part));
+        view->smsc_offset = offset;
+        view->smsc_len = 2 * (smsc_addr_size_bytes - 1);
         offset += smsc_addr_size_bytes;
-    } else
-        mm_dbg ("  No SMSC address given");
-
+    }
 
     /* ---------------------------------------------------------------------- */
     /* TP-MTI (1 byte) */
@@ -429,30 +426,26 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
     pdu_type = (pdu[offset] & SMS_TP_MTI_MASK);
     switch (pdu_type) {
     case SMS_TP_MTI_SMS_DELIVER:
-        mm_dbg ("  Deliver type PDU detected");
-        mm_sms_part_set_pdu_type (sms_part, MM_SMS_PDU_TYPE_DELIVER);
+        view->pdu_type = MM_SMS_PDU_TYPE_DELIVER;
         break;
     case SMS_TP_MTI_SMS_SUBMIT:
-        mm_dbg ("  Submit type PDU detected");
-        mm_sms_part_set_pdu_type (sms_part, MM_SMS_PDU_TYPE_SUBMIT);
+        view->pdu_type = MM_SMS_PDU_TYPE_SUBMIT;
         break;
     case SMS_TP_MTI_SMS_STATUS_REPORT:
-        mm_dbg ("  Status report type PDU detected");
-        mm_sms_part_set_pdu_type (sms_part, MM_SMS_PDU_TYPE_STATUS_REPORT);
+        view->pdu_type = MM_SMS_PDU_TYPE_STATUS_REPORT;
         break;
     default:
-        mm_sms_part_free (sms_part);
         g_set_error (error,
                      MM_CORE_ERROR,
                      MM_CORE_ERROR_FAILED,
                      "Unhandled message type: 0x%02x",
                      pdu_type);
-        return NULL;
+        return FALSE;
     }
 
     /* Delivery report was requested? */
     if (pdu[offset] & 0x20)
-        mm_sms_part_set_delivery_report_request (sms_part, TRUE);
+        view->delivery_report_request = TRUE;
 
     /* PDU with validity? (only in SUBMIT PDUs) */
     if (pdu_type == SMS_TP_MTI_SMS_SUBMIT)
@@ -469,13 +462,10 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
     if (pdu_type == SMS_TP_MTI_SMS_STATUS_REPORT ||
         pdu_type == SMS_TP_MTI_SMS_SUBMIT) {
         PDU_SIZE_CHECK (offset + 1, "cannot read message reference");
-
-        mm_dbg ("  message reference: %u", (guint)pdu[offset]);
-        mm_sms_part_set_message_reference (sms_part, pdu[offset]);
+        view->message_reference = pdu[offset];
         offset++;
     }
 
-
     /* ---------------------------------------------------------------------- */
     /* TP-DA or TP-OA or TP-RA
      * First byte represents the number of DIGITS in the number.
@@ -487,10 +477,8 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
     tp_addr_size_bytes = (tp_addr_size_digits + 1) >> 1;
 
     PDU_SIZE_CHECK (offset + tp_addr_size_bytes, "cannot read number");
-    mm_sms_part_take_number (sms_part,
-                             sms_decode_address (&pdu[offset],
-                                                 tp_addr_size_digits));
-    mm_dbg ("  Number parsed: '%s'", mm_sms_part_get_number (sms_part));
+    view->number_offset = offset;
+    view->number_len = tp_addr_size_digits;
     offset += (1 + tp_addr_size_bytes); /* +1 due to the Type of Address byte */
 
     /* ---------------------------------------------------------------------- */
@@ -507,8 +495,7 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
         tp_dcs_offset = offset++;
 
         /* ------ Timestamp (7 bytes) ------ */
-        mm_sms_part_take_timestamp (sms_part,
-                                    sms_decode_timestamp (&pdu[offset]));
+        view->timestamp_offset = offset;
         offset += 7;
 
         tp_user_data_len_offset = offset;
@@ -523,30 +510,22 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
         tp_dcs_offset = offset++;
 
         /* ----------- TP-Validity-Period (1 byte) ----------- */
-        if (validity_format) {
-            switch (validity_format) {
-            case 0x10:
-                mm_dbg ("  validity available, format relative");
-                mm_sms_part_set_validity_relative (sms_part,
-                                                   relative_to_validity (pdu[offset]));
-                offset++;
-                break;
-            case 0x08:
-                /* TODO: support enhanced format; GSM 03.40 */
-                mm_dbg ("  validity available, format enhanced (not implemented)");
-                /* 7 bytes for enhanced validity */
-                offset += 7;
-                break;
-            case 0x18:
-                /* TODO: support absolute format; GSM 03.40 */
-                mm_dbg ("  validity available, format absolute (not implemented)");
-                /* 7 bytes for absolute validity */
-                offset += 7;
-                break;
-            default:
-                /* Cannot happen as we AND with the 0x18 mask */
-                g_assert_not_reached ();
-            }
+        switch (validity_format) {
+        case 0x00:
+            break;
+        case 0x10:
+            view->validity_relative = relative_to_validity (pdu[offset]);
+            offset++;
+            break;
+        case 0x08:
+        case 0x18:
+            /* TODO: support enhanced and absolute formats; GSM 03.40 */
+            /* 7 bytes for enhanced or absolute validity */
+            offset += 7;
+            break;
+        default:
+            /* Cannot happen as we AND with the 0x18 mask */
+            g_assert_not_reached ();
         }
 
         tp_user_data_len_offset = offset;
@@ -559,18 +538,15 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
         PDU_SIZE_CHECK (offset + 15, "cannot read Timestamps/TP-STATUS"); /* 7+7+1=15 */
 
         /* ------ Timestamp (7 bytes) ------ */
-        mm_sms_part_take_timestamp (sms_part,
-                                    sms_decode_timestamp (&pdu[offset]));
+        view->timestamp_offset = offset;
         offset += 7;
 
         /* ------ Discharge Timestamp (7 bytes) ------ */
-        mm_sms_part_take_discharge_timestamp (sms_part,
-                                              sms_decode_timestamp (&pdu[offset]));
+        view->discharge_timestamp_offset = offset;
         offset += 7;
 
         /* ----- TP-STATUS (1 byte) ------ */
-        mm_dbg ("  delivery state: %u", (guint)pdu[offset]);
-        mm_sms_part_set_delivery_state (sms_part, pdu[offset]);
+        view->delivery_state = pdu[offset];
         offset++;
 
         /* ------ TP-PI (1 byte) OPTIONAL ------ */
@@ -592,37 +568,19 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
     } else
         g_assert_not_reached ();
 
-    if (tp_pid_offset > 0) {
+    if (tp_pid_offset > 0)
         PDU_SIZE_CHECK (tp_pid_offset + 1, "cannot read TP-PID");
-        mm_dbg ("  PID: %u", (guint)pdu[tp_pid_offset]);
-    }
 
     /* Grab user data encoding and message class */
     if (tp_dcs_offset > 0) {
         PDU_SIZE_CHECK (tp_dcs_offset + 1, "cannot read TP-DCS");
 
         /* Encoding given in the 'alphabet' bits */
-        user_data_encoding = sms_encoding_type (pdu[tp_dcs_offset]);
-        switch (user_data_encoding) {
-        case MM_SMS_ENCODING_GSM7:
-            mm_dbg ("  user data encoding is GSM7");
-            break;
-        case MM_SMS_ENCODING_UCS2:
-            mm_dbg ("  user data encoding is UCS2");
-            break;
-        case MM_SMS_ENCODING_8BIT:
-            mm_dbg ("  user data encoding is 8bit");
-            break;
-        default:
-            mm_dbg ("  user data encoding is unknown");
-            break;
-        }
-        mm_sms_part_set_encoding (sms_part, user_data_encoding);
+        view->encoding = sms_encoding_type (pdu[tp_dcs_offset]);
 
         /* Class */
         if (pdu[tp_dcs_offset] & SMS_DCS_CLASS_VALID)
-            mm_sms_part_set_class (sms_part,
-                                   pdu[tp_dcs_offset] & SMS_DCS_CLASS_MASK);
+            view->class = pdu[tp_dcs_offset] & SMS_DCS_CLASS_MASK;
     }
 
     if (tp_user_data_len_offset > 0) {
@@ -633,13 +591,11 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
 
         PDU_SIZE_CHECK (tp_user_data_len_offset + 1, "cannot read TP-UDL");
         tp_user_data_size_elements = pdu[tp_user_data_len_offset];
-        mm_dbg ("  user data length: %u elements", tp_user_data_size_elements);
 
-        if (user_data_encoding == MM_SMS_ENCODING_GSM7)
+        if (view->encoding == MM_SMS_ENCODING_GSM7)
             tp_user_data_size_bytes = (7 * (tp_user_data_size_elements + 1 )) / 8;
         else
             tp_user_data_size_bytes = tp_user_data_size_elements;
-        mm_dbg ("  user data length: %u bytes", tp_user_data_size_bytes);
 
         tp_user_data_offset = tp_user_data_len_offset + 1;
         PDU_SIZE_CHECK (tp_user_data_offset + tp_user_data_size_bytes, "cannot read TP-UD");
@@ -672,9 +628,10 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
                         pdu[offset + 2] > pdu[offset + 1])
                         break;
 
-                    mm_sms_part_set_concat_reference (sms_part, pdu[offset]);
-                    mm_sms_part_set_concat_max (sms_part, pdu[offset + 1]);
-                    mm_sms_part_set_concat_sequence (sms_part, pdu[offset + 2]);
+                    view->concat = TRUE;
+                    view->concat_reference = pdu[offset];
+                    view->concat_max = pdu[offset + 1];
+                    view->concat_sequence = pdu[offset + 2];
                     break;
                 case 0x08:
                     if (offset + 3 >= end)
@@ -684,9 +641,10 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
                         pdu[offset + 3] > pdu[offset + 2])
                         break;
 
-                    mm_sms_part_set_concat_reference (sms_part, (pdu[offset] << 8) | pdu[offset + 1]);
-                    mm_sms_part_set_concat_max (sms_part,pdu[offset + 2]);
-                    mm_sms_part_set_concat_sequence (sms_part, pdu[offset + 3]);
+                    view->concat = TRUE;
+                    view->concat_reference = (pdu[offset] << 8) | pdu[offset + 1];
+                    view->concat_max = pdu[offset + 2];
+                    view->concat_sequence = pdu[offset + 3];
                     break;
                 }
 
@@ -699,7 +657,7 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
              */
             tp_user_data_offset += udhl;
             tp_user_data_size_bytes -= udhl;
-            if (user_data_encoding == MM_SMS_ENCODING_GSM7) {
+            if (view->encoding == MM_SMS_ENCODING_GSM7) {
                 /*
                  * Find the number of bits we need to add to the length of the
                  * user data to get a multiple of 7 (the padding).
@@ -710,35 +668,142 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
                 tp_user_data_size_elements -= udhl;
         }
 
-        switch (user_data_encoding) {
-        case MM_SMS_ENCODING_GSM7:
-        case MM_SMS_ENCODING_UCS2:
-            /* Otherwise if it's 7-bit or UCS2 we can decode it */
-            mm_dbg ("Decoding SMS text with '%u' elements", tp_user_data_size_elements);
-            mm_sms_part_take_text (sms_part,
-                                   sms_decode_text (&pdu[tp_user_data_offset],
-                                                    tp_user_data_size_elements,
-                                                    user_data_encoding,
-                                                    bit_offset));
-            g_warn_if_fail (mm_sms_part_get_text (sms_part) != NULL);
-            break;
+        /* 8-bit encoding is usually binary data, kept as is */
+        if (view->encoding != MM_SMS_ENCODING_GSM7 &&
+            view->encoding != MM_SMS_ENCODING_UCS2)
+            PDU_SIZE_CHECK (tp_user_data_offset + tp_user_data_size_bytes, "cannot read user data");
 
-        default:
-            {
-                GByteArray *raw;
+        view->user_data_offset = tp_user_data_offset;
+        view->user_data_elements = tp_user_data_size_elements;
+        view->user_data_bytes = tp_user_data_size_bytes;
+        view->user_data_bit_offset = bit_offset;
+    }
 
-                mm_dbg ("Skipping SMS text: Unknown encoding (0x%02X)", user_data_encoding);
+#undef PDU_SIZE_CHECK
 
-                PDU_SIZE_CHECK (tp_user_data_offset + tp_user_data_size_bytes, "cannot read user data");
+    return TRUE;
+}
 
-                /* 8-bit encoding is usually binary data, and we have no idea what
-                 * actual encoding the data is in so we can't convert it.
-                 */
-                raw = g_byte_array_sized_new (tp_user_data_size_bytes);
-                g_byte_array_append (raw, &pdu[tp_user_data_offset], tp_user_data_size_bytes);
-                mm_sms_part_take_data (sms_part, raw);
-                break;
-            }
+gchar *
+mm_sms_part_3gpp_view_get_smsc (const MMSmsPart3gppView *view)
+{
+    if (!view->smsc_offset)
+        return NULL;
+    return sms_decode_address (&view->pdu[view->smsc_offset], view->smsc_len);
+}
+
+gchar *
+mm_sms_part_3gpp_view_get_number (const MMSmsPart3gppView *view)
+{
+    if (!view->number_offset)
+        return NULL;
+    return sms_decode_address (&view->pdu[view->number_offset], view->number_len);
+}
+
+gchar *
+mm_sms_part_3gpp_view_get_timestamp (const MMSmsPart3gppView *view)
+{
+    if (!view->timestamp_offset)
+        return NULL;
+    return sms_decode_timestamp (&view->pdu[view->timestamp_offset]);
+}
+
+gchar *
+mm_sms_part_3gpp_view_get_discharge_timestamp (const MMSmsPart3gppView *view)
+{
+    if (!view->discharge_timestamp_offset)
+        return NULL;
+    return sms_decode_timestamp (&view->pdu[view->discharge_timestamp_offset]);
+}
+
+gchar *
+mm_sms_part_3gpp_view_get_text (const MMSmsPart3gppView *view)
+{
+    if (!view->user_data_offset ||
+        (view->encoding != MM_SMS_ENCODING_GSM7 &&
+         view->encoding != MM_SMS_ENCODING_UCS2))
+        return NULL;
+
+    return sms_decode_text (&view->pdu[view->user_data_offset],
+                            view->user_data_elements,
+                            view->encoding,
+                            view->user_data_bit_offset);
+}
+
+const guint8 *
+mm_sms_part_3gpp_view_peek_data (const MMSmsPart3gppView *view,
+                                 gsize *data_len)
+{
+    if (!view->user_data_offset ||
+        view->encoding == MM_SMS_ENCODING_GSM7 ||
+        view->encoding == MM_SMS_ENCODING_UCS2)
+        return NULL;
+
+    *data_len = view->user_data_bytes;
+    return &view->pdu[view->user_data_offset];
+}
+
+/*****************************************************************************/
+
+MMSmsPart *
+mm_sms_part_3gpp_new_from_binary_pdu (guint index,
+                                      const guint8 *pdu,
+                                      gsize pdu_len,
+                                      GError **error)
+{
+    MMSmsPart3gppView view;
+    MMSmsPart *sms_part;
+
+    if (index != SMS_PART_INVALID_INDEX)
+        mm_dbg ("Parsing PDU (%u)...", index);
+    else
+        mm_dbg ("Parsing PDU...");
+
+    if (!mm_sms_part_3gpp_view_parse (&view, pdu, pdu_len, error))
+        return NULL;
+
+    /* Create the new MMSmsPart */
+    sms_part = mm_sms_part_new (index, view.pdu_type);
+
+    mm_sms_part_take_smsc (sms_part, mm_sms_part_3gpp_view_get_smsc (&view));
+    mm_sms_part_take_number (sms_part, mm_sms_part_3gpp_view_get_number (&view));
+    mm_sms_part_take_timestamp (sms_part, mm_sms_part_3gpp_view_get_timestamp (&view));
+    mm_sms_part_take_discharge_timestamp (sms_part, mm_sms_part_3gpp_view_get_discharge_timestamp (&view));
+    mm_dbg ("  %s PDU, SMSC '%s', number '%s'",
+            mm_sms_pdu_type_get_string (view.pdu_type),
+            mm_sms_part_get_smsc (sms_part) ? mm_sms_part_get_smsc (sms_part) : "none",
+            mm_sms_part_get_number (sms_part));
+
+    mm_sms_part_set_delivery_report_request (sms_part, view.delivery_report_request);
+    mm_sms_part_set_message_reference (sms_part, view.message_reference);
+    if (view.validity_relative)
+        mm_sms_part_set_validity_relative (sms_part, view.validity_relative);
+    mm_sms_part_set_delivery_state (sms_part, view.delivery_state);
+    mm_sms_part_set_encoding (sms_part, view.encoding);
+    mm_sms_part_set_class (sms_part, view.class);
+
+    if (view.concat) {
+        mm_sms_part_set_concat_reference (sms_part, view.concat_reference);
+        mm_sms_part_set_concat_max (sms_part, view.concat_max);
+        mm_sms_part_set_concat_sequence (sms_part, view.concat_sequence);
+    }
+
+    if (view.user_data_offset) {
+        const guint8 *data;
+        gsize data_len = 0;
+
+        data = mm_sms_part_3gpp_view_peek_data (&view, &data_len);
+        if (data) {
+            GByteArray *raw;
+
+            mm_dbg ("Skipping SMS text: Unknown encoding (0x%02X)", view.encoding);
+            raw = g_byte_array_sized_new (data_len);
+            g_byte_array_append (raw, data, data_len);
+            mm_sms_part_take_data (sms_part, raw);
+        } else {
+            mm_dbg ("Decoding SMS text with '%u' elements", view.user_data_elements);
+            mm_sms_part_take_text (sms_part, mm_sms_part_3gpp_view_get_text (&view));
+            g_warn_if_fail (mm_sms_part_get_text (sms_part) != NULL);
         }
     }
 
@@ -1044,6 +1109,128 @@ error:
     return NULL;
 }
 
+/*****************************************************************************/
+
+/* Bitmap of the 256 possible references, for each number */
+#define REFERENCES_BITMAP_SIZE (256 / 8)
+
+GHashTable *
+mm_sms_part_3gpp_reserved_references_new (void)
+{
+    return g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+}
+
+guint8
+mm_sms_part_3gpp_reserve_reference (GHashTable *reserved,
+                                    const gchar *number,
+                                    MMSmsPart3gppReferenceInUseFn in_use,
+                                    gpointer user_data)
+{
+    guint8 *bitmap = NULL;
+    guint8 reference;
+    guint8 first;
+
+    if (!number)
+        number = "";
+
+    if (reserved) {
+        bitmap = g_hash_table_lookup (reserved, number);
+        if (!bitmap) {
+            bitmap = g_malloc0 (REFERENCES_BITMAP_SIZE);
+            g_hash_table_insert (reserved, g_strdup (number), bitmap);
+        }
+    }
+
+    /* Start by looking for a random number; reference 0 is not valid */
+    reference = g_random_int_range (1, 256);
+    first = reference;
+    do {
+        if ((!bitmap || !(bitmap[reference / 8] & (1 << (reference % 8)))) &&
+            (!in_use || !in_use (number, reference, user_data))) {
+            if (bitmap)
+                bitmap[reference / 8] |= (1 << (reference % 8));
+            return reference;
+        }
+
+        if (reference == 255)
+            reference = 1;
+        else
+            reference++;
+    } while (reference != first);
+
+    /* No reference left */
+    return 0;
+}
+
+GList *
+mm_sms_part_3gpp_new_submit_parts (const gchar *number,
+                                   const gchar *text,
+                                   GHashTable *reserved,
+                                   MMSmsPart3gppReferenceInUseFn in_use,
+                                   gpointer user_data,
+                                   GError **error)
+{
+    MMSmsEncoding encoding = MM_SMS_ENCODING_UNKNOWN;
+    gchar **split_text;
+    GList *parts = NULL;
+    guint n_parts;
+    guint8 reference = 0;
+    guint i;
+
+    split_text = mm_sms_part_3gpp_util_split_text (text, &encoding);
+    if (!split_text) {
+        g_set_error (error,
+                     MM_CORE_ERROR,
+                     MM_CORE_ERROR_INVALID_ARGS,
+                     "Cannot generate PDUs: Error processing input text");
+        return NULL;
+    }
+
+    n_parts = g_strv_length (split_text);
+    if (n_parts > 255) {
+        g_strfreev (split_text);
+        g_set_error (error,
+                     MM_CORE_ERROR,
+                     MM_CORE_ERROR_TOO_MANY,
+                     "Cannot generate PDUs: Text too long");
+        return NULL;
+    }
+
+    if (n_parts > 1) {
+        reference = mm_sms_part_3gpp_reserve_reference (reserved, number, in_use, user_data);
+        if (!reference) {
+            g_strfreev (split_text);
+            g_set_error (error,
+                         MM_CORE_ERROR,
+                         MM_CORE_ERROR_TOO_MANY,
+                         "Cannot create multipart SMS: No valid multipart reference "
+                         "available for destination number '%s'",
+                         number);
+            return NULL;
+        }
+    }
+
+    for (i = 0; i < n_parts; i++) {
+        MMSmsPart *part;
+
+        part = mm_sms_part_new (SMS_PART_INVALID_INDEX, MM_SMS_PDU_TYPE_SUBMIT);
+        mm_sms_part_set_text (part, split_text[i]);
+        mm_sms_part_set_encoding (part, encoding);
+        mm_sms_part_set_number (part, number);
+        if (n_parts > 1) {
+            mm_sms_part_set_concat_reference (part, reference);
+            mm_sms_part_set_concat_sequence (part, i + 1);
+            mm_sms_part_set_concat_max (part, n_parts);
+        }
+        parts = g_list_prepend (parts, part);
+    }
+
+    g_strfreev (split_text);
+    return g_list_reverse (parts);
+}
+
+/*****************************************************************************/
+
 gchar **
 mm_sms_part_3gpp_util_split_text (const gchar *text,
                                   MMSmsEncoding *encoding)
@@ -22,6 +22,51 @@
 
 #include "mm-sms-part.h"
 
+/* A parsed 3GPP PDU, referring to the binary PDU it was parsed from, which
+ * must be kept around while the view is in use. Parsing doesn't allocate;
+ * addresses, timestamps and text are only decoded when requested. */
+typedef struct {
+    const guint8 *pdu;
+    gsize pdu_len;
+
+    MMSmsPduType pdu_type;
+    gboolean delivery_report_request;
+    guint message_reference;
+    guint validity_relative; /* 0 if not given */
+    guint delivery_state;
+    MMSmsEncoding encoding;
+    gint class; /* -1 if not given */
+
+    gboolean concat;
+    guint concat_reference;
+    guint concat_max;
+    guint concat_sequence;
+
+    /* Offsets in the PDU, 0 if not given; address lengths in semi-octets */
+    guint smsc_offset;
+    guint smsc_len;
+    guint number_offset;
+    guint number_len;
+    guint timestamp_offset;
+    guint discharge_timestamp_offset;
+    guint user_data_offset;
+    guint user_data_elements;
+    guint user_data_bytes;
+    guint user_data_bit_offset;
+} MMSmsPart3gppView;
+
+gboolean      mm_sms_part_3gpp_view_parse                   (MMSmsPart3gppView *view,
+                                                             const guint8 *pdu,
+                                                             gsize pdu_len,
+                                                             GError **error);
+gchar        *mm_sms_part_3gpp_view_get_smsc                (const MMSmsPart3gppView *view);
+gchar        *mm_sms_part_3gpp_view_get_number              (const MMSmsPart3gppView *view);
+gchar        *mm_sms_part_3gpp_view_get_timestamp           (const MMSmsPart3gppView *view);
+gchar        *mm_sms_part_3gpp_view_get_discharge_timestamp (const MMSmsPart3gppView *view);
+gchar        *mm_sms_part_3gpp_view_get_text                (const MMSmsPart3gppView *view);
+const guint8 *mm_sms_part_3gpp_view_peek_data               (const MMSmsPart3gppView *view,
+                                                             gsize *data_len);
+
 MMSmsPart *mm_sms_part_3gpp_new_from_pdu  (guint index,
                                            const gchar *hexpdu,
                                            GError **error);
@@ -36,6 +81,27 @@ guint8    *mm_sms_part_3gpp_get_submit_pdu (MMSmsPart *part,
                                             guint *out_msgstart,
                                             GError **error);
 
+/* Multipart references reserved per destination number, e.g. for the
+ * messages of a batch, which aren't kept anywhere else while being sent */
+typedef gboolean (* MMSmsPart3gppReferenceInUseFn) (const gchar *number,
+                                                    guint8 reference,
+                                                    gpointer user_data);
+
+GHashTable *mm_sms_part_3gpp_reserved_references_new (void);
+guint8      mm_sms_part_3gpp_reserve_reference       (GHashTable *reserved,
+                                                      const gchar *number,
+                                                      MMSmsPart3gppReferenceInUseFn in_use,
+                                                      gpointer user_data);
+
+/* Builds the SUBMIT parts of a text message, splitting it as needed; multipart
+ * messages get a reference reserved as above */
+GList *mm_sms_part_3gpp_new_submit_parts (const gchar *number,
+                                          const gchar *text,
+                                          GHashTable *reserved,
+                                          MMSmsPart3gppReferenceInUseFn in_use,
+                                          gpointer user_data,
+                                          GError **error);
+
 /* For testcases only */
 
 guint mm_sms_part_3gpp_encode_address (const gchar *address,
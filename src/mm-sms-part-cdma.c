@@ -23,6 +23,7 @@
 #include <libmm-glib.h>
 
 #include "mm-charsets.h"
+#include "mm-bit-stream.h"
 #include "mm-sms-part-cdma.h"
 #include "mm-log.h"
 
@@ -228,37 +229,6 @@ encoding_to_string (Encoding encoding)
     return "unknown";
 }
 
-/*****************************************************************************/
-/* Read bits; o_bits < 8; n_bits <= 8
- *
- * Byte 0            Byte 1
- * [7|6|5|4|3|2|1|0] [7|6|5|4|3|2|1|0]
- *
- * o_bits+n_bits <= 16
- *
- */
-static guint8
-read_bits (const guint8 *bytes,
-           guint8 o_bits,
-           guint8 n_bits)
-{
-    guint8 bits_in_first;
-    guint8 bits_in_second;
-
-    g_assert (o_bits < 8);
-    g_assert (n_bits <= 8);
-    g_assert (o_bits + n_bits <= 16);
-
-    /* Read only from the first byte */
-    if (o_bits + n_bits <= 8)
-        return (bytes[0] >> (8 - o_bits - n_bits)) & ((1 << n_bits) - 1);
-
-    /* Read (8 - o_bits) from the first byte and (n_bits - (8 - o_bits)) from the second byte */
-    bits_in_first = 8 - o_bits;
-    bits_in_second = n_bits - bits_in_first;
-    return (read_bits (&bytes[0], o_bits, bits_in_first) << bits_in_second) | read_bits (&bytes[1], 0, bits_in_second);
-}
-
 /*****************************************************************************/
 /* Cause code to delivery state */
 
@@ -467,39 +437,36 @@ static void
 read_address (MMSmsPart *sms_part,
               const struct Parameter *parameter)
 {
-    guint8 digit_mode;
-    guint8 number_mode;
-    guint8 number_type;
-    guint8 numbering_plan;
-    guint8 num_fields;
-    guint byte_offset = 0;
-    guint bit_offset = 0;
+    MMBitReader reader;
+    guint32 digit_mode;
+    guint32 number_mode;
+    guint32 number_type;
+    guint32 numbering_plan;
+    guint32 num_fields;
+    guint32 value;
     guint i;
     gchar *number = NULL;
 
-#define OFFSETS_UPDATE(n_bits) do { \
-        bit_offset += n_bits;       \
-        if (bit_offset >= 8) {      \
-            bit_offset-=8;          \
-            byte_offset++;          \
-        }                           \
-    } while (0)
+#define READ_BITS(n_bits, out)                                          \
+    if (!mm_bit_reader_read (&reader, n_bits, &out)) {                  \
+        mm_dbg ("        cannot read address, need at least %u more bits (got %" G_GSIZE_FORMAT ")", \
+                (guint) (n_bits),                                       \
+                mm_bit_reader_get_remaining (&reader));                 \
+        return;                                                         \
+    }
 
-#define PARAMETER_SIZE_CHECK(required_size)                             \
-    if (parameter->parameter_len < required_size) {                     \
-        mm_dbg ("        cannot read address, need at least %u bytes (got %u)", \
-                required_size,                                          \
-                parameter->parameter_len);                              \
+#define READABILITY_CHECK(required_bits)                                \
+    if (mm_bit_reader_get_remaining (&reader) < (required_bits)) {      \
+        mm_dbg ("        cannot read address, need at least %u more bits (got %" G_GSIZE_FORMAT ")", \
+                (guint) (required_bits),                                \
+                mm_bit_reader_get_remaining (&reader));                 \
         return;                                                         \
     }
 
-    /* Readability of digit mode and number mode (first 2 bits, i.e. first byte) */
-    PARAMETER_SIZE_CHECK (1);
+    mm_bit_reader_init (&reader, parameter->parameter_value, parameter->parameter_len);
 
     /* Digit mode */
-    digit_mode = read_bits (&parameter->parameter_value[byte_offset], bit_offset, 1);
-    OFFSETS_UPDATE (1);
-    g_assert (digit_mode <= 1);
+    READ_BITS (1, digit_mode);
     switch (digit_mode) {
     case DIGIT_MODE_DTMF:
         mm_dbg ("        digit mode: dtmf");
@@ -512,8 +479,7 @@ read_address (MMSmsPart *sms_part,
     }
 
     /* Number mode */
-    number_mode = read_bits (&parameter->parameter_value[byte_offset], bit_offset, 1);
-    OFFSETS_UPDATE (1);
+    READ_BITS (1, number_mode);
     switch (number_mode) {
     case NUMBER_MODE_DIGIT:
         mm_dbg ("        number mode: digit");
@@ -527,9 +493,7 @@ read_address (MMSmsPart *sms_part,
 
     /* Number type */
     if (digit_mode == DIGIT_MODE_ASCII) {
-        /* No need for readability check, still in first byte always */
-        number_type = read_bits (&parameter->parameter_value[byte_offset], bit_offset, 3);
-        OFFSETS_UPDATE (3);
+        READ_BITS (3, number_type);
         switch (number_type) {
         case NUMBER_TYPE_UNKNOWN:
             mm_dbg ("        number type: unknown");
@@ -558,10 +522,7 @@ read_address (MMSmsPart *sms_part,
 
     /* Numbering plan */
     if (digit_mode == DIGIT_MODE_ASCII && number_mode == NUMBER_MODE_DIGIT) {
-        /* Readability of numbering plan; may go to second byte */
-        PARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + 4) / 8));
-        numbering_plan = read_bits (&parameter->parameter_value[byte_offset], bit_offset, 4);
-        OFFSETS_UPDATE (4);
+        READ_BITS (4, numbering_plan);
         switch (numbering_plan) {
         case NUMBERING_PLAN_UNKNOWN:
             mm_dbg ("        numbering plan: unknown");
@@ -582,57 +543,38 @@ read_address (MMSmsPart *sms_part,
             mm_dbg ("        numbering plan unknown (%u)", numbering_plan);
             break;
         }
-    } else
-        numbering_plan = 0xFF;
+    }
 
-    /* Readability of num_fields; will go to third byte (((bit_offset + 8) / 8) == 1) */
-    PARAMETER_SIZE_CHECK (byte_offset + 2);
-    num_fields = read_bits (&parameter->parameter_value[byte_offset], bit_offset, 8);
-    OFFSETS_UPDATE (8);
+    READ_BITS (8, num_fields);
     mm_dbg ("        num fields: %u", num_fields);
 
     /* Address string */
 
     if (digit_mode == DIGIT_MODE_DTMF) {
         /* DTMF */
-        PARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 4)) / 8));
+        READABILITY_CHECK (num_fields * 4);
         number = g_malloc (num_fields + 1);
         for (i = 0; i < num_fields; i++) {
-            number[i] = dtmf_to_ascii (read_bits (&parameter->parameter_value[byte_offset], bit_offset, 4));
-            OFFSETS_UPDATE (4);
+            mm_bit_reader_read (&reader, 4, &value);
+            number[i] = dtmf_to_ascii (value);
         }
         number[i] = '\0';
-    } else if (number_mode == NUMBER_MODE_DIGIT) {
-        /* ASCII
+    } else if (number_mode == NUMBER_MODE_DIGIT ||
+               number_type == DATA_NETWORK_ADDRESS_TYPE_INTERNET_EMAIL_ADDRESS) {
+        /* ASCII, or Internet e-mail address (ASCII)
          * TODO: should we expose numbering plan and number type? */
-        PARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 8)) / 8));
+        READABILITY_CHECK (num_fields * 8);
         number = g_malloc (num_fields + 1);
-        for (i = 0; i < num_fields; i++) {
-            number[i] = read_bits (&parameter->parameter_value[byte_offset], bit_offset, 8);
-            OFFSETS_UPDATE (8);
-        }
-        number[i] = '\0';
-    } else if (number_type == DATA_NETWORK_ADDRESS_TYPE_INTERNET_EMAIL_ADDRESS) {
-        /* Internet e-mail address (ASCII) */
-        PARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 8)) / 8));
-        number = g_malloc (num_fields + 1);
-        for (i = 0; i < num_fields; i++) {
-            number[i] = read_bits (&parameter->parameter_value[byte_offset], bit_offset, 8);
-            OFFSETS_UPDATE (8);
-        }
-        number[i] = '\0';
+        mm_bit_reader_read_bytes (&reader, (guint8 *)number, num_fields);
+        number[num_fields] = '\0';
     } else if (number_type == DATA_NETWORK_ADDRESS_TYPE_INTERNET_PROTOCOL) {
-        GString *str;
+        guint8 address[G_MAXUINT8];
 
         /* Binary data network address (most significant first)
          * For now, just print the hex string (e.g. FF:01...) */
-        PARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 8)) / 8));
-        str = g_string_sized_new (num_fields * 2);
-        for (i = 0; i < num_fields; i++) {
-            g_string_append_printf (str, "%.2X", read_bits (&parameter->parameter_value[byte_offset], bit_offset, 8));
-            OFFSETS_UPDATE (8);
-        }
-        number = g_string_free (str, FALSE);
+        READABILITY_CHECK (num_fields * 8);
+        mm_bit_reader_read_bytes (&reader, address, num_fields);
+        number = mm_utils_bin2hexstr (address, num_fields);
     } else
         mm_dbg ("        data network address number type unknown (%u)", number_type);
 
@@ -641,15 +583,16 @@ read_address (MMSmsPart *sms_part,
     mm_sms_part_set_number (sms_part, number);
     g_free (number);
 
-#undef OFFSETS_UPDATE
-#undef PARAMETER_SIZE_CHECK
+#undef READ_BITS
+#undef READABILITY_CHECK
 }
 
 static void
 read_bearer_reply_option (MMSmsPart *sms_part,
                           const struct Parameter *parameter)
 {
-    guint8 sequence;
+    MMBitReader reader;
+    guint32 sequence;
 
     g_assert (parameter->parameter_id == PARAMETER_ID_BEARER_REPLY_OPTION);
 
@@ -659,7 +602,8 @@ read_bearer_reply_option (MMSmsPart *sms_part,
         return;
     }
 
-    sequence = read_bits (&parameter->parameter_value[0], 0, 6);
+    mm_bit_reader_init (&reader, parameter->parameter_value, parameter->parameter_len);
+    mm_bit_reader_read (&reader, 6, &sequence);
     mm_dbg ("        sequence: %u", sequence);
 
     mm_sms_part_set_message_reference (sms_part, sequence);
@@ -669,12 +613,13 @@ static void
 read_cause_codes (MMSmsPart *sms_part,
                   const struct Parameter *parameter)
 {
-    guint8 sequence;
-    guint8 error_class;
-    guint8 cause_code;
+    MMBitReader reader;
+    guint32 sequence;
+    guint32 error_class;
+    guint32 cause_code;
     MMSmsDeliveryState delivery_state;
 
-    g_assert (parameter->parameter_id == PARAMETER_ID_BEARER_REPLY_OPTION);
+    g_assert (parameter->parameter_id == PARAMETER_ID_CAUSE_CODES);
 
     if (parameter->parameter_len != 1 && parameter->parameter_len != 2) {
         mm_dbg ("        invalid cause codes length found (%u): ignoring",
@@ -682,19 +627,20 @@ read_cause_codes (MMSmsPart *sms_part,
         return;
     }
 
-    sequence = read_bits (&parameter->parameter_value[0], 0, 6);
+    mm_bit_reader_init (&reader, parameter->parameter_value, parameter->parameter_len);
+
+    mm_bit_reader_read (&reader, 6, &sequence);
     mm_dbg ("        sequence: %u", sequence);
 
-    error_class = read_bits (&parameter->parameter_value[0], 6, 2);
+    mm_bit_reader_read (&reader, 2, &error_class);
     mm_dbg ("        error class: %u", error_class);
 
     if (error_class != ERROR_CLASS_NO_ERROR) {
-        if (parameter->parameter_len != 2) {
+        if (!mm_bit_reader_read (&reader, 8, &cause_code)) {
             mm_dbg ("        invalid cause codes length found (%u != 2): ignoring",
                     parameter->parameter_len);
             return;
         }
-        cause_code = parameter->parameter_value[1];
         mm_dbg ("        cause code: %u", cause_code);
     } else
         cause_code = 0;
@@ -710,9 +656,10 @@ static void
 read_bearer_data_message_identifier (MMSmsPart *sms_part,
                                      const struct Parameter *subparameter)
 {
-    guint8 message_type;
-    guint16 message_id;
-    guint8 header_ind;
+    MMBitReader reader;
+    guint32 message_type;
+    guint32 message_id;
+    guint32 header_ind;
 
     g_assert (subparameter->parameter_id == SUBPARAMETER_ID_MESSAGE_ID);
 
@@ -722,7 +669,9 @@ read_bearer_data_message_identifier (MMSmsPart *sms_part,
         return;
     }
 
-    message_type = read_bits (&subparameter->parameter_value[0], 0, 4);
+    mm_bit_reader_init (&reader, subparameter->parameter_value, subparameter->parameter_len);
+
+    mm_bit_reader_read (&reader, 4, &message_type);
     switch (message_type) {
     case TELESERVICE_MESSAGE_TYPE_UNKNOWN:
         mm_dbg ("            message type: unknown");
@@ -756,12 +705,10 @@ read_bearer_data_message_identifier (MMSmsPart *sms_part,
         break;
     }
 
-    message_id = ((read_bits (&subparameter->parameter_value[0], 4, 8) << 8) |
-                  (read_bits (&subparameter->parameter_value[1], 4, 8)));
-    message_id = GUINT16_FROM_BE (message_id);
-    mm_dbg ("            message id: %u", (guint) message_id);
+    mm_bit_reader_read (&reader, 16, &message_id);
+    mm_dbg ("            message id: %u", message_id);
 
-    header_ind = read_bits (&subparameter->parameter_value[2], 4, 1);
+    mm_bit_reader_read (&reader, 1, &header_ind);
     mm_dbg ("            header indicator: %u", header_ind);
 }
 
@@ -769,64 +716,58 @@ static void
 read_bearer_data_user_data (MMSmsPart *sms_part,
                             const struct Parameter *subparameter)
 {
-    guint8 message_encoding;
-    guint8 message_type = 0;
-    guint8 num_fields;
-    guint byte_offset = 0;
-    guint bit_offset = 0;
-
-#define OFFSETS_UPDATE(n_bits) do { \
-        bit_offset += n_bits;       \
-        if (bit_offset >= 8) {      \
-            bit_offset-=8;          \
-            byte_offset++;          \
-        }                           \
-    } while (0)
-
-#define SUBPARAMETER_SIZE_CHECK(required_size)                             \
-    if (subparameter->parameter_len < required_size) {                  \
-        mm_dbg ("        cannot read user data, need at least %u bytes (got %u)", \
-                required_size,                                          \
-                subparameter->parameter_len);                           \
+    MMBitReader reader;
+    guint32 message_encoding;
+    guint32 message_type = 0;
+    guint32 num_fields;
+    guint32 value;
+    /* Up to 255 fields of 2 bytes each */
+    guint8 buffer[2 * G_MAXUINT8];
+
+#define READ_BITS(n_bits, out)                                          \
+    if (!mm_bit_reader_read (&reader, n_bits, &out)) {                  \
+        mm_dbg ("        cannot read user data, need at least %u more bits (got %" G_GSIZE_FORMAT ")", \
+                (guint) (n_bits),                                       \
+                mm_bit_reader_get_remaining (&reader));                 \
+        return;                                                         \
+    }
+
+#define READABILITY_CHECK(required_bits)                                \
+    if (mm_bit_reader_get_remaining (&reader) < (required_bits)) {      \
+        mm_dbg ("        cannot read user data, need at least %u more bits (got %" G_GSIZE_FORMAT ")", \
+                (guint) (required_bits),                                \
+                mm_bit_reader_get_remaining (&reader));                 \
         return;                                                         \
     }
 
     g_assert (subparameter->parameter_id == SUBPARAMETER_ID_USER_DATA);
 
+    mm_bit_reader_init (&reader, subparameter->parameter_value, subparameter->parameter_len);
+
     /* Message encoding */
-    SUBPARAMETER_SIZE_CHECK (1);
-    message_encoding = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 5);
-    OFFSETS_UPDATE (5);
+    READ_BITS (5, message_encoding);
     mm_dbg ("            message encoding: %s", encoding_to_string (message_encoding));
 
     /* Message type, only if extended protocol message */
     if (message_encoding == ENCODING_EXTENDED_PROTOCOL_MESSAGE) {
-        SUBPARAMETER_SIZE_CHECK (2);
-        message_type = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 8);
-        OFFSETS_UPDATE (8);
+        READ_BITS (8, message_type);
         mm_dbg ("            message type: %u", message_type);
     }
 
     /* Number of fields */
-    SUBPARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + 8) / 8));
-    num_fields = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 8);
-    OFFSETS_UPDATE (8);
+    READ_BITS (8, num_fields);
     mm_dbg ("            num fields: %u", num_fields);
 
     /* Now, process actual text or data */
     switch (message_encoding) {
     case ENCODING_OCTET: {
         GByteArray *data;
-        guint i;
 
-        SUBPARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 8)) / 8));
+        READABILITY_CHECK (num_fields * 8);
 
         data = g_byte_array_sized_new (num_fields);
         g_byte_array_set_size (data, num_fields);
-        for (i = 0; i < num_fields; i++) {
-            data->data[i] = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 8);
-            OFFSETS_UPDATE (8);
-        }
+        mm_bit_reader_read_bytes (&reader, data->data, num_fields);
 
         mm_dbg ("            data: (%u bytes)", num_fields);
         mm_sms_part_take_data (sms_part, data);
@@ -837,12 +778,12 @@ read_bearer_data_user_data (MMSmsPart *sms_part,
         gchar *text;
         guint i;
 
-        SUBPARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 7)) / 8));
+        READABILITY_CHECK (num_fields * 7);
 
         text = g_malloc (num_fields + 1);
         for (i = 0; i < num_fields; i++) {
-            text[i] = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 7);
-            OFFSETS_UPDATE (7);
+            mm_bit_reader_read (&reader, 7, &value);
+            text[i] = value;
         }
         text[i] = '\0';
 
@@ -852,57 +793,41 @@ read_bearer_data_user_data (MMSmsPart *sms_part,
     }
 
     case ENCODING_LATIN: {
-        gchar *latin;
         gchar *text;
-        guint i;
 
-        SUBPARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 8)) / 8));
+        READABILITY_CHECK (num_fields * 8);
 
-        latin = g_malloc (num_fields + 1);
-        for (i = 0; i < num_fields; i++) {
-            latin[i] = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 8);
-            OFFSETS_UPDATE (8);
-        }
-        latin[i] = '\0';
+        mm_bit_reader_read_bytes (&reader, buffer, num_fields);
 
-        text = g_convert (latin, -1, "UTF-8", "ISO−8859−1", NULL, NULL, NULL);
+        text = g_convert ((const gchar *)buffer, strnlen ((const gchar *)buffer, num_fields),
+                          "UTF-8", "ISO−8859−1", NULL, NULL, NULL);
         if (!text) {
             mm_dbg ("            text/data: ignored (latin to UTF-8 conversion error)");
         } else {
             mm_dbg ("            text: '%s'", text);
             mm_sms_part_take_text (sms_part, text);
         }
-
-        g_free (latin);
         break;
     }
 
     case ENCODING_UNICODE: {
-        gchar *utf16;
         gchar *text;
-        guint i;
         guint num_bytes;
 
         /* 2 bytes per field! */
         num_bytes = num_fields * 2;
 
-        SUBPARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_bytes * 8)) / 8));
+        READABILITY_CHECK (num_bytes * 8);
 
-        utf16 = g_malloc (num_bytes);
-        for (i = 0; i < num_bytes; i++) {
-            utf16[i] = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 8);
-            OFFSETS_UPDATE (8);
-        }
+        mm_bit_reader_read_bytes (&reader, buffer, num_bytes);
 
-        text = g_convert (utf16, num_bytes, "UTF-8", "UCS-2BE", NULL, NULL, NULL);
+        text = g_convert ((const gchar *)buffer, num_bytes, "UTF-8", "UCS-2BE", NULL, NULL, NULL);
         if (!text) {
             mm_dbg ("            text/data: ignored (UTF-16 to UTF-8 conversion error)");
         } else {
             mm_dbg ("            text: '%s'", text);
             mm_sms_part_take_text (sms_part, text);
         }
-
-        g_free (utf16);
         break;
     }
 
@@ -910,8 +835,8 @@ read_bearer_data_user_data (MMSmsPart *sms_part,
         mm_dbg ("            text/data: ignored (unsupported encoding)");
     }
 
-#undef OFFSETS_UPDATE
-#undef SUBPARAMETER_SIZE_CHECK
+#undef READ_BITS
+#undef READABILITY_CHECK
 }
 
 static void
@@ -1155,43 +1080,6 @@ mm_sms_part_cdma_new_from_binary_pdu (guint index,
     return sms_part;
 }
 
-/*****************************************************************************/
-/* Write bits; o_bits < 8; n_bits <= 8
- *
- * Byte 0            Byte 1
- * [7|6|5|4|3|2|1|0] [7|6|5|4|3|2|1|0]
- *
- * o_bits+n_bits <= 16
- *
- * NOTE! The bits being set should be 0 initially.
- */
-static void
-write_bits (guint8 *bytes,
-            guint8 o_bits,
-            guint8 n_bits,
-            guint8 bits)
-{
-    guint8 bits_in_first;
-    guint8 bits_in_second;
-
-    g_assert (o_bits < 8);
-    g_assert (n_bits <= 8);
-    g_assert (o_bits + n_bits <= 16);
-
-    /* Write only in the first byte */
-    if (o_bits + n_bits <= 8) {
-        bytes[0] |= (bits & ((1 << n_bits) - 1)) << (8 - o_bits - n_bits);
-        return;
-    }
-
-    /* Write (8 - o_bits) in the first byte and (n_bits - (8 - o_bits)) in the second byte */
-    bits_in_first = 8 - o_bits;
-    bits_in_second = n_bits - bits_in_first;
-
-    write_bits (&bytes[0], o_bits, bits_in_first, (bits >> bits_in_second));
-    write_bits (&bytes[1], 0, bits_in_second, bits);
-}
-
 /*****************************************************************************/
 
 static guint8
@@ -1250,57 +1138,44 @@ write_destination_address (MMSmsPart *part,
                            guint *absolute_offset,
                            GError **error)
 {
+    MMBitWriter writer;
     const gchar *number;
-    guint bit_offset;
-    guint byte_offset;
     guint n_digits;
     guint i;
 
     mm_dbg ("    writing destination address...");
 
-#define OFFSETS_UPDATE(n_bits) do { \
-        bit_offset += n_bits;       \
-        if (bit_offset >= 8) {      \
-            bit_offset-=8;          \
-            byte_offset++;          \
-        }                           \
-    } while (0)
-
     number = mm_sms_part_get_number (part);
     n_digits = strlen (number);
 
     pdu[0] = PARAMETER_ID_DESTINATION_ADDRESS;
     /* Write parameter length at the end */
 
-    byte_offset = 2;
-    bit_offset = 0;
+    mm_bit_writer_init (&writer, &pdu[2], G_MAXUINT8);
 
     /* Digit mode: DTMF always */
     mm_dbg ("        digit mode: dtmf");
-    write_bits (&pdu[byte_offset], bit_offset, 1, DIGIT_MODE_DTMF);
-    OFFSETS_UPDATE (1);
+    mm_bit_writer_write (&writer, 1, DIGIT_MODE_DTMF);
 
     /* Number mode: DIGIT always */
     mm_dbg ("        number mode: digit");
-    write_bits (&pdu[byte_offset], bit_offset, 1, NUMBER_MODE_DIGIT);
-    OFFSETS_UPDATE (1);
+    mm_bit_writer_write (&writer, 1, NUMBER_MODE_DIGIT);
 
     /* Number type and numbering plan only needed in ASCII digit mode, so skip */
 
     /* Number of fields */
-    if (n_digits > 256) {
+    if (n_digits > G_MAXUINT8) {
         g_set_error (error,
                      MM_CORE_ERROR,
                      MM_CORE_ERROR_UNSUPPORTED,
-                     "Number too long (max 256 digits, %u given)",
+                     "Number too long (max 255 digits, %u given)",
                      n_digits);
         return FALSE;
     }
     mm_dbg ("        num fields: %u", n_digits);
-    write_bits (&pdu[byte_offset], bit_offset, 8, n_digits);
-    OFFSETS_UPDATE (8);
+    mm_bit_writer_write (&writer, 8, n_digits);
 
-    /* Actual DTMF encoded number */
+    /* Actual DTMF encoded number; 255 digits always fit in the parameter */
     mm_dbg ("        address: %s", number);
     for (i = 0; i < n_digits; i++) {
         guint8 dtmf;
@@ -1314,23 +1189,11 @@ write_destination_address (MMSmsPart *part,
                          number[i]);
             return FALSE;
         }
-        write_bits (&pdu[byte_offset], bit_offset, 4, dtmf);
-        OFFSETS_UPDATE (4);
+        mm_bit_writer_write (&writer, 4, dtmf);
     }
 
-#undef OFFSETS_UPDATE
-
-    /* Write parameter length (remove header length to offset) */
-    byte_offset += !!bit_offset - 2;
-    if (byte_offset > 256) {
-        g_set_error (error,
-                     MM_CORE_ERROR,
-                     MM_CORE_ERROR_UNSUPPORTED,
-                     "Number too long (max 256 bytes, %u given)",
-                     byte_offset);
-        return FALSE;
-    }
-    pdu[1] = byte_offset;
+    /* Write parameter length */
+    pdu[1] = mm_bit_writer_get_length (&writer);
 
     *absolute_offset += (2 + pdu[1]);
     return TRUE;
@@ -1342,13 +1205,16 @@ write_bearer_data_message_identifier (MMSmsPart *part,
                                       guint *parameter_offset,
                                       GError **error)
 {
+    MMBitWriter writer;
+
     pdu[0] = SUBPARAMETER_ID_MESSAGE_ID;
     pdu[1] = 3; /* subparameter_len, always 3 */
 
     mm_dbg ("        writing message identifier: submit");
 
     /* Message type */
-    write_bits (&pdu[2], 0, 4, TELESERVICE_MESSAGE_TYPE_SUBMIT);
+    mm_bit_writer_init (&writer, &pdu[2], pdu[1]);
+    mm_bit_writer_write (&writer, 4, TELESERVICE_MESSAGE_TYPE_SUBMIT);
 
     /* Skip adding a message id; assume it's filled in by device */
 
@@ -1419,28 +1285,19 @@ write_bearer_data_user_data (MMSmsPart *part,
                              guint *parameter_offset,
                              GError **error)
 {
+    MMBitWriter writer;
     const gchar *text;
     const GByteArray *data;
-    guint bit_offset = 0;
-    guint byte_offset = 0;
     guint num_fields;
     guint num_bits_per_field;
     guint i;
     Encoding encoding;
     GByteArray *converted = NULL;
     const GByteArray *aux;
-    guint num_bits_per_iter;
+    gboolean written;
 
     mm_dbg ("        writing user data...");
 
-#define OFFSETS_UPDATE(n_bits) do { \
-        bit_offset += n_bits;       \
-        if (bit_offset >= 8) {      \
-            bit_offset-=8;          \
-            byte_offset++;          \
-        }                           \
-    } while (0)
-
     text = mm_sms_part_get_text (part);
     data = mm_sms_part_get_data (part);
     g_assert (text || data);
@@ -1448,8 +1305,7 @@ write_bearer_data_user_data (MMSmsPart *part,
 
     pdu[0] = SUBPARAMETER_ID_USER_DATA;
     /* Write parameter length at the end */
-    byte_offset = 2;
-    bit_offset = 0;
+    mm_bit_writer_init (&writer, &pdu[2], G_MAXUINT8);
 
     /* Text or Data */
     if (text) {
@@ -1468,23 +1324,21 @@ write_bearer_data_user_data (MMSmsPart *part,
 
     /* Message encoding*/
     mm_dbg ("            message encoding: %s", encoding_to_string (encoding));
-    write_bits (&pdu[byte_offset], bit_offset, 5, encoding);
-    OFFSETS_UPDATE (5);
+    mm_bit_writer_write (&writer, 5, encoding);
 
     /* Number of fields */
-    if (num_fields > 256) {
+    if (num_fields > G_MAXUINT8) {
         if (converted)
             g_byte_array_unref (converted);
         g_set_error (error,
                      MM_CORE_ERROR,
                      MM_CORE_ERROR_UNSUPPORTED,
-                     "Data too long (max 256 fields, %u given)",
+                     "Data too long (max 255 fields, %u given)",
                      num_fields);
         return FALSE;
     }
     mm_dbg ("            num fields: %u", num_fields);
-    write_bits (&pdu[byte_offset], bit_offset, 8, num_fields);
-    OFFSETS_UPDATE (8);
+    mm_bit_writer_write (&writer, 8, num_fields);
 
     /* For ASCII-7, write 7 bits in each iteration; for the remaining ones
      * go byte per byte */
@@ -1492,28 +1346,26 @@ write_bearer_data_user_data (MMSmsPart *part,
         mm_dbg ("            text: '%s'", text);
     else
         mm_dbg ("            data: (%u bytes)", num_fields);
-    num_bits_per_iter = num_bits_per_field < 8 ? num_bits_per_field : 8;
-    for (i = 0; i < aux->len; i++) {
-        write_bits (&pdu[byte_offset], bit_offset, num_bits_per_iter, aux->data[i]);
-        OFFSETS_UPDATE (num_bits_per_iter);
-    }
+    if (num_bits_per_field < 8) {
+        written = TRUE;
+        for (i = 0; written && i < aux->len; i++)
+            written = mm_bit_writer_write (&writer, num_bits_per_field, aux->data[i]);
+    } else
+        written = mm_bit_writer_write_bytes (&writer, aux->data, aux->len);
 
     if (converted)
         g_byte_array_unref (converted);
 
-#undef OFFSETS_UPDATE
-
-    /* Write subparameter length (remove header length to offset) */
-    byte_offset += !!bit_offset - 2;
-    if (byte_offset > 256) {
+    if (!written) {
         g_set_error (error,
                      MM_CORE_ERROR,
                      MM_CORE_ERROR_UNSUPPORTED,
-                     "Data or Text too long (max 256 bytes, %u given)",
-                     byte_offset);
+                     "Data or Text too long (max 255 bytes)");
         return FALSE;
     }
-    pdu[1] = byte_offset;
+
+    /* Write subparameter length */
+    pdu[1] = mm_bit_writer_get_length (&writer);
 
     *parameter_offset += (2 + pdu[1]);
     return TRUE;
@@ -1547,11 +1399,11 @@ write_bearer_data (MMSmsPart *part,
 
     /* Write parameter length (remove header length to offset) */
     offset -= 2;
-    if (offset > 256) {
+    if (offset > G_MAXUINT8) {
         g_set_error (error,
                      MM_CORE_ERROR,
                      MM_CORE_ERROR_UNSUPPORTED,
-                     "Bearer data too long (max 256 bytes, %u given)",
+                     "Bearer data too long (max 255 bytes, %u given)",
                      offset);
         return FALSE;
     }
@@ -1588,7 +1440,7 @@ mm_sms_part_cdma_get_submit_pdu (MMSmsPart *part,
      *  Message type: 1 byte
      *  Teleservice ID: 5 bytes
      *  Destination address: 2 + 256 bytes
-     *  Bearer data: 2 + 256 bytes
+     *  Bearer data: 2 + 255 bytes
      */
     pdu = g_malloc0 (1024);
 
@@ -0,0 +1,322 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ */
+
+#include <config.h>
+#include <string.h>
+
+#include <ModemManager.h>
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-sms-storage-cache.h"
+#include "mm-iface-modem.h"
+#include "mm-base-sim.h"
+#include "mm-log.h"
+
+/* Snapshots of storages of modems no longer around are never removed, so
+ * keep a limit */
+#ifndef MM_SMS_STORAGE_CACHE_MAX_SNAPSHOTS
+# define MM_SMS_STORAGE_CACHE_MAX_SNAPSHOTS 16
+#endif
+
+/* While the modem is disabled, messages may be received and deleted without
+ * us knowing. The count check doesn't catch a deletion followed by a new
+ * message, so don't trust snapshots left unwatched for longer than this */
+#ifndef MM_SMS_STORAGE_CACHE_MAX_UNWATCHED_US
+# define MM_SMS_STORAGE_CACHE_MAX_UNWATCHED_US (60 * G_USEC_PER_SEC)
+#endif
+
+/*****************************************************************************/
+
+typedef struct {
+    guint8 status;
+    guint8 *pdu;
+    gsize pdu_len;
+} SnapshotEntry;
+
+struct _MMSmsStorageSnapshot {
+    /* index -> SnapshotEntry */
+    GHashTable *entries;
+    /* Since when changes in the storage are not being watched, or 0 */
+    gint64 unwatched_since;
+};
+
+static void
+snapshot_entry_free (SnapshotEntry *entry)
+{
+    g_free (entry->pdu);
+    g_slice_free (SnapshotEntry, entry);
+}
+
+MMSmsStorageSnapshot *
+mm_sms_storage_snapshot_new (void)
+{
+    MMSmsStorageSnapshot *snapshot;
+
+    snapshot = g_slice_new0 (MMSmsStorageSnapshot);
+    snapshot->entries = g_hash_table_new_full (g_direct_hash,
+                                               g_direct_equal,
+                                               NULL,
+                                               (GDestroyNotify)snapshot_entry_free);
+    return snapshot;
+}
+
+void
+mm_sms_storage_snapshot_free (MMSmsStorageSnapshot *snapshot)
+{
+    g_hash_table_unref (snapshot->entries);
+    g_slice_free (MMSmsStorageSnapshot, snapshot);
+}
+
+void
+mm_sms_storage_snapshot_add (MMSmsStorageSnapshot *snapshot,
+                             guint index,
+                             guint status,
+                             const gchar *hexpdu)
+{
+    SnapshotEntry *entry;
+    guint8 *pdu;
+    gsize pdu_len;
+
+    pdu = (guint8 *) mm_utils_hexstr2bin (hexpdu, &pdu_len);
+    if (!pdu)
+        return;
+
+    entry = g_slice_new (SnapshotEntry);
+    entry->status = status;
+    entry->pdu = pdu;
+    entry->pdu_len = pdu_len;
+    g_hash_table_replace (snapshot->entries, GUINT_TO_POINTER (index), entry);
+}
+
+/*****************************************************************************/
+
+/* key -> MMSmsStorageSnapshot */
+static GHashTable *cache;
+/* Keys, least recently stored first */
+static GQueue cache_keys = G_QUEUE_INIT;
+
+/* Common to the keys of all storages of the modem */
+static gchar *
+build_key_prefix (MMBaseModem *modem)
+{
+    MMBaseSim *sim = NULL;
+    gchar *prefix = NULL;
+
+    g_object_get (modem,
+                  MM_IFACE_MODEM_SIM, &sim,
+                  NULL);
+    if (!sim)
+        return NULL;
+
+    if (mm_gdbus_sim_get_sim_identifier (MM_GDBUS_SIM (sim)))
+        prefix = g_strdup_printf ("%s/%s/",
+                                  mm_base_modem_get_device (modem),
+                                  mm_gdbus_sim_get_sim_identifier (MM_GDBUS_SIM (sim)));
+    g_object_unref (sim);
+    return prefix;
+}
+
+static gchar *
+build_key (MMBaseModem *modem,
+           MMSmsStorage storage)
+{
+    gchar *prefix;
+    gchar *key;
+
+    prefix = build_key_prefix (modem);
+    if (!prefix)
+        return NULL;
+
+    key = g_strconcat (prefix, mm_sms_storage_get_string (storage), NULL);
+    g_free (prefix);
+    return key;
+}
+
+static MMSmsStorageSnapshot *
+peek_snapshot (MMBaseModem *modem,
+               MMSmsStorage storage)
+{
+    MMSmsStorageSnapshot *snapshot;
+    gchar *key;
+
+    if (!cache)
+        return NULL;
+
+    key = build_key (modem, storage);
+    if (!key)
+        return NULL;
+
+    snapshot = g_hash_table_lookup (cache, key);
+    g_free (key);
+    return snapshot;
+}
+
+static void
+remove_snapshot (const gchar *key)
+{
+    GList *l;
+
+    l = g_queue_find_custom (&cache_keys, key, (GCompareFunc)g_strcmp0);
+    if (l)
+        g_queue_delete_link (&cache_keys, l);
+    /* Frees the key */
+    g_hash_table_remove (cache, key);
+}
+
+void
+mm_sms_storage_cache_take (MMBaseModem *modem,
+                           MMSmsStorage storage,
+                           MMSmsStorageSnapshot *snapshot)
+{
+    gchar *key;
+
+    key = build_key (modem, storage);
+    if (!key) {
+        mm_sms_storage_snapshot_free (snapshot);
+        return;
+    }
+
+    if (!cache)
+        cache = g_hash_table_new_full (g_str_hash,
+                                       g_str_equal,
+                                       g_free,
+                                       (GDestroyNotify)mm_sms_storage_snapshot_free);
+    else if (g_hash_table_contains (cache, key))
+        remove_snapshot (key);
+
+    while (g_queue_get_length (&cache_keys) >= MM_SMS_STORAGE_CACHE_MAX_SNAPSHOTS)
+        remove_snapshot (g_queue_peek_head (&cache_keys));
+
+    mm_dbg ("Cached %u SMS parts of storage '%s'",
+            g_hash_table_size (snapshot->entries),
+            mm_sms_storage_get_string (storage));
+    g_hash_table_insert (cache, key, snapshot);
+    g_queue_push_tail (&cache_keys, key);
+}
+
+gboolean
+mm_sms_storage_cache_foreach (MMBaseModem *modem,
+                              MMSmsStorage storage,
+                              guint expected_count,
+                              MMSmsStorageCacheForeachFn callback,
+                              gpointer user_data)
+{
+    MMSmsStorageSnapshot *snapshot;
+    GHashTableIter iter;
+    gpointer index;
+    SnapshotEntry *entry;
+
+    snapshot = peek_snapshot (modem, storage);
+    if (!snapshot)
+        return FALSE;
+
+    if (snapshot->unwatched_since &&
+        (g_get_monotonic_time () - snapshot->unwatched_since) >= MM_SMS_STORAGE_CACHE_MAX_UNWATCHED_US) {
+        mm_dbg ("Cached SMS parts of storage '%s' are too old",
+                mm_sms_storage_get_string (storage));
+        mm_sms_storage_cache_invalidate (modem, storage);
+        return FALSE;
+    }
+
+    /* Changes done while the modem wasn't being watched will most likely
+     * change the number of messages in the storage */
+    if (g_hash_table_size (snapshot->entries) != expected_count) {
+        mm_dbg ("Cached SMS parts of storage '%s' are outdated (%u != %u)",
+                mm_sms_storage_get_string (storage),
+                g_hash_table_size (snapshot->entries),
+                expected_count);
+        return FALSE;
+    }
+
+    /* The snapshot is in use again, so it's kept up to date from now on */
+    snapshot->unwatched_since = 0;
+
+    g_hash_table_iter_init (&iter, snapshot->entries);
+    while (g_hash_table_iter_next (&iter, &index, (gpointer *)&entry))
+        callback (GPOINTER_TO_UINT (index), entry->status, entry->pdu, entry->pdu_len, user_data);
+    return TRUE;
+}
+
+void
+mm_sms_storage_cache_add_part (MMBaseModem *modem,
+                               MMSmsStorage storage,
+                               guint index,
+                               guint status,
+                               const gchar *hexpdu)
+{
+    MMSmsStorageSnapshot *snapshot;
+
+    /* Only keep up to date snapshots we already have */
+    snapshot = peek_snapshot (modem, storage);
+    if (snapshot)
+        mm_sms_storage_snapshot_add (snapshot, index, status, hexpdu);
+}
+
+void
+mm_sms_storage_cache_remove_part (MMBaseModem *modem,
+                                  MMSmsStorage storage,
+                                  guint index)
+{
+    MMSmsStorageSnapshot *snapshot;
+
+    snapshot = peek_snapshot (modem, storage);
+    if (snapshot)
+        g_hash_table_remove (snapshot->entries, GUINT_TO_POINTER (index));
+}
+
+void
+mm_sms_storage_cache_invalidate (MMBaseModem *modem,
+                                 MMSmsStorage storage)
+{
+    gchar *key;
+
+    if (!cache)
+        return;
+
+    key = build_key (modem, storage);
+    if (!key)
+        return;
+
+    if (g_hash_table_contains (cache, key))
+        remove_snapshot (key);
+    g_free (key);
+}
+
+void
+mm_sms_storage_cache_unwatch (MMBaseModem *modem)
+{
+    gchar *prefix;
+    GList *l;
+    gint64 now;
+
+    if (!cache)
+        return;
+
+    prefix = build_key_prefix (modem);
+    if (!prefix)
+        return;
+
+    now = g_get_monotonic_time ();
+    for (l = cache_keys.head; l; l = g_list_next (l)) {
+        MMSmsStorageSnapshot *snapshot;
+
+        if (!g_str_has_prefix (l->data, prefix))
+            continue;
+
+        snapshot = g_hash_table_lookup (cache, l->data);
+        if (!snapshot->unwatched_since)
+            snapshot->unwatched_since = now;
+    }
+    g_free (prefix);
+}
@@ -0,0 +1,70 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ */
+
+#ifndef MM_SMS_STORAGE_CACHE_H
+#define MM_SMS_STORAGE_CACHE_H
+
+#include <glib.h>
+
+#include <ModemManager.h>
+
+#include "mm-base-modem.h"
+
+/* The PDUs listed from an SMS storage, by index, along with their status
+ * (as given in +CMGL responses) */
+typedef struct _MMSmsStorageSnapshot MMSmsStorageSnapshot;
+
+MMSmsStorageSnapshot *mm_sms_storage_snapshot_new  (void);
+void                  mm_sms_storage_snapshot_free (MMSmsStorageSnapshot *snapshot);
+void                  mm_sms_storage_snapshot_add  (MMSmsStorageSnapshot *snapshot,
+                                                    guint index,
+                                                    guint status,
+                                                    const gchar *hexpdu);
+
+/* Process-wide cache of storage snapshots, by device, SIM identifier and
+ * storage, so that storages whose contents didn't change don't need to be
+ * listed again when the modem is enabled. Nothing is cached if the SIM
+ * identifier is unknown. Snapshots are only validated by the number of
+ * messages in the storage, see mm_sms_storage_cache_unwatch(). */
+
+typedef void (* MMSmsStorageCacheForeachFn) (guint index,
+                                             guint status,
+                                             const guint8 *pdu,
+                                             gsize pdu_len,
+                                             gpointer user_data);
+
+void     mm_sms_storage_cache_take        (MMBaseModem *modem,
+                                           MMSmsStorage storage,
+                                           MMSmsStorageSnapshot *snapshot);
+gboolean mm_sms_storage_cache_foreach     (MMBaseModem *modem,
+                                           MMSmsStorage storage,
+                                           guint expected_count,
+                                           MMSmsStorageCacheForeachFn callback,
+                                           gpointer user_data);
+void     mm_sms_storage_cache_add_part    (MMBaseModem *modem,
+                                           MMSmsStorage storage,
+                                           guint index,
+                                           guint status,
+                                           const gchar *hexpdu);
+void     mm_sms_storage_cache_remove_part (MMBaseModem *modem,
+                                           MMSmsStorage storage,
+                                           guint index);
+void     mm_sms_storage_cache_invalidate  (MMBaseModem *modem,
+                                           MMSmsStorage storage);
+
+/* To be called when changes in the storages of the modem are no longer
+ * reported, e.g. when disabled; their snapshots are then only trusted for a
+ * limited time */
+void     mm_sms_storage_cache_unwatch     (MMBaseModem *modem);
+
+#endif /* MM_SMS_STORAGE_CACHE_H */
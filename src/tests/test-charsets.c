@@ -315,6 +315,195 @@ test_gsm7_pack_7_chars_offset (void)
     g_free (packed);
 }
 
+/* Reference one-septet-at-a-time implementations, used to validate the
+ * word-at-a-time ones */
+static guint8 *
+reference_gsm_unpack (const guint8 *gsm,
+                      guint32       num_septets,
+                      guint8        start_offset)
+{
+    guint8 *unpacked;
+    guint32 i;
+
+    unpacked = g_malloc (num_septets + 1);
+    for (i = 0; i < num_septets; i++) {
+        guint8 bits_here, bits_in_next, offset, c;
+        guint32 start_bit;
+
+        start_bit = start_offset + (i * 7);
+        offset = start_bit % 8;
+        bits_here = offset ? (8 - offset) : 7;
+        bits_in_next = 7 - bits_here;
+
+        c = (gsm[start_bit / 8] >> offset) & (0xFF >> (8 - bits_here));
+        if (bits_in_next)
+            c |= (gsm[(start_bit / 8) + 1] & (0xFF >> (8 - bits_in_next))) << bits_here;
+        unpacked[i] = c;
+    }
+    return unpacked;
+}
+
+static guint8 *
+reference_gsm_pack (const guint8 *src,
+                    guint32       src_len,
+                    guint8        start_offset,
+                    guint32      *out_packed_len)
+{
+    guint8 *packed;
+    guint octet = 0, lshift, plen;
+    guint32 i;
+
+    plen = ((src_len * 7) + start_offset + 7) / 8;
+    packed = g_malloc0 (plen);
+    for (i = 0, lshift = start_offset; i < src_len; i++) {
+        packed[octet] |= (src[i] & 0x7F) << lshift;
+        if (lshift > 1)
+            packed[octet + 1] = (src[i] & 0x7F) >> (8 - lshift);
+        if (lshift)
+            octet++;
+        lshift = lshift ? lshift - 1 : 7;
+    }
+    *out_packed_len = plen;
+    return packed;
+}
+
+#define EQUIVALENCE_MAX_SEPTETS 200
+
+static void
+test_gsm7_unpack_equivalence (void)
+{
+    GRand   *rand;
+    guint8   gsm[((EQUIVALENCE_MAX_SEPTETS * 7) + 255 + 7) / 8];
+    guint32  num_septets;
+    guint    start_offset;
+    guint    i;
+
+    rand = g_rand_new_with_seed (1234);
+
+    /* All lengths across several blocks, all bit offsets within the first
+     * octets plus some larger ones, with exactly the number of input octets
+     * needed so that any overread is caught by valgrind/ASan */
+    for (num_septets = 0; num_septets <= EQUIVALENCE_MAX_SEPTETS; num_septets++) {
+        for (start_offset = 0; start_offset < 256; start_offset += (start_offset < 24 ? 1 : 29)) {
+            guint8  *input;
+            guint32  input_len;
+            guint8  *expected;
+            guint8  *unpacked;
+            guint32  unpacked_len = 0;
+
+            input_len = ((num_septets * 7) + start_offset + 7) / 8;
+            for (i = 0; i < input_len; i++)
+                gsm[i] = g_rand_int_range (rand, 0, 256);
+            input = g_memdup (gsm, input_len);
+
+            expected = reference_gsm_unpack (input, num_septets, start_offset);
+            unpacked = mm_charset_gsm_unpack (input, num_septets, start_offset, &unpacked_len);
+            g_assert_cmpuint (unpacked_len, ==, num_septets);
+            g_assert_cmpint (memcmp (unpacked, expected, num_septets), ==, 0);
+
+            g_free (unpacked);
+            g_free (expected);
+            g_free (input);
+        }
+    }
+
+    g_rand_free (rand);
+}
+
+static void
+test_gsm7_pack_equivalence (void)
+{
+    GRand   *rand;
+    guint8   unpacked[EQUIVALENCE_MAX_SEPTETS];
+    guint32  num_septets;
+    guint    start_offset;
+    guint    i;
+
+    rand = g_rand_new_with_seed (1234);
+
+    for (num_septets = 0; num_septets <= EQUIVALENCE_MAX_SEPTETS; num_septets++) {
+        for (start_offset = 0; start_offset < 8; start_offset++) {
+            guint8  *input;
+            guint8  *expected;
+            guint32  expected_len = 0;
+            guint8  *packed;
+            guint32  packed_len = 0;
+            guint8  *roundtrip;
+            guint32  roundtrip_len = 0;
+
+            /* Include the 8th bit, which must be ignored */
+            for (i = 0; i < num_septets; i++)
+                unpacked[i] = g_rand_int_range (rand, 0, 256);
+            input = g_memdup (unpacked, num_septets);
+
+            expected = reference_gsm_pack (input, num_septets, start_offset, &expected_len);
+            packed = mm_charset_gsm_pack (input, num_septets, start_offset, &packed_len);
+            g_assert_cmpuint (packed_len, ==, expected_len);
+            g_assert_cmpint (memcmp (packed, expected, packed_len), ==, 0);
+
+            roundtrip = mm_charset_gsm_unpack (packed, num_septets, start_offset, &roundtrip_len);
+            g_assert_cmpuint (roundtrip_len, ==, num_septets);
+            for (i = 0; i < num_septets; i++)
+                g_assert_cmpuint (roundtrip[i], ==, input[i] & 0x7F);
+
+            g_free (roundtrip);
+            g_free (packed);
+            g_free (expected);
+            g_free (input);
+        }
+    }
+
+    g_rand_free (rand);
+}
+
+/* Throughput of the septet packing with a full multipart SMS chunk (153
+ * septets after a 6-octet UDH, so 1 fill bit) */
+static void
+test_gsm7_pack_benchmark (void)
+{
+    guint8  unpacked[153];
+    guint8 *packed;
+    guint32 packed_len = 0;
+    guint   n_iterations = 200000;
+    guint   i;
+    gdouble native;
+    gdouble reference;
+
+    for (i = 0; i < G_N_ELEMENTS (unpacked); i++)
+        unpacked[i] = i & 0x7F;
+
+    g_test_timer_start ();
+    for (i = 0; i < n_iterations; i++)
+        g_free (mm_charset_gsm_pack (unpacked, G_N_ELEMENTS (unpacked), 1, &packed_len));
+    native = g_test_timer_elapsed ();
+    g_test_timer_start ();
+    for (i = 0; i < n_iterations; i++)
+        g_free (reference_gsm_pack (unpacked, G_N_ELEMENTS (unpacked), 1, &packed_len));
+    reference = g_test_timer_elapsed ();
+    g_test_minimized_result (native, "pack: %.1lf MB/s", (n_iterations * G_N_ELEMENTS (unpacked)) / (native * 1e6));
+    g_test_message ("pack:              %.1lf MB/s", (n_iterations * G_N_ELEMENTS (unpacked)) / (native * 1e6));
+    g_test_message ("pack (reference):  %.1lf MB/s", (n_iterations * G_N_ELEMENTS (unpacked)) / (reference * 1e6));
+
+    packed = mm_charset_gsm_pack (unpacked, G_N_ELEMENTS (unpacked), 1, &packed_len);
+
+    g_test_timer_start ();
+    for (i = 0; i < n_iterations; i++) {
+        guint32 unpacked_len;
+
+        g_free (mm_charset_gsm_unpack (packed, G_N_ELEMENTS (unpacked), 1, &unpacked_len));
+    }
+    native = g_test_timer_elapsed ();
+    g_test_timer_start ();
+    for (i = 0; i < n_iterations; i++)
+        g_free (reference_gsm_unpack (packed, G_N_ELEMENTS (unpacked), 1));
+    reference = g_test_timer_elapsed ();
+    g_test_minimized_result (native, "unpack: %.1lf MB/s", (n_iterations * G_N_ELEMENTS (unpacked)) / (native * 1e6));
+    g_test_message ("unpack:            %.1lf MB/s", (n_iterations * G_N_ELEMENTS (unpacked)) / (native * 1e6));
+    g_test_message ("unpack (reference): %.1lf MB/s", (n_iterations * G_N_ELEMENTS (unpacked)) / (reference * 1e6));
+
+    g_free (packed);
+}
+
 static void
 test_take_convert_ucs2_hex_utf8 (void)
 {
@@ -350,6 +539,174 @@ test_take_convert_ucs2_bad_ascii2 (void)
     g_assert (converted == NULL);
 }
 
+/* The native codecs must give the same results as iconv for every byte */
+static void
+common_test_single_byte_charset_iconv (MMModemCharset  charset,
+                                       const gchar    *iconv_name)
+{
+    GString *hex;
+    gchar    bin[256];
+    gchar   *native;
+    gchar   *iconv;
+    gchar   *back;
+    guint    i;
+
+    hex = g_string_new (NULL);
+    for (i = 0; i < 256; i++) {
+        /* Skip the NUL byte, as it would end the string */
+        bin[i] = (i == 0xFF ? 0x20 : i + 1);
+        g_string_append_printf (hex, "%02X", (guint8) bin[i]);
+    }
+
+    native = mm_modem_charset_hex_to_utf8 (hex->str, charset);
+    g_assert (native);
+    iconv = g_convert (bin, 256, "UTF-8", iconv_name, NULL, NULL, NULL);
+    g_assert (iconv);
+    g_assert_cmpstr (native, ==, iconv);
+
+    /* And back */
+    back = mm_modem_charset_utf8_to_hex (native, charset);
+    g_assert_cmpstr (back, ==, hex->str);
+
+    g_free (back);
+    g_free (iconv);
+    g_free (native);
+    g_string_free (hex, TRUE);
+}
+
+static void
+test_native_8859_1 (void)
+{
+    common_test_single_byte_charset_iconv (MM_MODEM_CHARSET_8859_1, "ISO8859-1");
+}
+
+static void
+test_native_pccp437 (void)
+{
+    common_test_single_byte_charset_iconv (MM_MODEM_CHARSET_PCCP437, "CP437");
+}
+
+static void
+test_native_pcdn (void)
+{
+    common_test_single_byte_charset_iconv (MM_MODEM_CHARSET_PCDN, "CP850");
+}
+
+static void
+test_native_ucs2 (void)
+{
+    static const gchar *s = "ホモ・サピエンス 喂人类 katakana, chinese, english: UCS2 takes it all";
+    gchar *hex;
+    gchar *utf8;
+
+    hex = mm_modem_charset_utf8_to_hex (s, MM_MODEM_CHARSET_UCS2);
+    g_assert (hex);
+    g_assert_cmpuint (strlen (hex), ==, 4 * g_utf8_strlen (s, -1));
+    g_assert (g_str_has_prefix (hex, "30DB30E2"));
+
+    utf8 = mm_modem_charset_hex_to_utf8 (hex, MM_MODEM_CHARSET_UCS2);
+    g_assert_cmpstr (utf8, ==, s);
+    g_free (utf8);
+    g_free (hex);
+
+    /* Surrogate pairs are accepted in both directions */
+    hex = mm_modem_charset_utf8_to_hex ("\xf0\x9f\x98\x80", MM_MODEM_CHARSET_UCS2);
+    g_assert_cmpstr (hex, ==, "D83DDE00");
+    utf8 = mm_modem_charset_hex_to_utf8 (hex, MM_MODEM_CHARSET_UCS2);
+    g_assert_cmpstr (utf8, ==, "\xf0\x9f\x98\x80");
+    g_free (utf8);
+    g_free (hex);
+
+    /* But not lone surrogates, nor invalid hex */
+    g_assert (mm_modem_charset_hex_to_utf8 ("D83D0041", MM_MODEM_CHARSET_UCS2) == NULL);
+    g_assert (mm_modem_charset_hex_to_utf8 ("DE000041", MM_MODEM_CHARSET_UCS2) == NULL);
+    g_assert (mm_modem_charset_hex_to_utf8 ("00G1", MM_MODEM_CHARSET_UCS2) == NULL);
+}
+
+static void
+test_native_gsm (void)
+{
+    static const gchar *s = "@£$¥èéùìòÇ\nØø\rÅåΔ_ΦΓΛΩΠΨΣΘΞÆæßÉ !\"#¤%&'()*+,-./0123456789:;<=>?¡ABCDEFGHIJKLMNOPQRSTUVWXYZÄÖÑÜ§¿abcdefghijklmnopqrstuvwxyzäöñüà\f^{}\\[~]|€";
+    gchar *hex;
+    gchar *utf8;
+
+    hex = mm_modem_charset_utf8_to_hex (s, MM_MODEM_CHARSET_GSM);
+    g_assert (hex);
+    /* 127 chars in the default alphabet, 10 escaped ones */
+    g_assert_cmpuint (strlen (hex), ==, 2 * (127 + 2 * 10));
+    g_assert (g_str_has_prefix (hex, "000102"));
+    g_assert (g_str_has_suffix (hex, "1B65"));
+
+    utf8 = mm_modem_charset_hex_to_utf8 (hex, MM_MODEM_CHARSET_GSM);
+    g_assert_cmpstr (utf8, ==, s);
+    g_free (utf8);
+    g_free (hex);
+}
+
+static void
+test_native_gsm_at_sign (void)
+{
+    GByteArray *array;
+    gchar      *encoded;
+
+    /* Chars not needing 0x00 are fine in a NUL-terminated string */
+    encoded = mm_utf8_take_and_convert_to_charset (g_strdup ("user_1$"), MM_MODEM_CHARSET_GSM);
+    g_assert_cmpstr (encoded, ==, "user\x11" "1\x02");
+    g_free (encoded);
+
+    /* '@' is 0x00 in GSM, the string would be truncated */
+    encoded = mm_utf8_take_and_convert_to_charset (g_strdup ("user@domain"), MM_MODEM_CHARSET_GSM);
+    g_assert (!encoded);
+
+    /* The byte array keeps the full length */
+    array = g_byte_array_new ();
+    g_assert (mm_modem_charset_byte_array_append (array, "user@domain", FALSE, MM_MODEM_CHARSET_GSM));
+    g_assert_cmpuint (array->len, ==, 11);
+    g_assert_cmpuint (array->data[4], ==, 0x00);
+    g_assert (memcmp (&array->data[5], "domain", 6) == 0);
+    g_byte_array_unref (array);
+}
+
+/* Compare native hex+UCS2 decoding with the previous hexstr2bin+iconv path */
+static void
+test_native_benchmark (void)
+{
+    static const gchar *s = "ホモ・サピエンス 喂人类 katakana, chinese, english: UCS2 takes it all";
+    gchar   *hex;
+    guint    hex_len;
+    guint    n_iterations = 100000;
+    guint    i;
+    gdouble  native;
+    gdouble  iconv;
+
+    hex = mm_modem_charset_utf8_to_hex (s, MM_MODEM_CHARSET_UCS2);
+    hex_len = strlen (hex);
+
+    g_test_timer_start ();
+    for (i = 0; i < n_iterations; i++)
+        g_free (mm_modem_charset_hex_to_utf8 (hex, MM_MODEM_CHARSET_UCS2));
+    native = g_test_timer_elapsed ();
+
+    g_test_timer_start ();
+    for (i = 0; i < n_iterations; i++) {
+        gchar *bin;
+        guint  j;
+
+        bin = g_malloc (hex_len / 2);
+        for (j = 0; j < hex_len / 2; j++)
+            bin[j] = (g_ascii_xdigit_value (hex[2 * j]) << 4) | g_ascii_xdigit_value (hex[2 * j + 1]);
+        g_free (g_convert (bin, hex_len / 2, "UTF-8//TRANSLIT", "UCS-2BE", NULL, NULL, NULL));
+        g_free (bin);
+    }
+    iconv = g_test_timer_elapsed ();
+
+    g_test_minimized_result (native, "native: %.1lf MB/s", (n_iterations * hex_len) / (native * 1e6));
+    g_test_message ("native: %.1lf MB/s", (n_iterations * hex_len) / (native * 1e6));
+    g_test_message ("iconv:  %.1lf MB/s", (n_iterations * hex_len) / (iconv * 1e6));
+
+    g_free (hex);
+}
+
 struct charset_can_convert_to_test_s {
     const char *utf8;
     gboolean    to_gsm;
@@ -448,6 +805,10 @@ int main (int argc, char **argv)
     g_test_add_func ("/MM/charsets/gsm7/pack/24-chars",          test_gsm7_pack_24_chars);
     g_test_add_func ("/MM/charsets/gsm7/pack/last-septet-alone", test_gsm7_pack_last_septet_alone);
     g_test_add_func ("/MM/charsets/gsm7/pack/7-chars-offset",    test_gsm7_pack_7_chars_offset);
+    g_test_add_func ("/MM/charsets/gsm7/unpack/equivalence",     test_gsm7_unpack_equivalence);
+    g_test_add_func ("/MM/charsets/gsm7/pack/equivalence",       test_gsm7_pack_equivalence);
+    if (g_test_perf ())
+        g_test_add_func ("/MM/charsets/gsm7/benchmark", test_gsm7_pack_benchmark);
 
     g_test_add_func ("/MM/charsets/take-convert/ucs2/hex",         test_take_convert_ucs2_hex_utf8);
     g_test_add_func ("/MM/charsets/take-convert/ucs2/bad-ascii",   test_take_convert_ucs2_bad_ascii);
@@ -455,5 +816,14 @@ int main (int argc, char **argv)
 
     g_test_add_func ("/MM/charsets/can-convert-to", test_charset_can_covert_to);
 
+    g_test_add_func ("/MM/charsets/native/8859-1",  test_native_8859_1);
+    g_test_add_func ("/MM/charsets/native/pccp437", test_native_pccp437);
+    g_test_add_func ("/MM/charsets/native/pcdn",    test_native_pcdn);
+    g_test_add_func ("/MM/charsets/native/ucs2",    test_native_ucs2);
+    g_test_add_func ("/MM/charsets/native/gsm",     test_native_gsm);
+    g_test_add_func ("/MM/charsets/native/gsm/at-sign", test_native_gsm_at_sign);
+    if (g_test_perf ())
+        g_test_add_func ("/MM/charsets/native/benchmark", test_native_benchmark);
+
     return g_test_run ();
 }
@@ -0,0 +1,364 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ */
+
+#include <glib.h>
+#include <glib-object.h>
+#include <string.h>
+#include <locale.h>
+
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-filter.h"
+#include "mm-log.h"
+
+/* Define symbol to enable test message traces */
+#undef ENABLE_TEST_MESSAGE_TRACES
+
+/*****************************************************************************/
+/* Fake kernel device, counting how many times the global (i.e. per-physdev)
+ * properties are looked up */
+
+#define TEST_TYPE_KERNEL_DEVICE (test_kernel_device_get_type ())
+#define TEST_KERNEL_DEVICE(obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), TEST_TYPE_KERNEL_DEVICE, TestKernelDevice))
+
+typedef struct {
+    MMKernelDevice  parent;
+    gchar          *subsystem;
+    gchar          *name;
+    gchar          *physdev_uid;
+    gboolean        ignore;
+    guint          *global_lookups;
+} TestKernelDevice;
+
+typedef struct {
+    MMKernelDeviceClass parent;
+} TestKernelDeviceClass;
+
+GType test_kernel_device_get_type (void);
+
+G_DEFINE_TYPE (TestKernelDevice, test_kernel_device, MM_TYPE_KERNEL_DEVICE)
+
+static const gchar *
+kernel_device_get_subsystem (MMKernelDevice *self)
+{
+    return TEST_KERNEL_DEVICE (self)->subsystem;
+}
+
+static const gchar *
+kernel_device_get_name (MMKernelDevice *self)
+{
+    return TEST_KERNEL_DEVICE (self)->name;
+}
+
+static const gchar *
+kernel_device_get_physdev_uid (MMKernelDevice *self)
+{
+    return TEST_KERNEL_DEVICE (self)->physdev_uid;
+}
+
+static const gchar *
+kernel_device_get_physdev_sysfs_path (MMKernelDevice *self)
+{
+    /* Virtual devices have no physdev */
+    return TEST_KERNEL_DEVICE (self)->physdev_uid;
+}
+
+static const gchar *
+kernel_device_get_physdev_subsystem (MMKernelDevice *self)
+{
+    return "usb";
+}
+
+static gboolean
+kernel_device_get_global_property_as_boolean (MMKernelDevice *self,
+                                              const gchar    *property)
+{
+    (*TEST_KERNEL_DEVICE (self)->global_lookups)++;
+    if (g_str_equal (property, "ID_MM_DEVICE_IGNORE"))
+        return TEST_KERNEL_DEVICE (self)->ignore;
+    return FALSE;
+}
+
+static void
+test_kernel_device_init (TestKernelDevice *self)
+{
+}
+
+static void
+test_kernel_device_finalize (GObject *object)
+{
+    TestKernelDevice *self = TEST_KERNEL_DEVICE (object);
+
+    g_free (self->subsystem);
+    g_free (self->name);
+    g_free (self->physdev_uid);
+
+    G_OBJECT_CLASS (test_kernel_device_parent_class)->finalize (object);
+}
+
+static void
+test_kernel_device_class_init (TestKernelDeviceClass *klass)
+{
+    GObjectClass        *object_class        = G_OBJECT_CLASS (klass);
+    MMKernelDeviceClass *kernel_device_class = MM_KERNEL_DEVICE_CLASS (klass);
+
+    object_class->finalize = test_kernel_device_finalize;
+
+    kernel_device_class->get_subsystem                  = kernel_device_get_subsystem;
+    kernel_device_class->get_name                       = kernel_device_get_name;
+    kernel_device_class->get_physdev_uid                = kernel_device_get_physdev_uid;
+    kernel_device_class->get_physdev_sysfs_path         = kernel_device_get_physdev_sysfs_path;
+    kernel_device_class->get_physdev_subsystem          = kernel_device_get_physdev_subsystem;
+    kernel_device_class->get_global_property_as_boolean = kernel_device_get_global_property_as_boolean;
+}
+
+static MMKernelDevice *
+test_kernel_device_new (const gchar *subsystem,
+                        const gchar *name,
+                        const gchar *physdev_uid,
+                        gboolean     ignore,
+                        guint       *global_lookups)
+{
+    TestKernelDevice *self;
+
+    self = g_object_new (TEST_TYPE_KERNEL_DEVICE, NULL);
+    self->subsystem      = g_strdup (subsystem);
+    self->name           = g_strdup (name);
+    self->physdev_uid    = g_strdup (physdev_uid);
+    self->ignore         = ignore;
+    self->global_lookups = global_lookups;
+    return MM_KERNEL_DEVICE (self);
+}
+
+/*****************************************************************************/
+
+static void
+test_verdict_cache_siblings (void)
+{
+    MMFilter       *filter;
+    MMKernelDevice *tty0;
+    MMKernelDevice *tty1;
+    MMKernelDevice *other;
+    GError         *error = NULL;
+    guint           lookups = 0;
+    guint           lookups_first;
+
+    filter = mm_filter_new (MM_FILTER_POLICY_DEFAULT, &error);
+    g_assert_no_error (error);
+    g_assert (filter);
+
+    tty0  = test_kernel_device_new ("tty", "ttyUSB0", "/sys/devices/usb1/1-1", FALSE, &lookups);
+    tty1  = test_kernel_device_new ("tty", "ttyUSB1", "/sys/devices/usb1/1-1", FALSE, &lookups);
+    other = test_kernel_device_new ("tty", "ttyUSB2", "/sys/devices/usb1/1-2", FALSE, &lookups);
+
+    /* Miss: first port of the device */
+    g_assert (mm_filter_port (filter, tty0, FALSE));
+    g_assert_cmpuint (lookups, >, 0);
+    lookups_first = lookups;
+
+    /* Hit: sibling port reuses the verdict */
+    g_assert (mm_filter_port (filter, tty1, FALSE));
+    g_assert_cmpuint (lookups, ==, lookups_first);
+
+    /* Hit: same port re-evaluated */
+    g_assert (mm_filter_port (filter, tty0, FALSE));
+    g_assert_cmpuint (lookups, ==, lookups_first);
+
+    /* Miss: port in a different device */
+    g_assert (mm_filter_port (filter, other, FALSE));
+    g_assert_cmpuint (lookups, ==, 2 * lookups_first);
+
+    g_assert_cmpuint (mm_filter_get_rule_hits (filter, MM_FILTER_RULE_TTY_DEFAULT_ALLOWED), ==, 4);
+    g_assert_cmpuint (mm_filter_get_rule_hits (filter, MM_FILTER_RULE_TTY_BLACKLIST), ==, 0);
+
+    g_object_unref (other);
+    g_object_unref (tty1);
+    g_object_unref (tty0);
+    g_object_unref (filter);
+}
+
+static void
+test_verdict_cache_port_removed (void)
+{
+    MMFilter       *filter;
+    MMKernelDevice *tty0;
+    MMKernelDevice *tty1;
+    GError         *error = NULL;
+    guint           lookups = 0;
+    guint           lookups_first;
+
+    filter = mm_filter_new (MM_FILTER_POLICY_DEFAULT, &error);
+    g_assert_no_error (error);
+    g_assert (filter);
+
+    tty0 = test_kernel_device_new ("tty", "ttyUSB0", "/sys/devices/usb1/1-1", FALSE, &lookups);
+    tty1 = test_kernel_device_new ("tty", "ttyUSB1", "/sys/devices/usb1/1-1", FALSE, &lookups);
+
+    g_assert (mm_filter_port (filter, tty0, FALSE));
+    g_assert (mm_filter_port (filter, tty1, FALSE));
+    lookups_first = lookups;
+
+    /* Removing any port of the device forgets the verdict: miss */
+    mm_filter_port_removed (filter, tty0);
+    g_assert (mm_filter_port (filter, tty1, FALSE));
+    g_assert_cmpuint (lookups, ==, 2 * lookups_first);
+
+    /* And cached again afterwards: hit */
+    g_assert (mm_filter_port (filter, tty1, FALSE));
+    g_assert_cmpuint (lookups, ==, 2 * lookups_first);
+
+    /* Removing an unknown port is harmless */
+    mm_filter_port_removed (filter, tty0);
+    g_assert (mm_filter_port (filter, tty1, FALSE));
+    g_assert_cmpuint (lookups, ==, 2 * lookups_first);
+
+    g_object_unref (tty1);
+    g_object_unref (tty0);
+    g_object_unref (filter);
+}
+
+static void
+test_verdict_cache_blacklist (void)
+{
+    MMFilter       *filter;
+    MMKernelDevice *tty0;
+    MMKernelDevice *tty1;
+    MMKernelDevice *net;
+    GError         *error = NULL;
+    guint           lookups = 0;
+    guint           lookups_first;
+
+    filter = mm_filter_new (MM_FILTER_POLICY_DEFAULT, &error);
+    g_assert_no_error (error);
+    g_assert (filter);
+
+    tty0 = test_kernel_device_new ("tty", "ttyUSB0", "/sys/devices/usb1/1-1", TRUE, &lookups);
+    tty1 = test_kernel_device_new ("tty", "ttyUSB1", "/sys/devices/usb1/1-1", TRUE, &lookups);
+    net  = test_kernel_device_new ("net", "wwan0",   "/sys/devices/usb1/1-1", TRUE, &lookups);
+
+    g_assert (!mm_filter_port (filter, tty0, FALSE));
+    lookups_first = lookups;
+    g_assert (!mm_filter_port (filter, tty1, FALSE));
+    g_assert_cmpuint (lookups, ==, lookups_first);
+
+    /* The blacklist is tty-specific, the cached verdict must not leak into
+     * the net port */
+    g_assert (mm_filter_port (filter, net, FALSE));
+    g_assert_cmpuint (lookups, ==, lookups_first);
+
+    g_assert_cmpuint (mm_filter_get_rule_hits (filter, MM_FILTER_RULE_TTY_BLACKLIST), ==, 2);
+    g_assert_cmpuint (mm_filter_get_rule_hits (filter, MM_FILTER_RULE_NET), ==, 1);
+    g_assert_cmpuint (mm_filter_get_rule_hits (filter, MM_FILTER_RULE_TTY_DEFAULT_ALLOWED), ==, 0);
+
+    g_object_unref (net);
+    g_object_unref (tty1);
+    g_object_unref (tty0);
+    g_object_unref (filter);
+}
+
+static void
+test_verdict_cache_virtual (void)
+{
+    MMFilter       *filter;
+    MMKernelDevice *tty;
+    GError         *error = NULL;
+    guint           lookups = 0;
+    guint           lookups_first;
+
+    filter = mm_filter_new (MM_FILTER_POLICY_DEFAULT, &error);
+    g_assert_no_error (error);
+    g_assert (filter);
+
+    /* Virtual devices have no physdev, so the verdict is never cached */
+    tty = test_kernel_device_new ("tty", "tnt0", NULL, FALSE, &lookups);
+
+    g_assert (!mm_filter_port (filter, tty, FALSE));
+    lookups_first = lookups;
+    g_assert_cmpuint (lookups_first, >, 0);
+    g_assert (!mm_filter_port (filter, tty, FALSE));
+    g_assert_cmpuint (lookups, ==, 2 * lookups_first);
+
+    g_assert_cmpuint (mm_filter_get_rule_hits (filter, MM_FILTER_RULE_VIRTUAL), ==, 2);
+
+    g_object_unref (tty);
+    g_object_unref (filter);
+}
+
+/*****************************************************************************/
+/* The filter only needs these from the device and port probe objects, when
+ * running the TTY_WITH_NET rule, which isn't exercised here. */
+
+GList *
+mm_device_peek_port_probe_list (MMDevice *self)
+{
+    g_assert_not_reached ();
+    return NULL;
+}
+
+GType
+mm_port_probe_get_type (void)
+{
+    g_assert_not_reached ();
+    return G_TYPE_INVALID;
+}
+
+const gchar *
+mm_port_probe_get_port_name (MMPortProbe *self)
+{
+    g_assert_not_reached ();
+    return NULL;
+}
+
+const gchar *
+mm_port_probe_get_port_subsys (MMPortProbe *self)
+{
+    g_assert_not_reached ();
+    return NULL;
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    setlocale (LC_ALL, "");
+
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/filter/verdict-cache/siblings",     test_verdict_cache_siblings);
+    g_test_add_func ("/MM/filter/verdict-cache/port-removed", test_verdict_cache_port_removed);
+    g_test_add_func ("/MM/filter/verdict-cache/blacklist",    test_verdict_cache_blacklist);
+    g_test_add_func ("/MM/filter/verdict-cache/virtual",      test_verdict_cache_virtual);
+
+    return g_test_run ();
+}
@@ -412,6 +412,71 @@ test_cmgl_response_pantech_multiple (void *f, gpointer d)
     test_cmgl_response (str, expected, G_N_ELEMENTS (expected));
 }
 
+static void
+test_cmgl_response_streamed (void *f, gpointer d)
+{
+    /* Same as the pantech one, received in small chunks */
+    const gchar *str =
+        "\r\n+CMGL: 17,3,35\r\n079100F40D1101000F001000B917118336058F300001954747A0E4ACF41F27298CDCE83C6EF371B0402814020\r\n"
+        "+CMGL: 15,3,35\r\n079100F40D1101000F001000B917118336058F300001954747A0E4ACF41F27298CDCE83C6EF371B0402814020\r\n"
+        "+CMGL: 13,0,,35\r\n079100F40D1101000F001000B917118336058F300\r\n"
+        "\r\nOK\r\n";
+    const gint expected_index[] = { 17, 15, 13 };
+    const gint expected_status[] = { 3, 3, 0 };
+    const gchar *expected_pdu[] = {
+        "079100F40D1101000F001000B917118336058F300001954747A0E4ACF41F27298CDCE83C6EF371B0402814020",
+        "079100F40D1101000F001000B917118336058F300001954747A0E4ACF41F27298CDCE83C6EF371B0402814020",
+        "079100F40D1101000F001000B917118336058F300"
+    };
+    GRegex *r;
+    GString *buffer;
+    guint n_entries = 0;
+    guint max_buffer_len = 0;
+    gsize i;
+
+    r = mm_3gpp_cmgl_pdu_entry_regex_get ();
+    buffer = g_string_new (NULL);
+
+    for (i = 0; i < strlen (str); i += 7) {
+        GMatchInfo *match_info = NULL;
+        gint start = 0;
+        gint end = 0;
+
+        g_string_append_len (buffer, str + i, MIN (7, strlen (str) - i));
+
+        /* Complete entries are parsed and removed from the buffer right away */
+        if (g_regex_match (r, buffer->str, 0, &match_info)) {
+            MM3gppPduInfo *info;
+            GError *error = NULL;
+
+            info = mm_3gpp_parse_pdu_cmgl_entry (match_info, &error);
+            g_assert_no_error (error);
+            g_assert (info);
+            g_assert_cmpuint (n_entries, <, G_N_ELEMENTS (expected_index));
+            g_assert_cmpint (info->index, ==, expected_index[n_entries]);
+            g_assert_cmpint (info->status, ==, expected_status[n_entries]);
+            g_assert_cmpstr (info->pdu, ==, expected_pdu[n_entries]);
+            mm_3gpp_pdu_info_free (info);
+            n_entries++;
+
+            g_assert (g_match_info_fetch_pos (match_info, 0, &start, &end));
+            g_string_erase (buffer, start, end - start);
+            g_assert (!g_match_info_next (match_info, NULL));
+        }
+        g_match_info_free (match_info);
+
+        max_buffer_len = MAX (max_buffer_len, buffer->len);
+    }
+
+    g_assert_cmpuint (n_entries, ==, G_N_ELEMENTS (expected_index));
+    /* Never more than one entry (plus a chunk) buffered */
+    g_assert_cmpuint (max_buffer_len, <, 128);
+    g_assert_cmpstr (buffer->str, ==, "\r\n\r\nOK\r\n");
+
+    g_string_free (buffer, TRUE);
+    g_regex_unref (r);
+}
+
 /*****************************************************************************/
 /* Test CMGR responses */
 
@@ -2483,6 +2548,44 @@ test_cgact_read_response_multiple (void)
     test_cgact_read_results ("multiple", reply, &expected[0], G_N_ELEMENTS (expected));
 }
 
+/*****************************************************************************/
+/* Test +CGEV indications */
+
+typedef struct {
+    const gchar *str;
+    MM3gppCgev   expected;
+    guint        expected_cid;
+} CgevTest;
+
+static const CgevTest cgev_tests[] = {
+    { "NW DETACH",                  MM_3GPP_CGEV_DETACH,      0 },
+    { "ME DETACH",                  MM_3GPP_CGEV_DETACH,      0 },
+    { "NW PDN DEACT 1",             MM_3GPP_CGEV_DEACTIVATED, 1 },
+    { "ME PDN DEACT 3,0",           MM_3GPP_CGEV_DEACTIVATED, 3 },
+    { "NW DEACT \"IP\",\"10.0.0.2\",2", MM_3GPP_CGEV_DEACTIVATED, 2 },
+    { "ME DEACT IPV6, \"fe80::1\", 4", MM_3GPP_CGEV_DEACTIVATED, 4 },
+    { "NW DEACT \"IP\",\"10.0.0.2\"",  MM_3GPP_CGEV_DEACTIVATED, 0 },
+    { "NW DEACT 1,2,0",             MM_3GPP_CGEV_UNKNOWN,     0 },
+    { "NW PDN ACT 1",               MM_3GPP_CGEV_UNKNOWN,     0 },
+    { "ME PDN DEACT",               MM_3GPP_CGEV_UNKNOWN,     0 },
+    { "NW CLASS \"B\"",             MM_3GPP_CGEV_UNKNOWN,     0 },
+    { "REJECT \"IP\",\"10.0.0.2\"",   MM_3GPP_CGEV_UNKNOWN,     0 },
+};
+
+static void
+test_cgev_indication (void)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (cgev_tests); i++) {
+        guint cid = G_MAXUINT;
+
+        trace ("\nTesting +CGEV: %s\n", cgev_tests[i].str);
+        g_assert_cmpuint (mm_3gpp_parse_cgev_indication (cgev_tests[i].str, &cid), ==, cgev_tests[i].expected);
+        g_assert_cmpuint (cid, ==, cgev_tests[i].expected_cid);
+    }
+}
+
 /*****************************************************************************/
 /* Test CPMS responses */
 
@@ -2686,6 +2789,28 @@ test_cpms_query_response (void *f, gpointer d) {
     }
 }
 
+static void
+test_cpms_set_response (void *f, gpointer d)
+{
+    guint used = 0;
+    guint total = 0;
+    GError *error = NULL;
+
+    g_assert (mm_3gpp_parse_cpms_set_response ("+CPMS: 12,30,12,30,0,30", &used, &total, &error));
+    g_assert_no_error (error);
+    g_assert_cmpuint (used, ==, 12);
+    g_assert_cmpuint (total, ==, 30);
+
+    g_assert (mm_3gpp_parse_cpms_set_response ("\r\n+CPMS: 0, 255\r\n", &used, &total, &error));
+    g_assert_no_error (error);
+    g_assert_cmpuint (used, ==, 0);
+    g_assert_cmpuint (total, ==, 255);
+
+    g_assert (!mm_3gpp_parse_cpms_set_response ("", &used, &total, &error));
+    g_assert (error != NULL);
+    g_clear_error (&error);
+}
+
 /*****************************************************************************/
 /* Test CNUM responses */
 
@@ -3943,6 +4068,7 @@ int main (int argc, char **argv)
     g_test_suite_add (suite, TESTCASE (test_cpms_response_mixed_spaces, NULL));
     g_test_suite_add (suite, TESTCASE (test_cpms_response_empty_fields, NULL));
     g_test_suite_add (suite, TESTCASE (test_cpms_query_response,        NULL));
+    g_test_suite_add (suite, TESTCASE (test_cpms_set_response,          NULL));
 
     g_test_suite_add (suite, TESTCASE (test_cmp_apn_name, NULL));
 
@@ -3961,6 +4087,8 @@ int main (int argc, char **argv)
     g_test_suite_add (suite, TESTCASE (test_cgact_read_response_single_active, NULL));
     g_test_suite_add (suite, TESTCASE (test_cgact_read_response_multiple, NULL));
 
+    g_test_suite_add (suite, TESTCASE (test_cgev_indication, NULL));
+
     g_test_suite_add (suite, TESTCASE (test_cnum_response_generic, NULL));
     g_test_suite_add (suite, TESTCASE (test_cnum_response_generic_without_detail, NULL));
     g_test_suite_add (suite, TESTCASE (test_cnum_response_generic_detail_unquoted, NULL));
@@ -3977,6 +4105,7 @@ int main (int argc, char **argv)
     g_test_suite_add (suite, TESTCASE (test_cmgl_response_generic_multiple, NULL));
     g_test_suite_add (suite, TESTCASE (test_cmgl_response_pantech, NULL));
     g_test_suite_add (suite, TESTCASE (test_cmgl_response_pantech_multiple, NULL));
+    g_test_suite_add (suite, TESTCASE (test_cmgl_response_streamed, NULL));
 
     g_test_suite_add (suite, TESTCASE (test_cmgr_response_generic, NULL));
     g_test_suite_add (suite, TESTCASE (test_cmgr_response_telit, NULL));
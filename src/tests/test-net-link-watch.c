@@ -0,0 +1,239 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ */
+
+#include <string.h>
+#include <locale.h>
+#include <sys/socket.h>
+#include <linux/if.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+#include <glib.h>
+
+#include "mm-net-link-watch.h"
+#include "mm-log.h"
+
+/*****************************************************************************/
+
+/* Appends a link message for @iface, as the kernel would send it */
+static void
+append_link_message (GByteArray *buffer,
+                     guint16 type,
+                     const gchar *iface,
+                     guint flags)
+{
+    struct nlmsghdr hdr;
+    struct ifinfomsg ifi;
+    struct rtattr rta;
+    gsize iface_len;
+    guint8 pad[NLMSG_ALIGNTO] = { 0 };
+    guint start;
+
+    iface_len = strlen (iface) + 1;
+    start = buffer->len;
+
+    memset (&hdr, 0, sizeof (hdr));
+    hdr.nlmsg_type = type;
+    hdr.nlmsg_len = NLMSG_LENGTH (sizeof (ifi)) + RTA_LENGTH (iface_len);
+    g_byte_array_append (buffer, (const guint8 *) &hdr, NLMSG_HDRLEN);
+
+    memset (&ifi, 0, sizeof (ifi));
+    ifi.ifi_family = AF_UNSPEC;
+    ifi.ifi_flags = flags;
+    g_byte_array_append (buffer, (const guint8 *) &ifi, sizeof (ifi));
+    g_byte_array_append (buffer, pad, NLMSG_ALIGN (sizeof (ifi)) - sizeof (ifi));
+
+    memset (&rta, 0, sizeof (rta));
+    rta.rta_type = IFLA_IFNAME;
+    rta.rta_len = RTA_LENGTH (iface_len);
+    g_byte_array_append (buffer, (const guint8 *) &rta, sizeof (rta));
+    g_byte_array_append (buffer, (const guint8 *) iface, iface_len);
+
+    /* Messages are aligned within the buffer */
+    g_byte_array_append (buffer, pad, NLMSG_ALIGN (buffer->len - start) - (buffer->len - start));
+}
+
+typedef struct {
+    guint n_lost;
+    guint n_removed;
+    /* Watch to remove when notified, if any */
+    guint remove_id;
+} LinkEvents;
+
+static void
+link_event_cb (const gchar *iface,
+               gboolean removed,
+               LinkEvents *events)
+{
+    g_assert_cmpstr (iface, ==, "wwan0");
+
+    if (removed)
+        events->n_removed++;
+    else
+        events->n_lost++;
+
+    if (events->remove_id) {
+        mm_net_link_watch_remove (events->remove_id);
+        events->remove_id = 0;
+    }
+}
+
+static guint
+watch_add (const gchar *iface,
+           LinkEvents *events)
+{
+    guint id;
+
+    id = mm_net_link_watch_add (iface, (MMNetLinkWatchFn) link_event_cb, events);
+    if (!id)
+        g_test_message ("netlink socket not available, skipping");
+    return id;
+}
+
+static void
+process (GByteArray *buffer)
+{
+    mm_net_link_watch_process (buffer->data, buffer->len);
+    g_byte_array_set_size (buffer, 0);
+}
+
+static void
+test_carrier (void)
+{
+    LinkEvents events = { 0 };
+    GByteArray *buffer;
+    guint id;
+
+    id = watch_add ("wwan0", &events);
+    if (!id)
+        return;
+
+    buffer = g_byte_array_new ();
+
+    /* Changes which keep the carrier aren't reported */
+    append_link_message (buffer, RTM_NEWLINK, "wwan0", IFF_UP | IFF_LOWER_UP);
+    process (buffer);
+    g_assert_cmpuint (events.n_lost, ==, 0);
+
+    /* Losing it is reported once, however many messages say so */
+    append_link_message (buffer, RTM_NEWLINK, "wwan0", IFF_UP);
+    append_link_message (buffer, RTM_NEWLINK, "wwan0", IFF_UP);
+    process (buffer);
+    g_assert_cmpuint (events.n_lost, ==, 1);
+
+    /* And again after getting it back */
+    append_link_message (buffer, RTM_NEWLINK, "wwan0", IFF_UP | IFF_LOWER_UP);
+    append_link_message (buffer, RTM_NEWLINK, "wwan0", 0);
+    process (buffer);
+    g_assert_cmpuint (events.n_lost, ==, 2);
+    g_assert_cmpuint (events.n_removed, ==, 0);
+
+    g_byte_array_unref (buffer);
+    mm_net_link_watch_remove (id);
+}
+
+static void
+test_removed (void)
+{
+    LinkEvents events = { 0 };
+    GByteArray *buffer;
+    guint id;
+
+    id = watch_add ("wwan0", &events);
+    if (!id)
+        return;
+
+    buffer = g_byte_array_new ();
+
+    /* Other interfaces are ignored */
+    append_link_message (buffer, RTM_DELLINK, "wwan1", 0);
+    append_link_message (buffer, RTM_NEWLINK, "wwan1", 0);
+    process (buffer);
+    g_assert_cmpuint (events.n_removed, ==, 0);
+    g_assert_cmpuint (events.n_lost, ==, 0);
+
+    append_link_message (buffer, RTM_DELLINK, "wwan0", IFF_UP | IFF_LOWER_UP);
+    process (buffer);
+    g_assert_cmpuint (events.n_removed, ==, 1);
+    g_assert_cmpuint (events.n_lost, ==, 0);
+
+    g_byte_array_unref (buffer);
+    mm_net_link_watch_remove (id);
+}
+
+static void
+test_remove_in_callback (void)
+{
+    LinkEvents events1 = { 0 };
+    LinkEvents events2 = { 0 };
+    GByteArray *buffer;
+    guint id1;
+    guint id2;
+
+    id1 = watch_add ("wwan0", &events1);
+    if (!id1)
+        return;
+    id2 = watch_add ("wwan0", &events2);
+    g_assert_cmpuint (id2, !=, 0);
+
+    /* Whichever watch is notified first removes the other one, which must
+     * then not be notified */
+    events1.remove_id = id2;
+    events2.remove_id = id1;
+
+    buffer = g_byte_array_new ();
+    append_link_message (buffer, RTM_DELLINK, "wwan0", 0);
+    process (buffer);
+    g_byte_array_unref (buffer);
+
+    g_assert_cmpuint (events1.n_removed + events2.n_removed, ==, 1);
+    if (events1.n_removed)
+        mm_net_link_watch_remove (id1);
+    else
+        mm_net_link_watch_remove (id2);
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    setlocale (LC_ALL, "");
+
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/net-link-watch/carrier",            test_carrier);
+    g_test_add_func ("/MM/net-link-watch/removed",            test_removed);
+    g_test_add_func ("/MM/net-link-watch/remove-in-callback", test_remove_in_callback);
+
+    return g_test_run ();
+}
@@ -0,0 +1,219 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <locale.h>
+
+#include <ModemManager.h>
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-net-stats.h"
+#include "mm-log.h"
+
+/*****************************************************************************/
+
+static void
+test_rate_basic (void)
+{
+    MMNetRate rate = { 0 };
+
+    /* 1000 bytes in 1s */
+    mm_net_rate_update (&rate, 1000, 1.0, 10.0);
+    g_assert_cmpuint (rate.current, ==, 8000);
+    g_assert_cmpuint (rate.peak, ==, 8000);
+    g_assert_cmpuint (rate.average, ==, 727);
+
+    /* 1000 bytes in 2s */
+    mm_net_rate_update (&rate, 1000, 2.0, 10.0);
+    g_assert_cmpuint (rate.current, ==, 4000);
+    g_assert_cmpuint (rate.peak, ==, 8000);
+    g_assert_cmpuint (rate.average, ==, 1273);
+
+    /* Idle */
+    mm_net_rate_update (&rate, 0, 1.0, 10.0);
+    g_assert_cmpuint (rate.current, ==, 0);
+    g_assert_cmpuint (rate.peak, ==, 8000);
+    g_assert_cmpuint (rate.average, ==, 1157);
+}
+
+static void
+test_rate_interval (void)
+{
+    static const gdouble intervals[] = { 1.0, 2.0, 5.0 };
+    guint i;
+
+    /* A steady rate must be approached at about the same speed whatever the
+     * update interval */
+    for (i = 0; i < G_N_ELEMENTS (intervals); i++) {
+        MMNetRate rate = { 0 };
+        gdouble   elapsed;
+
+        for (elapsed = 0; elapsed < 60.0; elapsed += intervals[i])
+            mm_net_rate_update (&rate, (guint64) (125000 * intervals[i]), intervals[i], 10.0);
+
+        g_assert_cmpuint (rate.current, ==, 1000000);
+        g_assert_cmpuint (rate.average, >, 990000);
+        g_assert_cmpuint (rate.average, <=, 1000000);
+    }
+}
+
+/*****************************************************************************/
+
+static void
+write_counter (const gchar *dir,
+               const gchar *name,
+               guint64 value)
+{
+    gchar *path;
+    FILE  *f;
+
+    /* Rewrite in place, the reader keeps the file open */
+    path = g_build_filename (dir, name, NULL);
+    f = fopen (path, "w");
+    g_assert (f);
+    fprintf (f, "%" G_GUINT64_FORMAT "\n", value);
+    fclose (f);
+    g_free (path);
+}
+
+static void
+write_counters (const gchar *dir,
+                guint64 rx_bytes,
+                guint64 tx_bytes,
+                guint64 rx_packets,
+                guint64 tx_packets)
+{
+    write_counter (dir, "rx_bytes",   rx_bytes);
+    write_counter (dir, "tx_bytes",   tx_bytes);
+    write_counter (dir, "rx_packets", rx_packets);
+    write_counter (dir, "tx_packets", tx_packets);
+}
+
+static void
+remove_counters (const gchar *dir)
+{
+    static const gchar *names[] = { "rx_bytes", "tx_bytes", "rx_packets", "tx_packets" };
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (names); i++) {
+        gchar *path;
+
+        path = g_build_filename (dir, names[i], NULL);
+        g_unlink (path);
+        g_free (path);
+    }
+    g_rmdir (dir);
+}
+
+static void
+test_reader (void)
+{
+    MMNetStatsReader *reader;
+    const MMNetStats *stats;
+    GError           *error = NULL;
+    gchar            *dir;
+
+    dir = g_dir_make_tmp ("test-net-stats-XXXXXX", &error);
+    g_assert_no_error (error);
+
+    /* Counters before the connection aren't accounted */
+    write_counters (dir, 1000, 500, 10, 5);
+    reader = mm_net_stats_reader_new_for_path (dir, 0, &error);
+    g_assert_no_error (error);
+    g_assert (reader);
+
+    stats = mm_net_stats_reader_peek (reader);
+    g_assert_cmpuint (stats->rx_bytes, ==, 0);
+    g_assert_cmpuint (stats->tx_bytes, ==, 0);
+
+    write_counters (dir, 3000, 1500, 30, 15);
+    g_assert (mm_net_stats_reader_update (reader, 2 * G_USEC_PER_SEC, &error));
+    g_assert_no_error (error);
+    g_assert_cmpuint (stats->rx_bytes,   ==, 2000);
+    g_assert_cmpuint (stats->tx_bytes,   ==, 1000);
+    g_assert_cmpuint (stats->rx_packets, ==, 20);
+    g_assert_cmpuint (stats->tx_packets, ==, 10);
+    g_assert_cmpuint (stats->rx_rate.current, ==, 8000);
+    g_assert_cmpuint (stats->tx_rate.current, ==, 4000);
+
+    /* No time elapsed: totals updated, rates untouched */
+    write_counters (dir, 4000, 1500, 40, 15);
+    g_assert (mm_net_stats_reader_update (reader, 2 * G_USEC_PER_SEC, &error));
+    g_assert_cmpuint (stats->rx_bytes, ==, 3000);
+    g_assert_cmpuint (stats->rx_rate.current, ==, 8000);
+
+    /* Counters reset */
+    write_counters (dir, 100, 50, 1, 1);
+    g_assert (mm_net_stats_reader_update (reader, 3 * G_USEC_PER_SEC, &error));
+    g_assert_cmpuint (stats->rx_bytes,   ==, 3100);
+    g_assert_cmpuint (stats->tx_bytes,   ==, 1050);
+    g_assert_cmpuint (stats->rx_packets, ==, 31);
+    g_assert_cmpuint (stats->tx_packets, ==, 11);
+    g_assert_cmpuint (stats->rx_rate.current, ==, 800);
+    g_assert_cmpuint (stats->rx_rate.peak, ==, 8000);
+
+    mm_net_stats_reader_free (reader);
+    remove_counters (dir);
+    g_free (dir);
+}
+
+static void
+test_reader_missing (void)
+{
+    MMNetStatsReader *reader;
+    GError           *error = NULL;
+
+    reader = mm_net_stats_reader_new_for_path ("/nonexistent/statistics", 0, &error);
+    g_assert_error (error, MM_CORE_ERROR, MM_CORE_ERROR_UNSUPPORTED);
+    g_assert (!reader);
+    g_error_free (error);
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    setlocale (LC_ALL, "");
+
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/net-stats/rate/basic",      test_rate_basic);
+    g_test_add_func ("/MM/net-stats/rate/interval",   test_rate_interval);
+    g_test_add_func ("/MM/net-stats/reader",          test_reader);
+    g_test_add_func ("/MM/net-stats/reader/missing",  test_reader_missing);
+
+    return g_test_run ();
+}
@@ -108,6 +108,46 @@ server_send_response (int fd, const char *buf, gsize len)
     }
 }
 
+/* Sends all data at once, so that the port reads many frames together */
+static void
+server_send_burst (int fd, const char *buf, gsize len)
+{
+    gsize i = 0;
+
+    if (g_test_verbose ())
+        print_buf (">>>", buf, len);
+
+    while (i < len) {
+        ssize_t status;
+
+        status = write (fd, &buf[i], len - i);
+        if (status < 0 && errno == EAGAIN) {
+            usleep (1000);
+            continue;
+        }
+        g_assert_cmpint (status, >, 0);
+        i += status;
+    }
+}
+
+/* Appends the encapsulated frame for @payload to @frames */
+static void
+append_frame (GByteArray *frames, const char *payload, gsize payload_len)
+{
+    char *cmdbuf;
+    char *encap;
+    gsize encap_len;
+
+    cmdbuf = g_malloc (payload_len + 2);
+    encap = g_malloc (payload_len * 2 + 5);
+    memcpy (cmdbuf, payload, payload_len);
+    encap_len = dm_encapsulate_buffer (cmdbuf, payload_len, payload_len + 2, encap, payload_len * 2 + 5);
+    g_assert_cmpuint (encap_len, >, 0);
+    g_byte_array_append (frames, (const guint8 *) encap, encap_len);
+    g_free (encap);
+    g_free (cmdbuf);
+}
+
 static gsize
 server_wait_request (int fd, char *buf, gsize len)
 {
@@ -205,6 +245,42 @@ qcdm_request_verinfo (MMPortSerialQcdm *port,
     g_byte_array_unref (verinfo);
 }
 
+#define TEST_LOG_CODE 0x1234
+#define TEST_N_LOGS   5
+
+static guint n_logs_received;
+
+static void
+qcdm_log_received (MMPortSerialQcdm *port,
+                   GByteArray *log_buffer,
+                   gpointer user_data)
+{
+    g_assert_cmpuint (log_buffer->len, ==, 16 + n_logs_received);
+    n_logs_received++;
+}
+
+static guint n_log_batches;
+static guint n_log_records;
+
+static gboolean
+qcdm_log_batch_received (MMPortSerialQcdm *port,
+                         const QcdmLogRecord *records,
+                         guint n_records,
+                         guint n_dropped,
+                         gpointer user_data)
+{
+    guint i;
+
+    g_assert_cmpuint (n_dropped, ==, 0);
+    for (i = 0; i < n_records; i++) {
+        g_assert_cmpuint (records[i].log_code, ==, TEST_LOG_CODE);
+        g_assert_cmpuint (records[i].payload_len, ==, n_log_records);
+        n_log_records++;
+    }
+    n_log_batches++;
+    return TRUE;
+}
+
 static void
 qcdm_test_child (int fd, GAsyncReadyCallback cb)
 {
@@ -218,6 +294,9 @@ qcdm_test_child (int fd, GAsyncReadyCallback cb)
     port = mm_port_serial_qcdm_new_fd (fd);
     g_assert (port);
 
+    mm_port_serial_qcdm_add_unsolicited_msg_handler (port, TEST_LOG_CODE, qcdm_log_received, NULL, NULL);
+    mm_port_serial_qcdm_set_log_consumer (port, qcdm_log_batch_received, TEST_N_LOGS, NULL, NULL);
+
     success = mm_port_serial_open (MM_PORT_SERIAL (port), &error);
     g_assert_no_error (error);
     g_assert (success);
@@ -397,6 +476,359 @@ test_leading_frame_markers (TestData *d)
     g_assert (wait_for_child (d, 3));
 }
 
+#define LARGE_RESPONSE_LEN 3000
+
+static void
+qcdm_large_response_cb (MMPortSerialQcdm *port,
+                        GAsyncResult *res,
+                        GMainLoop *loop)
+{
+    GError *error = NULL;
+    GByteArray *response;
+    guint i;
+
+    response = mm_port_serial_qcdm_command_finish (port, res, &error);
+
+    g_assert_no_error (error);
+    g_assert_cmpuint (response->len, ==, LARGE_RESPONSE_LEN);
+    for (i = 1; i < response->len; i++)
+        g_assert_cmpuint (response->data[i], ==, (guint8) i);
+    g_byte_array_unref (response);
+    g_main_loop_quit (loop);
+}
+
+/* Test that a response larger than any read, and with lots of characters
+ * needing to be escaped, is parsed correctly.
+ */
+static void
+test_large_response (TestData *d)
+{
+    char req[512];
+    gsize req_len;
+    pid_t cpid;
+    GByteArray *rsp;
+    char payload[LARGE_RESPONSE_LEN];
+    guint i;
+
+    payload[0] = 0x00;
+    for (i = 1; i < sizeof (payload); i++)
+        payload[i] = (char) i;
+    rsp = g_byte_array_new ();
+    append_frame (rsp, payload, sizeof (payload));
+
+    signal (SIGCHLD, SIG_DFL);
+    cpid = fork ();
+    g_assert (cpid >= 0);
+
+    if (cpid == 0) {
+        /* In the child */
+        qcdm_test_child (d->slave, (GAsyncReadyCallback)qcdm_large_response_cb);
+        exit (0);
+    }
+    /* Parent */
+    d->child = cpid;
+
+    req_len = server_wait_request (d->master, req, sizeof (req));
+    g_assert (req_len == 1);
+    g_assert_cmpint (req[0], ==, 0x00);
+
+    server_send_burst (d->master, (const char *) rsp->data, rsp->len);
+    g_byte_array_unref (rsp);
+
+    /* We expect the child to exit normally */
+    g_assert (wait_for_child (d, 3));
+}
+
+static void
+qcdm_logs_then_response_cb (MMPortSerialQcdm *port,
+                            GAsyncResult *res,
+                            GMainLoop *loop)
+{
+    /* All log frames received along with the response got dispatched */
+    g_assert_cmpuint (n_logs_received, ==, TEST_N_LOGS);
+    /* ...and handed to the log consumer in batches, not one by one */
+    g_assert_cmpuint (n_log_records, ==, TEST_N_LOGS);
+    g_assert_cmpuint (n_log_batches, <, TEST_N_LOGS);
+    qcdm_verinfo_expect_success_cb (port, res, loop);
+}
+
+/* Test that many log frames and the response received in a single read
+ * are all processed.
+ */
+static void
+test_logs_and_response (TestData *d)
+{
+    char req[512];
+    gsize req_len;
+    pid_t cpid;
+    GByteArray *rsp;
+    const char verinfo_rsp[] = { 0x00, 0x41, 0x75, 0x67, 0x20, 0x31, 0x39 };
+    guint i;
+
+    rsp = g_byte_array_new ();
+    /* Leading marker, as usually sent by devices */
+    g_byte_array_append (rsp, (const guint8 *) "\x7e", 1);
+    for (i = 0; i < TEST_N_LOGS; i++) {
+        char log[16 + TEST_N_LOGS];
+
+        /* DMCmdLog header, log code in LE and a growing payload */
+        memset (log, 0x7e, sizeof (log));
+        log[0] = 0x10;
+        log[1] = 0x00;
+        log[2] = log[4] = 12 + i;
+        log[3] = log[5] = 0x00;
+        log[6] = TEST_LOG_CODE & 0xFF;
+        log[7] = (TEST_LOG_CODE >> 8) & 0xFF;
+        append_frame (rsp, log, 16 + i);
+    }
+    append_frame (rsp, verinfo_rsp, sizeof (verinfo_rsp));
+
+    signal (SIGCHLD, SIG_DFL);
+    cpid = fork ();
+    g_assert (cpid >= 0);
+
+    if (cpid == 0) {
+        /* In the child */
+        qcdm_test_child (d->slave, (GAsyncReadyCallback)qcdm_logs_then_response_cb);
+        exit (0);
+    }
+    /* Parent */
+    d->child = cpid;
+
+    req_len = server_wait_request (d->master, req, sizeof (req));
+    g_assert (req_len == 1);
+    g_assert_cmpint (req[0], ==, 0x00);
+
+    server_send_burst (d->master, (const char *) rsp->data, rsp->len);
+    g_byte_array_unref (rsp);
+
+    /* We expect the child to exit normally */
+    g_assert (wait_for_child (d, 3));
+}
+
+static void
+qcdm_batch_cb (MMPortSerialQcdm *port,
+               GAsyncResult *res,
+               GMainLoop *loop)
+{
+    GError *error = NULL;
+    GPtrArray *responses;
+    GByteArray *response;
+
+    responses = mm_port_serial_qcdm_command_batch_finish (port, res, &error);
+    g_assert_no_error (error);
+    g_assert_cmpuint (responses->len, ==, 2);
+
+    /* Responses come in the order of the commands, whatever the order in
+     * which they were received */
+    response = g_ptr_array_index (responses, 0);
+    g_assert_cmpuint (response->data[0], ==, 0x00);
+    g_assert_cmpuint (response->len, ==, 7);
+    response = g_ptr_array_index (responses, 1);
+    g_assert_cmpuint (response->data[0], ==, 0x01);
+    g_assert_cmpuint (response->len, ==, 5);
+
+    g_ptr_array_unref (responses);
+    g_main_loop_quit (loop);
+}
+
+static void
+qcdm_batch_partial_cb (MMPortSerialQcdm *port,
+                       GAsyncResult *res,
+                       GMainLoop *loop)
+{
+    GError *error = NULL;
+    GPtrArray *responses;
+    GByteArray *response;
+
+    /* The responses which arrived before the timeout are given */
+    responses = mm_port_serial_qcdm_command_batch_finish (port, res, &error);
+    g_assert_no_error (error);
+    g_assert_cmpuint (responses->len, ==, 2);
+
+    g_assert (g_ptr_array_index (responses, 0) == NULL);
+    response = g_ptr_array_index (responses, 1);
+    g_assert_cmpuint (response->data[0], ==, 0x01);
+    g_assert_cmpuint (response->len, ==, 5);
+
+    g_ptr_array_unref (responses);
+    g_main_loop_quit (loop);
+}
+
+static void
+qcdm_batch_test_child (int fd,
+                       guint32 timeout_seconds,
+                       GAsyncReadyCallback callback)
+{
+    MMPortSerialQcdm *port;
+    GMainLoop *loop;
+    GPtrArray *commands;
+    GByteArray *cmd;
+    gboolean success;
+    GError *error = NULL;
+
+    loop = g_main_loop_new (NULL, FALSE);
+
+    port = mm_port_serial_qcdm_new_fd (fd);
+    g_assert (port);
+
+    success = mm_port_serial_open (MM_PORT_SERIAL (port), &error);
+    g_assert_no_error (error);
+    g_assert (success);
+
+    commands = g_ptr_array_new_with_free_func ((GDestroyNotify)g_byte_array_unref);
+    cmd = g_byte_array_sized_new (50);
+    cmd->len = qcdm_cmd_version_info_new ((char *) cmd->data, 50);
+    g_assert_cmpuint (cmd->len, >, 0);
+    g_ptr_array_add (commands, cmd);
+    cmd = g_byte_array_sized_new (50);
+    cmd->len = qcdm_cmd_esn_new ((char *) cmd->data, 50);
+    g_assert_cmpuint (cmd->len, >, 0);
+    g_ptr_array_add (commands, cmd);
+
+    mm_port_serial_qcdm_command_batch (port, commands, timeout_seconds, NULL, callback, loop);
+    g_ptr_array_unref (commands);
+
+    g_main_loop_run (loop);
+    g_main_loop_unref (loop);
+
+    mm_port_serial_close (MM_PORT_SERIAL (port));
+    g_object_unref (port);
+}
+
+/* Test that a batch of commands is sent at once, and that the responses are
+ * matched to their commands when received in a different order.
+ */
+static void
+test_batch (TestData *d)
+{
+    char req[512];
+    gsize req_len;
+    pid_t cpid;
+    GByteArray *rsp;
+    const char verinfo_rsp[] = { 0x00, 0x41, 0x75, 0x67, 0x20, 0x31, 0x39 };
+    const char esn_rsp[] = { 0x01, 0xef, 0xbe, 0xad, 0xde };
+    const char unexpected_rsp[] = { 0x26, 0x00, 0x00, 0x00 };
+
+    signal (SIGCHLD, SIG_DFL);
+    cpid = fork ();
+    g_assert (cpid >= 0);
+
+    if (cpid == 0) {
+        /* In the child */
+        qcdm_batch_test_child (d->slave, 3, (GAsyncReadyCallback)qcdm_batch_cb);
+        exit (0);
+    }
+    /* Parent */
+    d->child = cpid;
+
+    req_len = server_wait_request (d->master, req, sizeof (req));
+    g_assert (req_len == 1);
+    g_assert_cmpint (req[0], ==, 0x00);
+    req_len = server_wait_request (d->master, req, sizeof (req));
+    g_assert (req_len == 1);
+    g_assert_cmpint (req[0], ==, 0x01);
+
+    rsp = g_byte_array_new ();
+    append_frame (rsp, esn_rsp, sizeof (esn_rsp));
+    append_frame (rsp, unexpected_rsp, sizeof (unexpected_rsp));
+    append_frame (rsp, verinfo_rsp, sizeof (verinfo_rsp));
+    server_send_burst (d->master, (const char *) rsp->data, rsp->len);
+    g_byte_array_unref (rsp);
+
+    /* We expect the child to exit normally */
+    g_assert (wait_for_child (d, 3));
+}
+
+/* Test that the responses received are given when the batch times out
+ * before all of them arrive.
+ */
+static void
+test_batch_partial (TestData *d)
+{
+    char req[512];
+    gsize req_len;
+    pid_t cpid;
+    GByteArray *rsp;
+    const char esn_rsp[] = { 0x01, 0xef, 0xbe, 0xad, 0xde };
+
+    signal (SIGCHLD, SIG_DFL);
+    cpid = fork ();
+    g_assert (cpid >= 0);
+
+    if (cpid == 0) {
+        /* In the child */
+        qcdm_batch_test_child (d->slave, 1, (GAsyncReadyCallback)qcdm_batch_partial_cb);
+        exit (0);
+    }
+    /* Parent */
+    d->child = cpid;
+
+    req_len = server_wait_request (d->master, req, sizeof (req));
+    g_assert (req_len == 1);
+    g_assert_cmpint (req[0], ==, 0x00);
+    req_len = server_wait_request (d->master, req, sizeof (req));
+    g_assert (req_len == 1);
+    g_assert_cmpint (req[0], ==, 0x01);
+
+    /* No response to the version info command */
+    rsp = g_byte_array_new ();
+    append_frame (rsp, esn_rsp, sizeof (esn_rsp));
+    server_send_burst (d->master, (const char *) rsp->data, rsp->len);
+    g_byte_array_unref (rsp);
+
+    /* We expect the child to exit normally */
+    g_assert (wait_for_child (d, 5));
+}
+
+/* Test that frames are found after data already scanned by the parser is
+ * removed from the response buffer by the serial port, e.g. when flushed
+ * after an I/O error, even if the buffer then grows past the scanned length.
+ */
+static void
+test_buffer_reset (void)
+{
+    MMPortSerialQcdm *port;
+    MMPortSerialClass *port_class;
+    GByteArray *buffer;
+    GByteArray *parsed = NULL;
+    GError *error = NULL;
+    const char payload[] = { 0x00, 0x01, 0x02 };
+    const guint8 noise[] = {
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a,
+        0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14
+    };
+
+    port = mm_port_serial_qcdm_new ("ttyTEST0");
+    port_class = MM_PORT_SERIAL_GET_CLASS (port);
+    buffer = g_byte_array_new ();
+
+    /* No frame marker in the buffer yet */
+    g_byte_array_append (buffer, noise, sizeof (noise));
+    g_assert_cmpint (port_class->parse_response (MM_PORT_SERIAL (port), buffer, &parsed, &error), ==, MM_PORT_SERIAL_RESPONSE_NONE);
+    g_assert_no_error (error);
+    g_assert_cmpuint (buffer->len, ==, sizeof (noise));
+
+    /* Flushed by the serial port, then refilled beyond the scanned length
+     * with a frame shorter than it */
+    g_byte_array_remove_range (buffer, 0, buffer->len);
+    port_class->response_buffer_reset (MM_PORT_SERIAL (port));
+    append_frame (buffer, payload, sizeof (payload));
+    g_assert_cmpuint (buffer->len, <, sizeof (noise));
+    g_byte_array_append (buffer, noise, sizeof (noise));
+
+    g_assert_cmpint (port_class->parse_response (MM_PORT_SERIAL (port), buffer, &parsed, &error), ==, MM_PORT_SERIAL_RESPONSE_BUFFER);
+    g_assert_no_error (error);
+    g_assert (parsed);
+    g_assert_cmpuint (parsed->len, ==, sizeof (payload));
+    g_assert (memcmp (parsed->data, payload, sizeof (payload)) == 0);
+    g_assert_cmpuint (buffer->len, ==, sizeof (noise));
+
+    g_byte_array_unref (parsed);
+    g_byte_array_unref (buffer);
+    g_object_unref (port);
+}
+
 static void
 test_pty_create (TestData *d)
 {
@@ -468,6 +900,11 @@ int main (int argc, char **argv)
     TESTCASE_PTY ("/MM/QCDM/Sierra-Cns-Rejected", test_sierra_cns_rejected);
     TESTCASE_PTY ("/MM/QCDM/Random-Data-Rejected", test_random_data_rejected);
     TESTCASE_PTY ("/MM/QCDM/Leading-Frame-Markers", test_leading_frame_markers);
+    TESTCASE_PTY ("/MM/QCDM/Large-Response", test_large_response);
+    TESTCASE_PTY ("/MM/QCDM/Logs-And-Response", test_logs_and_response);
+    TESTCASE_PTY ("/MM/QCDM/Batch", test_batch);
+    TESTCASE_PTY ("/MM/QCDM/Batch-Partial", test_batch_partial);
+    g_test_add_func ("/MM/QCDM/Buffer-Reset", test_buffer_reset);
 
     return g_test_run ();
 }
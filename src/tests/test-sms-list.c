@@ -0,0 +1,724 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ */
+
+#include <glib.h>
+#include <glib-object.h>
+#include <string.h>
+#include <locale.h>
+
+#include <ModemManager.h>
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-sms-list.h"
+#include "mm-base-sms.h"
+#include "mm-iface-modem-messaging.h"
+#include "mm-log.h"
+
+/* Define symbol to enable test message traces */
+#undef ENABLE_TEST_MESSAGE_TRACES
+
+/*****************************************************************************/
+/* Minimal SMS objects
+ *
+ * The real ones need a modem to talk to, and the list only cares about which
+ * parts they hold, so they're replaced here with a simple implementation of
+ * the methods used by the list.
+ */
+
+struct _MMBaseSmsPrivate {
+    gchar        *path;
+    MMSmsStorage  storage;
+    gboolean      is_multipart;
+    guint         reference;
+    guint         max_parts;
+    GList        *parts;
+};
+
+G_DEFINE_TYPE (MMBaseSms, mm_base_sms, MM_GDBUS_TYPE_SMS_SKELETON)
+
+static guint sms_path_id;
+
+static MMBaseSms *
+sms_new (MMSmsState    state,
+         MMSmsStorage  storage,
+         MMSmsPart    *part)
+{
+    MMBaseSms *self;
+
+    self = g_object_new (MM_TYPE_BASE_SMS, NULL);
+    self->priv->path    = g_strdup_printf (MM_DBUS_SMS_PREFIX "/%u", sms_path_id++);
+    self->priv->storage = storage;
+    mm_gdbus_sms_set_state    (MM_GDBUS_SMS (self), state);
+    mm_gdbus_sms_set_pdu_type (MM_GDBUS_SMS (self), mm_sms_part_get_pdu_type (part));
+    mm_gdbus_sms_set_number   (MM_GDBUS_SMS (self), mm_sms_part_get_number (part));
+    return self;
+}
+
+MMBaseSms *
+mm_base_sms_singlepart_new (MMBaseModem  *modem,
+                            MMSmsState    state,
+                            MMSmsStorage  storage,
+                            MMSmsPart    *part,
+                            GError      **error)
+{
+    MMBaseSms *self;
+
+    self = sms_new (state, storage, part);
+    self->priv->parts = g_list_append (NULL, part);
+    return self;
+}
+
+gboolean
+mm_base_sms_multipart_take_part (MMBaseSms  *self,
+                                 MMSmsPart  *part,
+                                 GError    **error)
+{
+    GList *l;
+
+    if (g_list_length (self->priv->parts) >= self->priv->max_parts) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED, "too many parts");
+        return FALSE;
+    }
+
+    for (l = self->priv->parts; l; l = g_list_next (l)) {
+        if (mm_sms_part_get_concat_sequence (l->data) == mm_sms_part_get_concat_sequence (part)) {
+            g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED, "sequence already taken");
+            return FALSE;
+        }
+    }
+
+    self->priv->parts = g_list_append (self->priv->parts, part);
+    return TRUE;
+}
+
+MMBaseSms *
+mm_base_sms_multipart_new (MMBaseModem  *modem,
+                           MMSmsState    state,
+                           MMSmsStorage  storage,
+                           guint         reference,
+                           guint         max_parts,
+                           MMSmsPart    *first_part,
+                           GError      **error)
+{
+    MMBaseSms *self;
+
+    self = sms_new (state, storage, first_part);
+    self->priv->is_multipart = TRUE;
+    self->priv->reference    = reference;
+    self->priv->max_parts    = max_parts;
+    if (!mm_base_sms_multipart_take_part (self, first_part, error))
+        g_clear_object (&self);
+    return self;
+}
+
+void
+mm_base_sms_unexport (MMBaseSms *self)
+{
+    g_clear_pointer (&self->priv->path, g_free);
+}
+
+const gchar *
+mm_base_sms_get_path (MMBaseSms *self)
+{
+    return self->priv->path;
+}
+
+MMSmsStorage
+mm_base_sms_get_storage (MMBaseSms *self)
+{
+    return self->priv->storage;
+}
+
+gboolean
+mm_base_sms_has_part_index (MMBaseSms *self,
+                            guint      index)
+{
+    GList *l;
+
+    for (l = self->priv->parts; l; l = g_list_next (l)) {
+        if (mm_sms_part_get_index (l->data) == index)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+gboolean
+mm_base_sms_is_multipart (MMBaseSms *self)
+{
+    return self->priv->is_multipart;
+}
+
+guint
+mm_base_sms_get_multipart_reference (MMBaseSms *self)
+{
+    return self->priv->reference;
+}
+
+gboolean
+mm_base_sms_multipart_is_complete (MMBaseSms *self)
+{
+    return (g_list_length (self->priv->parts) == self->priv->max_parts);
+}
+
+void
+mm_base_sms_delete (MMBaseSms           *self,
+                    GAsyncReadyCallback  callback,
+                    gpointer             user_data)
+{
+    GTask *task;
+
+    task = g_task_new (self, NULL, callback, user_data);
+    g_task_return_boolean (task, TRUE);
+    g_object_unref (task);
+}
+
+gboolean
+mm_base_sms_delete_finish (MMBaseSms     *self,
+                           GAsyncResult  *res,
+                           GError       **error)
+{
+    return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+static void
+mm_base_sms_init (MMBaseSms *self)
+{
+    self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, MM_TYPE_BASE_SMS, MMBaseSmsPrivate);
+}
+
+static void
+mm_base_sms_finalize (GObject *object)
+{
+    MMBaseSms *self = MM_BASE_SMS (object);
+
+    g_list_free_full (self->priv->parts, (GDestroyNotify)mm_sms_part_free);
+    g_free (self->priv->path);
+
+    G_OBJECT_CLASS (mm_base_sms_parent_class)->finalize (object);
+}
+
+static void
+mm_base_sms_class_init (MMBaseSmsClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    g_type_class_add_private (object_class, sizeof (MMBaseSmsPrivate));
+    object_class->finalize = mm_base_sms_finalize;
+}
+
+/* The list only uses the modem type for its property */
+GType
+mm_base_modem_get_type (void)
+{
+    return G_TYPE_OBJECT;
+}
+
+/*****************************************************************************/
+/* Minimal modem
+ *
+ * Only the loading of single stored parts is used by the list, for the parts
+ * loaded on demand with lazy export.
+ */
+
+GType
+mm_iface_modem_messaging_get_type (void)
+{
+    static GType type = 0;
+
+    if (G_UNLIKELY (!type)) {
+        type = g_type_register_static_simple (G_TYPE_INTERFACE,
+                                              "MMIfaceModemMessaging",
+                                              sizeof (MMIfaceModemMessaging),
+                                              NULL, 0, NULL, 0);
+        g_type_interface_add_prerequisite (type, G_TYPE_OBJECT);
+    }
+    return type;
+}
+
+typedef struct {
+    guint index;
+    const gchar *number;
+    guint reference;
+    guint max;
+    guint sequence;
+} StoredPart;
+
+typedef struct {
+    GObject parent;
+    const StoredPart *stored;
+    guint n_stored;
+    guint n_loads;
+} TestModem;
+
+typedef struct {
+    GObjectClass parent;
+} TestModemClass;
+
+static void test_modem_iface_modem_messaging_init (MMIfaceModemMessaging *iface);
+
+static GType test_modem_get_type (void);
+G_DEFINE_TYPE_WITH_CODE (TestModem, test_modem, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (MM_TYPE_IFACE_MODEM_MESSAGING,
+                                                test_modem_iface_modem_messaging_init))
+
+static MMSmsPart *part_new (guint        index,
+                            const gchar *number,
+                            guint        reference,
+                            guint        max,
+                            guint        sequence);
+
+static MMSmsPart *
+test_modem_load_sms_part_finish (MMIfaceModemMessaging  *self,
+                                 GAsyncResult           *res,
+                                 GError                **error)
+{
+    return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+static void
+test_modem_load_sms_part (MMIfaceModemMessaging *_self,
+                          MMSmsStorage           storage,
+                          guint                  index,
+                          GAsyncReadyCallback    callback,
+                          gpointer               user_data)
+{
+    TestModem *self = (TestModem *)_self;
+    GTask     *task;
+    guint      i;
+
+    self->n_loads++;
+    task = g_task_new (self, NULL, callback, user_data);
+    for (i = 0; i < self->n_stored; i++) {
+        const StoredPart *stored = &self->stored[i];
+
+        if (stored->index == index) {
+            g_task_return_pointer (task,
+                                   part_new (stored->index,
+                                             stored->number,
+                                             stored->reference,
+                                             stored->max,
+                                             stored->sequence),
+                                   (GDestroyNotify)mm_sms_part_free);
+            g_object_unref (task);
+            return;
+        }
+    }
+
+    g_task_return_new_error (task, MM_CORE_ERROR, MM_CORE_ERROR_NOT_FOUND, "no part at index %u", index);
+    g_object_unref (task);
+}
+
+static void
+test_modem_init (TestModem *self)
+{
+}
+
+static void
+test_modem_class_init (TestModemClass *klass)
+{
+}
+
+static void
+test_modem_iface_modem_messaging_init (MMIfaceModemMessaging *iface)
+{
+    iface->load_sms_part = test_modem_load_sms_part;
+    iface->load_sms_part_finish = test_modem_load_sms_part_finish;
+}
+
+static TestModem *
+test_modem_new (const StoredPart *stored,
+                guint             n_stored)
+{
+    TestModem *self;
+
+    self = g_object_new (test_modem_get_type (), NULL);
+    self->stored = stored;
+    self->n_stored = n_stored;
+    return self;
+}
+
+/*****************************************************************************/
+
+static MMSmsPart *
+part_new (guint        index,
+          const gchar *number,
+          guint        reference,
+          guint        max,
+          guint        sequence)
+{
+    MMSmsPart *part;
+
+    part = mm_sms_part_new (index, MM_SMS_PDU_TYPE_DELIVER);
+    mm_sms_part_set_number (part, number);
+    if (reference) {
+        mm_sms_part_set_concat_reference (part, reference);
+        mm_sms_part_set_concat_max (part, max);
+        mm_sms_part_set_concat_sequence (part, sequence);
+    }
+    return part;
+}
+
+static gboolean
+take_part (MMSmsList *list,
+           MMSmsPart *part)
+{
+    GError   *error = NULL;
+    gboolean  taken;
+
+    taken = mm_sms_list_take_part (list, part, MM_SMS_STATE_RECEIVED, MM_SMS_STORAGE_ME, &error);
+    if (!taken) {
+        g_assert (error);
+        g_error_free (error);
+        mm_sms_part_free (part);
+    }
+    return taken;
+}
+
+static void
+delete_ready (MMSmsList    *list,
+              GAsyncResult *res,
+              gboolean     *done)
+{
+    GError *error = NULL;
+
+    g_assert (mm_sms_list_delete_sms_finish (list, res, &error));
+    g_assert_no_error (error);
+    *done = TRUE;
+}
+
+static void
+delete_sms (MMSmsList   *list,
+            const gchar *path)
+{
+    gboolean done = FALSE;
+
+    mm_sms_list_delete_sms (list, path, (GAsyncReadyCallback)delete_ready, &done);
+    while (!done)
+        g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+load_deferred_ready (MMSmsList    *list,
+                     GAsyncResult *res,
+                     gboolean     *done)
+{
+    GError *error = NULL;
+
+    g_assert (mm_sms_list_load_deferred_finish (list, res, &error));
+    g_assert_no_error (error);
+    *done = TRUE;
+}
+
+static void
+load_deferred (MMSmsList *list)
+{
+    gboolean done = FALSE;
+
+    mm_sms_list_load_deferred (list, (GAsyncReadyCallback)load_deferred_ready, &done);
+    while (!done)
+        g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+sms_added (MMSmsList    *list,
+           const gchar  *path,
+           gboolean      received,
+           gchar       **last_added)
+{
+    g_free (*last_added);
+    *last_added = g_strdup (path);
+}
+
+/*****************************************************************************/
+
+static void
+test_index_has_part (void)
+{
+    MMSmsList *list;
+
+    list = mm_sms_list_new (NULL, FALSE);
+
+    g_assert (take_part (list, part_new (0, "+123", 0, 0, 0)));
+    g_assert (take_part (list, part_new (1, "+123", 7, 2, 1)));
+    g_assert (take_part (list, part_new (2, "+123", 7, 2, 2)));
+    g_assert_cmpuint (mm_sms_list_get_count (list), ==, 2);
+
+    g_assert (mm_sms_list_has_part (list, MM_SMS_STORAGE_ME, 0));
+    g_assert (mm_sms_list_has_part (list, MM_SMS_STORAGE_ME, 1));
+    g_assert (mm_sms_list_has_part (list, MM_SMS_STORAGE_ME, 2));
+    g_assert (!mm_sms_list_has_part (list, MM_SMS_STORAGE_ME, 3));
+    g_assert (!mm_sms_list_has_part (list, MM_SMS_STORAGE_SM, 0));
+
+    /* Same index again */
+    g_assert (!take_part (list, part_new (0, "+123", 0, 0, 0)));
+
+    /* Same reference from another number is another message */
+    g_assert (take_part (list, part_new (3, "+456", 7, 2, 1)));
+    g_assert_cmpuint (mm_sms_list_get_count (list), ==, 3);
+
+    g_object_unref (list);
+}
+
+static void
+test_index_delete (void)
+{
+    MMSmsList *list;
+    gchar     *singlepart = NULL;
+    gchar     *multipart = NULL;
+    gchar     *last_added = NULL;
+
+    list = mm_sms_list_new (NULL, FALSE);
+    g_signal_connect (list, MM_SMS_ADDED, G_CALLBACK (sms_added), &last_added);
+
+    g_assert (take_part (list, part_new (0, "+123", 0, 0, 0)));
+    singlepart = g_strdup (last_added);
+    g_assert (take_part (list, part_new (1, "+123", 7, 3, 1)));
+    multipart = g_strdup (last_added);
+    g_assert (take_part (list, part_new (2, "+123", 7, 3, 2)));
+    g_assert_cmpstr (last_added, ==, multipart);
+
+    delete_sms (list, multipart);
+    g_assert_cmpuint (mm_sms_list_get_count (list), ==, 1);
+    g_assert (mm_sms_list_has_part (list, MM_SMS_STORAGE_ME, 0));
+    g_assert (!mm_sms_list_has_part (list, MM_SMS_STORAGE_ME, 1));
+    g_assert (!mm_sms_list_has_part (list, MM_SMS_STORAGE_ME, 2));
+
+    /* The missing part of the deleted message arrives: new message */
+    g_assert (take_part (list, part_new (3, "+123", 7, 3, 3)));
+    g_assert_cmpstr (last_added, !=, multipart);
+    g_assert_cmpuint (mm_sms_list_get_count (list), ==, 2);
+
+    /* The index of a deleted part can be reused by a new message */
+    g_assert (take_part (list, part_new (1, "+123", 0, 0, 0)));
+    g_assert_cmpuint (mm_sms_list_get_count (list), ==, 3);
+
+    delete_sms (list, singlepart);
+    g_assert (!mm_sms_list_has_part (list, MM_SMS_STORAGE_ME, 0));
+    g_assert (mm_sms_list_has_part (list, MM_SMS_STORAGE_ME, 1));
+    g_assert (mm_sms_list_has_part (list, MM_SMS_STORAGE_ME, 3));
+
+    g_free (singlepart);
+    g_free (multipart);
+    g_free (last_added);
+    g_object_unref (list);
+}
+
+static void
+test_lazy_load_on_demand (void)
+{
+    static const StoredPart stored[] = {
+        { 0, "+123", 0, 0, 0 },
+        { 1, "+123", 7, 2, 1 },
+        { 2, "+123", 7, 2, 2 },
+    };
+    TestModem *modem;
+    MMSmsList *list;
+    guint      i;
+
+    modem = test_modem_new (stored, G_N_ELEMENTS (stored));
+    list = mm_sms_list_new ((MMBaseModem *)modem, TRUE);
+
+    /* Parts found in the initial load are only indexed */
+    for (i = 0; i < G_N_ELEMENTS (stored); i++)
+        g_assert (take_part (list, part_new (stored[i].index,
+                                             stored[i].number,
+                                             stored[i].reference,
+                                             stored[i].max,
+                                             stored[i].sequence)));
+    mm_sms_list_initial_load_done (list);
+    g_assert_cmpuint (mm_sms_list_get_count (list), ==, 0);
+    for (i = 0; i < G_N_ELEMENTS (stored); i++)
+        g_assert (mm_sms_list_has_part (list, MM_SMS_STORAGE_ME, stored[i].index));
+    g_assert (!take_part (list, part_new (1, "+123", 7, 2, 1)));
+    g_assert_cmpuint (modem->n_loads, ==, 0);
+
+    /* And read again from the modem when requested */
+    load_deferred (list);
+    g_assert_cmpuint (modem->n_loads, ==, G_N_ELEMENTS (stored));
+    g_assert_cmpuint (mm_sms_list_get_count (list), ==, 2);
+    for (i = 0; i < G_N_ELEMENTS (stored); i++)
+        g_assert (mm_sms_list_has_part (list, MM_SMS_STORAGE_ME, stored[i].index));
+
+    /* Only once */
+    load_deferred (list);
+    g_assert_cmpuint (modem->n_loads, ==, G_N_ELEMENTS (stored));
+    g_assert_cmpuint (mm_sms_list_get_count (list), ==, 2);
+
+    g_object_unref (list);
+    g_object_unref (modem);
+}
+
+static void
+test_lazy_load_failed (void)
+{
+    TestModem *modem;
+    MMSmsList *list;
+
+    /* Nothing stored in the modem anymore */
+    modem = test_modem_new (NULL, 0);
+    list = mm_sms_list_new ((MMBaseModem *)modem, TRUE);
+
+    g_assert (take_part (list, part_new (0, "+123", 0, 0, 0)));
+    mm_sms_list_initial_load_done (list);
+    g_assert (mm_sms_list_has_part (list, MM_SMS_STORAGE_ME, 0));
+
+    load_deferred (list);
+    g_assert_cmpuint (modem->n_loads, ==, 1);
+    g_assert_cmpuint (mm_sms_list_get_count (list), ==, 0);
+    g_assert (!mm_sms_list_has_part (list, MM_SMS_STORAGE_ME, 0));
+
+    g_object_unref (list);
+    g_object_unref (modem);
+}
+
+static void
+test_lazy_load_multipart (void)
+{
+    static const StoredPart stored[] = {
+        { 0, "+123", 0, 0, 0 },
+        { 1, "+123", 9, 3, 1 },
+        { 2, "+123", 9, 3, 2 },
+        { 3, "+456", 9, 3, 1 },
+    };
+    TestModem *modem;
+    MMSmsList *list;
+    gchar     *last_added = NULL;
+    gchar     *multipart;
+    guint      i;
+
+    modem = test_modem_new (stored, G_N_ELEMENTS (stored));
+    list = mm_sms_list_new ((MMBaseModem *)modem, TRUE);
+    g_signal_connect (list, MM_SMS_ADDED, G_CALLBACK (sms_added), &last_added);
+
+    for (i = 0; i < G_N_ELEMENTS (stored); i++)
+        g_assert (take_part (list, part_new (stored[i].index,
+                                             stored[i].number,
+                                             stored[i].reference,
+                                             stored[i].max,
+                                             stored[i].sequence)));
+    mm_sms_list_initial_load_done (list);
+    g_assert_cmpuint (mm_sms_list_get_count (list), ==, 0);
+
+    /* The last part of a deferred multipart message arrives: only the stored
+     * parts of that message are loaded, and merged with it */
+    g_assert (take_part (list, part_new (4, "+123", 9, 3, 3)));
+    multipart = g_strdup (last_added);
+    while (modem->n_loads < 2 || g_main_context_pending (NULL))
+        g_main_context_iteration (NULL, TRUE);
+    g_assert_cmpuint (modem->n_loads, ==, 2);
+    g_assert_cmpuint (mm_sms_list_get_count (list), ==, 1);
+    g_assert_cmpstr (last_added, ==, multipart);
+    g_assert (mm_sms_list_has_part (list, MM_SMS_STORAGE_ME, 1));
+    g_assert (mm_sms_list_has_part (list, MM_SMS_STORAGE_ME, 2));
+
+    /* The rest stay deferred until requested */
+    load_deferred (list);
+    g_assert_cmpuint (modem->n_loads, ==, G_N_ELEMENTS (stored));
+    g_assert_cmpuint (mm_sms_list_get_count (list), ==, 3);
+
+    g_free (multipart);
+    g_free (last_added);
+    g_object_unref (list);
+    g_object_unref (modem);
+}
+
+#define N_BENCHMARK_PARTS 1000
+
+static void
+test_index_benchmark (void)
+{
+    MMSmsList *list;
+    GPtrArray *paths;
+    gchar     *last_added = NULL;
+    gdouble    elapsed_take;
+    gdouble    elapsed_delete;
+    guint      i;
+
+    list = mm_sms_list_new (NULL, FALSE);
+    g_signal_connect (list, MM_SMS_ADDED, G_CALLBACK (sms_added), &last_added);
+    paths = g_ptr_array_new_with_free_func (g_free);
+
+    /* Half singlepart messages, half 2-part messages */
+    g_test_timer_start ();
+    for (i = 0; i < N_BENCHMARK_PARTS; i++) {
+        if (i % 4 < 2)
+            g_assert (take_part (list, part_new (i, "+123", 0, 0, 0)));
+        else
+            g_assert (take_part (list, part_new (i, "+123", (i / 4) + 1, 2, (i % 4) - 1)));
+        if (i % 4 != 3)
+            g_ptr_array_add (paths, g_strdup (last_added));
+    }
+    for (i = 0; i < N_BENCHMARK_PARTS; i++)
+        g_assert (mm_sms_list_has_part (list, MM_SMS_STORAGE_ME, i));
+    elapsed_take = g_test_timer_elapsed ();
+
+    g_assert_cmpuint (mm_sms_list_get_count (list), ==, paths->len);
+
+    g_test_timer_start ();
+    for (i = 0; i < paths->len; i++)
+        delete_sms (list, g_ptr_array_index (paths, i));
+    elapsed_delete = g_test_timer_elapsed ();
+
+    g_assert_cmpuint (mm_sms_list_get_count (list), ==, 0);
+    g_assert (!mm_sms_list_has_part (list, MM_SMS_STORAGE_ME, 0));
+
+    g_test_minimized_result (elapsed_take + elapsed_delete,
+                             "%u parts taken and deleted in %.3lf s",
+                             N_BENCHMARK_PARTS, elapsed_take + elapsed_delete);
+    g_test_message ("take: %u parts in %.3lf s", N_BENCHMARK_PARTS, elapsed_take);
+    g_test_message ("delete: %u messages in %.3lf s", paths->len, elapsed_delete);
+
+    g_ptr_array_unref (paths);
+    g_free (last_added);
+    g_object_unref (list);
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    setlocale (LC_ALL, "");
+
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/sms-list/index/has-part", test_index_has_part);
+    g_test_add_func ("/MM/sms-list/index/delete",   test_index_delete);
+    g_test_add_func ("/MM/sms-list/lazy/load-on-demand", test_lazy_load_on_demand);
+    g_test_add_func ("/MM/sms-list/lazy/load-failed",    test_lazy_load_failed);
+    g_test_add_func ("/MM/sms-list/lazy/multipart",      test_lazy_load_multipart);
+    if (g_test_perf ())
+        g_test_add_func ("/MM/sms-list/index/benchmark", test_index_benchmark);
+
+    return g_test_run ();
+}
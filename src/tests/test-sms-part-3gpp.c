@@ -454,6 +454,247 @@ test_pdu_not_stored (void)
         NULL, 0);
 }
 
+/********************* PDU VIEW TESTS *********************/
+
+/* PDUs from the parser tests above, with every field the view gives */
+typedef struct {
+    const gchar   *hexpdu;
+    MMSmsPduType   pdu_type;
+    MMSmsEncoding  encoding;
+    gint           class;
+    gboolean       delivery_report_request;
+    guint          message_reference;
+    guint          delivery_state;
+    gboolean       concat;
+    guint          concat_reference;
+    guint          concat_max;
+    guint          concat_sequence;
+    const gchar   *smsc;
+    const gchar   *number;
+    const gchar   *timestamp;
+    const gchar   *discharge_timestamp;
+    const gchar   *text;
+    const gchar   *hexdata;
+} PduViewTest;
+
+static const PduViewTest pdu_corpus[] = {
+    /* pdu2 */
+    {
+        "07919730071111F10414D04937BD2C7797E9D3E614000811309291024061080442043504410442",
+        MM_SMS_PDU_TYPE_DELIVER, MM_SMS_ENCODING_UCS2, -1, FALSE, 0, MM_SMS_DELIVERY_STATE_UNKNOWN,
+        FALSE, 0, 0, 0,
+        "+79037011111", "InternetSMS", "110329192004+04", NULL,
+        "тест",
+        NULL
+    },
+    /* pdu3 */
+    {
+        "07912143658709F1040B918100551512F20000111010214365000AE8329BFD4697D9EC37",
+        MM_SMS_PDU_TYPE_DELIVER, MM_SMS_ENCODING_GSM7, -1, FALSE, 0, MM_SMS_DELIVERY_STATE_UNKNOWN,
+        FALSE, 0, 0, 0,
+        "+12345678901", "+18005551212", "110101123456+00", NULL,
+        "hellohello",
+        NULL
+    },
+    /* pdu3-8bit */
+    {
+        "07912143658709F1040B918100551512F20004111010214365000AE8329BFD4697D9EC37DE",
+        MM_SMS_PDU_TYPE_DELIVER, MM_SMS_ENCODING_8BIT, -1, FALSE, 0, MM_SMS_DELIVERY_STATE_UNKNOWN,
+        FALSE, 0, 0, 0,
+        "+12345678901", "+18005551212", "110101123456+00", NULL,
+        NULL,
+        "E8329BFD4697D9EC37DE"
+    },
+    /* pdu-dcsf-8bit, class 0 */
+    {
+        "07912143658709F1040B918100551512F200F4111010214365000AE8329BFD4697D9EC37DE",
+        MM_SMS_PDU_TYPE_DELIVER, MM_SMS_ENCODING_8BIT, 0, FALSE, 0, MM_SMS_DELIVERY_STATE_UNKNOWN,
+        FALSE, 0, 0, 0,
+        "+12345678901", "+18005551212", "110101123456+00", NULL,
+        NULL,
+        "E8329BFD4697D9EC37DE"
+    },
+    /* pdu-udhi, 16-bit concat reference */
+    {
+        "07911356131313F64004850120390011609232239180A006080400100201D7327BFD6EB340E232"
+        "1BF46E83EA7790F59D1E97DBE1341B442F83C465763D3DA797E56537C81D0ECB41AB59CC1693C1"
+        "6031D96C064241E5656838AF03A96230982A269BCD462917C8FA4E8FCBED709A0D7ABBE9F6B0FB"
+        "5C7683D27350984D4FABC9A0B33C4C4FCF5D20EBFB2D079DCB62793DBD06D9C36E50FB2D4E97D9"
+        "A0B49B5E96BBCB",
+        MM_SMS_PDU_TYPE_DELIVER, MM_SMS_ENCODING_GSM7, -1, FALSE, 0, MM_SMS_DELIVERY_STATE_UNKNOWN,
+        TRUE, 0x0010, 2, 1,
+        "+31653131316", "1002", "110629233219+02", NULL,
+        "Welkom, bel om uw Voicemail te beluisteren naar +31612001233"
+        " (PrePay: *100*1233#). Voicemail ontvangen is altijd gratis."
+        " Voor gebruik van mobiel interne",
+        NULL
+    },
+    /* pdu-multipart, 8-bit concat reference */
+    {
+        "07912160130320F5440B916171056429F5000021405291650569A00500034C0201A9E8F41C949E"
+        "83C2207B599E07B1DFEE33885E9ED341E4F23C7D7697C920FA1B54C697E5E3F4BC0C6AD7D9F434"
+        "081E96D341E3303C2C4EB3D3F4BC0B94A483E6E8779D4D06CDD1EF3BA80E0785E7A0B7BB0C6A97"
+        "E7F3F0B9CC02B9DF7450780EA2DFDF2C50780EA2A3CBA0BA9B5C96B3F369F71954768FDFE4B4FB"
+        "0C9297E1F2F2BCECA6CF41",
+        MM_SMS_PDU_TYPE_DELIVER, MM_SMS_ENCODING_GSM7, -1, FALSE, 0, MM_SMS_DELIVERY_STATE_UNKNOWN,
+        TRUE, 0x4C, 2, 1,
+        "+12063130025", "+16175046925", "120425195650-04", NULL,
+        "This is a very long test designed to exercise multi part capability. It should "
+        "show up as one message, not as two, as the underlying encoding represents ",
+        NULL
+    },
+    {
+        "07912160130320F6440B916171056429F5000021405291651569320500034C0202E9E8301D4447"
+        "9741F0B09C3E0785E56590BCCC0ED3CB6410FD0D7ABBCBA0B0FB4D4797E52E10",
+        MM_SMS_PDU_TYPE_DELIVER, MM_SMS_ENCODING_GSM7, -1, FALSE, 0, MM_SMS_DELIVERY_STATE_UNKNOWN,
+        TRUE, 0x4C, 2, 2,
+        "+12063130026", "+16175046925", "120425195651-04", NULL,
+        "that the parts are related to one another. ",
+        NULL
+    },
+    /* pdu-stored-by-us, SUBMIT without SMSC */
+    {
+        "002100098136397339F70008224F60597D4F60597D4F60597D4F60597D4F60597D4F60597D4F60597D4F60597D4F60",
+        MM_SMS_PDU_TYPE_SUBMIT, MM_SMS_ENCODING_UCS2, -1, TRUE, 0, MM_SMS_DELIVERY_STATE_UNKNOWN,
+        FALSE, 0, 0, 0,
+        NULL, "639337937", NULL, NULL,
+        "你好你好你好你好你好你好你好你好你",
+        NULL
+    },
+    /* pdu-not-stored, STATUS-REPORT */
+    {
+        "07914356060013F1065A098136397339F7219011700463802190117004638030",
+        MM_SMS_PDU_TYPE_STATUS_REPORT, MM_SMS_ENCODING_UNKNOWN, -1, FALSE, 0x5A, 0x30,
+        FALSE, 0, 0, 0,
+        "+34656000311", "639337937", "120911074036+02", "120911074036+02",
+        NULL,
+        NULL
+    },
+};
+
+static void
+test_pdu_view (void)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (pdu_corpus); i++) {
+        const PduViewTest *expected = &pdu_corpus[i];
+        MMSmsPart3gppView view;
+        guint8 *pdu;
+        gsize pdu_len;
+        gchar *str;
+        const guint8 *data;
+        gsize data_len = 0;
+        GError *error = NULL;
+
+        pdu = (guint8 *) mm_utils_hexstr2bin (expected->hexpdu, &pdu_len);
+        g_assert (pdu != NULL);
+
+        g_assert (mm_sms_part_3gpp_view_parse (&view, pdu, pdu_len, &error));
+        g_assert_no_error (error);
+
+        g_assert_cmpuint (view.pdu_type, ==, expected->pdu_type);
+        g_assert_cmpuint (view.encoding, ==, expected->encoding);
+        g_assert_cmpint  (view.class, ==, expected->class);
+        g_assert_cmpuint (view.delivery_report_request, ==, expected->delivery_report_request);
+        g_assert_cmpuint (view.message_reference, ==, expected->message_reference);
+        g_assert_cmpuint (view.delivery_state, ==, expected->delivery_state);
+        g_assert_cmpuint (view.concat, ==, expected->concat);
+        g_assert_cmpuint (view.concat_reference, ==, expected->concat_reference);
+        g_assert_cmpuint (view.concat_max, ==, expected->concat_max);
+        g_assert_cmpuint (view.concat_sequence, ==, expected->concat_sequence);
+
+        str = mm_sms_part_3gpp_view_get_smsc (&view);
+        g_assert_cmpstr (str, ==, expected->smsc);
+        g_free (str);
+        str = mm_sms_part_3gpp_view_get_number (&view);
+        g_assert_cmpstr (str, ==, expected->number);
+        g_free (str);
+        str = mm_sms_part_3gpp_view_get_timestamp (&view);
+        g_assert_cmpstr (str, ==, expected->timestamp);
+        g_free (str);
+        str = mm_sms_part_3gpp_view_get_discharge_timestamp (&view);
+        g_assert_cmpstr (str, ==, expected->discharge_timestamp);
+        g_free (str);
+        str = mm_sms_part_3gpp_view_get_text (&view);
+        g_assert_cmpstr (str, ==, expected->text);
+        g_free (str);
+
+        data = mm_sms_part_3gpp_view_peek_data (&view, &data_len);
+        if (expected->hexdata) {
+            gchar *hexdata;
+
+            g_assert (data != NULL);
+            hexdata = mm_utils_bin2hexstr (data, data_len);
+            g_assert_cmpstr (hexdata, ==, expected->hexdata);
+            g_free (hexdata);
+        } else
+            g_assert (data == NULL);
+
+        g_free (pdu);
+    }
+}
+
+static void
+test_pdu_view_benchmark (void)
+{
+    GByteArray *corpus[G_N_ELEMENTS (pdu_corpus)];
+    guint    n_iterations = 100000;
+    guint    n_bytes = 0;
+    guint    i, j;
+    gdouble  view;
+    gdouble  view_number;
+    gdouble  full;
+
+    for (i = 0; i < G_N_ELEMENTS (pdu_corpus); i++) {
+        guint8 *pdu;
+        gsize pdu_len;
+
+        pdu = (guint8 *) mm_utils_hexstr2bin (pdu_corpus[i].hexpdu, &pdu_len);
+        corpus[i] = g_byte_array_new_take (pdu, pdu_len);
+        n_bytes += pdu_len;
+    }
+
+    /* Header fields only, e.g. to check concatenation info */
+    g_test_timer_start ();
+    for (i = 0; i < n_iterations; i++) {
+        for (j = 0; j < G_N_ELEMENTS (corpus); j++) {
+            MMSmsPart3gppView pdu_view;
+
+            g_assert (mm_sms_part_3gpp_view_parse (&pdu_view, corpus[j]->data, corpus[j]->len, NULL));
+        }
+    }
+    view = g_test_timer_elapsed ();
+
+    /* Header fields plus the sender */
+    g_test_timer_start ();
+    for (i = 0; i < n_iterations; i++) {
+        for (j = 0; j < G_N_ELEMENTS (corpus); j++) {
+            MMSmsPart3gppView pdu_view;
+
+            g_assert (mm_sms_part_3gpp_view_parse (&pdu_view, corpus[j]->data, corpus[j]->len, NULL));
+            g_free (mm_sms_part_3gpp_view_get_number (&pdu_view));
+        }
+    }
+    view_number = g_test_timer_elapsed ();
+
+    /* Everything, text included */
+    g_test_timer_start ();
+    for (i = 0; i < n_iterations; i++) {
+        for (j = 0; j < G_N_ELEMENTS (corpus); j++)
+            mm_sms_part_free (mm_sms_part_3gpp_new_from_binary_pdu (0, corpus[j]->data, corpus[j]->len, NULL));
+    }
+    full = g_test_timer_elapsed ();
+
+    g_test_minimized_result (view, "view: %.1lf MB/s", (n_iterations * n_bytes) / (view * 1e6));
+    g_test_message ("view:          %.1lf MB/s", (n_iterations * n_bytes) / (view * 1e6));
+    g_test_message ("view + number: %.1lf MB/s", (n_iterations * n_bytes) / (view_number * 1e6));
+    g_test_message ("full part:     %.1lf MB/s", (n_iterations * n_bytes) / (full * 1e6));
+
+    for (i = 0; i < G_N_ELEMENTS (corpus); i++)
+        g_byte_array_unref (corpus[i]);
+}
+
 /********************* SMS ADDRESS ENCODER TESTS *********************/
 
 static void
@@ -841,6 +1082,192 @@ test_text_split_two_pdu_ucs2 (void)
 
 /************************************************************/
 
+/* Builds the PDUs of all the parts and parses them back */
+static gchar *
+common_test_submit_parts_roundtrip (GList *parts,
+                                    guint *out_reference)
+{
+    GString *text;
+    GList   *l;
+    guint    sequence = 1;
+
+    text = g_string_new (NULL);
+    for (l = parts; l; l = g_list_next (l), sequence++) {
+        MMSmsPart *part;
+        guint8    *pdu;
+        guint      pdu_len = 0;
+        guint      msgstart = 0;
+        GError    *error = NULL;
+
+        pdu = mm_sms_part_3gpp_get_submit_pdu ((MMSmsPart *)l->data, &pdu_len, &msgstart, &error);
+        g_assert_no_error (error);
+        g_assert (pdu);
+
+        part = mm_sms_part_3gpp_new_from_binary_pdu (SMS_PART_INVALID_INDEX, pdu, pdu_len, &error);
+        g_assert_no_error (error);
+        g_assert (part);
+        g_assert_cmpuint (mm_sms_part_get_pdu_type (part), ==, MM_SMS_PDU_TYPE_SUBMIT);
+        g_assert_cmpstr (mm_sms_part_get_number (part), ==, "+34666123456");
+
+        if (parts->next) {
+            g_assert (mm_sms_part_should_concat (part));
+            g_assert_cmpuint (mm_sms_part_get_concat_sequence (part), ==, sequence);
+            g_assert_cmpuint (mm_sms_part_get_concat_max (part), ==, g_list_length (parts));
+            if (l == parts)
+                *out_reference = mm_sms_part_get_concat_reference (part);
+            else
+                g_assert_cmpuint (mm_sms_part_get_concat_reference (part), ==, *out_reference);
+        } else {
+            g_assert (!mm_sms_part_should_concat (part));
+            *out_reference = 0;
+        }
+
+        g_string_append (text, mm_sms_part_get_text (part));
+        mm_sms_part_free (part);
+        g_free (pdu);
+    }
+
+    return g_string_free (text, FALSE);
+}
+
+static void
+test_submit_parts_single (void)
+{
+    GList  *parts;
+    GError *error = NULL;
+    gchar  *text;
+    guint   reference;
+
+    parts = mm_sms_part_3gpp_new_submit_parts ("+34666123456", "Hello", NULL, NULL, NULL, &error);
+    g_assert_no_error (error);
+    g_assert_cmpuint (g_list_length (parts), ==, 1);
+
+    text = common_test_submit_parts_roundtrip (parts, &reference);
+    g_assert_cmpstr (text, ==, "Hello");
+    g_assert_cmpuint (reference, ==, 0);
+
+    g_free (text);
+    g_list_free_full (parts, (GDestroyNotify)mm_sms_part_free);
+}
+
+static void
+test_submit_parts_multipart (void)
+{
+    const gchar *input =
+        "0123456789012345678901234567890123456789"
+        "0123456789012345678901234567890123456789"
+        "0123456789012345678901234567890123456789"
+        "0123456789012345678901234567890123456789"
+        "0123456789012345678901234567890123456789"
+        "0123456789012345678901234567890123456789"
+        "0123456789012345678901234567890123456789"
+        "0123456789012345678901234567890123456789";
+    GList  *parts;
+    GError *error = NULL;
+    gchar  *text;
+    guint   reference = 0;
+
+    parts = mm_sms_part_3gpp_new_submit_parts ("+34666123456", input, NULL, NULL, NULL, &error);
+    g_assert_no_error (error);
+    /* 320 GSM chars need 3 parts of up to 153 chars */
+    g_assert_cmpuint (g_list_length (parts), ==, 3);
+
+    text = common_test_submit_parts_roundtrip (parts, &reference);
+    g_assert_cmpstr (text, ==, input);
+    g_assert_cmpuint (reference, >, 0);
+
+    g_free (text);
+    g_list_free_full (parts, (GDestroyNotify)mm_sms_part_free);
+}
+
+static void
+test_submit_parts_batch_references (void)
+{
+    const gchar *input =
+        "0123456789012345678901234567890123456789"
+        "0123456789012345678901234567890123456789"
+        "0123456789012345678901234567890123456789"
+        "0123456789012345678901234567890123456789"
+        "0123456789";
+    GHashTable *reserved;
+    guint       references[255];
+    guint       i;
+    guint       j;
+    GList      *parts;
+    GError     *error = NULL;
+
+    reserved = mm_sms_part_3gpp_reserved_references_new ();
+
+    /* All multipart messages to the same number in a batch get a different
+     * reference, until none is left */
+    for (i = 0; i < G_N_ELEMENTS (references); i++) {
+        gchar *text;
+
+        parts = mm_sms_part_3gpp_new_submit_parts ("+34666123456", input, reserved, NULL, NULL, &error);
+        g_assert_no_error (error);
+        g_assert_cmpuint (g_list_length (parts), ==, 2);
+        text = common_test_submit_parts_roundtrip (parts, &references[i]);
+        g_assert_cmpstr (text, ==, input);
+        g_free (text);
+        g_list_free_full (parts, (GDestroyNotify)mm_sms_part_free);
+
+        g_assert_cmpuint (references[i], >, 0);
+        for (j = 0; j < i; j++)
+            g_assert_cmpuint (references[i], !=, references[j]);
+    }
+
+    parts = mm_sms_part_3gpp_new_submit_parts ("+34666123456", input, reserved, NULL, NULL, &error);
+    g_assert_error (error, MM_CORE_ERROR, MM_CORE_ERROR_TOO_MANY);
+    g_assert (!parts);
+    g_clear_error (&error);
+
+    /* Single part messages don't need any */
+    parts = mm_sms_part_3gpp_new_submit_parts ("+34666123456", "Hello", reserved, NULL, NULL, &error);
+    g_assert_no_error (error);
+    g_assert_cmpuint (g_list_length (parts), ==, 1);
+    g_list_free_full (parts, (GDestroyNotify)mm_sms_part_free);
+
+    /* Other numbers have their own references */
+    g_assert_cmpuint (mm_sms_part_3gpp_reserve_reference (reserved, "+34666654321", NULL, NULL), >, 0);
+
+    g_hash_table_unref (reserved);
+}
+
+static gboolean
+odd_reference_in_use (const gchar *number,
+                      guint8       reference,
+                      gpointer     user_data)
+{
+    return (reference % 2);
+}
+
+static void
+test_reserve_reference_in_use (void)
+{
+    GHashTable *reserved;
+    guint       i;
+
+    reserved = mm_sms_part_3gpp_reserved_references_new ();
+
+    /* 127 even references available */
+    for (i = 0; i < 127; i++) {
+        guint8 reference;
+
+        reference = mm_sms_part_3gpp_reserve_reference (reserved, "+34666123456", odd_reference_in_use, NULL);
+        g_assert_cmpuint (reference, >, 0);
+        g_assert_cmpuint (reference % 2, ==, 0);
+    }
+    g_assert_cmpuint (mm_sms_part_3gpp_reserve_reference (reserved, "+34666123456", odd_reference_in_use, NULL), ==, 0);
+
+    /* Without reservations, only the callback is checked */
+    for (i = 0; i < 10; i++)
+        g_assert_cmpuint (mm_sms_part_3gpp_reserve_reference (NULL, "+34666123456", odd_reference_in_use, NULL) % 2, ==, 0);
+
+    g_hash_table_unref (reserved);
+}
+
+/************************************************************/
+
 void
 _mm_log (const char *loc,
          const char *func,
@@ -882,6 +1309,10 @@ int main (int argc, char **argv)
     g_test_add_func ("/MM/SMS/3GPP/PDU-Parser/pdu-stored-by-us", test_pdu_stored_by_us);
     g_test_add_func ("/MM/SMS/3GPP/PDU-Parser/pdu-not-stored", test_pdu_not_stored);
 
+    g_test_add_func ("/MM/SMS/3GPP/PDU-View/fields", test_pdu_view);
+    if (g_test_perf ())
+        g_test_add_func ("/MM/SMS/3GPP/PDU-View/benchmark", test_pdu_view_benchmark);
+
     g_test_add_func ("/MM/SMS/3GPP/Address-Encoder/smsc-intl", test_address_encode_smsc_intl);
     g_test_add_func ("/MM/SMS/3GPP/Address-Encoder/smsc-unknown", test_address_encode_smsc_unknown);
     g_test_add_func ("/MM/SMS/3GPP/Address-Encoder/intl", test_address_encode_intl);
@@ -901,5 +1332,10 @@ int main (int argc, char **argv)
     g_test_add_func ("/MM/SMS/3GPP/Text-Split/two-pdu", test_text_split_two_pdu);
     g_test_add_func ("/MM/SMS/3GPP/Text-Split/two-pdu-UCS2", test_text_split_two_pdu_ucs2);
 
+    g_test_add_func ("/MM/SMS/3GPP/Submit-Parts/single", test_submit_parts_single);
+    g_test_add_func ("/MM/SMS/3GPP/Submit-Parts/multipart", test_submit_parts_multipart);
+    g_test_add_func ("/MM/SMS/3GPP/Submit-Parts/batch-references", test_submit_parts_batch_references);
+    g_test_add_func ("/MM/SMS/3GPP/Reserve-Reference/in-use", test_reserve_reference_in_use);
+
     return g_test_run ();
 }
@@ -23,6 +23,7 @@
 #include <libmm-glib.h>
 
 #include "mm-sms-part-cdma.h"
+#include "mm-bit-stream.h"
 #include "mm-log.h"
 
 /* If defined will print debugging traces */
@@ -367,6 +368,259 @@ test_unicode_encoding (void)
         "中國哲學書電子化計劃");
 }
 
+/********************* BIT STREAM TESTS *********************/
+
+static void
+test_bit_reader (void)
+{
+    static const guint8 data[] = { 0xA5, 0x3C, 0xF0, 0x0F };
+    MMBitReader reader;
+    guint32 value;
+    guint8 bytes[3];
+
+    mm_bit_reader_init (&reader, data, sizeof (data));
+    g_assert_cmpuint (mm_bit_reader_get_remaining (&reader), ==, 32);
+
+    g_assert (mm_bit_reader_read (&reader, 1, &value));
+    g_assert_cmpuint (value, ==, 1);
+    g_assert (mm_bit_reader_read (&reader, 3, &value));
+    g_assert_cmpuint (value, ==, 2);
+    /* Across bytes */
+    g_assert (mm_bit_reader_read (&reader, 8, &value));
+    g_assert_cmpuint (value, ==, 0x53);
+    g_assert (mm_bit_reader_skip (&reader, 4));
+    g_assert (mm_bit_reader_read (&reader, 16, &value));
+    g_assert_cmpuint (value, ==, 0xF00F);
+    g_assert_cmpuint (mm_bit_reader_get_remaining (&reader), ==, 0);
+
+    /* Nothing left, and failed reads don't move the offset */
+    g_assert (!mm_bit_reader_read (&reader, 1, &value));
+    g_assert (!mm_bit_reader_skip (&reader, 1));
+
+    /* Unaligned bytes */
+    mm_bit_reader_init (&reader, data, sizeof (data));
+    g_assert (mm_bit_reader_skip (&reader, 4));
+    g_assert (mm_bit_reader_read_bytes (&reader, bytes, 3));
+    g_assert_cmpuint (bytes[0], ==, 0x53);
+    g_assert_cmpuint (bytes[1], ==, 0xCF);
+    g_assert_cmpuint (bytes[2], ==, 0x00);
+    g_assert (!mm_bit_reader_read_bytes (&reader, bytes, 1));
+    g_assert_cmpuint (mm_bit_reader_get_remaining (&reader), ==, 4);
+    g_assert (mm_bit_reader_read (&reader, 4, &value));
+    g_assert_cmpuint (value, ==, 0xF);
+}
+
+static void
+test_bit_writer (void)
+{
+    static const guint8 expected[] = { 0xA5, 0x3C, 0xF0, 0x0F };
+    static const guint8 bytes[] = { 0x53, 0xCF, 0x00 };
+    MMBitWriter writer;
+    guint8 data[4];
+
+    /* The writer doesn't need a cleared buffer */
+    memset (data, 0x5A, sizeof (data));
+
+    mm_bit_writer_init (&writer, data, sizeof (data));
+    g_assert (mm_bit_writer_write (&writer, 1, 1));
+    g_assert (mm_bit_writer_write (&writer, 3, 2));
+    g_assert_cmpuint (mm_bit_writer_get_length (&writer), ==, 1);
+    g_assert (mm_bit_writer_write (&writer, 8, 0x53));
+    g_assert (mm_bit_writer_write (&writer, 4, 0xC));
+    g_assert (mm_bit_writer_write (&writer, 16, 0xF00F));
+    g_assert_cmpuint (mm_bit_writer_get_length (&writer), ==, 4);
+    g_assert (!mm_bit_writer_write (&writer, 1, 1));
+    g_assert_cmpint (memcmp (data, expected, sizeof (data)), ==, 0);
+
+    /* Unaligned bytes */
+    memset (data, 0x5A, sizeof (data));
+    mm_bit_writer_init (&writer, data, sizeof (data));
+    g_assert (mm_bit_writer_write (&writer, 4, 0xA));
+    g_assert (mm_bit_writer_write_bytes (&writer, bytes, sizeof (bytes)));
+    g_assert (!mm_bit_writer_write_bytes (&writer, bytes, 1));
+    g_assert (mm_bit_writer_write (&writer, 4, 0xF));
+    g_assert_cmpint (memcmp (data, expected, sizeof (data)), ==, 0);
+}
+
+static void
+test_bit_stream_roundtrip (void)
+{
+    guint8 data[64];
+    guint32 values[128];
+    guint widths[128];
+    guint n_fields;
+    guint iteration;
+    guint i;
+
+    for (iteration = 0; iteration < 1000; iteration++) {
+        MMBitWriter writer;
+        MMBitReader reader;
+        guint32 value;
+
+        /* Random fields until the buffer is full */
+        mm_bit_writer_init (&writer, data, sizeof (data));
+        for (n_fields = 0; n_fields < G_N_ELEMENTS (values); n_fields++) {
+            widths[n_fields] = g_test_rand_int_range (1, 33);
+            values[n_fields] = (guint32) g_test_rand_int ();
+            if (widths[n_fields] < 32)
+                values[n_fields] &= (1U << widths[n_fields]) - 1;
+            if (!mm_bit_writer_write (&writer, widths[n_fields], values[n_fields]))
+                break;
+        }
+
+        mm_bit_reader_init (&reader, data, mm_bit_writer_get_length (&writer));
+        for (i = 0; i < n_fields; i++) {
+            g_assert (mm_bit_reader_read (&reader, widths[i], &value));
+            g_assert_cmpuint (value, ==, values[i]);
+        }
+        g_assert_cmpuint (mm_bit_reader_get_remaining (&reader), <, 8);
+    }
+}
+
+/********************* FUZZ-DERIVED CORPUS TESTS *********************/
+
+typedef struct {
+    const gchar *hexpdu;
+    gboolean     valid;
+    const gchar *expected_address;
+} CorpusEntry;
+
+static const CorpusEntry pdu_corpus[] = {
+    /* Message type only */
+    { "00", TRUE, NULL },
+    /* Invalid message type */
+    { "03", FALSE, NULL },
+    /* Truncated parameter header */
+    { "0000", FALSE, NULL },
+    /* Parameter length beyond the PDU */
+    { "000002", FALSE, NULL },
+    /* DTMF address with 255 fields and a single byte of digits */
+    { "0002023FC0", TRUE, NULL },
+    /* ASCII address cut in the middle of the numbering plan */
+    { "00020180", TRUE, NULL },
+    /* Binary data network address, unaligned */
+    { "00000210020206C82605400008", TRUE, "C0A80001" },
+    /* E-mail data network address, unaligned */
+    { "00000210020205D01B0A0310", TRUE, "a@b" },
+    /* Bearer data subparameter length beyond the parameter */
+    { "00080401050000", TRUE, NULL },
+    /* Extended protocol message user data without message type */
+    { "000803010108", TRUE, NULL },
+    /* Unicode user data with 255 fields and no text */
+    { "000804010227F8", TRUE, NULL },
+    /* Message identifier of the wrong length */
+    { "00080400021234", TRUE, NULL },
+    /* Acknowledge with error class but no cause code */
+    { "02070103", TRUE, NULL },
+    /* Acknowledge with error class and cause code */
+    { "0207020323", TRUE, NULL },
+};
+
+static void
+test_pdu_corpus (void)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (pdu_corpus); i++) {
+        MMSmsPart *part;
+        GError *error = NULL;
+
+        part = mm_sms_part_cdma_new_from_pdu (0, pdu_corpus[i].hexpdu, &error);
+        if (!pdu_corpus[i].valid) {
+            g_assert (part == NULL);
+            g_assert (error != NULL);
+            g_error_free (error);
+            continue;
+        }
+
+        g_assert_no_error (error);
+        g_assert (part != NULL);
+        g_assert_cmpstr (mm_sms_part_get_number (part), ==, pdu_corpus[i].expected_address);
+        mm_sms_part_free (part);
+    }
+}
+
+/* A valid PDU exercising most of the parser */
+static const guint8 mutation_seed[] = {
+    /* message type */
+    0x00,
+    /* teleservice id */
+    0x00, 0x02,
+    0x10, 0x02,
+    /* originating address */
+    0x02, 0x07,
+    0x02, 0x8C, 0xE9, 0x5D, 0xCC, 0x65, 0x80,
+    /* bearer reply option */
+    0x06, 0x01,
+    0xFC,
+    /* bearer data */
+    0x08, 0x1C,
+        /* message id */
+        0x00, 0x03,
+        0x13, 0x8D, 0x20,
+        /* user data */
+        0x01, 0x0A,
+        0x40, 0x42, 0x1B, 0x0B, 0x6B, 0x83, 0x2F, 0x9B,
+        0x71, 0x08,
+        /* message center timestamp */
+        0x03, 0x06,
+        0x13, 0x10, 0x23, 0x20, 0x06, 0x37,
+        /* priority indicator */
+        0x08, 0x01,
+        0x00
+};
+
+static void
+test_pdu_mutations (void)
+{
+    guint8 pdu[sizeof (mutation_seed)];
+    guint len;
+    guint i;
+    guint bit;
+
+    /* Every truncation of the seed */
+    for (len = 0; len <= sizeof (mutation_seed); len++)
+        mm_sms_part_free (mm_sms_part_cdma_new_from_binary_pdu (0, mutation_seed, len, NULL));
+
+    /* Every single bit flip of the seed */
+    for (i = 0; i < sizeof (mutation_seed); i++) {
+        for (bit = 0; bit < 8; bit++) {
+            memcpy (pdu, mutation_seed, sizeof (pdu));
+            pdu[i] ^= (1 << bit);
+            mm_sms_part_free (mm_sms_part_cdma_new_from_binary_pdu (0, pdu, sizeof (pdu), NULL));
+        }
+    }
+
+    /* Every value in the length bytes of the seed */
+    for (i = 0; i < sizeof (mutation_seed); i++) {
+        guint value;
+
+        for (value = 0; value <= G_MAXUINT8; value++) {
+            memcpy (pdu, mutation_seed, sizeof (pdu));
+            pdu[i] = value;
+            mm_sms_part_free (mm_sms_part_cdma_new_from_binary_pdu (0, pdu, sizeof (pdu), NULL));
+        }
+    }
+}
+
+static void
+test_pdu_benchmark (void)
+{
+    guint n_iterations = 100000;
+    guint i;
+    gdouble elapsed;
+
+    g_test_timer_start ();
+    for (i = 0; i < n_iterations; i++)
+        mm_sms_part_free (mm_sms_part_cdma_new_from_binary_pdu (0, mutation_seed, sizeof (mutation_seed), NULL));
+    elapsed = g_test_timer_elapsed ();
+
+    g_test_minimized_result (elapsed, "decode: %.1lf MB/s", (n_iterations * sizeof (mutation_seed)) / (elapsed * 1e6));
+    g_test_message ("decode: %.1lf MB/s (%.2lf us per PDU)",
+                    (n_iterations * sizeof (mutation_seed)) / (elapsed * 1e6),
+                    (elapsed * 1e6) / n_iterations);
+}
+
 /********************* PDU CREATOR TESTS *********************/
 
 static void
@@ -503,6 +757,58 @@ test_create_pdu_text_unicode_encoding (void)
                             expected, sizeof (expected));
 }
 
+/* Latin text with @n_chars characters */
+static guint8 *
+create_pdu_latin_text (guint n_chars,
+                       guint *len,
+                       GError **error)
+{
+    MMSmsPart *part;
+    GString *text;
+    guint8 *pdu;
+
+    /* A single non-ASCII char is enough to need Latin encoding */
+    text = g_string_new ("\xC3\xB3");
+    while (--n_chars)
+        g_string_append_c (text, 'a');
+
+    part = mm_sms_part_new (0, MM_SMS_PDU_TYPE_CDMA_SUBMIT);
+    mm_sms_part_set_cdma_teleservice_id (part, MM_SMS_CDMA_TELESERVICE_ID_WMT);
+    mm_sms_part_set_number (part, "3305773196");
+    mm_sms_part_set_text (part, text->str);
+    g_string_free (text, TRUE);
+
+    pdu = mm_sms_part_cdma_get_submit_pdu (part, len, error);
+    mm_sms_part_free (part);
+    return pdu;
+}
+
+static void
+test_create_pdu_bearer_data_max_length (void)
+{
+    guint8 *pdu;
+    guint len = 0;
+    GError *error = NULL;
+
+    /* 246 chars take 248 bytes of user data (5 bits of encoding, 8 of
+     * number of fields), so along with the 2 byte user data header and the
+     * 5 byte message id, the bearer data is 255 bytes long */
+    pdu = create_pdu_latin_text (246, &len, &error);
+    g_assert_no_error (error);
+    g_assert (pdu != NULL);
+    /* message type, teleservice id and destination address come first */
+    g_assert_cmpuint (len, ==, 1 + 5 + 9 + 2 + 255);
+    g_assert_cmpuint (pdu[15], ==, 0x08);
+    g_assert_cmpuint (pdu[16], ==, 255);
+    g_free (pdu);
+
+    /* One more char needs 256 bytes, which don't fit in the length field */
+    pdu = create_pdu_latin_text (247, &len, &error);
+    g_assert_error (error, MM_CORE_ERROR, MM_CORE_ERROR_UNSUPPORTED);
+    g_assert (pdu == NULL);
+    g_error_free (error);
+}
+
 /************************************************************/
 
 void
@@ -539,9 +845,19 @@ int main (int argc, char **argv)
     g_test_add_func ("/MM/SMS/CDMA/PDU-Parser/latin-encoding-2", test_latin_encoding_2);
     g_test_add_func ("/MM/SMS/CDMA/PDU-Parser/unicode-encoding", test_unicode_encoding);
 
+    g_test_add_func ("/MM/SMS/CDMA/Bit-Stream/reader", test_bit_reader);
+    g_test_add_func ("/MM/SMS/CDMA/Bit-Stream/writer", test_bit_writer);
+    g_test_add_func ("/MM/SMS/CDMA/Bit-Stream/roundtrip", test_bit_stream_roundtrip);
+
+    g_test_add_func ("/MM/SMS/CDMA/PDU-Parser/corpus", test_pdu_corpus);
+    g_test_add_func ("/MM/SMS/CDMA/PDU-Parser/mutations", test_pdu_mutations);
+    if (g_test_perf ())
+        g_test_add_func ("/MM/SMS/CDMA/PDU-Parser/benchmark", test_pdu_benchmark);
+
     g_test_add_func ("/MM/SMS/CDMA/PDU-Creator/ascii-encoding", test_create_pdu_text_ascii_encoding);
     g_test_add_func ("/MM/SMS/CDMA/PDU-Creator/latin-encoding", test_create_pdu_text_latin_encoding);
     g_test_add_func ("/MM/SMS/CDMA/PDU-Creator/unicode-encoding", test_create_pdu_text_unicode_encoding);
+    g_test_add_func ("/MM/SMS/CDMA/PDU-Creator/bearer-data-max-length", test_create_pdu_bearer_data_max_length);
 
     return g_test_run ();
 }
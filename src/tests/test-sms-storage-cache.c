@@ -0,0 +1,447 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ */
+
+#include <string.h>
+#include <locale.h>
+
+#include <glib.h>
+#include <glib-object.h>
+
+#include <ModemManager.h>
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-sms-storage-cache.h"
+#include "mm-iface-modem.h"
+#include "mm-log.h"
+
+/* Built with MM_SMS_STORAGE_CACHE_MAX_SNAPSHOTS=4 and
+ * MM_SMS_STORAGE_CACHE_MAX_UNWATCHED_US=0 */
+#define MAX_SNAPSHOTS 4
+
+/*****************************************************************************/
+/* Minimal modem, providing the device and the SIM the cache keys on */
+
+typedef struct {
+    GObject parent;
+    gchar *device;
+    GObject *sim;
+} TestModem;
+
+typedef struct {
+    GObjectClass parent;
+} TestModemClass;
+
+enum {
+    PROP_0,
+    PROP_SIM
+};
+
+static GType test_modem_get_type (void);
+G_DEFINE_TYPE (TestModem, test_modem, G_TYPE_OBJECT)
+
+static void
+test_modem_get_property (GObject *object,
+                         guint prop_id,
+                         GValue *value,
+                         GParamSpec *pspec)
+{
+    TestModem *self = (TestModem *) object;
+
+    switch (prop_id) {
+    case PROP_SIM:
+        g_value_set_object (value, self->sim);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+test_modem_set_property (GObject *object,
+                         guint prop_id,
+                         const GValue *value,
+                         GParamSpec *pspec)
+{
+    TestModem *self = (TestModem *) object;
+
+    switch (prop_id) {
+    case PROP_SIM:
+        g_clear_object (&self->sim);
+        self->sim = g_value_dup_object (value);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+test_modem_init (TestModem *self)
+{
+}
+
+static void
+test_modem_finalize (GObject *object)
+{
+    TestModem *self = (TestModem *) object;
+
+    g_free (self->device);
+    g_clear_object (&self->sim);
+
+    G_OBJECT_CLASS (test_modem_parent_class)->finalize (object);
+}
+
+static void
+test_modem_class_init (TestModemClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    object_class->get_property = test_modem_get_property;
+    object_class->set_property = test_modem_set_property;
+    object_class->finalize = test_modem_finalize;
+
+    g_object_class_install_property (
+        object_class, PROP_SIM,
+        g_param_spec_object (MM_IFACE_MODEM_SIM,
+                             "SIM",
+                             "SIM object",
+                             G_TYPE_OBJECT,
+                             G_PARAM_READWRITE));
+}
+
+/* Modem in @device, with a SIM with the given identifier; no SIM at all if
+ * @sim_identifier is NULL, a SIM without identifier if it's empty */
+static MMBaseModem *
+test_modem_new (const gchar *device,
+                const gchar *sim_identifier)
+{
+    TestModem *self;
+
+    self = g_object_new (test_modem_get_type (), NULL);
+    self->device = g_strdup (device);
+    if (sim_identifier) {
+        self->sim = G_OBJECT (mm_gdbus_sim_skeleton_new ());
+        if (sim_identifier[0])
+            mm_gdbus_sim_set_sim_identifier (MM_GDBUS_SIM (self->sim), sim_identifier);
+    }
+    return (MMBaseModem *) self;
+}
+
+const gchar *
+mm_base_modem_get_device (MMBaseModem *self)
+{
+    return ((TestModem *) self)->device;
+}
+
+/*****************************************************************************/
+
+/* Snapshot with the parts at the given indexes, with PDUs derived from them */
+static MMSmsStorageSnapshot *
+snapshot_new (const guint *indexes,
+              guint n_indexes)
+{
+    MMSmsStorageSnapshot *snapshot;
+    guint i;
+
+    snapshot = mm_sms_storage_snapshot_new ();
+    for (i = 0; i < n_indexes; i++) {
+        gchar *hexpdu;
+
+        hexpdu = g_strdup_printf ("07%02X", indexes[i]);
+        mm_sms_storage_snapshot_add (snapshot, indexes[i], 1, hexpdu);
+        g_free (hexpdu);
+    }
+    return snapshot;
+}
+
+static void
+collect_part (guint index,
+              guint status,
+              const guint8 *pdu,
+              gsize pdu_len,
+              GArray *indexes)
+{
+    g_assert_cmpuint (pdu_len, ==, 2);
+    g_assert_cmpuint (pdu[0], ==, 0x07);
+    g_assert_cmpuint (pdu[1], ==, index);
+    g_array_append_val (indexes, index);
+}
+
+static gint
+compare_index (const guint *a,
+               const guint *b)
+{
+    return (gint) *a - (gint) *b;
+}
+
+/* Checks whether the cache gives the parts at the given indexes when
+ * @n_indexes messages are expected */
+static gboolean
+cache_has (MMBaseModem *modem,
+           MMSmsStorage storage,
+           const guint *indexes,
+           guint n_indexes)
+{
+    GArray *found;
+    gboolean hit;
+
+    found = g_array_new (FALSE, FALSE, sizeof (guint));
+    hit = mm_sms_storage_cache_foreach (modem,
+                                        storage,
+                                        n_indexes,
+                                        (MMSmsStorageCacheForeachFn) collect_part,
+                                        found);
+    if (hit) {
+        g_array_sort (found, (GCompareFunc) compare_index);
+        g_assert_cmpuint (found->len, ==, n_indexes);
+        g_assert (memcmp (found->data, indexes, n_indexes * sizeof (guint)) == 0);
+    } else
+        g_assert_cmpuint (found->len, ==, 0);
+    g_array_unref (found);
+    return hit;
+}
+
+static void
+test_take_foreach (void)
+{
+    MMBaseModem *modem;
+    static const guint indexes[] = { 1, 2, 5 };
+
+    modem = test_modem_new ("take-foreach", "8934000000000000001");
+
+    g_assert (!cache_has (modem, MM_SMS_STORAGE_SM, indexes, G_N_ELEMENTS (indexes)));
+
+    mm_sms_storage_cache_take (modem, MM_SMS_STORAGE_SM, snapshot_new (indexes, G_N_ELEMENTS (indexes)));
+    g_assert (cache_has (modem, MM_SMS_STORAGE_SM, indexes, G_N_ELEMENTS (indexes)));
+    /* Not consumed when used */
+    g_assert (cache_has (modem, MM_SMS_STORAGE_SM, indexes, G_N_ELEMENTS (indexes)));
+
+    /* Other storages are separate */
+    g_assert (!cache_has (modem, MM_SMS_STORAGE_ME, indexes, G_N_ELEMENTS (indexes)));
+
+    /* A different number of messages means the storage changed */
+    g_assert (!cache_has (modem, MM_SMS_STORAGE_SM, indexes, 2));
+
+    mm_sms_storage_cache_invalidate (modem, MM_SMS_STORAGE_SM);
+    g_object_unref (modem);
+}
+
+static void
+test_sim_changed (void)
+{
+    MMBaseModem *modem;
+    MMBaseModem *other;
+    static const guint indexes[] = { 1, 2 };
+
+    modem = test_modem_new ("sim-changed", "8934000000000000001");
+    mm_sms_storage_cache_take (modem, MM_SMS_STORAGE_SM, snapshot_new (indexes, G_N_ELEMENTS (indexes)));
+
+    /* Same device, different SIM */
+    other = test_modem_new ("sim-changed", "8934000000000000002");
+    g_assert (!cache_has (other, MM_SMS_STORAGE_SM, indexes, G_N_ELEMENTS (indexes)));
+    g_object_unref (other);
+
+    g_assert (cache_has (modem, MM_SMS_STORAGE_SM, indexes, G_N_ELEMENTS (indexes)));
+
+    mm_sms_storage_cache_invalidate (modem, MM_SMS_STORAGE_SM);
+    g_object_unref (modem);
+}
+
+static void
+test_no_sim_identifier (void)
+{
+    MMBaseModem *modem;
+    static const guint indexes[] = { 1 };
+
+    /* Without SIM */
+    modem = test_modem_new ("no-sim-identifier", NULL);
+    mm_sms_storage_cache_take (modem, MM_SMS_STORAGE_SM, snapshot_new (indexes, G_N_ELEMENTS (indexes)));
+    g_assert (!cache_has (modem, MM_SMS_STORAGE_SM, indexes, G_N_ELEMENTS (indexes)));
+    mm_sms_storage_cache_add_part (modem, MM_SMS_STORAGE_SM, 3, 1, "0703");
+    mm_sms_storage_cache_remove_part (modem, MM_SMS_STORAGE_SM, 1);
+    mm_sms_storage_cache_unwatch (modem);
+    mm_sms_storage_cache_invalidate (modem, MM_SMS_STORAGE_SM);
+    g_object_unref (modem);
+
+    /* With a SIM whose identifier isn't known */
+    modem = test_modem_new ("no-sim-identifier", "");
+    mm_sms_storage_cache_take (modem, MM_SMS_STORAGE_SM, snapshot_new (indexes, G_N_ELEMENTS (indexes)));
+    g_assert (!cache_has (modem, MM_SMS_STORAGE_SM, indexes, G_N_ELEMENTS (indexes)));
+    g_object_unref (modem);
+}
+
+static void
+test_add_remove_part (void)
+{
+    MMBaseModem *modem;
+    static const guint indexes[] = { 1, 2 };
+    static const guint added[] = { 1, 2, 4 };
+    static const guint removed[] = { 1, 4 };
+
+    modem = test_modem_new ("add-remove-part", "8934000000000000001");
+
+    /* Nothing is cached for storages not listed yet */
+    mm_sms_storage_cache_add_part (modem, MM_SMS_STORAGE_SM, 4, 1, "0704");
+    g_assert (!cache_has (modem, MM_SMS_STORAGE_SM, removed, 1));
+
+    mm_sms_storage_cache_take (modem, MM_SMS_STORAGE_SM, snapshot_new (indexes, G_N_ELEMENTS (indexes)));
+
+    mm_sms_storage_cache_add_part (modem, MM_SMS_STORAGE_SM, 4, 1, "0704");
+    g_assert (cache_has (modem, MM_SMS_STORAGE_SM, added, G_N_ELEMENTS (added)));
+
+    mm_sms_storage_cache_remove_part (modem, MM_SMS_STORAGE_SM, 2);
+    g_assert (cache_has (modem, MM_SMS_STORAGE_SM, removed, G_N_ELEMENTS (removed)));
+
+    /* Unknown indexes are ignored */
+    mm_sms_storage_cache_remove_part (modem, MM_SMS_STORAGE_SM, 9);
+    g_assert (cache_has (modem, MM_SMS_STORAGE_SM, removed, G_N_ELEMENTS (removed)));
+
+    mm_sms_storage_cache_invalidate (modem, MM_SMS_STORAGE_SM);
+    g_object_unref (modem);
+}
+
+static void
+test_invalidate (void)
+{
+    MMBaseModem *modem;
+    static const guint indexes[] = { 3 };
+
+    modem = test_modem_new ("invalidate", "8934000000000000001");
+    mm_sms_storage_cache_take (modem, MM_SMS_STORAGE_SM, snapshot_new (indexes, G_N_ELEMENTS (indexes)));
+    mm_sms_storage_cache_take (modem, MM_SMS_STORAGE_ME, snapshot_new (indexes, G_N_ELEMENTS (indexes)));
+
+    /* As done when a message is stored or sent from storage */
+    mm_sms_storage_cache_invalidate (modem, MM_SMS_STORAGE_SM);
+    g_assert (!cache_has (modem, MM_SMS_STORAGE_SM, indexes, G_N_ELEMENTS (indexes)));
+    g_assert (cache_has (modem, MM_SMS_STORAGE_ME, indexes, G_N_ELEMENTS (indexes)));
+
+    /* Nothing to invalidate */
+    mm_sms_storage_cache_invalidate (modem, MM_SMS_STORAGE_SM);
+
+    mm_sms_storage_cache_invalidate (modem, MM_SMS_STORAGE_ME);
+    g_object_unref (modem);
+}
+
+static void
+test_eviction (void)
+{
+    MMBaseModem *modems[MAX_SNAPSHOTS + 1];
+    static const guint indexes[] = { 1 };
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (modems); i++) {
+        gchar *device;
+
+        device = g_strdup_printf ("eviction-%u", i);
+        modems[i] = test_modem_new (device, "8934000000000000001");
+        g_free (device);
+    }
+
+    for (i = 0; i < MAX_SNAPSHOTS; i++)
+        mm_sms_storage_cache_take (modems[i], MM_SMS_STORAGE_SM, snapshot_new (indexes, G_N_ELEMENTS (indexes)));
+
+    /* Storing the first one again makes it the newest */
+    mm_sms_storage_cache_take (modems[0], MM_SMS_STORAGE_SM, snapshot_new (indexes, G_N_ELEMENTS (indexes)));
+
+    /* So one more snapshot evicts the second one */
+    mm_sms_storage_cache_take (modems[MAX_SNAPSHOTS], MM_SMS_STORAGE_SM, snapshot_new (indexes, G_N_ELEMENTS (indexes)));
+    g_assert (!cache_has (modems[1], MM_SMS_STORAGE_SM, indexes, G_N_ELEMENTS (indexes)));
+    g_assert (cache_has (modems[0], MM_SMS_STORAGE_SM, indexes, G_N_ELEMENTS (indexes)));
+    for (i = 2; i < G_N_ELEMENTS (modems); i++)
+        g_assert (cache_has (modems[i], MM_SMS_STORAGE_SM, indexes, G_N_ELEMENTS (indexes)));
+
+    /* And the next one the third, the oldest left */
+    mm_sms_storage_cache_take (modems[1], MM_SMS_STORAGE_SM, snapshot_new (indexes, G_N_ELEMENTS (indexes)));
+    g_assert (!cache_has (modems[2], MM_SMS_STORAGE_SM, indexes, G_N_ELEMENTS (indexes)));
+    g_assert (cache_has (modems[0], MM_SMS_STORAGE_SM, indexes, G_N_ELEMENTS (indexes)));
+    g_assert (cache_has (modems[1], MM_SMS_STORAGE_SM, indexes, G_N_ELEMENTS (indexes)));
+
+    for (i = 0; i < G_N_ELEMENTS (modems); i++) {
+        mm_sms_storage_cache_invalidate (modems[i], MM_SMS_STORAGE_SM);
+        g_object_unref (modems[i]);
+    }
+}
+
+static void
+test_unwatch (void)
+{
+    MMBaseModem *modem;
+    MMBaseModem *other;
+    static const guint indexes[] = { 1, 2 };
+
+    modem = test_modem_new ("unwatch", "8934000000000000001");
+    other = test_modem_new ("unwatch-other", "8934000000000000001");
+    mm_sms_storage_cache_take (modem, MM_SMS_STORAGE_SM, snapshot_new (indexes, G_N_ELEMENTS (indexes)));
+    mm_sms_storage_cache_take (other, MM_SMS_STORAGE_SM, snapshot_new (indexes, G_N_ELEMENTS (indexes)));
+
+    /* Snapshots of storages no longer watched can't be trusted for long, even
+     * if the count still matches (no time at all in this test) */
+    mm_sms_storage_cache_unwatch (modem);
+    g_assert (!cache_has (modem, MM_SMS_STORAGE_SM, indexes, G_N_ELEMENTS (indexes)));
+    /* And they're gone, not just skipped */
+    mm_sms_storage_cache_add_part (modem, MM_SMS_STORAGE_SM, 3, 1, "0703");
+    g_assert (!cache_has (modem, MM_SMS_STORAGE_SM, indexes, 1));
+
+    /* Other modems are unaffected */
+    g_assert (cache_has (other, MM_SMS_STORAGE_SM, indexes, G_N_ELEMENTS (indexes)));
+
+    /* Snapshots taken afterwards are watched again */
+    mm_sms_storage_cache_take (modem, MM_SMS_STORAGE_SM, snapshot_new (indexes, G_N_ELEMENTS (indexes)));
+    g_assert (cache_has (modem, MM_SMS_STORAGE_SM, indexes, G_N_ELEMENTS (indexes)));
+
+    mm_sms_storage_cache_invalidate (modem, MM_SMS_STORAGE_SM);
+    mm_sms_storage_cache_invalidate (other, MM_SMS_STORAGE_SM);
+    g_object_unref (modem);
+    g_object_unref (other);
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    setlocale (LC_ALL, "");
+
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/sms-storage-cache/take-foreach",     test_take_foreach);
+    g_test_add_func ("/MM/sms-storage-cache/sim-changed",      test_sim_changed);
+    g_test_add_func ("/MM/sms-storage-cache/no-sim-identifier", test_no_sim_identifier);
+    g_test_add_func ("/MM/sms-storage-cache/add-remove-part",  test_add_remove_part);
+    g_test_add_func ("/MM/sms-storage-cache/invalidate",       test_invalidate);
+    g_test_add_func ("/MM/sms-storage-cache/eviction",         test_eviction);
+    g_test_add_func ("/MM/sms-storage-cache/unwatch",          test_unwatch);
+
+    return g_test_run ();
+}
@@ -46,6 +46,215 @@ test_load_cleanup_core (void)
 
 /************************************************************/
 
+#define N_SYNTHETIC_PORTS 5000
+
+static const gchar *
+test_get_property (const gchar *property,
+                   gpointer     user_data)
+{
+    return (const gchar *) g_hash_table_lookup ((GHashTable *) user_data, property);
+}
+
+static void
+test_set_property (const gchar    *property,
+                   const gchar    *value,
+                   GDestroyNotify  value_destroy,
+                   gpointer        user_data)
+{
+    g_hash_table_insert ((GHashTable *) user_data, g_strdup (property), g_strdup (value));
+    if (value_destroy)
+        value_destroy ((gpointer) value);
+}
+
+typedef struct {
+    MMUdevRulesDevice  device;
+    gchar             *name;
+    gchar             *sysfs_path;
+} SyntheticPort;
+
+static void
+synthetic_port_clear (SyntheticPort *port)
+{
+    g_free (port->name);
+    g_free (port->sysfs_path);
+}
+
+/* Build ports using the vendor and product ids found in the rules, so that
+ * most of them match at least one rule, plus some random ones */
+static GArray *
+build_synthetic_ports (GArray *rules,
+                       guint   n_ports)
+{
+    /* NULL for ports without driver */
+    static const gchar *drivers[] = { "option", "qcserial", "cdc_acm", "ftdi_sio", "cdc_wdm", NULL };
+    GArray *ids;
+    GArray *ports;
+    GRand  *rand;
+    guint   i;
+
+    ids = g_array_new (FALSE, FALSE, sizeof (guint));
+    for (i = 0; i < rules->len; i++) {
+        MMUdevRule *rule;
+        guint       vid = 0;
+        guint       pid = 0;
+        guint       j;
+
+        rule = &g_array_index (rules, MMUdevRule, i);
+        if (!rule->conditions)
+            continue;
+        for (j = 0; j < rule->conditions->len; j++) {
+            MMUdevRuleMatch *match;
+
+            match = &g_array_index (rule->conditions, MMUdevRuleMatch, j);
+            if (match->parameter_type == MM_UDEV_RULE_MATCH_PARAMETER_ATTR_VENDOR_ID && match->value_uint_set)
+                vid = match->value_uint;
+            else if (match->parameter_type == MM_UDEV_RULE_MATCH_PARAMETER_ATTR_PRODUCT_ID && match->value_uint_set)
+                pid = match->value_uint;
+        }
+        if (vid) {
+            guint id = (vid << 16) | pid;
+
+            g_array_append_val (ids, id);
+        }
+    }
+    g_assert_cmpuint (ids->len, >, 0);
+
+    rand = g_rand_new_with_seed (1234);
+    ports = g_array_sized_new (FALSE, TRUE, sizeof (SyntheticPort), n_ports);
+    g_array_set_clear_func (ports, (GDestroyNotify) synthetic_port_clear);
+
+    for (i = 0; i < n_ports; i++) {
+        SyntheticPort port;
+        guint         id;
+        guint         ifnum;
+
+        memset (&port, 0, sizeof (port));
+        if (g_rand_int_range (rand, 0, 4) == 0)
+            id = g_rand_int (rand);
+        else
+            id = g_array_index (ids, guint, g_rand_int_range (rand, 0, ids->len));
+        ifnum = g_rand_int_range (rand, 0, 8);
+
+        port.name = g_strdup_printf ("ttyUSB%u", i);
+        port.sysfs_path = g_strdup_printf ("/sys/devices/pci0000:00/0000:00:14.0/usb1/1-%u/1-%u:1.%u/%s/tty/%s",
+                                           i % 16, i % 16, ifnum, port.name, port.name);
+
+        port.device.subsystem            = "tty";
+        port.device.name                 = port.name;
+        port.device.sysfs_path           = port.sysfs_path;
+        port.device.driver               = drivers[g_rand_int_range (rand, 0, G_N_ELEMENTS (drivers))];
+        port.device.physdev_vid          = (id >> 16) & 0xFFFF;
+        port.device.physdev_pid          = id & 0xFFFF;
+        port.device.interface_class      = g_rand_boolean (rand) ? 0xff : 0x02;
+        port.device.interface_subclass   = g_rand_int_range (rand, 0, 3);
+        port.device.interface_protocol   = g_rand_int_range (rand, 0, 3);
+        port.device.interface_number     = ifnum;
+        g_array_append_val (ports, port);
+    }
+
+    g_rand_free (rand);
+    g_array_unref (ids);
+    return ports;
+}
+
+static GHashTable *
+apply_rules (GArray                  *rules,
+             const MMUdevRulesDevice *device,
+             gboolean                 use_index)
+{
+    GHashTable *props;
+
+    props = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+    mm_kernel_device_generic_rules_apply (rules, device, use_index, test_get_property, test_set_property, props);
+    return props;
+}
+
+static void
+test_index_equivalence (void)
+{
+    GArray *rules;
+    GArray *ports;
+    GError *error = NULL;
+    guint   i;
+    guint   n_tagged = 0;
+
+    rules = mm_kernel_device_generic_rules_load (TESTUDEVRULESDIR, &error);
+    g_assert_no_error (error);
+    g_assert (rules);
+
+    ports = build_synthetic_ports (rules, N_SYNTHETIC_PORTS);
+
+    for (i = 0; i < ports->len; i++) {
+        const MMUdevRulesDevice *device;
+        GHashTable              *linear;
+        GHashTable              *indexed;
+        GHashTableIter           iter;
+        gpointer                 key, value;
+
+        device = &g_array_index (ports, SyntheticPort, i).device;
+        linear  = apply_rules (rules, device, FALSE);
+        indexed = apply_rules (rules, device, TRUE);
+
+        g_assert_cmpuint (g_hash_table_size (linear), ==, g_hash_table_size (indexed));
+        g_hash_table_iter_init (&iter, linear);
+        while (g_hash_table_iter_next (&iter, &key, &value))
+            g_assert_cmpstr ((const gchar *) value, ==, (const gchar *) g_hash_table_lookup (indexed, key));
+
+        if (g_hash_table_size (linear) > 0)
+            n_tagged++;
+
+        g_hash_table_unref (linear);
+        g_hash_table_unref (indexed);
+    }
+
+    /* Make sure the synthetic ports do exercise the rules */
+    g_assert_cmpuint (n_tagged, >, 0);
+
+    g_array_unref (ports);
+    g_array_unref (rules);
+}
+
+static gdouble
+benchmark_rules (GArray   *rules,
+                 GArray   *ports,
+                 gboolean  use_index)
+{
+    guint i;
+
+    g_test_timer_start ();
+    for (i = 0; i < ports->len; i++)
+        g_hash_table_unref (apply_rules (rules, &g_array_index (ports, SyntheticPort, i).device, use_index));
+    return g_test_timer_elapsed ();
+}
+
+static void
+test_index_benchmark (void)
+{
+    GArray  *rules;
+    GArray  *ports;
+    GError  *error = NULL;
+    gdouble  linear;
+    gdouble  indexed;
+
+    rules = mm_kernel_device_generic_rules_load (TESTUDEVRULESDIR, &error);
+    g_assert_no_error (error);
+    g_assert (rules);
+
+    ports = build_synthetic_ports (rules, 10 * N_SYNTHETIC_PORTS);
+
+    linear  = benchmark_rules (rules, ports, FALSE);
+    indexed = benchmark_rules (rules, ports, TRUE);
+
+    g_test_minimized_result (indexed, "indexed: %u ports in %.3lf s", ports->len, indexed);
+    g_test_message ("linear: %u ports in %.3lf s", ports->len, linear);
+    g_test_message ("indexed: %u ports in %.3lf s", ports->len, indexed);
+
+    g_array_unref (ports);
+    g_array_unref (rules);
+}
+
+/************************************************************/
+
 void
 _mm_log (const char *loc,
          const char *func,
@@ -73,6 +282,9 @@ int main (int argc, char **argv)
     g_test_init (&argc, &argv, NULL);
 
     g_test_add_func ("/MM/test-udev-rules/load-cleanup-core", test_load_cleanup_core);
+    g_test_add_func ("/MM/test-udev-rules/index-equivalence", test_index_equivalence);
+    if (g_test_perf ())
+        g_test_add_func ("/MM/test-udev-rules/index-benchmark", test_index_benchmark);
 
     return g_test_run ();
 }